@@ -1,14 +1,38 @@
 /* =========================================================================
-   Knowledge Graph Engine (C, Single-File Edition)
+   Knowledge Graph Engine (C, Console Client)
    -------------------------------------------------------------------------
  ->  Purpose:
-     A robust, user-friendly knowledge graph system using core data structures:
-       - Hash Table (for O(1) entity lookup)
-       - Adjacency List via Linked Lists (for directed relations)
-       - Queue (BFS path finding)
+     A robust, user-friendly menu on top of the graph engine library
+     (kg_graph.h). All graph logic lives in the library; this file only
+     reads input, picks among fuzzy suggestions and prints results.
 ->   Build & Run:
-     gcc -o knowledge_graph knowledge_graph.c
-     ./knowledge_graph
+     gcc -pthread -o ipproject ipproject.c kg_graph.c kg_metrics.c kg_reach.c kg_scc.c kg_csr.c kg_pathcache.c kg_query.c kg_rpq.c kg_kpaths.c kg_ego.c kg_topo.c kg_rank.c kg_central.c -lm
+     ./ipproject
+->  Profile: "explain 4" runs option 4 and prints a per-phase breakdown.
+->  Query: "query ?x Requires Python . ?x \"Subset of\" ?y" lists matches;
+     "explain query ..." adds the plan with estimated vs actual rows.
+->  Path query: "rpq Machine Learning : Includes+" lists everything reached
+     along relations matching the expression, each with a witness path;
+     "rpq A : Requires/(\"Subset of\")* : B" asks about B only.
+->  Routes: "routes A : B" lists the 5 shortest loopless paths (": k" for
+     more), "allpaths A : B : 4" every simple path of at most 4 hops.
+->  Related: "related A : B" says whether any chain of relations, in
+     either direction, links the two (no search needed).
+->  Cycles: "cycles Requires, Prerequisite for" lists the groups of entities
+     that depend on each other in a circle along those relations.
+->  Neighborhood: "ego Python : 2 : both" lists everything within 2 hops
+     either way; ": ego.dot" (or any other file name) also saves it.
+->  Order: "order" lists everything in learning order along "Prerequisite
+     for" / "Requires" ("order Needed for / Depends on" picks others);
+     "prereqs Algorithms" only what Algorithms needs, in the same order.
+->  Rank: "rank" scores every entity by PageRank; suggestions and option 3
+     list the important ones first from then on. "rank Python : NumPy"
+     recommends what matters most from those two (personalized PageRank).
+->  Bridges: "bridges" lists the concepts most shortest paths run through
+     and those the rest reach fastest; "bridges 200" estimates both from
+     200 random starting points, with an error bound.
+->  Metrics: type "stats" at the menu prompt, or `kill -USR1 <pid>` to
+     write Prometheus text to kg_metrics.prom.
 ->  Optional (to render PNG after exporting .dot):
      dot -Tpng kg_graph.dot -o graph.png
 
@@ -17,19 +41,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "kg_graph.h"
+#include "kg_metrics.h"
+#include "kg_reach.h"
+#include "kg_scc.h"
+#include "kg_pathcache.h"
+#include "kg_query.h"
+#include "kg_rpq.h"
+#include "kg_kpaths.h"
+#include "kg_ego.h"
+#include "kg_topo.h"
+#include "kg_rank.h"
+#include "kg_central.h"
 
 /* [SECTION] Configuration & UI Constants */
 
-#define HASH_SIZE   101          
-#define NAME_LEN    128
-#define REL_LEN     128
-#define LINE_BUF    512
-#define SUGGEST_MAX 16          
-#define QUEUE_INIT  128          
+#define NAME_LEN    KG_NAME_LEN
+#define REL_LEN     KG_REL_LEN
+#define LINE_BUF    KG_LINE_BUF
+#define SUGGEST_MAX 16
+#define QUERY_MAX   200          /* answers printed per query */
+#define ROUTES_DEFAULT 5         /* "routes" without a count */
+#define ALLPATHS_HOPS  4         /* "allpaths" without a hop limit */
+#define EGO_HOPS       2         /* "ego" without a hop count */
+#define RANK_TOP      10         /* entities "rank" lists */
+#define RANK_SEEDS    16         /* entities "rank a : b ..." starts from */
+#define BRIDGES_SAMPLES 1000     /* "bridges" without a count; exact below that */
+#define STATS_RELATIONS 10       /* relations listed by "stats" */
 
 #define DEFAULT_DATA_FILE  "relations.txt"
 #define DEFAULT_DOT_FILE   "kg_graph.dot"
+#define METRICS_FILE       "kg_metrics.prom"
 
 /* ANSI colors for a clean, professional console UI */
 #define RESET   "\033[0m"
@@ -41,32 +86,16 @@
 #define MAGENTA "\033[1;35m"
 #define WHITE   "\033[1;37m"
 
-/* =========================================================================
-   [SECTION] Data Structures
-   - Relation: labeled directed edge to a target entity
-   - Entity: node with name, adjacency list head, hash-chain link
-   ========================================================================= */
-typedef struct Entity Entity;
-
-typedef struct Relation {
-    char rel[REL_LEN];
-    Entity *target;
-    struct Relation *next;   /* adjacency next */
-} Relation;
-
-struct Entity {
-    char name[NAME_LEN];
-    Relation *relations;     /* adjacency list head */
-    struct Entity *hnext;    /* hash chain next */
-    /* transient fields for BFS */
-    int visited;
-    Entity *prev;
-};
+/* The one graph this console session works on */
+static kg_graph_t *gGraph = NULL;
+static kg_metrics_t gMetrics;
+static kg_reach_t *gReach = NULL;    /* rebuilt on demand once stale */
+static kg_path_cache_t *gPathCache = NULL;
+static kg_triples_t *gTriples = NULL;    /* SPO/POS/OSP, rebuilt on demand once stale */
+static kg_topo_t *gTopo = NULL;          /* for gTopoSpec, rebuilt on demand once stale */
+static char gTopoSpec[LINE_BUF];
 
-/* Global hash table (closed chaining) */
-static Entity *gHash[HASH_SIZE] = { NULL };
-
-/*  [SECTION] Utility: Safe I/O, String Helpers, Trimming, Case, etc. */
+/*  [SECTION] Utility: Safe I/O */
 
 /* Read a line safely, strip trailing newline. */
 static void read_line(char *buf, size_t n) {
@@ -74,116 +103,33 @@ static void read_line(char *buf, size_t n) {
     buf[strcspn(buf, "\r\n")] = 0;
 }
 
-/* Trim leading & trailing whitespace (in place). */
-static void trim(char *s) {
-    size_t len = strlen(s);
-    size_t start = 0, end = len ? len - 1 : 0;
-
-    while (s[start] && isspace((unsigned char)s[start])) start++;
-    while (end > start && isspace((unsigned char)s[end])) end--;
-
-    if (start > 0) memmove(s, s + start, end - start + 1);
-    s[end - start + 1] = '\0';
-}
-
-/* Optional normalization: collapse multiple internal spaces into single space. */
-static void squeeze_spaces(char *s) {
-    char *dst = s;
-    int in_space = 0;
-    for (; *s; ++s) {
-        if (isspace((unsigned char)*s)) {
-            if (!in_space) { *dst++ = ' '; in_space = 1; }
-        } else {
-            *dst++ = *s; in_space = 0;
-        }
-    }
-    *dst = '\0';
-}
-
-/* Lowercase copy (safe). */
-static void to_lower_copy(const char *src, char *dst, size_t dstsz) {
-    size_t i = 0;
-    for (; src[i] && i + 1 < dstsz; ++i) dst[i] = (char)tolower((unsigned char)src[i]);
-    dst[i] = '\0';
-}
-
-/* Case-insensitive compare. Returns 0 if equal ignoring case. */
-static int ci_cmp(const char *a, const char *b) {
-    while (*a && *b) {
-        int ca = tolower((unsigned char)*a);
-        int cb = tolower((unsigned char)*b);
-        if (ca != cb) return ca - cb;
-        ++a; ++b;
-    }
-    return (unsigned char)*a - (unsigned char)*b;
-}
-
-/* Case-insensitive substring check. */
-static int ci_contains(const char *hay, const char *needle) {
-    char H[NAME_LEN*2], N[NAME_LEN];
-    to_lower_copy(hay, H, sizeof(H));
-    to_lower_copy(needle, N, sizeof(N));
-    return strstr(H, N) != NULL;
-}
-
-/* [SECTION] Hash Table Operations */
-static unsigned hash_index(const char *s) {
-    /* djb2 */
-    unsigned long h = 5381;
-    int c;
-    while ((c = (unsigned char)*s++)) h = ((h << 5) + h) + (unsigned)c;
-    return (unsigned)(h % HASH_SIZE);
-}
-
-static Entity* find_entity_exact(const char *name) {
-    unsigned idx = hash_index(name);
-    for (Entity *e = gHash[idx]; e; e = e->hnext)
-        if (strcmp(e->name, name) == 0) return e;
-    return NULL;
-}
-
-static Entity* create_entity(const char *name) {
-    Entity *e = (Entity*)malloc(sizeof(Entity));
-    if (!e) { printf(RED "Memory allocation failed\n" RESET); exit(1); }
-    strncpy(e->name, name, NAME_LEN-1); e->name[NAME_LEN-1] = '\0';
-    e->relations = NULL;
-    e->visited = 0;
-    e->prev = NULL;
-
-    unsigned idx = hash_index(e->name);
-    e->hnext = gHash[idx];
-    gHash[idx] = e;
-    return e;
-}
-
-static Entity* get_or_create_entity(const char *name) {
-    Entity *e = find_entity_exact(name);
-    if (e) return e;
-    return create_entity(name);
+/* Library failures other than "not found"-style outcomes are fatal here. */
+static void die_on_nomem(kg_status_t st) {
+    if (st == KG_ERR_NOMEM) { printf(RED "Memory allocation failed\n" RESET); exit(1); }
 }
 
 /*[SECTION] Graph Operations (Edges/Relations) */
 
-static void add_relationship(const char *src, const char *rel, const char *tgt) {
-    Entity *S = get_or_create_entity(src);
-    Entity *T = get_or_create_entity(tgt);
-    Relation *R = (Relation*)malloc(sizeof(Relation));
-    if (!R) { printf(RED "Memory allocation failed\n" RESET); exit(1); }
-    strncpy(R->rel, rel, REL_LEN-1); R->rel[REL_LEN-1] = '\0';
-    R->target = T;
-    R->next = S->relations;
-    S->relations = R;
-
-    printf(GREEN "✔ Added: " CYAN "\"%s\"" RESET " --" WHITE "%s" RESET "--> " CYAN "\"%s\"" RESET "\n",
-           S->name, R->rel, T->name);
+static void add_relationship(const char *src, const char *rel, const char *tgt, double weight) {
+    kg_relation_t *R;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_add_edge_weighted(gGraph, src, rel, tgt, weight, &R);
+    kg_metrics_record(&gMetrics, KG_OP_ADD, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); return; }
+
+    printf(GREEN "✔ Added: " CYAN "\"%s\"" RESET " --" WHITE "%s" RESET "--> " CYAN "\"%s\"" RESET,
+           src, R->rel, R->target->name);
+    if (R->weight != 1.0f) printf(WHITE " (cost %g)" RESET, (double)R->weight);
+    printf("\n");
 }
 
 /*
    [SECTION] Fuzzy Search (Case-insensitive + Prefix/Substring Suggestions)
-   - Returns an Entity* after disambiguation, or NULL if no match.
+   - Returns an entity after disambiguation, or NULL if no match.
     */
 
-static Entity* fuzzy_pick_from_suggestions(Entity **list, int count) {
+static kg_entity_t* fuzzy_pick_from_suggestions(kg_entity_t **list, int count) {
     if (count <= 0) return NULL;
     if (count == 1) return list[0];
 
@@ -200,109 +146,95 @@ static Entity* fuzzy_pick_from_suggestions(Entity **list, int count) {
     return NULL;
 }
 
-/* Main fuzzy search:
-   1) exact (case-insensitive) match
-   2) prefix matches
-   3) substring matches
-*/
-static Entity* search_entity_smart(const char *user_input) {
-    char key[NAME_LEN]; strncpy(key, user_input, NAME_LEN-1); key[NAME_LEN-1] = '\0';
-    trim(key); squeeze_spaces(key);
-    if (key[0] == '\0') return NULL;
-
-    /* Pass 1: exact (case-insensitive) */
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        for (Entity *e = gHash[i]; e; e = e->hnext) {
-            if (ci_cmp(e->name, key) == 0) return e;
-        }
-    }
-
-    /* Collect suggestions (prefix first) */
-    Entity *sugg[SUGGEST_MAX]; int sc = 0;
-
-    /* Pass 2: prefix (case-insensitive) */
-    for (int i = 0; i < HASH_SIZE && sc < SUGGEST_MAX; ++i) {
-        for (Entity *e = gHash[i]; e && sc < SUGGEST_MAX; e = e->hnext) {
-            char lowE[NAME_LEN], lowK[NAME_LEN];
-            to_lower_copy(e->name, lowE, sizeof(lowE));
-            to_lower_copy(key,    lowK, sizeof(lowK));
-            if (strncmp(lowE, lowK, strlen(lowK)) == 0) {
-                sugg[sc++] = e;
-            }
-        }
-    }
-
-    /* Pass 3: substring (case-insensitive) */
-    if (sc == 0) {
-        for (int i = 0; i < HASH_SIZE && sc < SUGGEST_MAX; ++i) {
-            for (Entity *e = gHash[i]; e && sc < SUGGEST_MAX; e = e->hnext) {
-                if (ci_contains(e->name, key)) {
-                    sugg[sc++] = e;
-                }
-            }
-        }
-    }
+/* Timed without the user's think time at the suggestion prompt. */
+static kg_entity_t* lookup_exact(const char *name) {
+    unsigned long t0 = kg_now_ns();
+    kg_entity_t *e = kg_find_entity(gGraph, name);
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, e != NULL);
+    return e;
+}
 
+static kg_entity_t* search_entity_smart(const char *user_input) {
+    kg_entity_t *e = lookup_exact(user_input);
+    if (e) return e;
+    kg_entity_t *sugg[SUGGEST_MAX]; int sc = 0;
+    unsigned long t0 = kg_now_ns();
+    kg_search(gGraph, user_input, sugg, SUGGEST_MAX, &sc);
+    kg_metrics_record(&gMetrics, KG_OP_SEARCH, t0, sc > 0);
     return fuzzy_pick_from_suggestions(sugg, sc);
 }
 
-/* 
-   [SECTION] BFS Path Finding (prints a clean path if found)
-  */
-static void reset_bfs_marks(void) {
-    for (int i = 0; i < HASH_SIZE; ++i)
-        for (Entity *e = gHash[i]; e; e = e->hnext)
-            e->visited = 0, e->prev = NULL;
+/* "Can src reach tgt at all?" from the reachability index, so a miss
+   does not cost a search of everything src reaches. The index is only
+   rebuilt when it cannot answer (it went stale and would say "no"). */
+static int can_reach(const kg_entity_t *src, const kg_entity_t *tgt) {
+    kg_reach_answer_t a = gReach ? kg_reach_query(gReach, src, tgt) : KG_REACH_UNKNOWN;
+    if (a != KG_REACH_UNKNOWN) return a == KG_REACH_YES;
+    kg_snapshot_t s;
+    if (kg_snapshot_acquire(gGraph, &s) != KG_OK) return 1;
+    kg_reach_t *fresh;
+    kg_status_t st = kg_reach_build(&s, 0, 0, &fresh);
+    kg_snapshot_release(&s);
+    die_on_nomem(st);
+    if (st != KG_OK) return 1;
+    kg_reach_free(gReach);
+    gReach = fresh;
+    return kg_reach_query(gReach, src, tgt) != KG_REACH_NO;
 }
 
-static void find_path_bfs(const char *src_in, const char *tgt_in, int fuzzy) {
-    Entity *src = fuzzy ? search_entity_smart(src_in) : find_entity_exact(src_in);
-    Entity *tgt = fuzzy ? search_entity_smart(tgt_in) : find_entity_exact(tgt_in);
+/*
+   [SECTION] BFS Path Finding (prints a clean path if found)
+  */
+static void find_path_bfs(const char *src_in, const char *tgt_in, const char *labels, int fuzzy) {
+    kg_entity_t *src = fuzzy ? search_entity_smart(src_in) : lookup_exact(src_in);
+    kg_entity_t *tgt = fuzzy ? search_entity_smart(tgt_in) : lookup_exact(tgt_in);
 
     if (!src) { printf(RED "✖ Source not found.\n" RESET); return; }
     if (!tgt) { printf(RED "✖ Target not found.\n" RESET); return; }
 
-    reset_bfs_marks();
-
-    int cap = QUEUE_INIT, head = 0, tail = 0;
-    Entity **Q = (Entity**)malloc(sizeof(Entity*) * cap);
-    if (!Q) { printf(RED "Memory allocation failed\n" RESET); exit(1); }
-
-    src->visited = 1; Q[tail++] = src;
-    int found = 0;
-
-    while (head < tail) {
-        if (tail >= cap) { cap *= 2; Q = (Entity**)realloc(Q, sizeof(Entity*) * cap); }
-        Entity *cur = Q[head++];
-        if (cur == tgt) { found = 1; break; }
-
-        for (Relation *r = cur->relations; r; r = r->next) {
-            Entity *n = r->target;
-            if (!n->visited) {
-                n->visited = 1;
-                n->prev = cur;
-                Q[tail++] = n;
-            }
-        }
+    /* Optional relation filter: "a, b" follows only those, "!a, b" all but them */
+    kg_label_filter_t filter, *f = NULL;
+    if (labels && labels[0]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, labels, bad, sizeof(bad));
+        die_on_nomem(fst);
+        if (fst != KG_OK) { printf(RED "✖ Unknown relationship \"%s\".\n" RESET, bad); return; }
+        f = &filter;
     }
 
-    if (!found) {
+    /* Once any edge has a cost, "shortest" means cheapest: Dijkstra */
+    int weighted = kg_graph_weighted(gGraph);
+    kg_path_t path;
+    unsigned long t0 = kg_now_ns();
+    /* Repeat questions come from the cache until the next insert */
+    unsigned long version = kg_graph_version(gGraph);
+    kg_status_t st = kg_path_cache_get(gPathCache, version, src, tgt, f, weighted, &path);
+    if (st == KG_ERR_NOT_FOUND) {
+        st = KG_ERR_NO_PATH;
+        /* Different components: no path either way, and no index rebuild */
+        if (kg_connected(gGraph, src, tgt) && can_reach(src, tgt))
+            st = weighted ? kg_weighted_path(gGraph, src, tgt, f, NULL, NULL, &path)
+                          : gReach ? kg_scc_shortest_path(gReach->scc, gGraph, src, tgt, f, &path)
+                                   : kg_shortest_path_filtered(gGraph, src, tgt, f, &path);
+        kg_path_cache_put(gPathCache, version, src, tgt, f, weighted, st, &path);
+    }
+    kg_metrics_record(&gMetrics, KG_OP_PATH, t0, st == KG_OK);
+    if (f) kg_label_filter_free(f);
+    die_on_nomem(st);
+    if (st != KG_OK) {
         printf(RED "\n✖ No path found from \"%s\" to \"%s\".\n" RESET, src->name, tgt->name);
-        free(Q); return;
+        return;
     }
 
-    /* Reconstruct path (reverse via prev) */
-    Entity *stack[1024]; int top = 0;
-    for (Entity *p = tgt; p; p = p->prev) stack[top++] = p;
-
-    printf(GREEN "\n🧭 Path Found:\n" RESET);
-    for (int i = top - 1; i >= 0; --i) {
-        printf(CYAN "%s" RESET, stack[i]->name);
-        if (i) printf(WHITE " -> " RESET);
+    if (weighted) printf(GREEN "\n🧭 Cheapest Path (%zu hops, total cost %g):\n" RESET, path.len - 1, path.cost);
+    else printf(GREEN "\n🧭 Path Found (%zu hops):\n" RESET, path.len - 1);
+    for (size_t i = 0; i < path.len; ++i) {
+        printf(CYAN "%s" RESET, path.nodes[i]->name);
+        if (i + 1 < path.len) printf(WHITE " -> " RESET);
     }
     printf("\n");
 
-    free(Q);
+    kg_path_free(&path);
 }
 
 /*
@@ -325,167 +257,139 @@ static void menu(void) {
     printf(GREEN "7." RESET " 💾 Save Graph to File\n");
     printf(GREEN "8." RESET " 🖼️  Export Graph to DOT (.dot for PNG)\n");
     printf(GREEN "9." RESET " 🚪 Exit\n");
+    printf(WHITE "   or type: " RESET "stats" WHITE " (latency & counters), " RESET "memory" WHITE " (bytes per subsystem), " RESET "explain <n>" WHITE " (profile option n),\n"
+           "            " RESET "query <patterns>" WHITE " (e.g. query ?x Requires Python . ?x \"Subset of\" ?y; "
+           RESET "explain query ..." WHITE " shows the plan),\n"
+           "            " RESET "rpq <source> : <relation path>[ : <target>]" WHITE " (e.g. rpq Python : \"Has Library\"/\"Used for\"*),\n"
+           "            " RESET "routes <source> : <target>[ : k]" WHITE " (k shortest paths), "
+           RESET "allpaths <source> : <target>[ : max hops]" WHITE ",\n"
+           "            " RESET "related <a> : <b>" WHITE " (linked at all?), "
+           RESET "cycles[ <relations>]" WHITE " (circular dependencies),\n"
+           "            " RESET "ego <entity>[ : hops[ : out|in|both[ : <file>]]]" WHITE " (neighborhood; .dot or relations file),\n"
+           "            " RESET "order[ <before> / <after>]" WHITE " (learning order), "
+           RESET "prereqs <entity>[ : <before> / <after>]" WHITE " (what it needs, in order),\n"
+           "            " RESET "rank[ <entity>[ : <entity> ...]]" WHITE " (PageRank; with entities, what matters from there),\n"
+           "            " RESET "bridges[ <samples>]" WHITE " (betweenness & closeness)\n" RESET);
     printf(WHITE "Enter choice: " RESET);
 }
 
 static void display_connections(const char *query, int fuzzy) {
-    Entity *e = fuzzy ? search_entity_smart(query) : find_entity_exact(query);
+    kg_entity_t *e = fuzzy ? search_entity_smart(query) : lookup_exact(query);
     if (!e) { printf(RED "✖ Entity not found.\n" RESET); return; }
 
     printf("\n" BLUE "═══════════════════════════════════════════\n" RESET);
     printf(MAGENTA "  🔗 CONNECTIONS OF: %s\n" RESET, e->name);
     printf(BLUE "═══════════════════════════════════════════\n" RESET);
 
-    Relation *r = e->relations;
-    if (!r) { printf(YELLOW "   (No outgoing relationships)\n" RESET); return; }
+    kg_snapshot_t s;
+    die_on_nomem(kg_snapshot_acquire(gGraph, &s));
+    kg_relation_t *head = kg_snapshot_relations(&s, e), *r;
+    if (!head) {
+        kg_snapshot_release(&s);
+        printf(YELLOW "   (No outgoing relationships)\n" RESET);
+        return;
+    }
+
+    /* Most important targets first once "rank" has scored them */
+    size_t n = 0;
+    for (r = head; r; r = r->next) n++;
+    kg_relation_t **rows = (kg_relation_t**)malloc(n * sizeof(kg_relation_t*));
+    if (!rows) die_on_nomem(KG_ERR_NOMEM);
+    n = 0;
+    for (r = head; r; r = r->next) {
+        size_t k = n++;
+        if (kg_scores_version(gGraph))
+            for (; k > 0 && kg_score(rows[k - 1]->target) < kg_score(r->target); --k) rows[k] = rows[k - 1];
+        rows[k] = r;
+    }
 
     printf(WHITE "   %-28s | %-28s\n" RESET, "Target Entity", "Relationship");
     printf(BLUE  "   --------------------------------------------------------\n" RESET);
-    for (; r; r = r->next) {
-        printf("   %-28s | %-28s\n", r->target->name, r->rel);
+    for (size_t i = 0; i < n; ++i) {
+        r = rows[i];
+        if (r->weight == 1.0f) printf("   %-28s | %-28s\n", r->target->name, r->rel);
+        else printf("   %-28s | %s (cost %g)\n", r->target->name, r->rel, (double)r->weight);
     }
+    kg_snapshot_release(&s);
+    free(rows);
     printf(BLUE "═══════════════════════════════════════════\n" RESET);
 }
 
-/* 
-   [SECTION] File I/O: Robust Load & Save
-   - Format per line:  Source|Relationship|Target
-   - Skips: blanks, lines starting with '#'
-   - Trims & normalizes spaces around tokens
+/*
+   [SECTION] File I/O: Load & Save (parsing lives in the library)
  */
 
-static int parse_relation_line(char *line, char *src, char *rel, char *tgt) {
-    /* Expect exactly two '|' separators */
-    char *p1 = strchr(line, '|');
-    if (!p1) return 0;
-    char *p2 = strchr(p1 + 1, '|');
-    if (!p2) return 0;
-
-    /* Extract substrings */
-    size_t L1 = (size_t)(p1 - line);
-    size_t L2 = (size_t)(p2 - (p1 + 1));
-    size_t L3 = strlen(p2 + 1);
-
-    if (L1 == 0 || L2 == 0 || L3 == 0) return 0;
-
-    if (L1 >= NAME_LEN) L1 = NAME_LEN - 1;
-    if (L2 >= REL_LEN)  L2 = REL_LEN - 1;
-    if (L3 >= NAME_LEN) L3 = NAME_LEN - 1;
-
-    strncpy(src, line, L1); src[L1] = '\0';
-    strncpy(rel, p1 + 1, L2); rel[L2] = '\0';
-    strncpy(tgt, p2 + 1, L3); tgt[L3] = '\0';
-
-    trim(src); trim(rel); trim(tgt);
-    squeeze_spaces(src); squeeze_spaces(rel); squeeze_spaces(tgt);
-    return 1;
+static void on_load_line(void *ctx, int line_no, const char *line,
+                         const kg_entity_t *src, const kg_relation_t *rel) {
+    (void)ctx;
+    if (!rel) {
+        printf(YELLOW "⚠ Skipping invalid line %d: \"%s\"\n" RESET, line_no, line);
+        return;
+    }
+    printf(GREEN "✔ Added: " CYAN "\"%s\"" RESET " --" WHITE "%s" RESET "--> " CYAN "\"%s\"" RESET "\n",
+           src->name, rel->rel, rel->target->name);
 }
 
 static void load_from_file(const char *filename) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) { printf(RED "✖ Cannot open '%s'\n" RESET, filename); return; }
-
-    char line[LINE_BUF];
-    int count = 0, bad = 0, lineNo = 0;
-
-    while (fgets(line, sizeof(line), fp)) {
-        lineNo++;
-        line[strcspn(line, "\r\n")] = 0;
-        trim(line);
-        if (line[0] == '\0') continue;      /* skip blanks */
-        if (line[0] == '#')  continue;      /* skip comments */
-
-        char src[NAME_LEN], rel[REL_LEN], tgt[NAME_LEN];
-        if (!parse_relation_line(line, src, rel, tgt)) {
-            bad++; 
-            printf(YELLOW "⚠ Skipping invalid line %d: \"%s\"\n" RESET, lineNo, line);
-            continue;
-        }
-        add_relationship(src, rel, tgt);
-        count++;
-    }
-    fclose(fp);
-    printf(GREEN "📂 Loaded %d relations from '%s' (skipped %d)\n" RESET, count, filename, bad);
+    kg_load_stats_t ls;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_load_file(gGraph, filename, &ls, on_load_line, NULL);
+    kg_metrics_record(&gMetrics, KG_OP_LOAD, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st == KG_ERR_IO) { printf(RED "✖ Cannot read '%s' (nothing loaded)\n" RESET, filename); return; }
+    printf(GREEN "📂 Loaded %d relations from '%s' (skipped %d)\n" RESET, ls.loaded, filename, ls.skipped);
 }
 
 static void save_to_file(const char *filename) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) { printf(RED "✖ Cannot write '%s'\n" RESET, filename); return; }
-
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        for (Entity *e = gHash[i]; e; e = e->hnext) {
-            for (Relation *r = e->relations; r; r = r->next) {
-                fprintf(fp, "%s|%s|%s\n", e->name, r->rel, r->target->name);
-            }
-        }
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_save_file(gGraph, filename);
+    kg_metrics_record(&gMetrics, KG_OP_SAVE, t0, st == KG_OK);
+    if (st != KG_OK) {
+        printf(RED "✖ Cannot write '%s'\n" RESET, filename);
+        return;
     }
-    fclose(fp);
     printf(GREEN "💾 Saved graph to '%s'\n" RESET, filename);
 }
 
-/* 
+/*
    [SECTION] Batch Input (manual, N lines)
+   - All N lines are published together as one graph version.
   */
 static void batch_input_lines(int n) {
     char line[LINE_BUF];
+    kg_batch_begin(gGraph);
     for (int i = 1; i <= n; ++i) {
-        printf(WHITE "Line %d [src|rel|tgt]: " RESET, i);
+        printf(WHITE "Line %d [src|rel|tgt(|cost)]: " RESET, i);
         read_line(line, sizeof(line));
-        trim(line);
-        if (line[0] == '\0' || line[0] == '#') { 
-            printf(YELLOW "  (skipped)\n" RESET); 
-            continue; 
+        kg_trim(line);
+        if (line[0] == '\0' || line[0] == '#') {
+            printf(YELLOW "  (skipped)\n" RESET);
+            continue;
         }
         char src[NAME_LEN], rel[REL_LEN], tgt[NAME_LEN];
-        if (!parse_relation_line(line, src, rel, tgt)) {
-            printf(RED "  Invalid format. Use: Source|Relationship|Target\n" RESET);
+        double w;
+        if (!kg_parse_relation_line_weighted(line, src, rel, tgt, &w)) {
+            printf(RED "  Invalid format. Use: Source|Relationship|Target[|Cost]\n" RESET);
             --i; /* re-ask same line index */
             continue;
         }
-        add_relationship(src, rel, tgt);
+        add_relationship(src, rel, tgt, w);
     }
+    kg_batch_commit(gGraph);
 }
 
-/* 
+/*
    [SECTION] GraphViz .dot Export (for PNG rendering externally)
 */
 static void export_dot(const char *dotfile) {
-    FILE *fp = fopen(dotfile, "w");
-    if (!fp) { 
-        printf(RED "✖ Cannot create '%s'\n" RESET, dotfile); 
-        return; 
-    }
-
-    // Modern GraphViz Styling
-    fprintf(fp, "digraph KnowledgeGraph {\n");
-    fprintf(fp, "  rankdir=LR;\n"); 
-    fprintf(fp, "  layout=dot;\n");
-    fprintf(fp, "  graph [splines=true, overlap=false, ranksep=1.3, nodesep=1.0, fontsize=12, fontname=\"Calibri\", bgcolor=\"#FFFFFF\"];\n");
-
-    // Node Style (Soft Blue | Rounded Box | Drop Shadow-ish contrast)
-    fprintf(fp, "  node [shape=box, style=filled, fontname=\"Calibri\", fontsize=11, penwidth=1.5, "
-                "color=\"#1A73E8\", fillcolor=\"#E8F0FE\", fontcolor=\"#202124\"];\n");
-    // Edge Style (Smooth dark gray arrows with nice labels)
-    fprintf(fp, "  edge [color=\"#5F6368\", fontname=\"Calibri\", fontsize=10, penwidth=1.3, arrowsize=0.85, fontcolor=\"#3C4043\"];\n\n");
-
-    // Entities & Relations Output
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        for (Entity *e = gHash[i]; e; e = e->hnext) {
-            if (!e->relations) {
-                fprintf(fp, "  \"%s\";\n", e->name);
-            }
-            for (Relation *r = e->relations; r; r = r->next) {
-                fprintf(fp,
-                    "  \"%s\" -> \"%s\" [label=\"%s\"];\n",
-                    e->name, r->target->name, r->rel
-                );
-            }
-        }
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_export_dot(gGraph, dotfile);
+    kg_metrics_record(&gMetrics, KG_OP_EXPORT, t0, st == KG_OK);
+    if (st != KG_OK) {
+        printf(RED "✖ Cannot create '%s'\n" RESET, dotfile);
+        return;
     }
 
-    fprintf(fp, "}\n");
-    fclose(fp);
-
     printf(GREEN "\n✅ Modern DOT file exported to '%s'\n" RESET, dotfile);
     printf(WHITE "To render a high-quality PNG run:\n" RESET CYAN
         "  dot -Tpng -Gdpi=300 %s -o graph_hd.png\n" RESET, dotfile);
@@ -495,105 +399,687 @@ static void export_dot(const char *dotfile) {
            dotfile, dotfile);
 }
 
+/*
+   [SECTION] Pattern Queries ("query ...")
+   - Runs on the triple indexes as of the last insert; they are rebuilt
+     here, on first use after the graph changed.
+ */
+static void run_query(const char *text, int explain) {
+    char err[KG_LINE_BUF];
+    kg_query_t *q;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_query_parse(gGraph, text, &q, err, sizeof(err));
+    die_on_nomem(st);
+    if (st != KG_OK) {
+        kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, 0);
+        printf(RED "✖ %s\n" RESET, err);
+        return;
+    }
+    if (!gTriples || !kg_triples_is_current(gTriples)) {
+        kg_snapshot_t s;
+        st = kg_snapshot_acquire(gGraph, &s);
+        kg_triples_t *fresh = NULL;
+        if (st == KG_OK) {
+            st = kg_triples_build(&s, KG_TRIPLES_ALL_ORDERS, &fresh);
+            kg_snapshot_release(&s);
+        }
+        die_on_nomem(st);
+        kg_triples_free(gTriples);
+        gTriples = fresh;
+    }
+    kg_query_result_t r;
+    kg_query_plan_t plan;
+    /* Cycles (A -> B -> C plus A -> C) go to the worst-case-optimal join */
+    st = kg_query_explain(gTriples, q, kg_query_is_cyclic(q), QUERY_MAX, explain ? &plan : NULL, &r);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+
+    if (r.n_rows == 0) printf(YELLOW "\n(no matches)\n" RESET);
+    else if (q->n_vars == 0) printf(GREEN "\n✔ Yes, all of these hold.\n" RESET);
+    else {
+        printf(GREEN "\n🔎 %zu match%s%s:\n" RESET, r.n_rows, r.n_rows == 1 ? "" : "es",
+               r.truncated ? " (first ones only)" : "");
+        for (size_t i = 0; i < r.n_rows; ++i) {
+            printf("  ");
+            for (size_t v = 0; v < q->n_vars; ++v)
+                printf(WHITE "?%s" RESET " = " CYAN "%s" RESET "%s", q->vars[v],
+                       kg_query_value(gGraph, q, &r, i, v), v + 1 < q->n_vars ? ", " : "\n");
+        }
+    }
+    if (explain) {
+        printf(BLUE "\n═══════════════════════════════════════════\n" RESET);
+        printf(MAGENTA "  🔬 EXPLAIN (query)\n" RESET);
+        printf(BLUE "═══════════════════════════════════════════\n" RESET);
+        kg_query_plan_print(gGraph, q, &plan, stdout);
+        kg_query_plan_free(&plan);
+    }
+    kg_query_result_free(&r);
+    kg_query_free(q);
+}
 
 /*
-   [SECTION] Memory Cleanup
+   [SECTION] Regular Path Queries ("rpq ...")
+   - "source : expression[ : target]"; the source (and target) may be
+     fuzzy, the expression is over relation labels (see kg_rpq.h).
  */
-static void free_graph(void) {
-    for (int i = 0; i < HASH_SIZE; ++i) {
-        Entity *e = gHash[i];
-        while (e) {
-            Relation *r = e->relations;
-            while (r) { Relation *tmp = r; r = r->next; free(tmp); }
-            Entity *tmpE = e; e = e->hnext; free(tmpE);
+static void print_witness(const kg_rpq_result_t *res, size_t i) {
+    kg_rpq_path_t p;
+    die_on_nomem(kg_rpq_witness(res, i, &p));
+    printf("  " CYAN "%s" RESET, p.nodes[0]->name);
+    for (size_t k = 0; k < p.len; ++k)
+        printf(" -%s-> " CYAN "%s" RESET, p.rels[k]->rel, p.nodes[k + 1]->name);
+    printf("\n");
+    kg_rpq_path_free(&p);
+}
+
+static void run_rpq(char *text) {
+    char *expr = strchr(text, ':');
+    if (!expr) { printf(RED "✖ Usage: rpq <source> : <relation path>[ : <target>]\n" RESET); return; }
+    *expr++ = '\0';
+    char *tname = strrchr(expr, ':');
+    if (tname) *tname++ = '\0';
+    kg_trim(text); kg_squeeze_spaces(text);
+    if (tname) { kg_trim(tname); kg_squeeze_spaces(tname); }
+
+    char err[KG_LINE_BUF];
+    kg_rpq_t *r;
+    kg_status_t st = kg_rpq_compile(gGraph, expr, &r, err, sizeof(err));
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, err); return; }
+    kg_entity_t *src = search_entity_smart(text);
+    kg_entity_t *tgt = src && tname ? search_entity_smart(tname) : NULL;
+    if (!src || (tname && !tgt)) {
+        printf(RED "✖ %s entity not found.\n" RESET, src ? "Target" : "Source");
+        kg_rpq_free(r);
+        return;
+    }
+
+    kg_rpq_result_t res;
+    unsigned long t0 = kg_now_ns();
+    st = kg_rpq_eval(gGraph, r, src, tgt, QUERY_MAX, /*witnesses*/1, &res);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st == KG_ERR_NO_PATH || (st == KG_OK && res.n == 0)) {
+        printf(YELLOW "\n(no matching paths)\n" RESET);
+    } else if (st == KG_OK) {
+        printf(GREEN "\n🔎 %zu match%s%s:\n" RESET, res.n, res.n == 1 ? "" : "es",
+               res.truncated ? " (nearest ones only)" : "");
+        for (size_t i = 0; i < res.n; ++i) print_witness(&res, i);
+    } else {
+        printf(RED "✖ %s\n" RESET, kg_strerror(st));
+    }
+    kg_rpq_result_free(&res);
+    kg_rpq_free(r);
+}
+
+/*
+   [SECTION] Alternative Routes ("routes ...", "allpaths ...")
+   - "source : target[ : number]"; each path is printed the moment the
+     library hands it over, so long enumerations show progress.
+ */
+typedef struct route_printer {
+    size_t n;
+    int weighted;
+} route_printer_t;
+
+static int print_route(void *ctx, const kg_path_t *p) {
+    route_printer_t *rp = (route_printer_t*)ctx;
+    if (rp->weighted) printf(WHITE "  %2zu. (%zu hops, cost %g) " RESET, ++rp->n, p->len - 1, p->cost);
+    else printf(WHITE "  %2zu. (%zu hops) " RESET, ++rp->n, p->len - 1);
+    for (size_t i = 0; i < p->len; ++i)
+        printf(CYAN "%s" RESET "%s", p->nodes[i]->name, i + 1 < p->len ? WHITE " -> " RESET : "\n");
+    fflush(stdout);
+    return 0;
+}
+
+static void run_routes(char *text, int all) {
+    const char *usage = all ? "allpaths <source> : <target>[ : max hops]" : "routes <source> : <target>[ : k]";
+    char *tname = strchr(text, ':');
+    if (!tname) { printf(RED "✖ Usage: %s\n" RESET, usage); return; }
+    *tname++ = '\0';
+    char *num = strchr(tname, ':');
+    if (num) *num++ = '\0';
+    long limit = num ? atol(num) : (all ? ALLPATHS_HOPS : ROUTES_DEFAULT);
+    if (limit <= 0) { printf(RED "✖ Usage: %s\n" RESET, usage); return; }
+    kg_trim(text); kg_squeeze_spaces(text);
+    kg_trim(tname); kg_squeeze_spaces(tname);
+    kg_entity_t *src = search_entity_smart(text);
+    if (!src) { printf(RED "✖ Source not found.\n" RESET); return; }
+    kg_entity_t *tgt = search_entity_smart(tname);
+    if (!tgt) { printf(RED "✖ Target not found.\n" RESET); return; }
+
+    route_printer_t rp = { 0, kg_graph_weighted(gGraph) };
+    printf(GREEN "\n🧭 %s from \"%s\" to \"%s\":\n" RESET,
+           all ? "Simple paths" : (rp.weighted ? "Cheapest routes" : "Shortest routes"), src->name, tgt->name);
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = all ? kg_simple_paths(gGraph, src, tgt, NULL, (unsigned)limit, QUERY_MAX, print_route, &rp, NULL)
+                         : kg_k_shortest_paths(gGraph, src, tgt, NULL, (size_t)limit, rp.weighted, print_route, &rp, NULL);
+    kg_metrics_record(&gMetrics, KG_OP_PATH, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st == KG_ERR_NO_PATH) printf(YELLOW "  (none%s)\n" RESET, all ? " within that many hops" : "");
+    else if (all && rp.n == QUERY_MAX) printf(YELLOW "  (first %d only)\n" RESET, QUERY_MAX);
+}
+
+/*
+   [SECTION] Relatedness ("related ...")
+   - Any chain of relations, either direction, from the union-find the
+     library keeps up to date on every insert.
+ */
+static void run_related(char *text) {
+    char *bname = strchr(text, ':');
+    if (!bname) { printf(RED "✖ Usage: related <a> : <b>\n" RESET); return; }
+    *bname++ = '\0';
+    kg_trim(text); kg_squeeze_spaces(text);
+    kg_trim(bname); kg_squeeze_spaces(bname);
+    kg_entity_t *a = search_entity_smart(text);
+    if (!a) { printf(RED "✖ First entity not found.\n" RESET); return; }
+    kg_entity_t *b = search_entity_smart(bname);
+    if (!b) { printf(RED "✖ Second entity not found.\n" RESET); return; }
+
+    unsigned long t0 = kg_now_ns();
+    int linked = kg_connected(gGraph, a, b);
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, 1);
+    if (linked)
+        printf(GREEN "\n✔ \"%s\" and \"%s\" are related (same group of %zu entities).\n" RESET,
+               a->name, b->name, kg_component_size(gGraph, a));
+    else
+        printf(YELLOW "\n✖ \"%s\" and \"%s\" are not related: no chain of relations links them.\n" RESET,
+               a->name, b->name);
+}
+
+/*
+   [SECTION] Cyclic Clusters ("cycles ...")
+   - Strongly connected components with more than one entity (or an
+     entity that relates to itself), over the listed relations or all of
+     them; the latter reuse the reachability index while it is current.
+ */
+static void run_cycles(char *labels) {
+    kg_label_filter_t filter, *f = NULL;
+    kg_trim(labels);
+    if (labels[0]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, labels, bad, sizeof(bad));
+        die_on_nomem(fst);
+        if (fst != KG_OK) { printf(RED "✖ Unknown relationship \"%s\".\n" RESET, bad); return; }
+        f = &filter;
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_scc_t *own = NULL;
+    const kg_scc_t *c = !f && gReach && kg_reach_is_current(gReach) ? gReach->scc : NULL;
+    kg_status_t st = KG_OK;
+    if (!c) {
+        kg_snapshot_t s;
+        st = kg_snapshot_acquire(gGraph, &s);
+        if (st == KG_OK) {
+            st = kg_scc_build(&s, f, &own);
+            kg_snapshot_release(&s);
         }
-        gHash[i] = NULL;
+        c = own;
+    }
+    unsigned *ids = NULL;
+    size_t n = 0;
+    if (st == KG_OK) st = kg_scc_cycles(c, &ids, &n);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (f) kg_label_filter_free(f);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); kg_scc_free(own); return; }
+
+    if (n == 0) printf(GREEN "\n✔ No cycles%s%s.\n" RESET, f ? " along " : "", f ? labels : "");
+    else printf(GREEN "\n🔁 %zu cyclic cluster%s%s%s%s:\n" RESET, n, n == 1 ? "" : "s", f ? " along " : "",
+                f ? labels : "", n > QUERY_MAX ? " (largest ones only)" : "");
+    for (size_t i = 0; i < n && i < QUERY_MAX; ++i) {
+        size_t size = kg_scc_size(c, ids[i]);
+        const unsigned *m = c->members + c->member_row[ids[i]];
+        printf(WHITE "  %2zu. (%zu) " RESET, i + 1, size);
+        for (size_t k = 0; k < size; ++k)
+            printf(CYAN "%s" RESET "%s", kg_entity_at(gGraph, m[k])->name, k + 1 < size ? ", " : "\n");
+    }
+    free(ids);
+    kg_scc_free(own);
+}
+
+/*
+   [SECTION] Ego Network ("ego ...")
+   - "entity[ : hops[ : out|in|both[ : file]]]"; a file ending in .dot
+     gets GraphViz, any other a relations file "5" can load.
+ */
+static void run_ego(char *text) {
+    const char *usage = "ego <entity>[ : hops[ : out|in|both[ : <file>]]]";
+    char *field[3] = { NULL, NULL, NULL };
+    char *p = text;
+    for (int i = 0; i < 3 && (p = strchr(p, ':')) != NULL; ++i) { *p++ = '\0'; field[i] = p; }
+    kg_ego_opts_t o;
+    kg_ego_defaults(&o);
+    o.hops = EGO_HOPS;
+    o.max_nodes = QUERY_MAX;
+    if (field[0]) {
+        char *end;
+        long hops = strtol(field[0], &end, 10);
+        if (end == field[0] || hops < 0) { printf(RED "✖ Usage: %s\n" RESET, usage); return; }
+        o.hops = (unsigned)hops;
+    }
+    if (field[1]) {
+        kg_trim(field[1]);
+        if (kg_ci_cmp(field[1], "out") == 0) o.dir = KG_EGO_OUT;
+        else if (kg_ci_cmp(field[1], "in") == 0) o.dir = KG_EGO_IN;
+        else if (kg_ci_cmp(field[1], "both") == 0) o.dir = KG_EGO_BOTH;
+        else { printf(RED "✖ Usage: %s\n" RESET, usage); return; }
+    }
+    if (field[2]) {
+        kg_trim(field[2]);
+        if (!*field[2]) { printf(RED "✖ Usage: %s\n" RESET, usage); return; }
+        o.max_nodes = 0;         /* the file gets all of it */
+    }
+    kg_trim(text); kg_squeeze_spaces(text);
+    kg_entity_t *center = search_entity_smart(text);
+    if (!center) { printf(RED "✖ Entity not found.\n" RESET); return; }
+
+    kg_ego_t e;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_ego_extract(gGraph, center, &o, &e);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); return; }
+
+    printf(GREEN "\n🕸️  %zu entit%s within %u hop%s of \"%s\"%s:\n" RESET, e.n_nodes, e.n_nodes == 1 ? "y" : "ies",
+           o.hops, o.hops == 1 ? "" : "s", center->name, e.truncated ? " (nearest ones only)" : "");
+    size_t shown = e.n_nodes < QUERY_MAX ? e.n_nodes : QUERY_MAX;
+    for (size_t i = 1; i < shown; ++i) {
+        if (e.hop[i] != e.hop[i - 1]) printf(WHITE "  hop %u:" RESET, e.hop[i]);
+        printf(" " CYAN "%s" RESET "%s", e.nodes[i]->name, i + 1 < shown && e.hop[i + 1] == e.hop[i] ? "," : "\n");
+    }
+    printf(GREEN "🔗 %zu edge%s among them.\n" RESET, e.n_edges, e.n_edges == 1 ? "" : "s");
+    shown = e.n_edges < QUERY_MAX ? e.n_edges : QUERY_MAX;
+    for (size_t i = 0; i < shown; ++i)
+        printf("  " CYAN "%s" RESET " -%s-> " CYAN "%s" RESET "\n",
+               e.edges[i].src->name, e.edges[i].rel->rel, e.edges[i].rel->target->name);
+    if (shown < e.n_edges) printf(YELLOW "  (first %d only)\n" RESET, QUERY_MAX);
+
+    if (field[2]) {
+        size_t len = strlen(field[2]);
+        int dot = len >= 4 && kg_ci_cmp(field[2] + len - 4, ".dot") == 0;
+        t0 = kg_now_ns();
+        st = kg_ego_save(&e, dot ? KG_EGO_DOT : KG_EGO_RELATIONS, field[2]);
+        kg_metrics_record(&gMetrics, KG_OP_EXPORT, t0, st == KG_OK);
+        if (st == KG_OK) printf(GREEN "✔ Saved to %s\n" RESET, field[2]);
+        else printf(RED "✖ Could not write %s\n" RESET, field[2]);
+    }
+    kg_ego_free(&e);
+}
+
+/*
+   [SECTION] Dependency Order ("order ...", "prereqs ...")
+   - "<before relations> / <after relations>", blank for the defaults in
+     kg_topo.h. One index is kept for the last spec used.
+ */
+static int topo_index(char *spec) {
+    kg_trim(spec);
+    if (gTopo && kg_topo_is_current(gTopo) && strcmp(spec, gTopoSpec) == 0) return 1;
+    char bad[KG_REL_LEN];
+    kg_topo_rels_t r;
+    kg_status_t st = kg_topo_rels_parse(gGraph, spec, &r, bad, sizeof(bad));
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ Unknown relationship \"%s\".\n" RESET, bad); return 0; }
+    kg_snapshot_t s;
+    kg_topo_t *fresh = NULL;
+    st = kg_snapshot_acquire(gGraph, &s);
+    if (st == KG_OK) {
+        st = kg_topo_build(&s, &r, &fresh);
+        kg_snapshot_release(&s);
+    }
+    kg_topo_rels_free(&r);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); return 0; }
+    kg_topo_free(gTopo);
+    gTopo = fresh;
+    snprintf(gTopoSpec, sizeof(gTopoSpec), "%s", spec);
+    return 1;
+}
+
+static void print_ids(const unsigned *ids, size_t n) {
+    for (size_t i = 0; i < n && i < QUERY_MAX; ++i)
+        printf(WHITE "  %3zu. " RESET CYAN "%s\n" RESET, i + 1, kg_entity_at(gGraph, ids[i])->name);
+    if (n > QUERY_MAX) printf(YELLOW "  (first %d only)\n" RESET, QUERY_MAX);
+}
+
+static void run_order(char *spec) {
+    unsigned long t0 = kg_now_ns();
+    int ok = topo_index(spec);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, ok);
+    if (!ok) return;
+    const kg_topo_t *t = gTopo;
+    if (t->n_involved == 0) { printf(YELLOW "\n⚠ No entity has such a relation.\n" RESET); return; }
+    printf(GREEN "\n📚 %zu of %zu entities in learning order:\n" RESET, t->n_ordered, t->n_involved);
+    print_ids(t->order, t->n_ordered);
+    if (t->n_cycles == 0) return;
+    printf(YELLOW "⚠ %zu more wait on %zu cycle%s:\n" RESET, t->n_involved - t->n_ordered,
+           t->n_cycles, t->n_cycles == 1 ? "" : "s");
+    for (size_t k = 0; k < t->n_cycles && k < QUERY_MAX; ++k) {
+        printf("  ");
+        for (size_t i = t->cycle_row[k]; i < t->cycle_row[k + 1]; ++i)
+            printf(CYAN "%s" RESET " -> ", kg_entity_at(gGraph, t->cycle[i])->name);
+        printf(CYAN "%s\n" RESET, kg_entity_at(gGraph, t->cycle[t->cycle_row[k]])->name);
     }
 }
 
-/* 
+static void run_prereqs(char *text) {
+    char none[1] = "";
+    char *spec = strchr(text, ':');
+    if (spec) *spec++ = '\0';
+    else spec = none;
+    kg_trim(text); kg_squeeze_spaces(text);
+    kg_entity_t *x = search_entity_smart(text);
+    if (!x) { printf(RED "✖ Entity not found.\n" RESET); return; }
+
+    unsigned long t0 = kg_now_ns();
+    if (!topo_index(spec)) { kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, 0); return; }
+    unsigned *ids = NULL;
+    size_t n = 0;
+    kg_status_t st = kg_topo_prerequisites(gTopo, x, &ids, &n);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); return; }
+
+    if (n == 0) printf(GREEN "\n✔ \"%s\" needs nothing first.\n" RESET, x->name);
+    else printf(GREEN "\n📚 \"%s\" needs %zu entit%s first, in this order:\n" RESET, x->name, n, n == 1 ? "y" : "ies");
+    print_ids(ids, n);
+    if (kg_topo_blocked(gTopo, x))
+        printf(YELLOW "⚠ Some of these depend on each other in a circle (see \"order\").\n" RESET);
+    free(ids);
+}
+
+/*
+   [SECTION] Importance ("rank ...")
+   - Without entities: PageRank over every relation, stored in the graph
+     so suggestions and connections list important entities first.
+   - With entities: personalized PageRank from them, printed only.
+ */
+static void run_rank(char *text) {
+    unsigned seeds[RANK_SEEDS];
+    size_t n_seeds = 0;
+    kg_trim(text);
+    for (char *p = text; *p; ) {
+        char *next = strchr(p, ':');
+        if (next) *next++ = '\0';
+        kg_trim(p); kg_squeeze_spaces(p);
+        if (n_seeds == RANK_SEEDS) { printf(RED "✖ At most %d entities.\n" RESET, RANK_SEEDS); return; }
+        kg_entity_t *e = search_entity_smart(p);
+        if (!e) { printf(RED "✖ Entity \"%s\" not found.\n" RESET, p); return; }
+        seeds[n_seeds++] = e->id;
+        if (!next) break;
+        p = next;
+    }
+
+    kg_rank_opts_t o;
+    kg_rank_defaults(&o);
+    o.seeds = seeds;
+    o.n_seeds = n_seeds;
+    kg_snapshot_t s;
+    kg_rank_t *r = NULL;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_snapshot_acquire(gGraph, &s);
+    if (st == KG_OK) {
+        st = kg_pagerank(&s, &o, &r);
+        kg_snapshot_release(&s);
+    }
+    unsigned *ids = NULL;
+    size_t n = 0;
+    if (st == KG_OK) st = kg_rank_top(r, RANK_TOP, seeds, n_seeds, &ids, &n);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); kg_rank_free(r); return; }
+    double ms = (double)(kg_now_ns() - t0) / 1e6;
+
+    if (!n_seeds) {
+        kg_set_scores(gGraph, r->score, r->n, r->version);
+        printf(GREEN "\n⭐ PageRank of %zu entities (%u iterations%s, %u thread%s, %.1f ms); most important:\n" RESET,
+               r->n, r->iterations, r->converged ? "" : ", not converged", r->threads, r->threads == 1 ? "" : "s", ms);
+    } else {
+        printf(GREEN "\n⭐ Most important from %s%s (%u iterations, %.1f ms):\n" RESET,
+               kg_entity_at(gGraph, seeds[0])->name, n_seeds > 1 ? " and the others" : "", r->iterations, ms);
+    }
+    for (size_t i = 0; i < n; ++i)
+        printf(WHITE "  %2zu. " RESET CYAN "%-32s" RESET " %.5f\n", i + 1, kg_entity_at(gGraph, ids[i])->name, r->score[ids[i]]);
+    if (!n) printf(YELLOW "  (nothing reachable)\n" RESET);
+    if (!n_seeds) printf(WHITE "Suggestions and connections now list important entities first.\n" RESET);
+    free(ids);
+    kg_rank_free(r);
+}
+
+/*
+   [SECTION] Bridging Concepts ("bridges ...")
+   - Brandes betweenness and harmonic closeness from the same BFS runs,
+     over every entity up to BRIDGES_SAMPLES, from that many random ones
+     beyond (or as many as asked for).
+ */
+static void print_central(const char *title, const double *score, size_t n_scores) {
+    unsigned *ids = NULL;
+    size_t n = 0;
+    die_on_nomem(kg_top_scores(score, n_scores, RANK_TOP, NULL, 0, &ids, &n));
+    printf(MAGENTA "  %s\n" RESET, title);
+    for (size_t i = 0; i < n; ++i)
+        printf(WHITE "  %2zu. " RESET CYAN "%-32s" RESET " %.5f\n", i + 1, kg_entity_at(gGraph, ids[i])->name, score[ids[i]]);
+    if (!n) printf(YELLOW "   (none)\n" RESET);
+    free(ids);
+}
+
+static void run_bridges(char *text) {
+    kg_central_opts_t o;
+    kg_central_defaults(&o);
+    o.samples = BRIDGES_SAMPLES;
+    kg_trim(text);
+    if (text[0]) {
+        char *end;
+        long k = strtol(text, &end, 10);
+        if (end == text || *end || k < 1) { printf(RED "✖ Usage: bridges[ <samples>]\n" RESET); return; }
+        o.samples = (size_t)k;
+    }
+    kg_snapshot_t s;
+    kg_central_t *c = NULL;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_snapshot_acquire(gGraph, &s);
+    if (st == KG_OK) {
+        st = kg_centrality(&s, &o, &c);
+        kg_snapshot_release(&s);
+    }
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    die_on_nomem(st);
+    if (st != KG_OK) { printf(RED "✖ %s\n" RESET, kg_strerror(st)); return; }
+
+    double ms = (double)(kg_now_ns() - t0) / 1e6;
+    if (c->exact)
+        printf(GREEN "\n🌉 Exact, from all %zu entities (%u thread%s, %.1f ms):\n" RESET,
+               c->sources, c->threads, c->threads == 1 ? "" : "s", ms);
+    else
+        printf(GREEN "\n🌉 Estimated from %zu of %zu entities, each score within ±%.4f with %.0f%% confidence (%u thread%s, %.1f ms):\n" RESET,
+               c->sources, c->n_visible, c->error, 100.0 * (1.0 - c->delta), c->threads, c->threads == 1 ? "" : "s", ms);
+    print_central("Bridges (share of shortest paths through them):", c->betweenness, c->n);
+    print_central("Central (reached fastest from everything else):", c->closeness, c->n);
+    kg_central_free(c);
+}
+
+/*
+   [SECTION] Metrics ("stats")
+ */
+static void show_stats(void) {
+    printf(BLUE "\n═══════════════════════════════════════════\n" RESET);
+    printf(MAGENTA "  📊 COMMAND LATENCY & GRAPH COUNTERS\n" RESET);
+    printf(BLUE "═══════════════════════════════════════════\n" RESET);
+    kg_metrics_report(&gMetrics, gGraph, stdout);
+    const kg_path_cache_stats_t *pc = &gPathCache->stats;
+    printf("path cache %zu/%zu entries, hits %lu, misses %lu (%lu stale), evictions %lu, hit rate %.1f%%\n",
+           gPathCache->used, gPathCache->cap, pc->hits, pc->misses, pc->stale, pc->evictions,
+           100.0 * kg_path_cache_hit_rate(gPathCache));
+    printf("\n");
+    die_on_nomem(kg_metrics_relations(gGraph, STATS_RELATIONS, stdout));
+    printf(WHITE "\n(kill -USR1 %ld writes Prometheus text to %s)\n" RESET, (long)getpid(), METRICS_FILE);
+}
+
+static void show_memory(void) {
+    printf(BLUE "\n═══════════════════════════════════════════\n" RESET);
+    printf(MAGENTA "  🧮 MEMORY BY SUBSYSTEM\n" RESET);
+    printf(BLUE "═══════════════════════════════════════════\n" RESET);
+    die_on_nomem(kg_metrics_memory(gGraph, stdout));
+}
+
+/*
+   [SECTION] Menu Actions
+   - Returns 0 when the user chose Exit.
+ */
+static int run_choice(int choice) {
+    char buf[LINE_BUF];
+
+    if (choice == 1) { /* Add Entity (manual) */
+        printf(WHITE "Enter entity name: " RESET);
+        read_line(buf, sizeof(buf));
+        kg_trim(buf); kg_squeeze_spaces(buf);
+        if (buf[0] == '\0') { printf(YELLOW "⚠ Empty name. Skipped.\n" RESET); return 1; }
+        unsigned long t0 = kg_now_ns();
+        kg_status_t st = kg_add_entity(gGraph, buf, NULL);
+        kg_metrics_record(&gMetrics, KG_OP_ADD, t0, st == KG_OK);
+        die_on_nomem(st);
+        if (st == KG_ERR_EXISTS) {
+            printf(YELLOW "⚠ '%s' already exists.\n" RESET, buf);
+        } else {
+            printf(GREEN "✔ Entity '%s' added.\n" RESET, buf);
+        }
+    }
+    else if (choice == 2) { /* Add Relationship (manual) */
+        char s[NAME_LEN], r[REL_LEN], t[NAME_LEN];
+
+        printf(WHITE "Source entity          : " RESET); read_line(s, sizeof(s)); kg_trim(s); kg_squeeze_spaces(s);
+        printf(WHITE "Relationship (label)   : " RESET); read_line(r, sizeof(r)); kg_trim(r); kg_squeeze_spaces(r);
+        printf(WHITE "Target entity          : " RESET); read_line(t, sizeof(t)); kg_trim(t); kg_squeeze_spaces(t);
+        printf(WHITE "Cost (Enter = 1)       : " RESET); read_line(buf, sizeof(buf)); kg_trim(buf);
+
+        if (s[0] == '\0' || r[0] == '\0' || t[0] == '\0') {
+            printf(RED "✖ Invalid input. All fields are required.\n" RESET);
+            return 1;
+        }
+        char *end;
+        double w = buf[0] ? strtod(buf, &end) : 1.0;
+        if (buf[0] && (*end != '\0' || !(w >= 0.0))) {
+            printf(RED "✖ Cost must be a non-negative number.\n" RESET);
+            return 1;
+        }
+        add_relationship(s, r, t, w);
+    }
+    else if (choice == 3) { /* Display Connections (fuzzy) */
+        printf(WHITE "Enter entity to view: " RESET);
+        read_line(buf, sizeof(buf));
+        display_connections(buf, /*fuzzy*/1);
+    }
+    else if (choice == 4) { /* Find Path (BFS + fuzzy) */
+        char s[NAME_LEN], t[NAME_LEN];
+        printf(WHITE "Enter source entity: " RESET); read_line(s, sizeof(s));
+        printf(WHITE "Enter target entity: " RESET); read_line(t, sizeof(t));
+        printf(WHITE "Relations to follow (Enter = all, \"!a,b\" = all but): " RESET); read_line(buf, sizeof(buf));
+        find_path_bfs(s, t, buf, /*fuzzy*/1);
+    }
+    else if (choice == 5) { /* Load from File */
+        printf(WHITE "Enter filename (Enter for default: %s): " RESET, DEFAULT_DATA_FILE);
+        read_line(buf, sizeof(buf));
+        if (buf[0] == '\0') strcpy(buf, DEFAULT_DATA_FILE);
+        load_from_file(buf);
+    }
+    else if (choice == 6) { /* Batch Input (N lines) */
+        printf(WHITE "How many lines (src|rel|tgt)? " RESET);
+        read_line(buf, sizeof(buf));
+        int n = atoi(buf);
+        if (n <= 0) { printf(YELLOW "⚠ Nothing to do.\n" RESET); return 1; }
+        batch_input_lines(n);
+    }
+    else if (choice == 7) { /* Save to File */
+        printf(WHITE "Enter filename (Enter for default: %s): " RESET, DEFAULT_DATA_FILE);
+        read_line(buf, sizeof(buf));
+        if (buf[0] == '\0') strcpy(buf, DEFAULT_DATA_FILE);
+        save_to_file(buf);
+    }
+    else if (choice == 8) { /* Export to DOT */
+        printf(WHITE "Enter DOT filename (Enter for default: %s): " RESET, DEFAULT_DOT_FILE);
+        read_line(buf, sizeof(buf));
+        if (buf[0] == '\0') strcpy(buf, DEFAULT_DOT_FILE);
+        export_dot(buf);
+    }
+    else if (choice == 9) { /* Exit */
+        printf(MAGENTA "\n🚀 Exiting Knowledge Graph Engine... Goodbye!\n" RESET);
+        return 0;
+    }
+    else {
+        printf(RED "Invalid choice. Please try again.\n" RESET);
+    }
+    return 1;
+}
+
+/*
+   [SECTION] EXPLAIN / profile
+   - "explain 4" (or "profile 4") runs menu option 4 with a query profile
+     installed, then prints where the time went. Time spent waiting for
+     the user (prompts, suggestion picks) shows up as "outside the library".
+ */
+static int is_explain_prefix(const char *buf) {
+    char word[8];
+    kg_to_lower_copy(buf, word, sizeof(word));
+    return (strncmp(word, "explain", 7) == 0 || strncmp(word, "profile", 7) == 0) &&
+           (buf[7] == ' ' || buf[7] == '\0');
+}
+
+static void explain_choice(int choice) {
+    if (choice < 1 || choice > 8) { printf(YELLOW "⚠ Usage: explain <menu option 1-8>\n" RESET); return; }
+    kg_profile_t prof;
+    kg_profile_begin(&prof);
+    unsigned long t0 = kg_now_ns();
+    run_choice(choice);
+    unsigned long total = kg_now_ns() - t0;
+    kg_profile_end();
+
+    printf(BLUE "\n═══════════════════════════════════════════\n" RESET);
+    printf(MAGENTA "  🔬 EXPLAIN (option %d)\n" RESET, choice);
+    printf(BLUE "═══════════════════════════════════════════\n" RESET);
+    kg_metrics_explain(&prof, total, stdout);
+}
+
+/*
    [SECTION] Main Program Loop (UI, Navigation)
  */
 int main(void) {
+    gGraph = kg_graph_new();
+    if (!gGraph || kg_path_cache_new(0, &gPathCache) != KG_OK) { printf(RED "Memory allocation failed\n" RESET); return 1; }
+    kg_metrics_dump_on_signal(&gMetrics, gGraph, METRICS_FILE, SIGUSR1);
+
     banner();
 
     char buf[LINE_BUF];
-    int choice;
 
     for (;;) {
         menu();
         read_line(buf, sizeof(buf));
-        choice = atoi(buf);
-
-        if (choice == 1) { /* Add Entity (manual) */
-            printf(WHITE "Enter entity name: " RESET);
-            read_line(buf, sizeof(buf));
-            trim(buf); squeeze_spaces(buf);
-            if (buf[0] == '\0') { printf(YELLOW "⚠ Empty name. Skipped.\n" RESET); continue; }
-            if (find_entity_exact(buf)) {
-                printf(YELLOW "⚠ '%s' already exists.\n" RESET, buf);
-            } else {
-                create_entity(buf);
-                printf(GREEN "✔ Entity '%s' added.\n" RESET, buf);
-            }
-        }
-        else if (choice == 2) { /* Add Relationship (manual) */
-            char s[NAME_LEN], r[REL_LEN], t[NAME_LEN];
-
-            printf(WHITE "Source entity          : " RESET); read_line(s, sizeof(s)); trim(s); squeeze_spaces(s);
-            printf(WHITE "Relationship (label)   : " RESET); read_line(r, sizeof(r)); trim(r); squeeze_spaces(r);
-            printf(WHITE "Target entity          : " RESET); read_line(t, sizeof(t)); trim(t); squeeze_spaces(t);
-
-            if (s[0] == '\0' || r[0] == '\0' || t[0] == '\0') {
-                printf(RED "✖ Invalid input. All fields are required.\n" RESET);
-                continue;
-            }
-            add_relationship(s, r, t);
-        }
-        else if (choice == 3) { /* Display Connections (fuzzy) */
-            printf(WHITE "Enter entity to view: " RESET);
-            read_line(buf, sizeof(buf));
-            display_connections(buf, /*fuzzy*/1);
-        }
-        else if (choice == 4) { /* Find Path (BFS + fuzzy) */
-            char s[NAME_LEN], t[NAME_LEN];
-            printf(WHITE "Enter source entity: " RESET); read_line(s, sizeof(s));
-            printf(WHITE "Enter target entity: " RESET); read_line(t, sizeof(t));
-            find_path_bfs(s, t, /*fuzzy*/1);
-        }
-        else if (choice == 5) { /* Load from File */
-            printf(WHITE "Enter filename (Enter for default: %s): " RESET, DEFAULT_DATA_FILE);
-            read_line(buf, sizeof(buf));
-            if (buf[0] == '\0') strcpy(buf, DEFAULT_DATA_FILE);
-            load_from_file(buf);
-        }
-        else if (choice == 6) { /* Batch Input (N lines) */
-            printf(WHITE "How many lines (src|rel|tgt)? " RESET);
-            read_line(buf, sizeof(buf));
-            int n = atoi(buf);
-            if (n <= 0) { printf(YELLOW "⚠ Nothing to do.\n" RESET); continue; }
-            batch_input_lines(n);
-        }
-        else if (choice == 7) { /* Save to File */
-            printf(WHITE "Enter filename (Enter for default: %s): " RESET, DEFAULT_DATA_FILE);
-            read_line(buf, sizeof(buf));
-            if (buf[0] == '\0') strcpy(buf, DEFAULT_DATA_FILE);
-            save_to_file(buf);
-        }
-        else if (choice == 8) { /* Export to DOT */
-            printf(WHITE "Enter DOT filename (Enter for default: %s): " RESET, DEFAULT_DOT_FILE);
-            read_line(buf, sizeof(buf));
-            if (buf[0] == '\0') strcpy(buf, DEFAULT_DOT_FILE);
-            export_dot(buf);
-        }
-        else if (choice == 9) { /* Exit */
-            printf(MAGENTA "\n🚀 Exiting Knowledge Graph Engine... Goodbye!\n" RESET);
-            free_graph();
-            break;
-        }
-        else {
-            printf(RED "Invalid choice. Please try again.\n" RESET);
-        }
+        kg_trim(buf);
+        if (kg_ci_cmp(buf, "stats") == 0) { show_stats(); continue; }
+        if (kg_ci_cmp(buf, "memory") == 0) { show_memory(); continue; }
+        if (is_explain_prefix(buf) && strncmp(buf + 8, "query ", 6) == 0) { run_query(buf + 14, 1); continue; }
+        if (is_explain_prefix(buf)) { explain_choice(atoi(buf + 7)); continue; }
+        if (strncmp(buf, "query", 5) == 0 && (buf[5] == ' ' || buf[5] == '\t')) { run_query(buf + 6, 0); continue; }
+        if (strncmp(buf, "rpq", 3) == 0 && (buf[3] == ' ' || buf[3] == '\t')) { run_rpq(buf + 4); continue; }
+        if (strncmp(buf, "routes", 6) == 0 && (buf[6] == ' ' || buf[6] == '\t')) { run_routes(buf + 7, 0); continue; }
+        if (strncmp(buf, "allpaths", 8) == 0 && (buf[8] == ' ' || buf[8] == '\t')) { run_routes(buf + 9, 1); continue; }
+        if (strncmp(buf, "related", 7) == 0 && (buf[7] == ' ' || buf[7] == '\t')) { run_related(buf + 8); continue; }
+        if (kg_ci_cmp(buf, "cycles") == 0) { run_cycles(buf + 6); continue; }
+        if (strncmp(buf, "cycles", 6) == 0 && (buf[6] == ' ' || buf[6] == '\t')) { run_cycles(buf + 7); continue; }
+        if (strncmp(buf, "ego", 3) == 0 && (buf[3] == ' ' || buf[3] == '\t')) { run_ego(buf + 4); continue; }
+        if (kg_ci_cmp(buf, "order") == 0) { run_order(buf + 5); continue; }
+        if (strncmp(buf, "order", 5) == 0 && (buf[5] == ' ' || buf[5] == '\t')) { run_order(buf + 6); continue; }
+        if (strncmp(buf, "prereqs", 7) == 0 && (buf[7] == ' ' || buf[7] == '\t')) { run_prereqs(buf + 8); continue; }
+        if (kg_ci_cmp(buf, "rank") == 0) { run_rank(buf + 4); continue; }
+        if (strncmp(buf, "rank", 4) == 0 && (buf[4] == ' ' || buf[4] == '\t')) { run_rank(buf + 5); continue; }
+        if (kg_ci_cmp(buf, "bridges") == 0) { run_bridges(buf + 7); continue; }
+        if (strncmp(buf, "bridges", 7) == 0 && (buf[7] == ' ' || buf[7] == '\t')) { run_bridges(buf + 8); continue; }
+        if (!run_choice(atoi(buf))) break;
     }
+    kg_reach_free(gReach);
+    kg_path_cache_free(gPathCache);
+    kg_triples_free(gTriples);
+    kg_topo_free(gTopo);
+    kg_graph_free(gGraph);
     return 0;
 }
@@ -0,0 +1,296 @@
+/* =========================================================================
+   Knowledge Graph Engine — ALT Landmark Index (implementation)
+   ========================================================================= */
+
+#include "kg_alt.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+   [SECTION] Flat Adjacency
+   - Forward and reverse arrays of one snapshot, with weights, only for
+     the duration of the build (2k searches would otherwise chase lists).
+ */
+typedef struct adj {
+    size_t *row;
+    unsigned *nb;
+    float *w;
+} adj_t;
+
+static void adj_free(adj_t *a) { free(a->row); free(a->nb); free(a->w); }
+
+static kg_status_t adj_build(const kg_snapshot_t *s, size_t n, size_t m, adj_t *fw, adj_t *rv) {
+    fw->row = (size_t*)calloc(n + 1, sizeof(size_t));
+    rv->row = (size_t*)calloc(n + 1, sizeof(size_t));
+    fw->nb = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    rv->nb = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    fw->w = (float*)malloc((m ? m : 1) * sizeof(float));
+    rv->w = (float*)malloc((m ? m : 1) * sizeof(float));
+    if (!fw->row || !rv->row || !fw->nb || !rv->nb || !fw->w || !rv->w) return KG_ERR_NOMEM;
+
+    size_t k = 0;
+    for (size_t v = 0; v < n; ++v) {
+        fw->row[v] = k;
+        kg_entity_t *e = kg_entity_at(s->g, v);
+        if (!kg_visible(s, e)) continue;
+        for (kg_relation_t *r = kg_snapshot_relations(s, e); r && k < m; r = r->next, ++k) {
+            fw->nb[k] = r->target->id;
+            fw->w[k] = r->weight;
+            rv->row[r->target->id + 1]++;
+        }
+    }
+    fw->row[n] = k;
+    for (size_t v = 0; v < n; ++v) rv->row[v + 1] += rv->row[v];
+    size_t *pos = (size_t*)malloc((n + 1) * sizeof(size_t));
+    if (!pos) return KG_ERR_NOMEM;
+    memcpy(pos, rv->row, (n + 1) * sizeof(size_t));
+    for (size_t v = 0; v < n; ++v)
+        for (size_t j = fw->row[v]; j < fw->row[v + 1]; ++j) {
+            size_t d = pos[fw->nb[j]]++;
+            rv->nb[d] = (unsigned)v;
+            rv->w[d] = fw->w[j];
+        }
+    free(pos);
+    return KG_OK;
+}
+
+/*
+   [SECTION] Single-Source Distances
+   - BFS when every weight is 1, else Dijkstra on a binary heap with lazy
+     deletion. Results go to column i of a node-major table.
+ */
+typedef struct hitem { double key; unsigned v; } hitem_t;
+
+typedef struct sssp_scratch {
+    double *dist;
+    unsigned *queue;
+    hitem_t *heap;
+    size_t cap;
+} sssp_scratch_t;
+
+static int heap_push(sssp_scratch_t *sc, size_t *n, double key, unsigned v) {
+    if (*n == sc->cap) {
+        size_t cap = sc->cap ? sc->cap * 2 : 1024;
+        hitem_t *h = (hitem_t*)realloc(sc->heap, cap * sizeof(hitem_t));
+        if (!h) return 0;
+        sc->heap = h; sc->cap = cap;
+    }
+    hitem_t *h = sc->heap;
+    size_t i = (*n)++;
+    while (i > 0 && h[(i - 1) / 2].key > key) { h[i] = h[(i - 1) / 2]; i = (i - 1) / 2; }
+    h[i].key = key; h[i].v = v;
+    return 1;
+}
+
+static hitem_t heap_pop(sssp_scratch_t *sc, size_t *n) {
+    hitem_t *h = sc->heap, top = h[0], last = h[--*n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *n) break;
+        if (c + 1 < *n && h[c + 1].key < h[c].key) c++;
+        if (h[c].key >= last.key) break;
+        h[i] = h[c]; i = c;
+    }
+    if (*n) h[i] = last;
+    return top;
+}
+
+static kg_status_t sssp(const adj_t *a, size_t n, unsigned src, int weighted,
+                        sssp_scratch_t *sc, float *table, unsigned k, unsigned col) {
+    double *d = sc->dist;
+    for (size_t v = 0; v < n; ++v) d[v] = INFINITY;
+    d[src] = 0.0;
+    if (!weighted) {
+        size_t head = 0, tail = 0;
+        sc->queue[tail++] = src;
+        while (head < tail) {
+            unsigned cur = sc->queue[head++];
+            for (size_t j = a->row[cur]; j < a->row[cur + 1]; ++j) {
+                unsigned nx = a->nb[j];
+                if (d[nx] == INFINITY) { d[nx] = d[cur] + 1.0; sc->queue[tail++] = nx; }
+            }
+        }
+    } else {
+        size_t hn = 0;
+        if (!heap_push(sc, &hn, 0.0, src)) return KG_ERR_NOMEM;
+        while (hn) {
+            hitem_t it = heap_pop(sc, &hn);
+            if (it.key > d[it.v]) continue;
+            for (size_t j = a->row[it.v]; j < a->row[it.v + 1]; ++j) {
+                unsigned nx = a->nb[j];
+                double nd = it.key + (double)a->w[j];
+                if (nd < d[nx]) {
+                    d[nx] = nd;
+                    if (!heap_push(sc, &hn, nd, nx)) return KG_ERR_NOMEM;
+                }
+            }
+        }
+    }
+    for (size_t v = 0; v < n; ++v) table[v * k + col] = (float)d[v];
+    return KG_OK;
+}
+
+/* [SECTION] Build */
+
+void kg_alt_free(kg_alt_t *a) {
+    if (!a) return;
+    free(a->landmarks); free(a->to); free(a->from);
+    free(a);
+}
+
+size_t kg_alt_bytes(const kg_alt_t *a) {
+    return sizeof(*a) + a->k * sizeof(unsigned) + 2 * a->n * a->k * sizeof(float);
+}
+
+static size_t degree_of(const adj_t *fw, const adj_t *rv, size_t v) {
+    return (fw->row[v + 1] - fw->row[v]) + (rv->row[v + 1] - rv->row[v]);
+}
+
+static int is_landmark(const kg_alt_t *a, unsigned chosen, size_t v) {
+    for (unsigned i = 0; i < chosen; ++i) if (a->landmarks[i] == v) return 1;
+    return 0;
+}
+
+kg_status_t kg_alt_build(const kg_snapshot_t *s, unsigned k, kg_alt_select_t sel, kg_alt_t **out) {
+    *out = NULL;
+    if (k == 0 || k > KG_ALT_MAX_LANDMARKS) return KG_ERR_INVALID;
+    size_t n = s->n_entities;
+    if (k > n) k = (unsigned)n;
+
+    kg_alt_t *a = (kg_alt_t*)calloc(1, sizeof(kg_alt_t));
+    if (!a) return KG_ERR_NOMEM;
+    a->g = s->g;
+    a->version = s->version;
+    a->n = n;
+    a->k = k;
+    adj_t fw = { 0 }, rv = { 0 };
+    sssp_scratch_t sc = { 0 };
+    double *spread = NULL;
+    kg_status_t st = KG_ERR_NOMEM;
+
+    a->landmarks = (unsigned*)malloc((k ? k : 1) * sizeof(unsigned));
+    a->to = (float*)malloc(((n && k) ? n * k : 1) * sizeof(float));
+    a->from = (float*)malloc(((n && k) ? n * k : 1) * sizeof(float));
+    sc.dist = (double*)malloc((n ? n : 1) * sizeof(double));
+    sc.queue = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    spread = (double*)malloc((n ? n : 1) * sizeof(double));
+    if (!a->landmarks || !a->to || !a->from || !sc.dist || !sc.queue || !spread) goto out;
+
+    /* Edge count as of the snapshot (kg_edge_count may already be ahead) */
+    size_t m = 0;
+    for (size_t v = 0; v < n; ++v) {
+        kg_entity_t *e = kg_entity_at(s->g, v);
+        if (kg_visible(s, e))
+            for (kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next) m++;
+    }
+    if ((st = adj_build(s, n, m, &fw, &rv)) != KG_OK) goto out;
+    int weighted = kg_graph_weighted(s->g);
+
+    for (size_t v = 0; v < n; ++v) spread[v] = INFINITY;
+    for (unsigned i = 0; i < k; ++i) {
+        /* Pick landmark i: by degree, or (farthest) the entity whose
+           nearest landmark so far is farthest away; ties and the first
+           pick go to degree. */
+        size_t best = n, best_deg = 0;
+        double best_spread = -1.0;
+        for (size_t v = 0; v < n; ++v) {
+            if (!kg_visible(s, kg_entity_at(s->g, v)) || is_landmark(a, i, v)) continue;
+            size_t deg = degree_of(&fw, &rv, v);
+            double sp = (sel == KG_ALT_FARTHEST && i > 0 && spread[v] != INFINITY) ? spread[v] : 0.0;
+            if (best == n || sp > best_spread || (sp == best_spread && deg > best_deg)) {
+                best = v; best_deg = deg; best_spread = sp;
+            }
+        }
+        if (best == n) { a->k = i; break; }
+        a->landmarks[i] = (unsigned)best;
+
+        if ((st = sssp(&fw, n, (unsigned)best, weighted, &sc, a->from, k, i)) != KG_OK) goto out;
+        if ((st = sssp(&rv, n, (unsigned)best, weighted, &sc, a->to, k, i)) != KG_OK) goto out;
+
+        for (size_t v = 0; v < n; ++v) {
+            double f = a->from[v * k + i], t = a->to[v * k + i], d;
+            if (f != INFINITY && t != INFINITY) d = f + t;
+            else if (f != INFINITY) d = f;
+            else d = t;
+            if (d < spread[v]) spread[v] = d;
+        }
+    }
+
+    /* Fewer visible entities than landmarks asked for: compact the tables
+       to the smaller stride (moving entries down never overwrites one
+       that is still to be read). */
+    if (a->k == 0) { st = KG_ERR_NOT_FOUND; goto out; }
+    if (a->k != k)
+        for (size_t v = 0; v < n; ++v)
+            for (unsigned i = 0; i < a->k; ++i) {
+                a->to[v * a->k + i] = a->to[v * k + i];
+                a->from[v * a->k + i] = a->from[v * k + i];
+            }
+    st = KG_OK;
+out:
+    adj_free(&fw); adj_free(&rv);
+    free(sc.dist); free(sc.queue); free(sc.heap); free(spread);
+    if (st != KG_OK) { kg_alt_free(a); return st; }
+    *out = a;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Bounds & A*
+ */
+static double lower_bound(const float *vt, const float *vf, const float *tt, const float *tf, unsigned k) {
+    double lo = 0.0;
+    for (unsigned i = 0; i < k; ++i) {
+        /* d(v,t) >= d(v,L) - d(t,L); v cut off from L while t is not => unreachable */
+        if (tt[i] != INFINITY) {
+            double b = (double)vt[i] - (double)tt[i];
+            if (b > lo) lo = b;
+        }
+        /* d(v,t) >= d(L,t) - d(L,v); L reaches v but not t => unreachable */
+        if (vf[i] != INFINITY) {
+            double b = (double)tf[i] - (double)vf[i];
+            if (b > lo) lo = b;
+        }
+    }
+    return lo;
+}
+
+void kg_alt_estimate(const kg_alt_t *a, const kg_entity_t *src, const kg_entity_t *tgt,
+                     double *lo, double *hi) {
+    *lo = 0.0; *hi = INFINITY;
+    if (src == tgt) { *hi = 0.0; return; }
+    if (src->id >= a->n || tgt->id >= a->n) return;
+    unsigned k = a->k;
+    const float *vt = a->to + (size_t)src->id * k, *vf = a->from + (size_t)src->id * k;
+    const float *tt = a->to + (size_t)tgt->id * k, *tf = a->from + (size_t)tgt->id * k;
+    *lo = lower_bound(vt, vf, tt, tf, k);
+    for (unsigned i = 0; i < k; ++i) {
+        double via = (double)vt[i] + (double)tf[i];
+        if (via < *hi) *hi = via;
+    }
+    if (*hi < *lo) *hi = *lo;   /* float rounding */
+}
+
+typedef struct alt_ctx {
+    const kg_alt_t *a;
+    const float *tt, *tf;        /* the target's rows, read once per query */
+} alt_ctx_t;
+
+static double alt_heuristic(void *ctx, const kg_entity_t *v, const kg_entity_t *tgt) {
+    const alt_ctx_t *c = (const alt_ctx_t*)ctx;
+    (void)tgt;
+    if (v->id >= c->a->n) return 0.0;
+    size_t off = (size_t)v->id * c->a->k;
+    return lower_bound(c->a->to + off, c->a->from + off, c->tt, c->tf, c->a->k);
+}
+
+kg_status_t kg_alt_path(const kg_alt_t *a, const kg_snapshot_t *s, const kg_entity_t *src,
+                        const kg_entity_t *tgt, const kg_label_filter_t *f, kg_path_t *out) {
+    if (s->version != a->version || tgt->id >= a->n)
+        return kg_weighted_path_at(s, src, tgt, f, NULL, NULL, out);
+    alt_ctx_t c = { a, a->to + (size_t)tgt->id * a->k, a->from + (size_t)tgt->id * a->k };
+    return kg_weighted_path_at(s, src, tgt, f, alt_heuristic, &c, out);
+}
@@ -0,0 +1,70 @@
+/* =========================================================================
+   Knowledge Graph Engine — ALT Landmark Index
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     A* with Landmarks and the Triangle inequality. For k chosen entities
+     ("landmarks") the index stores the distance from every entity to each
+     landmark and from each landmark to every entity. For any pair (v, t):
+         d(v,t) >= d(v,L) - d(t,L)      and      d(v,t) >= d(L,t) - d(L,v)
+         d(v,t) <= d(v,L) + d(L,t)
+     so a lower and an upper bound come from 2k table reads, no traversal.
+     The lower bound is an admissible A* heuristic that steers the search
+     toward the target and prunes most of what Dijkstra would settle.
+     Distances are by edge weight (hop counts when the graph has none).
+->   Cost:
+     2 * k floats per entity; building runs 2k single-source searches.
+     The index reflects the snapshot it was built from. Added edges can
+     only shorten distances, which can make a stale lower bound too high:
+     kg_alt_path() falls back to plain Dijkstra once the graph has moved
+     on, so rebuild when kg_alt_is_current() turns false.
+->   Build:
+     add kg_alt.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_ALT_H
+#define KG_ALT_H
+
+#include "kg_graph.h"
+
+#define KG_ALT_MAX_LANDMARKS 64
+
+typedef enum kg_alt_select {
+    KG_ALT_DEGREE = 0,           /* highest in + out degree */
+    KG_ALT_FARTHEST              /* greedy: each next one farthest from those chosen */
+} kg_alt_select_t;
+
+typedef struct kg_alt {
+    const kg_graph_t *g;
+    unsigned long version;       /* snapshot the index was built from */
+    size_t n;                    /* entities covered (ids 0..n-1) */
+    unsigned k;
+    unsigned *landmarks;         /* k entity ids */
+    float *to;                   /* to[v * k + i]   = d(v, landmark i), INFINITY if none */
+    float *from;                 /* from[v * k + i] = d(landmark i, v) */
+} kg_alt_t;
+
+/* KG_ERR_INVALID if k is 0 or above KG_ALT_MAX_LANDMARKS; fewer than k
+   landmarks are chosen when the snapshot has fewer entities. */
+kg_status_t kg_alt_build(const kg_snapshot_t *s, unsigned k, kg_alt_select_t sel, kg_alt_t **out);
+void kg_alt_free(kg_alt_t *a);
+
+static inline int kg_alt_is_current(const kg_alt_t *a) {
+    return a->version == kg_graph_version(a->g);
+}
+
+size_t kg_alt_bytes(const kg_alt_t *a);
+
+/* Bounds on the cost of the cheapest src -> tgt path, as of the build.
+   *lo == INFINITY proves tgt unreachable; *hi == INFINITY means no
+   landmark lies on a known route. Entities newer than the index get
+   [0, INFINITY]. */
+void kg_alt_estimate(const kg_alt_t *a, const kg_entity_t *src, const kg_entity_t *tgt,
+                     double *lo, double *hi);
+
+/* Cheapest path via A* guided by the landmark lower bound (same result
+   as kg_weighted_path_at). f may be NULL; filtering only lengthens paths,
+   so the bound stays admissible. */
+kg_status_t kg_alt_path(const kg_alt_t *a, const kg_snapshot_t *s, const kg_entity_t *src,
+                        const kg_entity_t *tgt, const kg_label_filter_t *f, kg_path_t *out);
+
+#endif /* KG_ALT_H */
@@ -0,0 +1,313 @@
+/* =========================================================================
+   Knowledge Graph Engine — End-to-End Benchmark Driver
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     For each graph size: generate a synthetic relations file, load it with
+     kg_load_file(), then time exact lookups, fuzzy searches, BFS path
+     queries and Dijkstra on the same pairs. "bfs/opt" is how much the
+     hop-count path costs, by weight, relative to the cheapest one.
+     Then builds an ALT landmark index and times A* on those pairs again
+     ("settled" = entities A* settles as a share of Dijkstra's) plus the
+     traversal-free distance estimate. Each size runs in its own child process so the reported peak
+     RSS belongs to that size alone.
+->   Build & Run:
+     gcc -O2 -pthread -o kg_bench kg_bench.c kg_synth.c kg_graph.c kg_alt.c -lm
+     ./kg_bench                                   (10K, 100K, 1M edges)
+     ./kg_bench -s 10000,1000000,10000000,100000000 -m ba
+
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "kg_synth.h"
+#include "kg_alt.h"
+
+/* [SECTION] Configuration */
+
+#define DEFAULT_SIZES     "10000,100000,1000000"
+#define DEFAULT_DEGREE    8
+#define LOOKUP_SAMPLES    100000
+#define QUERY_BUDGET_NS   3e9      /* wall time per query kind, once MIN_SAMPLES are in */
+#define MIN_SAMPLES       5
+#define MAX_SAMPLES       1000
+#define DEFAULT_MAX_WEIGHT 10.0
+#define DEFAULT_LANDMARKS 16
+
+typedef struct bench_opts {
+    kg_synth_opts_t synth;
+    unsigned degree;
+    unsigned landmarks;
+    const char *tmpdir;
+} bench_opts_t;
+
+/* [SECTION] Timing & Statistics */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double pct(double *v, size_t n, double p) {
+    if (!n) return 0;
+    return v[(size_t)(p / 100.0 * (double)(n - 1) + 0.5)];
+}
+
+/* Human-scaled duration, e.g. "812ns", "14.2us", "3.10ms", "1.25s". */
+static const char *fmt_ns(double ns, char *buf, size_t n) {
+    if (ns < 1e3) snprintf(buf, n, "%.0fns", ns);
+    else if (ns < 1e6) snprintf(buf, n, "%.1fus", ns / 1e3);
+    else if (ns < 1e9) snprintf(buf, n, "%.2fms", ns / 1e6);
+    else snprintf(buf, n, "%.2fs", ns / 1e9);
+    return buf;
+}
+
+/* Slow queries (full scans, BFS) sample until the time budget is spent. */
+static int keep_sampling(size_t done, double started_ns) {
+    if (done < MIN_SAMPLES) return 1;
+    return done < MAX_SAMPLES && now_ns() - started_ns < QUERY_BUDGET_NS;
+}
+
+/*
+   [SECTION] One Size (runs in a child process)
+ */
+static int run_size(const bench_opts_t *bo, unsigned long edges) {
+    kg_synth_opts_t so = bo->synth;
+    so.edges = edges;
+    so.nodes = edges / bo->degree;
+    if (so.nodes < 16) so.nodes = 16;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/kg_bench_XXXXXX", bo->tmpdir);
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    FILE *fp = fdopen(fd, "w");
+    double t0 = now_ns();
+    kg_status_t st = fp ? kg_synth_write(fp, &so) : KG_ERR_IO;
+    if (fp && fclose(fp) != 0 && st == KG_OK) st = KG_ERR_IO;
+    double gen_ns = now_ns() - t0;
+    if (st != KG_OK) { fprintf(stderr, "generate: %s\n", kg_strerror(st)); unlink(path); return 1; }
+
+    kg_graph_t *g = kg_graph_new();
+    kg_load_stats_t ls;
+    t0 = now_ns();
+    st = g ? kg_load_file(g, path, &ls, NULL, NULL) : KG_ERR_NOMEM;
+    double load_ns = now_ns() - t0;
+    unlink(path);
+    if (st != KG_OK) { fprintf(stderr, "load: %s\n", kg_strerror(st)); return 1; }
+
+    size_t n = kg_entity_count(g);
+    kg_rng_t r;
+    kg_rng_seed(&r, so.seed ^ edges);
+
+    /* Exact lookups of names known to exist */
+    double *lat = (double*)malloc(sizeof(double) * LOOKUP_SAMPLES);
+    if (!lat) return 1;
+    for (size_t i = 0; i < LOOKUP_SAMPLES; ++i) {
+        const char *name = kg_entity_at(g, kg_rng_below(&r, n))->name;
+        double a = now_ns();
+        kg_entity_t *e = kg_find_entity(g, name);
+        lat[i] = now_ns() - a;
+        if (!e) { fprintf(stderr, "lookup lost '%s'\n", name); return 1; }
+    }
+    qsort(lat, LOOKUP_SAMPLES, sizeof(double), cmp_double);
+    double look50 = pct(lat, LOOKUP_SAMPLES, 50), look99 = pct(lat, LOOKUP_SAMPLES, 99);
+    free(lat);
+
+    /* Fuzzy search on 3-character prefixes (a full scan per query) */
+    lat = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    if (!lat) return 1;
+    size_t ns = 0;
+    for (double started = now_ns(); keep_sampling(ns, started); ++ns) {
+        char q[4] = { 0 };
+        const char *name = kg_entity_at(g, kg_rng_below(&r, n))->name;
+        memcpy(q, name, strnlen(name, 3));
+        kg_entity_t *cand[16]; int c;
+        double a = now_ns();
+        kg_search(g, q, cand, 16, &c);
+        lat[ns] = now_ns() - a;
+    }
+    qsort(lat, ns, sizeof(double), cmp_double);
+    double srch50 = pct(lat, ns, 50), srch99 = pct(lat, ns, 99);
+    free(lat);
+
+    /* BFS and Dijkstra between the same random pairs */
+    lat = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    double *wlat = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    double *alat = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    unsigned *pairs = (unsigned*)malloc(sizeof(unsigned) * 2 * MAX_SAMPLES);
+    double *opt = (double*)malloc(sizeof(double) * MAX_SAMPLES);
+    if (!lat || !wlat || !alat || !pairs || !opt) return 1;
+    size_t np = 0, found = 0;
+    double bfs_cost = 0, opt_cost = 0;
+    unsigned long settled_dijkstra = 0, settled_astar = 0;
+    kg_snapshot_t snap;
+    kg_profile_t prof;
+    if (kg_snapshot_acquire(g, &snap) != KG_OK) return 1;
+    for (double started = now_ns(); keep_sampling(np, started); ++np) {
+        kg_entity_t *a = kg_entity_at(g, kg_rng_below(&r, n));
+        kg_entity_t *b = kg_entity_at(g, kg_rng_below(&r, n));
+        pairs[2 * np] = a->id; pairs[2 * np + 1] = b->id;
+        kg_path_t p, wp;
+        double t = now_ns();
+        kg_status_t bs = kg_shortest_path_at(&snap, a, b, &p);
+        lat[np] = now_ns() - t;
+        kg_profile_begin(&prof);
+        t = now_ns();
+        kg_status_t ws = kg_weighted_path_at(&snap, a, b, NULL, NULL, NULL, &wp);
+        wlat[np] = now_ns() - t;
+        kg_profile_end();
+        settled_dijkstra += prof.nodes_visited;
+        opt[np] = ws == KG_OK ? wp.cost : -1.0;
+        if (bs == KG_OK) {
+            found++;
+            bfs_cost += kg_path_weight(&snap, &p);
+            kg_path_free(&p);
+        }
+        if (ws == KG_OK) { opt_cost += wp.cost; kg_path_free(&wp); }
+    }
+
+    /* ALT: build once, then A* and estimates on the same pairs */
+    kg_alt_t *alt;
+    t0 = now_ns();
+    st = kg_alt_build(&snap, bo->landmarks, KG_ALT_FARTHEST, &alt);
+    double alt_ns = now_ns() - t0;
+    if (st != KG_OK) { fprintf(stderr, "alt: %s\n", kg_strerror(st)); return 1; }
+    size_t wrong = 0;
+    for (size_t i = 0; i < np; ++i) {
+        kg_entity_t *a = kg_entity_at(g, pairs[2 * i]), *b = kg_entity_at(g, pairs[2 * i + 1]);
+        kg_path_t ap;
+        kg_profile_begin(&prof);
+        double t = now_ns();
+        kg_status_t as = kg_alt_path(alt, &snap, a, b, NULL, &ap);
+        alat[i] = now_ns() - t;
+        kg_profile_end();
+        settled_astar += prof.nodes_visited;
+        double c = as == KG_OK ? ap.cost : -1.0;
+        if (c != opt[i] && (c < 0 || opt[i] < 0 || c - opt[i] > 1e-4 * opt[i])) wrong++;
+        if (as == KG_OK) kg_path_free(&ap);
+    }
+    if (wrong) fprintf(stderr, "A* disagreed with Dijkstra on %zu of %zu pairs\n", wrong, np);
+    double est_ns = now_ns();
+    double lo_sum = 0, lo, hi;
+    for (size_t rep = 0; rep < 100; ++rep)
+        for (size_t i = 0; i < np; ++i) {
+            kg_alt_estimate(alt, kg_entity_at(g, pairs[2 * i]), kg_entity_at(g, pairs[2 * i + 1]), &lo, &hi);
+            lo_sum += lo;
+        }
+    est_ns = (now_ns() - est_ns) / (100.0 * (double)np);
+    if (lo_sum < 0) return 1;   /* keeps the loop */
+    kg_alt_free(alt);
+    kg_snapshot_release(&snap);
+
+    qsort(lat, np, sizeof(double), cmp_double);
+    qsort(wlat, np, sizeof(double), cmp_double);
+    qsort(alat, np, sizeof(double), cmp_double);
+    double path50 = pct(lat, np, 50), path99 = pct(lat, np, 99);
+    double wpath50 = pct(wlat, np, 50), wpath99 = pct(wlat, np, 99);
+    double apath50 = pct(alat, np, 50), apath99 = pct(alat, np, 99);
+    free(lat); free(wlat); free(alat); free(pairs); free(opt);
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    char b1[32], b2[32], b3[32], b4[32], b5[32], b6[32], b7[32], b8[32], b9[32];
+    char b10[32], b11[32], b12[32], b13[32];
+    printf("%11lu %9zu %8s %9.2f %9.1f | %8s %8s | %8s %8s | %8s %8s %5.0f%% | %8s %8s %7.3f"
+           " | %8s %8s %8s %6.1f%% %8s\n",
+           edges, n, fmt_ns(gen_ns, b7, sizeof(b7)),
+           (double)ls.loaded / (load_ns / 1e9) / 1e6,
+           (double)ru.ru_maxrss / 1024.0,
+           fmt_ns(look50, b1, sizeof(b1)), fmt_ns(look99, b2, sizeof(b2)),
+           fmt_ns(srch50, b3, sizeof(b3)), fmt_ns(srch99, b4, sizeof(b4)),
+           fmt_ns(path50, b5, sizeof(b5)), fmt_ns(path99, b6, sizeof(b6)),
+           100.0 * (double)found / (double)np,
+           fmt_ns(wpath50, b8, sizeof(b8)), fmt_ns(wpath99, b9, sizeof(b9)),
+           opt_cost > 0 ? bfs_cost / opt_cost : 1.0,
+           fmt_ns(alt_ns, b10, sizeof(b10)), fmt_ns(apath50, b11, sizeof(b11)), fmt_ns(apath99, b12, sizeof(b12)),
+           settled_dijkstra ? 100.0 * (double)settled_astar / (double)settled_dijkstra : 0.0,
+           fmt_ns(est_ns, b13, sizeof(b13)));
+    fflush(stdout);
+    kg_graph_free(g);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-s sizes (edges, comma separated)] [-d avg out-degree] [-m rmat|ba]\n"
+        "          [-l labels] [-z label skew] [-w max weight, 0 = none] [-k landmarks]\n"
+        "          [-S seed] [-t tmpdir]\n", prog);
+}
+
+/*
+   [SECTION] Main
+ */
+int main(int argc, char **argv) {
+    bench_opts_t bo;
+    kg_synth_defaults(&bo.synth);
+    bo.degree = DEFAULT_DEGREE;
+    bo.synth.max_weight = DEFAULT_MAX_WEIGHT;
+    bo.landmarks = DEFAULT_LANDMARKS;
+    bo.tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    char sizes[256];
+    snprintf(sizes, sizeof(sizes), "%s", DEFAULT_SIZES);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:m:l:z:w:k:S:t:h")) != -1) {
+        switch (opt) {
+        case 's': snprintf(sizes, sizeof(sizes), "%s", optarg); break;
+        case 'd': bo.degree = (unsigned)atoi(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "rmat") == 0) bo.synth.model = KG_SYNTH_RMAT;
+            else if (strcmp(optarg, "ba") == 0) bo.synth.model = KG_SYNTH_BA;
+            else { usage(argv[0]); return 2; }
+            break;
+        case 'l': bo.synth.labels = (unsigned)atoi(optarg); break;
+        case 'z': bo.synth.label_skew = atof(optarg); break;
+        case 'w': bo.synth.max_weight = atof(optarg); break;
+        case 'k': bo.landmarks = (unsigned)atoi(optarg); break;
+        case 'S': bo.synth.seed = strtoull(optarg, NULL, 10); break;
+        case 't': bo.tmpdir = optarg; break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (bo.degree == 0) { usage(argv[0]); return 2; }
+
+    printf("model=%s degree=%u labels=%u skew=%.2f max weight=%.1f seed=%llu\n",
+           bo.synth.model == KG_SYNTH_RMAT ? "rmat" : "ba", bo.degree,
+           bo.synth.labels, bo.synth.label_skew, bo.synth.max_weight, (unsigned long long)bo.synth.seed);
+    printf("%11s %9s %8s %9s %9s | %17s | %17s | %24s | %25s | %44s\n",
+           "", "", "", "load", "peak", "lookup", "fuzzy search", "path (BFS)", "path (Dijkstra)", "ALT landmarks + A*");
+    printf("%11s %9s %8s %9s %9s | %8s %8s | %8s %8s | %8s %8s %6s | %8s %8s %7s | %8s %8s %8s %7s %8s\n",
+           "edges", "entities", "gen", "Medge/s", "RSS MiB", "p50", "p99", "p50", "p99", "p50", "p99", "found",
+           "p50", "p99", "bfs/opt", "build", "p50", "p99", "settled", "estimate");
+    fflush(stdout);
+
+    int failed = 0;
+    for (char *tok = strtok(sizes, ","); tok; tok = strtok(NULL, ",")) {
+        unsigned long edges = strtoul(tok, NULL, 10);
+        if (edges == 0) continue;
+        pid_t pid = fork();
+        if (pid < 0) { perror("fork"); return 1; }
+        if (pid == 0) _exit(run_size(&bo, edges));
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("%11lu   (failed)\n", edges);
+            failed = 1;
+        }
+    }
+    return failed;
+}
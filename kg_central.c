@@ -0,0 +1,229 @@
+/* =========================================================================
+   Knowledge Graph Engine — Betweenness & Closeness (implementation)
+   ========================================================================= */
+#define _POSIX_C_SOURCE 200809L      /* sysconf under -std=c11 */
+#include "kg_central.h"
+#include "kg_csr.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define CENTRAL_MAX_THREADS 64
+
+void kg_central_defaults(kg_central_opts_t *o) {
+    o->samples = 0;
+    o->delta = 0.05;
+    o->threads = 0;
+    o->seed = 0;
+    o->f = NULL;
+}
+
+void kg_central_free(kg_central_t *c) {
+    if (!c) return;
+    free(c->betweenness); free(c->closeness);
+    free(c);
+}
+
+static double error_bound(size_t n, size_t k, double delta) {
+    if (k >= n || n < 2) return 0.0;
+    return (double)n / (double)(n - 1) * sqrt(log(2.0 * (double)n / delta) / (2.0 * (double)k));
+}
+
+size_t kg_central_samples(size_t n, double eps, double delta) {
+    if (n < 2 || !(eps > 0.0) || !(delta > 0.0 && delta < 1.0)) return n;
+    double e = eps * (double)(n - 1) / (double)n;
+    double k = ceil(log(2.0 * (double)n / delta) / (2.0 * e * e));
+    return k >= (double)n ? n : (size_t)k;
+}
+
+/* Keeps only the relations f allows, in place. */
+static void filter_csr(kg_csr_t *c, const kg_label_filter_t *f) {
+    size_t w = 0, start = 0;
+    for (size_t v = 0; v < c->n; ++v) {
+        size_t end = c->row[v + 1];
+        c->row[v] = w;
+        for (size_t k = start; k < end; ++k)
+            if (kg_label_allowed(f, c->lab[k])) c->tgt[w++] = c->tgt[k];
+        start = end;
+    }
+    c->row[c->n] = w;
+    c->m = w;
+}
+
+static unsigned long rng_next(unsigned long *s) {
+    *s ^= *s << 13; *s ^= *s >> 7; *s ^= *s << 17;
+    return *s;
+}
+
+/*
+   [SECTION] Brandes
+   - A slot owns dist / sigma / delta / queue for one BFS at a time and
+     resets only what the BFS touched, so a source costs what it reaches.
+   - The queue doubles as the stack: BFS order reversed is a valid order
+     for accumulating dependencies.
+ */
+typedef struct central_slot {
+    const kg_csr_t *c;
+    const unsigned *sources;
+    size_t n_sources;
+    unsigned index, stride;      /* sources index, index + stride, ... */
+    int *dist;                   /* -1 = not reached */
+    double *sigma, *delta;       /* shortest paths from the source, dependency */
+    unsigned *queue;
+    double *bc, *hc;             /* sums over this slot's sources */
+} central_slot_t;
+
+static void central_source(central_slot_t *S, unsigned s) {
+    const kg_csr_t *c = S->c;
+    int *dist = S->dist;
+    double *sigma = S->sigma, *delta = S->delta;
+    unsigned *queue = S->queue;
+    size_t head = 0, tail = 0;
+    dist[s] = 0;
+    sigma[s] = 1.0;
+    queue[tail++] = s;
+    while (head < tail) {
+        unsigned v = queue[head++];
+        for (size_t k = c->row[v]; k < c->row[v + 1]; ++k) {
+            unsigned w = c->tgt[k];
+            if (dist[w] < 0) { dist[w] = dist[v] + 1; queue[tail++] = w; }
+            if (dist[w] == dist[v] + 1) sigma[w] += sigma[v];
+        }
+    }
+    for (size_t i = 1; i < tail; ++i) S->hc[queue[i]] += 1.0 / (double)dist[queue[i]];
+    for (size_t i = tail; i-- > 0; ) {
+        unsigned v = queue[i];
+        double d = 0.0;
+        for (size_t k = c->row[v]; k < c->row[v + 1]; ++k) {
+            unsigned w = c->tgt[k];
+            if (dist[w] == dist[v] + 1) d += sigma[v] / sigma[w] * (1.0 + delta[w]);
+        }
+        delta[v] = d;
+        if (v != s) S->bc[v] += d;
+    }
+    for (size_t i = 0; i < tail; ++i) {
+        dist[queue[i]] = -1;
+        sigma[queue[i]] = 0.0;
+        delta[queue[i]] = 0.0;
+    }
+}
+
+static void *central_worker(void *arg) {
+    central_slot_t *S = (central_slot_t*)arg;
+    for (size_t i = S->index; i < S->n_sources; i += S->stride) central_source(S, S->sources[i]);
+    return NULL;
+}
+
+static void slot_free(central_slot_t *S) {
+    free(S->dist); free(S->sigma); free(S->delta); free(S->queue);
+    free(S->bc); free(S->hc);
+}
+
+static int slot_init(central_slot_t *S, size_t n) {
+    size_t len = n ? n : 1;
+    S->dist = (int*)malloc(len * sizeof(int));
+    S->sigma = (double*)calloc(len, sizeof(double));
+    S->delta = (double*)calloc(len, sizeof(double));
+    S->queue = (unsigned*)malloc(len * sizeof(unsigned));
+    S->bc = (double*)calloc(len, sizeof(double));
+    S->hc = (double*)calloc(len, sizeof(double));
+    if (!S->dist || !S->sigma || !S->delta || !S->queue || !S->bc || !S->hc) return 0;
+    memset(S->dist, 0xff, len * sizeof(int));
+    return 1;
+}
+
+/* Sources: every visible entity, or k of them by a partial shuffle. */
+static unsigned *pick_sources(const kg_snapshot_t *s, const kg_central_opts_t *o, size_t *n_visible, size_t *k) {
+    unsigned *ids = (unsigned*)malloc((s->n_entities ? s->n_entities : 1) * sizeof(unsigned));
+    if (!ids) return NULL;
+    size_t n = 0;
+    for (size_t v = 0; v < s->n_entities; ++v)
+        if (kg_visible(s, kg_entity_at(s->g, v))) ids[n++] = (unsigned)v;
+    *n_visible = n;
+    *k = o->samples && o->samples < n ? o->samples : n;
+    unsigned long rs = o->seed ? o->seed : 0x2545f4914f6cdd1dul;
+    for (size_t i = 0; i < *k && *k < n; ++i) {
+        size_t j = i + rng_next(&rs) % (n - i);
+        unsigned t = ids[i]; ids[i] = ids[j]; ids[j] = t;
+    }
+    return ids;
+}
+
+kg_status_t kg_centrality(const kg_snapshot_t *s, const kg_central_opts_t *o, kg_central_t **out) {
+    *out = NULL;
+    if (!(o->delta > 0.0 && o->delta < 1.0)) return KG_ERR_INVALID;
+    kg_csr_t *c;
+    kg_status_t st = kg_csr_build(s, 0, &c);
+    if (st != KG_OK) return st;
+    if (o->f) filter_csr(c, o->f);
+
+    size_t n = c->n, n_vis = 0, k = 0;
+    kg_central_t *r = (kg_central_t*)calloc(1, sizeof(kg_central_t));
+    unsigned *sources = pick_sources(s, o, &n_vis, &k);
+    long cpus = o->threads ? (long)o->threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    if (cpus > CENTRAL_MAX_THREADS) cpus = CENTRAL_MAX_THREADS;
+    unsigned slots = (size_t)cpus > k ? (unsigned)(k ? k : 1) : (unsigned)cpus;
+    central_slot_t *S = (central_slot_t*)calloc(slots, sizeof(central_slot_t));
+    st = r && sources && S ? KG_OK : KG_ERR_NOMEM;
+    for (unsigned t = 0; t < slots && st == KG_OK; ++t) {
+        S[t].c = c;
+        S[t].sources = sources;
+        S[t].n_sources = k;
+        S[t].index = t;
+        S[t].stride = slots;
+        if (!slot_init(&S[t], n)) st = KG_ERR_NOMEM;
+    }
+    if (st == KG_OK) {
+        r->betweenness = (double*)calloc(n ? n : 1, sizeof(double));
+        r->closeness = (double*)calloc(n ? n : 1, sizeof(double));
+        if (!r->betweenness || !r->closeness) st = KG_ERR_NOMEM;
+    }
+    if (st != KG_OK) {
+        for (unsigned t = 0; S && t < slots; ++t) slot_free(&S[t]);
+        free(S); free(sources); kg_central_free(r); kg_csr_free(c);
+        return st;
+    }
+
+    /* Slot 0 on this thread; a slot whose thread would not start, too */
+    pthread_t th[CENTRAL_MAX_THREADS];
+    unsigned char started[CENTRAL_MAX_THREADS] = { 0 };
+    r->threads = 1;
+    for (unsigned t = 1; t < slots; ++t)
+        if (pthread_create(&th[t], NULL, central_worker, &S[t]) == 0) { started[t] = 1; r->threads++; }
+    central_worker(&S[0]);
+    for (unsigned t = 1; t < slots; ++t) {
+        if (started[t]) pthread_join(th[t], NULL);
+        else central_worker(&S[t]);
+    }
+
+    /* Sum in slot order, scaled to all sources and normalized */
+    double scale = k ? (double)n_vis / (double)k : 0.0;
+    double pairs = n_vis > 2 ? (double)(n_vis - 1) * (double)(n_vis - 2) : 0.0;
+    double others = n_vis > 1 ? (double)(n_vis - 1) : 0.0;
+    for (unsigned t = 0; t < slots; ++t) {
+        for (size_t v = 0; v < n; ++v) {
+            r->betweenness[v] += S[t].bc[v];
+            r->closeness[v] += S[t].hc[v];
+        }
+        slot_free(&S[t]);
+    }
+    for (size_t v = 0; v < n; ++v) {
+        r->betweenness[v] = pairs > 0.0 ? r->betweenness[v] * scale / pairs : 0.0;
+        r->closeness[v] = others > 0.0 ? r->closeness[v] * scale / others : 0.0;
+    }
+    r->g = s->g;
+    r->version = s->version;
+    r->n = n;
+    r->n_visible = n_vis;
+    r->sources = k;
+    r->exact = k == n_vis;
+    r->delta = o->delta;
+    r->error = error_bound(n_vis, k, o->delta);
+    free(S); free(sources);
+    kg_csr_free(c);
+    *out = r;
+    return KG_OK;
+}
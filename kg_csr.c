@@ -0,0 +1,183 @@
+/* =========================================================================
+   Knowledge Graph Engine — Compressed Sparse Row Index (implementation)
+   ========================================================================= */
+
+#include "kg_csr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void kg_csr_free(kg_csr_t *c) {
+    if (!c) return;
+    free(c->row); free(c->tgt); free(c->lab);
+    free(c->run_row); free(c->run_lab); free(c->run_start);
+    free(c);
+}
+
+size_t kg_csr_bytes(const kg_csr_t *c) {
+    size_t b = sizeof(*c) + (c->n + 1) * sizeof(size_t) + c->m * 2 * sizeof(unsigned);
+    if (c->run_row)
+        b += (c->n + 1) * sizeof(size_t) + c->n_runs * sizeof(unsigned) + (c->n_runs + 1) * sizeof(size_t);
+    return b;
+}
+
+/*
+   [SECTION] Label Partition
+   - Counting sort of all edges by label, then a stable scatter back into
+     their rows: each row ends up grouped by label, original order kept
+     inside a label. O(n + m + labels).
+ */
+static kg_status_t partition_by_label(kg_csr_t *c, size_t n_labels) {
+    size_t n = c->n, m = c->m;
+    unsigned *src_of = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    size_t *by_lab = (size_t*)malloc((m ? m : 1) * sizeof(size_t));
+    size_t *cnt = (size_t*)calloc(n_labels + 1, sizeof(size_t));
+    size_t *pos = (size_t*)malloc((n + 1) * sizeof(size_t));
+    unsigned *tgt = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    unsigned *lab = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    kg_status_t st = KG_ERR_NOMEM;
+    if (!src_of || !by_lab || !cnt || !pos || !tgt || !lab) goto out;
+
+    for (size_t v = 0; v < n; ++v)
+        for (size_t k = c->row[v]; k < c->row[v + 1]; ++k) src_of[k] = (unsigned)v;
+    for (size_t k = 0; k < m; ++k) cnt[c->lab[k] + 1]++;
+    for (size_t l = 0; l < n_labels; ++l) cnt[l + 1] += cnt[l];
+    for (size_t k = 0; k < m; ++k) by_lab[cnt[c->lab[k]]++] = k;
+
+    memcpy(pos, c->row, (n + 1) * sizeof(size_t));
+    for (size_t i = 0; i < m; ++i) {
+        size_t k = by_lab[i];
+        size_t d = pos[src_of[k]]++;
+        tgt[d] = c->tgt[k];
+        lab[d] = c->lab[k];
+    }
+    free(c->tgt); c->tgt = tgt; tgt = NULL;
+    free(c->lab); c->lab = lab; lab = NULL;
+
+    /* Runs: one per (row, label) */
+    size_t runs = 0;
+    for (size_t v = 0; v < n; ++v)
+        for (size_t k = c->row[v]; k < c->row[v + 1]; ++k)
+            if (k == c->row[v] || c->lab[k] != c->lab[k - 1]) runs++;
+    c->run_row = (size_t*)malloc((n + 1) * sizeof(size_t));
+    c->run_lab = (unsigned*)malloc((runs ? runs : 1) * sizeof(unsigned));
+    c->run_start = (size_t*)malloc((runs + 1) * sizeof(size_t));
+    if (!c->run_row || !c->run_lab || !c->run_start) goto out;
+    size_t r = 0;
+    for (size_t v = 0; v < n; ++v) {
+        c->run_row[v] = r;
+        for (size_t k = c->row[v]; k < c->row[v + 1]; ++k)
+            if (k == c->row[v] || c->lab[k] != c->lab[k - 1]) {
+                c->run_lab[r] = c->lab[k];
+                c->run_start[r++] = k;
+            }
+    }
+    c->run_row[n] = r;
+    c->run_start[r] = m;
+    c->n_runs = runs;
+    st = KG_OK;
+out:
+    free(src_of); free(by_lab); free(cnt); free(pos); free(tgt); free(lab);
+    return st;
+}
+
+/* [SECTION] Build */
+
+kg_status_t kg_csr_build(const kg_snapshot_t *s, int by_label, kg_csr_t **out) {
+    *out = NULL;
+    kg_csr_t *c = (kg_csr_t*)calloc(1, sizeof(kg_csr_t));
+    if (!c) return KG_ERR_NOMEM;
+    c->g = s->g;
+    c->version = s->version;
+    c->n = s->n_entities;
+    c->row = (size_t*)calloc(c->n + 1, sizeof(size_t));
+    if (!c->row) { kg_csr_free(c); return KG_ERR_NOMEM; }
+
+    /* Pass 1: degrees, as seen by the snapshot */
+    for (size_t v = 0; v < c->n; ++v) {
+        kg_entity_t *e = kg_entity_at(s->g, v);
+        size_t d = 0;
+        if (kg_visible(s, e))
+            for (kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next) d++;
+        c->row[v + 1] = c->row[v] + d;
+    }
+    c->m = c->row[c->n];
+
+    /* Pass 2: fill targets and labels in list order */
+    c->tgt = (unsigned*)malloc((c->m ? c->m : 1) * sizeof(unsigned));
+    c->lab = (unsigned*)malloc((c->m ? c->m : 1) * sizeof(unsigned));
+    if (!c->tgt || !c->lab) { kg_csr_free(c); return KG_ERR_NOMEM; }
+    size_t max_label = 0;
+    for (size_t v = 0; v < c->n; ++v) {
+        size_t k = c->row[v];
+        if (k == c->row[v + 1]) continue;
+        for (kg_relation_t *r = kg_snapshot_relations(s, kg_entity_at(s->g, v)); r; r = r->next, ++k) {
+            c->tgt[k] = r->target->id;
+            c->lab[k] = r->label;
+            if (r->label + 1 > max_label) max_label = r->label + 1;
+        }
+    }
+
+    if (by_label) {
+        kg_status_t st = partition_by_label(c, max_label);
+        if (st != KG_OK) { kg_csr_free(c); return st; }
+    }
+    *out = c;
+    return KG_OK;
+}
+
+/*
+   [SECTION] BFS over the Index
+   - Same shape as the list-based BFS (prev[] doubles as visited), but
+     with label runs an excluded label costs one bit test per row.
+ */
+kg_status_t kg_csr_shortest_path(const kg_csr_t *c, unsigned src, unsigned tgt,
+                                 const kg_label_filter_t *f, kg_path_t *out) {
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    if (src >= c->n || tgt >= c->n) return KG_ERR_NOT_FOUND;
+
+    size_t n = c->n;
+    unsigned *prev = (unsigned*)malloc(n * sizeof(unsigned));
+    unsigned *Q = (unsigned*)malloc(n * sizeof(unsigned));
+    if (!prev || !Q) { free(prev); free(Q); return KG_ERR_NOMEM; }
+    memset(prev, 0xff, n * sizeof(unsigned));   /* KG_NO_ENTITY */
+
+    size_t head = 0, tail = 0;
+    prev[src] = src; Q[tail++] = src;
+    int found = 0;
+
+    while (head < tail) {
+        unsigned cur = Q[head++];
+        if (cur == tgt) { found = 1; break; }
+
+        if (c->run_row) {
+            for (size_t r = c->run_row[cur]; r < c->run_row[cur + 1]; ++r) {
+                if (f && !kg_label_allowed(f, c->run_lab[r])) continue;
+                for (size_t k = c->run_start[r]; k < c->run_start[r + 1]; ++k) {
+                    unsigned nx = c->tgt[k];
+                    if (prev[nx] == KG_NO_ENTITY) { prev[nx] = cur; Q[tail++] = nx; }
+                }
+            }
+        } else {
+            for (size_t k = c->row[cur]; k < c->row[cur + 1]; ++k) {
+                if (f && !kg_label_allowed(f, c->lab[k])) continue;
+                unsigned nx = c->tgt[k];
+                if (prev[nx] == KG_NO_ENTITY) { prev[nx] = cur; Q[tail++] = nx; }
+            }
+        }
+    }
+    free(Q);
+    if (!found) { free(prev); return KG_ERR_NO_PATH; }
+
+    size_t len = 1;
+    for (unsigned p = tgt; p != src; p = prev[p]) len++;
+    out->nodes = (kg_entity_t**)malloc(len * sizeof(kg_entity_t*));
+    if (!out->nodes) { free(prev); return KG_ERR_NOMEM; }
+    out->len = len;
+    out->cost = (double)(len - 1);
+    unsigned p = tgt;
+    for (size_t i = len; i-- > 0; p = prev[p]) out->nodes[i] = kg_entity_at(c->g, p);
+
+    free(prev);
+    return KG_OK;
+}
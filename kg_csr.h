@@ -0,0 +1,56 @@
+/* =========================================================================
+   Knowledge Graph Engine — Compressed Sparse Row Index
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     A read-only, array-based copy of the adjacency of one snapshot:
+     row[] offsets into flat target / label arrays, so traversals stream
+     through memory instead of chasing list nodes.
+     Optionally each row is partitioned by label into runs, so a filtered
+     traversal checks one bit per run and never touches the targets of an
+     excluded label.
+     The index reflects the snapshot it was built from; rebuild it when
+     kg_graph_version() moves on (see kg_csr_is_current()).
+->   Build:
+     add kg_csr.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_CSR_H
+#define KG_CSR_H
+
+#include "kg_graph.h"
+
+typedef struct kg_csr {
+    const kg_graph_t *g;
+    unsigned long version;       /* snapshot the index was built from */
+    size_t n, m;                 /* entities (ids 0..n-1), edges */
+    size_t *row;                 /* n + 1 offsets into tgt / lab */
+    unsigned *tgt;               /* target entity ids */
+    unsigned *lab;               /* label ids, parallel to tgt */
+
+    /* Label partition (NULL when built without it). Runs are contiguous
+       in tgt order: run r covers tgt[run_start[r] .. run_start[r + 1]). */
+    size_t *run_row;             /* n + 1 offsets into run_lab / run_start */
+    unsigned *run_lab;
+    size_t *run_start;           /* n_runs + 1 entries */
+    size_t n_runs;
+} kg_csr_t;
+
+/* Builds the index of snapshot s. Rows keep adjacency-list order (newest
+   first); with by_label, each row is grouped by label id, stable within
+   a label. */
+kg_status_t kg_csr_build(const kg_snapshot_t *s, int by_label, kg_csr_t **out);
+void kg_csr_free(kg_csr_t *c);
+
+static inline int kg_csr_is_current(const kg_csr_t *c) {
+    return c->version == kg_graph_version(c->g);
+}
+
+/* Bytes held by the index (for the memory report of callers). */
+size_t kg_csr_bytes(const kg_csr_t *c);
+
+/* Hop-count shortest path over the index, following only labels the
+   filter allows (NULL = all). Uses the label runs when present. */
+kg_status_t kg_csr_shortest_path(const kg_csr_t *c, unsigned src, unsigned tgt,
+                                 const kg_label_filter_t *f, kg_path_t *out);
+
+#endif /* KG_CSR_H */
@@ -0,0 +1,80 @@
+/* =========================================================================
+   Knowledge Graph Engine — Ego Networks
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     The k-hop neighborhood of one entity as a standalone subgraph, for
+     UI panels ("what is around Machine Learning?") and ML features:
+     every entity within `hops` edges of the center, following outgoing,
+     incoming or both kinds of edge and only the allowed relations, plus
+     every allowed edge between two of them.
+->   Expansion:
+     Level by level over bitsets (visited, frontier, next), one bit per
+     entity. Outgoing edges are pushed from the frontier's set bits.
+     Incoming edges have no index to follow, so each level pulls instead:
+     one pass over the unvisited entities' edges, testing each target's
+     frontier bit. That is O(m) per level, but needs no reverse index.
+     Stops at max_nodes (nearest hops first).
+->   Output:
+     An edge list (tab-separated), GraphViz DOT with the center
+     highlighted and one rank per hop, or a relations file that
+     kg_load_file() reads back as a graph of its own.
+->   Build:
+     add kg_ego.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_EGO_H
+#define KG_EGO_H
+
+#include <stdio.h>
+
+#include "kg_graph.h"
+
+#define KG_EGO_OUT   1           /* follow edges away from the center */
+#define KG_EGO_IN    2           /* follow edges into it */
+#define KG_EGO_BOTH  3
+
+typedef struct kg_ego_opts {
+    unsigned hops;               /* 0 = the center alone */
+    int dir;                     /* KG_EGO_OUT / IN / BOTH */
+    const kg_label_filter_t *f;  /* NULL = every relation */
+    size_t max_nodes;            /* 0 = no limit */
+} kg_ego_opts_t;
+
+/* 2 hops out, every relation, no limit. */
+void kg_ego_defaults(kg_ego_opts_t *o);
+
+typedef struct kg_ego_edge {
+    kg_entity_t *src;
+    const kg_relation_t *rel;    /* rel->target is the other end */
+} kg_ego_edge_t;
+
+typedef struct kg_ego {
+    size_t n_nodes;
+    kg_entity_t **nodes;         /* center first, then by hop */
+    unsigned *hop;               /* distance of each from the center */
+    size_t n_edges;
+    kg_ego_edge_t *edges;        /* every allowed edge between two nodes */
+    int truncated;               /* stopped at max_nodes */
+} kg_ego_t;
+
+/* KG_ERR_INVALID for a bad dir. The plain form pins its own snapshot for
+   the duration of the call; the edges stay valid after it, like every
+   published edge. */
+kg_status_t kg_ego_extract(const kg_graph_t *g, const kg_entity_t *center, const kg_ego_opts_t *o,
+                           kg_ego_t *out);
+kg_status_t kg_ego_extract_at(const kg_snapshot_t *s, const kg_entity_t *center, const kg_ego_opts_t *o,
+                              kg_ego_t *out);
+void kg_ego_free(kg_ego_t *e);
+
+typedef enum kg_ego_format {
+    KG_EGO_EDGES = 0,            /* source \t relation \t target \t weight */
+    KG_EGO_DOT,
+    KG_EGO_RELATIONS             /* Source|Relationship|Target[|Weight], as kg_save_file() */
+} kg_ego_format_t;
+
+/* KG_ERR_IO if a write fails. */
+kg_status_t kg_ego_write(const kg_ego_t *e, kg_ego_format_t fmt, FILE *fp);
+/* Same into a new file. */
+kg_status_t kg_ego_save(const kg_ego_t *e, kg_ego_format_t fmt, const char *filename);
+
+#endif /* KG_EGO_H */
@@ -0,0 +1,1474 @@
+/* =========================================================================
+   Knowledge Graph Engine — Library Implementation
+   -------------------------------------------------------------------------
+ ->  Core data structures:
+       - Hash Table (linear probing, grown off to the side and republished)
+       - Segmented id -> entity directory (per-query scratch arrays index by id)
+       - Adjacency List via Linked Lists (for directed relations)
+       - Interned relation labels (text stored once, edges carry an id)
+       - Queue (BFS path finding)
+ ->  Writers serialize on g->write_lock; readers use acquire loads only.
+ ->  No printing, no exit(): every failure is reported as a kg_status_t.
+
+   ========================================================================= */
+
+#define _POSIX_C_SOURCE 200809L      /* clock_gettime under -std=c11 */
+#include "kg_graph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+
+const char *kg_strerror(kg_status_t st) {
+    switch (st) {
+    case KG_OK:            return "ok";
+    case KG_ERR_NOMEM:     return "memory allocation failed";
+    case KG_ERR_INVALID:   return "invalid argument";
+    case KG_ERR_NOT_FOUND: return "entity not found";
+    case KG_ERR_EXISTS:    return "entity already exists";
+    case KG_ERR_NO_PATH:   return "no path";
+    case KG_ERR_IO:        return "file error";
+    }
+    return "unknown error";
+}
+
+/*  [SECTION] String Helpers: Trimming, Case, etc. */
+
+/* Trim leading & trailing whitespace (in place). */
+void kg_trim(char *s) {
+    size_t len = strlen(s);
+    if (len == 0) return;            /* never touch the byte past "" */
+    size_t start = 0, end = len - 1;
+
+    while (s[start] && isspace((unsigned char)s[start])) start++;
+    while (end > start && isspace((unsigned char)s[end])) end--;
+
+    if (start > 0) memmove(s, s + start, end - start + 1);
+    s[end - start + 1] = '\0';
+}
+
+/* Optional normalization: collapse multiple internal spaces into single space. */
+void kg_squeeze_spaces(char *s) {
+    char *dst = s;
+    int in_space = 0;
+    for (; *s; ++s) {
+        if (isspace((unsigned char)*s)) {
+            if (!in_space) { *dst++ = ' '; in_space = 1; }
+        } else {
+            *dst++ = *s; in_space = 0;
+        }
+    }
+    *dst = '\0';
+}
+
+/* Lowercase copy (safe). */
+void kg_to_lower_copy(const char *src, char *dst, size_t dstsz) {
+    size_t i = 0;
+    for (; src[i] && i + 1 < dstsz; ++i) dst[i] = (char)tolower((unsigned char)src[i]);
+    dst[i] = '\0';
+}
+
+/* Case-insensitive compare. Returns 0 if equal ignoring case. */
+int kg_ci_cmp(const char *a, const char *b) {
+    while (*a && *b) {
+        int ca = tolower((unsigned char)*a);
+        int cb = tolower((unsigned char)*b);
+        if (ca != cb) return ca - cb;
+        ++a; ++b;
+    }
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+/* Case-insensitive substring check. */
+int kg_ci_contains(const char *hay, const char *needle) {
+    char H[KG_NAME_LEN*2], N[KG_NAME_LEN];
+    kg_to_lower_copy(hay, H, sizeof(H));
+    kg_to_lower_copy(needle, N, sizeof(N));
+    return strstr(H, N) != NULL;
+}
+
+/* djb2 */
+unsigned long kg_hash_name(const char *s) {
+    unsigned long h = 5381;
+    int c;
+    while ((c = (unsigned char)*s++)) h = ((h << 5) + h) + (unsigned)c;
+    return h;
+}
+
+/*
+   [SECTION] Memory Accounting
+   - Relaxed atomics: writers account under the lock, BFS scratch from
+     any reader thread.
+ */
+static const char *const MEM_CAT_NAMES[KG_MEM_CATS] = {
+    "names", "entities", "labels", "adjacency", "buckets", "directory", "stats", "bfs"
+};
+
+const char *kg_mem_cat_name(kg_mem_cat_t cat) {
+    return (unsigned)cat < KG_MEM_CATS ? MEM_CAT_NAMES[cat] : "unknown";
+}
+
+static void mem_account(const kg_graph_t *g, kg_mem_cat_t cat, long bytes, long payload, long objects) {
+    kg_mem_account_t *a = &((kg_graph_t*)g)->mem[cat];
+    long now = atomic_fetch_add_explicit(&a->bytes, bytes, memory_order_relaxed) + bytes;
+    atomic_fetch_add_explicit(&a->payload, payload, memory_order_relaxed);
+    atomic_fetch_add_explicit(&a->objects, objects, memory_order_relaxed);
+    long peak = atomic_load_explicit(&a->peak, memory_order_relaxed);
+    while (now > peak && !atomic_compare_exchange_weak_explicit(&a->peak, &peak, now,
+                                                                memory_order_relaxed, memory_order_relaxed)) { }
+}
+
+static size_t htable_bytes(const kg_htable_t *t) {
+    return sizeof(kg_htable_t) + (t->mask + 1) * sizeof(kg_entity_t*);
+}
+
+/*
+   [SECTION] Query Profiling
+   - The profile pointer is thread-local: a query is profiled by the
+     thread running it, and other threads never pay for it.
+ */
+static _Thread_local kg_profile_t *tl_profile;
+
+static const char *const PHASE_NAMES[KG_PHASE_COUNT] = {
+    "lookup (hash)", "search: exact pass", "search: prefix pass", "search: substring pass",
+    "bfs: alloc + visited reset", "bfs: frontier expansion", "bfs: path reconstruction",
+    "dijkstra/a*: heap expansion"
+};
+
+const char *kg_phase_name(kg_phase_t ph) {
+    return (unsigned)ph < KG_PHASE_COUNT ? PHASE_NAMES[ph] : "unknown";
+}
+
+void kg_profile_begin(kg_profile_t *p) {
+    memset(p, 0, sizeof(*p));
+    tl_profile = p;
+}
+
+void kg_profile_end(void) { tl_profile = NULL; }
+
+static unsigned long prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000ul + (unsigned long)ts.tv_nsec;
+}
+
+/* Closes phase `ph` that started at *t and starts the next one at now. */
+static void prof_phase(kg_profile_t *p, kg_phase_t ph, unsigned long *t) {
+    unsigned long now = prof_now();
+    p->phase_ns[ph] += now - *t;
+    p->phase_calls[ph]++;
+    *t = now;
+}
+
+/* [SECTION] Graph Lifecycle */
+
+static kg_htable_t *htable_new(size_t nslots) {
+    kg_htable_t *t = (kg_htable_t*)calloc(1, sizeof(kg_htable_t) + nslots * sizeof(kg_entity_t*));
+    if (!t) return NULL;
+    t->mask = nslots - 1;
+    return t;
+}
+
+/* Only hands out identities; no graph state lives outside kg_graph_t. */
+static _Atomic unsigned long next_graph_gen = 1;
+
+kg_graph_t *kg_graph_new(void) {
+    kg_graph_t *g = (kg_graph_t*)calloc(1, sizeof(kg_graph_t));
+    if (!g) return NULL;
+    kg_htable_t *t = htable_new(KG_HASH_INIT);
+    if (!t) { free(g); return NULL; }
+    mem_account(g, KG_MEM_BUCKETS, (long)htable_bytes(t), 0, 1);
+    atomic_init(&g->table, t);
+    atomic_init(&g->n_entities, 0);
+    atomic_init(&g->n_edges, 0);
+    atomic_init(&g->n_weighted, 0);
+    atomic_init(&g->n_components, 0);
+    atomic_init(&g->largest_component, 0);
+    atomic_init(&g->scores_version, 0);
+    atomic_init(&g->n_labels, 0);
+    atomic_init(&g->version, 1);
+    atomic_init(&g->pins, NULL);
+    atomic_init(&g->write_owner, NULL);
+    g->gen = atomic_fetch_add(&next_graph_gen, 1);
+    pthread_mutex_init(&g->write_lock, NULL);
+    return g;
+}
+
+void kg_graph_free(kg_graph_t *g) {
+    if (!g) return;
+    size_t n = kg_entity_count(g);
+    for (size_t i = 0; i < n; ++i) {
+        kg_entity_t *e = kg_entity_at(g, i);
+        kg_relation_t *r = atomic_load_explicit(&e->relations, memory_order_relaxed);
+        while (r) { kg_relation_t *tmp = r; r = r->next; free(tmp); }
+        free(e);
+    }
+    size_t nl = kg_label_count(g);
+    for (size_t i = 0; i < nl; ++i) free((char*)kg_label_name(g, (unsigned)i));
+    for (unsigned k = 0; k < KG_DIR_SEGMENTS; ++k) {
+        free(g->dir[k]); free((void*)g->label_dir[k]); free(g->label_counts[k]);
+    }
+    free(g->label_index.slots);
+    free(g->degrees.slots);
+    while (g->retired) { kg_htable_t *t = g->retired; g->retired = t->retired_next; free(t); }
+    free(atomic_load_explicit(&g->table, memory_order_relaxed));
+    kg_pin_t *p = atomic_load_explicit(&g->pins, memory_order_relaxed);
+    while (p) { kg_pin_t *tmp = p; p = p->next; free(tmp); }
+    pthread_mutex_destroy(&g->write_lock);
+    free(g);
+}
+
+/*
+   [SECTION] Snapshots (reader pins)
+   - Each thread reading a graph owns one kg_pin_t, found through a small
+     thread-local cache, so pinning touches no shared cache line.
+   - A pin records the version the reader started from; the writer frees a
+     retired hash table only when every active pin is newer than it.
+ */
+#define PIN_CACHE 8
+
+static _Thread_local struct {
+    const kg_graph_t *g;
+    unsigned long gen;
+    kg_pin_t *pin;
+} tl_pins[PIN_CACHE];
+static _Thread_local unsigned tl_pin_next;
+
+static kg_pin_t *thread_pin(const kg_graph_t *g) {
+    for (unsigned i = 0; i < PIN_CACHE; ++i)
+        if (tl_pins[i].g == g && tl_pins[i].gen == g->gen) return tl_pins[i].pin;
+
+    kg_pin_t *p = (kg_pin_t*)calloc(1, sizeof(kg_pin_t));
+    if (!p) return NULL;
+    atomic_init(&p->version, KG_PIN_IDLE);
+    kg_graph_t *mg = (kg_graph_t*)g;
+    p->next = atomic_load_explicit(&mg->pins, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&mg->pins, &p->next, p,
+                                                  memory_order_release, memory_order_relaxed)) { }
+
+    /* An evicted pin stays registered (idle) until the graph is freed. */
+    unsigned slot = tl_pin_next++ % PIN_CACHE;
+    tl_pins[slot].g = g; tl_pins[slot].gen = g->gen; tl_pins[slot].pin = p;
+    return p;
+}
+
+kg_status_t kg_snapshot_acquire(const kg_graph_t *g, kg_snapshot_t *snap) {
+    kg_pin_t *p = thread_pin(g);
+    if (!p) return KG_ERR_NOMEM;
+    snap->g = g;
+    snap->pin = p;
+    if (p->depth++ == 0) {
+        atomic_store_explicit(&p->version, kg_graph_version(g), memory_order_relaxed);
+        /* Pairs with the fence in collect_garbage(): either the writer sees
+           this pin, or everything we load below is already post-retire. */
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+    snap->version = kg_graph_version(g);
+    snap->n_entities = kg_entity_count(g);
+    return KG_OK;
+}
+
+void kg_snapshot_release(kg_snapshot_t *snap) {
+    if (!snap->pin) return;
+    if (--snap->pin->depth == 0)
+        atomic_store_explicit(&snap->pin->version, KG_PIN_IDLE, memory_order_release);
+    snap->pin = NULL;
+}
+
+/* Writer only: free retired tables no pinned reader can still hold. */
+static void collect_garbage(kg_graph_t *g) {
+    atomic_thread_fence(memory_order_seq_cst);
+    unsigned long oldest = KG_PIN_IDLE;
+    for (kg_pin_t *p = atomic_load_explicit(&g->pins, memory_order_acquire); p; p = p->next) {
+        unsigned long v = atomic_load_explicit(&p->version, memory_order_acquire);
+        if (v < oldest) oldest = v;
+    }
+    kg_htable_t **link = &g->retired;
+    while (*link) {
+        kg_htable_t *t = *link;
+        if (t->retired_at < oldest) {
+            *link = t->retired_next;
+            mem_account(g, KG_MEM_BUCKETS, -(long)htable_bytes(t), 0, -1);
+            free(t);
+        }
+        else link = &t->retired_next;
+    }
+}
+
+/*
+   [SECTION] Writer Lock & Batches
+   - Re-entrant on the owning thread, so kg_add_edge nests inside a batch.
+   - Leaving the outermost level publishes version + 1 if anything changed.
+ */
+static _Thread_local char tl_writer_token;
+
+static void write_begin(kg_graph_t *g) {
+    if (atomic_load_explicit(&g->write_owner, memory_order_relaxed) == &tl_writer_token) {
+        g->write_depth++;
+        return;
+    }
+    pthread_mutex_lock(&g->write_lock);
+    atomic_store_explicit(&g->write_owner, &tl_writer_token, memory_order_relaxed);
+    g->write_depth = 1;
+}
+
+static void write_end(kg_graph_t *g) {
+    if (--g->write_depth > 0) return;
+    if (g->write_dirty) {
+        unsigned long v = atomic_load_explicit(&g->version, memory_order_relaxed);
+        atomic_store_explicit(&g->version, v + 1, memory_order_release);
+        g->write_dirty = 0;
+        collect_garbage(g);
+    }
+    atomic_store_explicit(&g->write_owner, NULL, memory_order_relaxed);
+    pthread_mutex_unlock(&g->write_lock);
+}
+
+/* Version that writes in progress are stamped with. */
+static unsigned long pending_version(kg_graph_t *g) {
+    g->write_dirty = 1;
+    return atomic_load_explicit(&g->version, memory_order_relaxed) + 1;
+}
+
+void kg_batch_begin(kg_graph_t *g)  { write_begin(g); }
+void kg_batch_commit(kg_graph_t *g) { write_end(g); }
+
+/* [SECTION] Hash Table Operations (lock-free lookup, single writer) */
+
+/* *probes (optional) receives the number of slots inspected. */
+static kg_entity_t *htable_find(const kg_htable_t *t, const char *name, unsigned long h,
+                                unsigned long *probes) {
+    unsigned long k = 1;
+    for (size_t i = h & t->mask;; i = (i + 1) & t->mask, ++k) {
+        kg_entity_t *e = atomic_load_explicit(&((kg_htable_t*)t)->slots[i], memory_order_acquire);
+        if (!e || strcmp(e->name, name) == 0) {
+            if (probes) *probes = k;
+            return e;
+        }
+    }
+}
+
+/* Writer only: the slot is claimed with a release store so a concurrent
+   reader probing past it sees a fully built entity or nothing. */
+static void htable_put(kg_htable_t *t, kg_entity_t *e, unsigned long h) {
+    size_t i = h & t->mask;
+    while (atomic_load_explicit(&t->slots[i], memory_order_relaxed)) i = (i + 1) & t->mask;
+    atomic_store_explicit(&t->slots[i], e, memory_order_release);
+}
+
+kg_entity_t *kg_find_entity(const kg_graph_t *g, const char *name) {
+    kg_profile_t *prof = tl_profile;
+    unsigned long t0 = prof ? prof_now() : 0;
+    kg_snapshot_t s;
+    if (kg_snapshot_acquire(g, &s) != KG_OK) return NULL;
+    const kg_htable_t *t = atomic_load_explicit(&((kg_graph_t*)g)->table, memory_order_acquire);
+    unsigned long probes;
+    kg_entity_t *e = htable_find(t, name, kg_hash_name(name), &probes);
+    if (e && !kg_visible(&s, e)) e = NULL;
+    kg_snapshot_release(&s);
+
+    kg_graph_counters_t *c = &((kg_graph_t*)g)->counters;
+    atomic_fetch_add_explicit(&c->lookups, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->probes, probes, memory_order_relaxed);
+    if (prof) {
+        prof_phase(prof, KG_PHASE_LOOKUP, &t0);
+        prof->lookups++;
+        prof->probes += probes;
+    }
+    return e;
+}
+
+/* Writer only: sees uncommitted entities of the open batch too. */
+static kg_entity_t *find_entity_locked(kg_graph_t *g, const char *name) {
+    return htable_find(atomic_load_explicit(&g->table, memory_order_relaxed), name, kg_hash_name(name), NULL);
+}
+
+/* Double the table off to the side, then publish it in one store. Readers
+   still probing the old table finish there, so it is only retired. */
+static int grow_table(kg_graph_t *g) {
+    kg_htable_t *old = atomic_load_explicit(&g->table, memory_order_relaxed);
+    kg_htable_t *t = htable_new((old->mask + 1) * 2);
+    if (!t) return 0;
+    mem_account(g, KG_MEM_BUCKETS, (long)htable_bytes(t), 0, 1);
+    for (size_t i = 0; i <= old->mask; ++i) {
+        kg_entity_t *e = atomic_load_explicit(&old->slots[i], memory_order_relaxed);
+        if (e) htable_put(t, e, kg_hash_name(e->name));
+    }
+    atomic_store_explicit(&g->table, t, memory_order_release);
+    old->retired_at = atomic_load_explicit(&g->version, memory_order_relaxed);
+    old->retired_next = g->retired;
+    g->retired = old;
+    return 1;
+}
+
+/* Counts one entity as a lone component again, or no longer. */
+static void component_count(kg_graph_t *g, long d) {
+    atomic_fetch_add_explicit(&g->n_components, (size_t)d, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g->component_hist[0], (unsigned long)d, memory_order_relaxed);
+}
+
+/* Writer only (caller is inside write_begin). */
+static kg_entity_t *create_entity(kg_graph_t *g, const char *name) {
+    kg_htable_t *t = atomic_load_explicit(&g->table, memory_order_relaxed);
+    if ((g->table_used + 1) * 2 > t->mask + 1) {
+        if (!grow_table(g)) return NULL;
+        t = atomic_load_explicit(&g->table, memory_order_relaxed);
+    }
+
+    size_t id = atomic_load_explicit(&g->n_entities, memory_order_relaxed);
+    unsigned k = kg_dir_segment(id);
+    if (k >= KG_DIR_SEGMENTS) return NULL;
+    if (!g->dir[k]) {
+        g->dir[k] = (kg_entity_t**)calloc((size_t)KG_DIR_BASE << k, sizeof(kg_entity_t*));
+        if (!g->dir[k]) return NULL;
+        mem_account(g, KG_MEM_DIRECTORY, (long)(((size_t)KG_DIR_BASE << k) * sizeof(kg_entity_t*)), 0, 1);
+    }
+
+    kg_entity_t *e = (kg_entity_t*)malloc(sizeof(kg_entity_t));
+    if (!e) return NULL;
+    strncpy(e->name, name, KG_NAME_LEN-1); e->name[KG_NAME_LEN-1] = '\0';
+    e->id = (unsigned)id;
+    atomic_init(&e->born, pending_version(g));
+    atomic_init(&e->relations, NULL);
+    atomic_init(&e->uf_parent, (unsigned)id);
+    e->uf_rank = 0;
+    atomic_init(&e->uf_size, 1);
+    atomic_init(&e->score, 0.0f);
+    mem_account(g, KG_MEM_NAMES, KG_NAME_LEN, (long)strlen(e->name) + 1, 1);
+    mem_account(g, KG_MEM_ENTITIES, (long)(sizeof(kg_entity_t) - KG_NAME_LEN),
+                (long)(sizeof(kg_entity_t) - KG_NAME_LEN), 1);
+
+    /* Publish: directory slot, then the count readers bound their scans by,
+       then the name index. */
+    g->dir[k][kg_dir_offset(id, k)] = e;
+    atomic_store_explicit(&g->n_entities, id + 1, memory_order_release);
+    htable_put(t, e, kg_hash_name(e->name));
+    component_count(g, 1);
+    if (!atomic_load_explicit(&g->largest_component, memory_order_relaxed))
+        atomic_store_explicit(&g->largest_component, 1, memory_order_relaxed);
+    g->table_used++;
+    return e;
+}
+
+static kg_status_t add_entity_locked(kg_graph_t *g, const char *name, kg_entity_t **out) {
+    kg_entity_t *e = find_entity_locked(g, name);
+    if (e && atomic_load_explicit(&e->born, memory_order_relaxed) == KG_BORN_NEVER) {
+        /* Left over from a failed load: created anew under its old id */
+        atomic_store_explicit(&e->born, pending_version(g), memory_order_relaxed);
+        component_count(g, 1);
+        if (out) *out = e;
+        return KG_OK;
+    }
+    if (e) { if (out) *out = e; return KG_ERR_EXISTS; }
+    e = create_entity(g, name);
+    if (!e) return KG_ERR_NOMEM;
+    if (out) *out = e;
+    return KG_OK;
+}
+
+kg_status_t kg_add_entity(kg_graph_t *g, const char *name, kg_entity_t **out) {
+    if (!name || !name[0]) return KG_ERR_INVALID;
+    write_begin(g);
+    kg_status_t st = add_entity_locked(g, name, out);
+    write_end(g);
+    return st;
+}
+
+kg_status_t kg_get_or_add_entity(kg_graph_t *g, const char *name, kg_entity_t **out) {
+    kg_status_t st = kg_add_entity(g, name, out);
+    return st == KG_ERR_EXISTS ? KG_OK : st;
+}
+
+/*
+   [SECTION] Relation Labels (interning)
+   - Writers find a label through label_index (open addressing on ids);
+     readers go through label_dir, published like the entity directory.
+ */
+static unsigned label_index_find(const kg_graph_t *g, const char *text, unsigned long h) {
+    const kg_label_index_t *ix = &g->label_index;
+    if (!ix->slots) return KG_NO_LABEL;
+    for (size_t i = h & ix->mask; ix->slots[i]; i = (i + 1) & ix->mask) {
+        unsigned id = ix->slots[i] - 1;
+        if (strcmp(kg_label_name(g, id), text) == 0) return id;
+    }
+    return KG_NO_LABEL;
+}
+
+static int label_index_put(kg_graph_t *g, unsigned id, unsigned long h) {
+    kg_label_index_t *ix = &g->label_index;
+    if ((ix->used + 1) * 2 > (ix->slots ? ix->mask + 1 : 0)) {
+        size_t cap = ix->slots ? (ix->mask + 1) * 2 : 64;
+        unsigned *slots = (unsigned*)calloc(cap, sizeof(unsigned));
+        if (!slots) return 0;
+        for (size_t i = 0; ix->slots && i <= ix->mask; ++i) {
+            if (!ix->slots[i]) continue;
+            size_t j = kg_hash_name(kg_label_name(g, ix->slots[i] - 1)) & (cap - 1);
+            while (slots[j]) j = (j + 1) & (cap - 1);
+            slots[j] = ix->slots[i];
+        }
+        mem_account(g, KG_MEM_LABELS, (long)((cap - (ix->slots ? ix->mask + 1 : 0)) * sizeof(unsigned)), 0, ix->slots ? 0 : 1);
+        free(ix->slots);
+        ix->slots = slots;
+        ix->mask = cap - 1;
+    }
+    size_t j = h & ix->mask;
+    while (ix->slots[j]) j = (j + 1) & ix->mask;
+    ix->slots[j] = id + 1;
+    ix->used++;
+    return 1;
+}
+
+/* Writer only. Returns the label's id, creating it on first use. */
+static unsigned intern_label(kg_graph_t *g, const char *label) {
+    char text[KG_REL_LEN];
+    size_t len = strlen(label);
+    if (len > KG_REL_LEN - 1) len = KG_REL_LEN - 1;
+    memcpy(text, label, len); text[len] = '\0';
+
+    unsigned long h = kg_hash_name(text);
+    unsigned id = label_index_find(g, text, h);
+    if (id != KG_NO_LABEL) return id;
+
+    size_t n = atomic_load_explicit(&g->n_labels, memory_order_relaxed);
+    unsigned k = kg_dir_segment(n);
+    if (k >= KG_DIR_SEGMENTS || n >= KG_NO_LABEL) return KG_NO_LABEL;
+    if (!g->label_dir[k]) {
+        g->label_dir[k] = (const char**)calloc((size_t)KG_DIR_BASE << k, sizeof(char*));
+        if (!g->label_dir[k]) return KG_NO_LABEL;
+        mem_account(g, KG_MEM_LABELS, (long)(((size_t)KG_DIR_BASE << k) * sizeof(char*)), 0, 1);
+    }
+    if (!g->label_counts[k]) {
+        g->label_counts[k] = (kg_label_counts_t*)calloc((size_t)KG_DIR_BASE << k, sizeof(kg_label_counts_t));
+        if (!g->label_counts[k]) return KG_NO_LABEL;
+        mem_account(g, KG_MEM_STATS, (long)(((size_t)KG_DIR_BASE << k) * sizeof(kg_label_counts_t)), 0, 1);
+    }
+    char *copy = (char*)malloc(len + 1);
+    if (!copy) return KG_NO_LABEL;
+    memcpy(copy, text, len); copy[len] = '\0';
+    g->label_dir[k][kg_dir_offset(n, k)] = copy;
+    if (!label_index_put(g, (unsigned)n, h)) { free(copy); return KG_NO_LABEL; }
+    mem_account(g, KG_MEM_LABELS, (long)len + 1, (long)len + 1, 1);
+    atomic_store_explicit(&g->n_labels, n + 1, memory_order_release);
+    return (unsigned)n;
+}
+
+unsigned kg_find_label(const kg_graph_t *g, const char *name) {
+    size_t n = kg_label_count(g);
+    unsigned ci = KG_NO_LABEL;
+    for (size_t i = 0; i < n; ++i) {
+        const char *l = kg_label_name(g, (unsigned)i);
+        if (strcmp(l, name) == 0) return (unsigned)i;
+        if (ci == KG_NO_LABEL && kg_ci_cmp(l, name) == 0) ci = (unsigned)i;
+    }
+    return ci;
+}
+
+kg_status_t kg_label_filter_init(const kg_graph_t *g, kg_label_filter_t *f, int deny,
+                                 const char *const *labels, size_t n_labels, size_t *bad) {
+    f->nbits = kg_label_count(g);
+    f->allow_new = deny;
+    f->bits = (uint64_t*)malloc(((f->nbits + 63) / 64 + 1) * sizeof(uint64_t));
+    if (!f->bits) return KG_ERR_NOMEM;
+    memset(f->bits, deny ? 0xff : 0x00, ((f->nbits + 63) / 64 + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < n_labels; ++i) {
+        unsigned id = kg_find_label(g, labels[i]);
+        if (id == KG_NO_LABEL || id >= f->nbits) {
+            if (bad) *bad = i;
+            kg_label_filter_free(f);
+            return KG_ERR_NOT_FOUND;
+        }
+        if (deny) f->bits[id >> 6] &= ~((uint64_t)1 << (id & 63));
+        else f->bits[id >> 6] |= (uint64_t)1 << (id & 63);
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_label_filter_parse(const kg_graph_t *g, kg_label_filter_t *f, const char *spec,
+                                  char *bad, size_t bad_len) {
+    while (isspace((unsigned char)*spec)) spec++;
+    int deny = (*spec == '!');
+    if (deny) spec++;
+    char *copy = (char*)malloc(strlen(spec) + 1);
+    if (!copy) return KG_ERR_NOMEM;
+    strcpy(copy, spec);
+
+    size_t n = 1;
+    for (const char *c = copy; *c; ++c) n += (*c == ',');
+    const char **labels = (const char**)malloc(n * sizeof(char*));
+    if (!labels) { free(copy); return KG_ERR_NOMEM; }
+    n = 0;
+    for (char *tok = copy, *end; tok; tok = end) {   /* no strtok: readers run concurrently */
+        end = strchr(tok, ',');
+        if (end) *end++ = '\0';
+        kg_trim(tok);
+        if (tok[0]) labels[n++] = tok;
+    }
+    size_t at = 0;
+    kg_status_t st = kg_label_filter_init(g, f, deny, labels, n, &at);
+    if (st == KG_ERR_NOT_FOUND && bad && bad_len) {
+        strncpy(bad, labels[at], bad_len - 1);
+        bad[bad_len - 1] = '\0';
+    }
+    free(labels); free(copy);
+    return st;
+}
+
+void kg_label_filter_free(kg_label_filter_t *f) {
+    free(f->bits);
+    f->bits = NULL; f->nbits = 0;
+}
+
+/*
+   [SECTION] Relation Statistics
+   - The degree index maps (entity, label, direction) to that entity's
+     edge count under the label; a count going 0 -> 1 is a new distinct
+     subject / object, and one crossing a power of two moves the entity
+     to the next histogram bucket. Writer only, under the write lock.
+ */
+static kg_label_counts_t *label_counts(const kg_graph_t *g, unsigned label) {
+    unsigned k = kg_dir_segment(label);
+    return &g->label_counts[k][kg_dir_offset(label, k)];
+}
+
+static size_t degree_slot(unsigned entity, unsigned label_dir, size_t mask) {
+    uint64_t h = ((uint64_t)label_dir << 32 | entity) * 0x9e3779b97f4a7c15ull;
+    return (size_t)(h ^ h >> 29) & mask;
+}
+
+/* Room for `extra` more keys without growing later (so a bump never fails). */
+static int degree_reserve(kg_graph_t *g, size_t extra) {
+    kg_degree_index_t *ix = &g->degrees;
+    size_t cap = ix->slots ? ix->mask + 1 : 0;
+    if ((ix->used + extra) * 4 <= cap * 3) return 1;
+    size_t ncap = cap ? cap * 2 : 1024;
+    while ((ix->used + extra) * 4 > ncap * 3) ncap *= 2;
+    kg_degree_slot_t *slots = (kg_degree_slot_t*)calloc(ncap, sizeof(kg_degree_slot_t));
+    if (!slots) return 0;
+    for (size_t i = 0; i < cap; ++i) {
+        const kg_degree_slot_t *d = &ix->slots[i];
+        if (!d->count) continue;
+        size_t j = degree_slot(d->entity, d->label_dir, ncap - 1);
+        while (slots[j].count) j = (j + 1) & (ncap - 1);
+        slots[j] = *d;
+    }
+    mem_account(g, KG_MEM_STATS, (long)((ncap - cap) * sizeof(kg_degree_slot_t)), 0, cap ? 0 : 1);
+    free(ix->slots);
+    ix->slots = slots;
+    ix->mask = ncap - 1;
+    return 1;
+}
+
+/* New degree of the entity under label_dir (after counting one more edge). */
+static unsigned degree_bump(kg_graph_t *g, unsigned entity, unsigned label_dir) {
+    kg_degree_index_t *ix = &g->degrees;
+    size_t j = degree_slot(entity, label_dir, ix->mask);
+    kg_degree_slot_t *d;
+    while ((d = &ix->slots[j])->count && (d->entity != entity || d->label_dir != label_dir))
+        j = (j + 1) & ix->mask;
+    if (!d->count) {
+        d->entity = entity;
+        d->label_dir = label_dir;
+        ix->used++;
+        mem_account(g, KG_MEM_STATS, 0, (long)sizeof(kg_degree_slot_t), 0);
+    }
+    return ++d->count;
+}
+
+static unsigned degree_bucket(unsigned long d) {
+    return 63u - (unsigned)__builtin_clzl(d);
+}
+
+static void degree_moved(_Atomic unsigned long *hist, _Atomic unsigned long *distinct,
+                         _Atomic unsigned long *max, unsigned long d) {
+    if (d == 1) atomic_fetch_add_explicit(distinct, 1, memory_order_relaxed);
+    unsigned b = degree_bucket(d);
+    if (d > 1 && degree_bucket(d - 1) != b) atomic_fetch_sub_explicit(&hist[b - 1], 1, memory_order_relaxed);
+    if (d == 1 || degree_bucket(d - 1) != b) atomic_fetch_add_explicit(&hist[b], 1, memory_order_relaxed);
+    if (d > atomic_load_explicit(max, memory_order_relaxed)) atomic_store_explicit(max, d, memory_order_relaxed);
+}
+
+static void label_stats_add(kg_graph_t *g, unsigned label, unsigned src, unsigned tgt) {
+    kg_label_counts_t *c = label_counts(g, label);
+    atomic_fetch_add_explicit(&c->edges, 1, memory_order_relaxed);
+    degree_moved(c->out_hist, &c->subjects, &c->max_out, degree_bump(g, src, label << 1));
+    degree_moved(c->in_hist, &c->objects, &c->max_in, degree_bump(g, tgt, label << 1 | 1));
+}
+
+kg_status_t kg_label_stats(const kg_graph_t *g, unsigned label, kg_label_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (label >= kg_label_count(g)) return KG_ERR_NOT_FOUND;
+    kg_label_counts_t *c = label_counts(g, label);
+    out->edges = atomic_load_explicit(&c->edges, memory_order_relaxed);
+    out->subjects = atomic_load_explicit(&c->subjects, memory_order_relaxed);
+    out->objects = atomic_load_explicit(&c->objects, memory_order_relaxed);
+    out->max_out = atomic_load_explicit(&c->max_out, memory_order_relaxed);
+    out->max_in = atomic_load_explicit(&c->max_in, memory_order_relaxed);
+    for (int k = 0; k < KG_DEGREE_BUCKETS; ++k) {
+        out->out_hist[k] = atomic_load_explicit(&c->out_hist[k], memory_order_relaxed);
+        out->in_hist[k] = atomic_load_explicit(&c->in_hist[k], memory_order_relaxed);
+    }
+    return KG_OK;
+}
+
+/*
+   [SECTION] Connected Components (union-find)
+   - find() halves the path as it goes: each step tries to point the
+     entity at its grandparent. A failed CAS only means someone else moved
+     it up already.
+   - Only the writer links roots, so ranks and sizes need no CAS.
+ */
+static unsigned uf_find(const kg_graph_t *g, unsigned x) {
+    for (;;) {
+        kg_entity_t *e = kg_entity_at(g, x);
+        unsigned p = atomic_load_explicit(&e->uf_parent, memory_order_acquire);
+        if (p == x) return x;
+        unsigned gp = atomic_load_explicit(&kg_entity_at(g, p)->uf_parent, memory_order_acquire);
+        if (gp != p) atomic_compare_exchange_weak_explicit(&e->uf_parent, &p, gp,
+                                                           memory_order_release, memory_order_relaxed);
+        x = gp;
+    }
+}
+
+static void component_union(kg_graph_t *g, kg_entity_t *a, kg_entity_t *b) {
+    unsigned ra = uf_find(g, a->id), rb = uf_find(g, b->id);
+    if (ra == rb) return;
+    kg_entity_t *A = kg_entity_at(g, ra), *B = kg_entity_at(g, rb);
+    if (A->uf_rank < B->uf_rank) { kg_entity_t *t = A; A = B; B = t; }
+    if (A->uf_rank == B->uf_rank) A->uf_rank++;
+    unsigned long sa = atomic_load_explicit(&A->uf_size, memory_order_relaxed);
+    unsigned long sb = atomic_load_explicit(&B->uf_size, memory_order_relaxed);
+    /* Size first: a reader that finds the new root sees the merged size */
+    atomic_store_explicit(&A->uf_size, (unsigned)(sa + sb), memory_order_relaxed);
+    atomic_store_explicit(&B->uf_parent, A->id, memory_order_release);
+
+    atomic_fetch_sub_explicit(&g->n_components, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&g->component_hist[degree_bucket(sa)], 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&g->component_hist[degree_bucket(sb)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g->component_hist[degree_bucket(sa + sb)], 1, memory_order_relaxed);
+    if (sa + sb > atomic_load_explicit(&g->largest_component, memory_order_relaxed))
+        atomic_store_explicit(&g->largest_component, sa + sb, memory_order_relaxed);
+}
+
+unsigned kg_component_of(const kg_graph_t *g, const kg_entity_t *e) {
+    return uf_find(g, e->id);
+}
+
+size_t kg_component_size(const kg_graph_t *g, const kg_entity_t *e) {
+    return atomic_load_explicit(&kg_entity_at(g, uf_find(g, e->id))->uf_size, memory_order_relaxed);
+}
+
+/* Two finds are not one atomic step: retry while a's root has been
+   linked under another since (only then can b have joined it). */
+int kg_connected(const kg_graph_t *g, const kg_entity_t *a, const kg_entity_t *b) {
+    for (;;) {
+        unsigned ra = uf_find(g, a->id), rb = uf_find(g, b->id);
+        if (ra == rb) return 1;
+        if (atomic_load_explicit(&kg_entity_at(g, ra)->uf_parent, memory_order_acquire) == ra) return 0;
+    }
+}
+
+void kg_component_stats(const kg_graph_t *g, kg_component_stats_t *out) {
+    kg_graph_t *w = (kg_graph_t*)g;
+    out->components = atomic_load_explicit(&w->n_components, memory_order_relaxed);
+    out->largest = atomic_load_explicit(&w->largest_component, memory_order_relaxed);
+    for (int k = 0; k < KG_DEGREE_BUCKETS; ++k)
+        out->size_hist[k] = atomic_load_explicit(&w->component_hist[k], memory_order_relaxed);
+}
+
+/* [SECTION] Importance Scores */
+
+void kg_set_scores(kg_graph_t *g, const double *score, size_t n, unsigned long version) {
+    write_begin(g);
+    size_t count = atomic_load_explicit(&g->n_entities, memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+        atomic_store_explicit(&kg_entity_at(g, i)->score, i < n ? (float)score[i] : 0.0f, memory_order_relaxed);
+    atomic_store_explicit(&g->scores_version, version, memory_order_relaxed);
+    write_end(g);
+}
+
+void kg_clear_scores(kg_graph_t *g) {
+    write_begin(g);
+    size_t count = atomic_load_explicit(&g->n_entities, memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) atomic_store_explicit(&kg_entity_at(g, i)->score, 0.0f, memory_order_relaxed);
+    atomic_store_explicit(&g->scores_version, 0, memory_order_relaxed);
+    write_end(g);
+}
+
+/* [SECTION] Graph Operations (Edges/Relations) */
+
+kg_status_t kg_add_edge(kg_graph_t *g, const char *src, const char *rel, const char *tgt,
+                        kg_relation_t **out) {
+    return kg_add_edge_weighted(g, src, rel, tgt, 1.0, out);
+}
+
+/* Writer only. Everything an edge needs that can fail: its endpoints, its
+   label and the edge itself, filled in but not yet linked. */
+static kg_status_t stage_edge(kg_graph_t *g, const char *src, const char *rel, const char *tgt,
+                              double weight, kg_entity_t **S, kg_relation_t **out) {
+    if (!src || !src[0] || !tgt || !tgt[0] || !rel || !rel[0]) return KG_ERR_INVALID;
+    if (!(weight >= 0.0 && weight <= FLT_MAX)) return KG_ERR_INVALID;   /* also NaN */
+    kg_relation_t *R = (kg_relation_t*)malloc(sizeof(kg_relation_t));
+    if (!R) return KG_ERR_NOMEM;
+
+    kg_entity_t *T;
+    kg_status_t st = add_entity_locked(g, src, S);
+    if (st == KG_OK || st == KG_ERR_EXISTS) st = add_entity_locked(g, tgt, &T);
+    if (st == KG_OK || st == KG_ERR_EXISTS) {
+        R->label = intern_label(g, rel);
+        if (R->label == KG_NO_LABEL) st = KG_ERR_NOMEM;
+    }
+    if (st != KG_OK && st != KG_ERR_EXISTS) { free(R); return st; }
+    R->rel = kg_label_name(g, R->label);
+    R->weight = (float)weight;
+    R->target = T;
+    *out = R;
+    return KG_OK;
+}
+
+/* Writer only, with degree_reserve() room for two keys; cannot fail. */
+static void link_edge(kg_graph_t *g, kg_entity_t *S, kg_relation_t *R) {
+    R->born = pending_version(g);
+    R->next = atomic_load_explicit(&S->relations, memory_order_relaxed);
+    atomic_store_explicit(&S->relations, R, memory_order_release);
+    atomic_fetch_add_explicit(&g->n_edges, 1, memory_order_relaxed);
+    if (R->weight != 1.0f) atomic_fetch_add_explicit(&g->n_weighted, 1, memory_order_relaxed);
+    label_stats_add(g, R->label, S->id, R->target->id);
+    component_union(g, S, R->target);
+    mem_account(g, KG_MEM_ADJACENCY, (long)sizeof(kg_relation_t), (long)sizeof(kg_relation_t), 1);
+}
+
+kg_status_t kg_add_edge_weighted(kg_graph_t *g, const char *src, const char *rel, const char *tgt,
+                                 double weight, kg_relation_t **out) {
+    kg_entity_t *S;
+    kg_relation_t *R;
+    write_begin(g);
+    kg_status_t st = stage_edge(g, src, rel, tgt, weight, &S, &R);
+    if (st == KG_OK && !degree_reserve(g, 2)) { free(R); st = KG_ERR_NOMEM; }
+    if (st == KG_OK) link_edge(g, S, R);
+    write_end(g);
+    if (st == KG_OK && out) *out = R;
+    return st;
+}
+
+/*
+   [SECTION] Fuzzy Search (Case-insensitive + Prefix/Substring Suggestions)
+   - Disambiguation between several candidates is left to the caller.
+   - With scores set, prefix and substring passes scan every entity and
+     keep the `max` best by insertion, since the best may come last.
+ */
+/* Adds e to the sc matches in out[max]: appended in id order, or by
+   descending score (earlier ids first among equals) when ranked. */
+static int keep_match(kg_entity_t **out, int sc, int max, kg_entity_t *e, int ranked) {
+    if (!ranked) { out[sc] = e; return sc + 1; }
+    float x = kg_score(e);
+    int k = sc < max ? sc : max - 1;
+    if (sc == max && kg_score(out[k]) >= x) return sc;
+    while (k > 0 && kg_score(out[k - 1]) < x) { out[k] = out[k - 1]; k--; }
+    out[k] = e;
+    return sc < max ? sc + 1 : sc;
+}
+
+kg_match_t kg_search(const kg_graph_t *g, const char *query,
+                     kg_entity_t **out, int max, int *count) {
+    char key[KG_NAME_LEN]; strncpy(key, query, KG_NAME_LEN-1); key[KG_NAME_LEN-1] = '\0';
+    kg_trim(key); kg_squeeze_spaces(key);
+    *count = 0;
+    if (key[0] == '\0' || max <= 0) return KG_MATCH_NONE;
+
+    kg_snapshot_t s;
+    if (kg_snapshot_acquire(g, &s) != KG_OK) return KG_MATCH_NONE;
+    size_t n = s.n_entities;
+    kg_match_t m = KG_MATCH_NONE;
+    kg_profile_t *prof = tl_profile;
+    unsigned long t = prof ? prof_now() : 0;
+    size_t scanned = 0;             /* entities compared, over all passes */
+
+    /* Pass 1: exact (case-insensitive) */
+    for (size_t i = 0; i < n; ++i) {
+        kg_entity_t *e = kg_entity_at(g, i);
+        if (kg_visible(&s, e) && kg_ci_cmp(e->name, key) == 0) {
+            out[0] = e; *count = 1;
+            m = KG_MATCH_EXACT;
+            scanned += i + 1;
+            if (prof) prof_phase(prof, KG_PHASE_SEARCH_EXACT, &t);
+            goto done;
+        }
+    }
+    scanned += n;
+    if (prof) prof_phase(prof, KG_PHASE_SEARCH_EXACT, &t);
+
+    /* Pass 2: prefix (case-insensitive) */
+    char lowK[KG_NAME_LEN];
+    kg_to_lower_copy(key, lowK, sizeof(lowK));
+    size_t klen = strlen(lowK);
+    int sc = 0;
+    int ranked = kg_scores_version(g) != 0;    /* scan all, keep the best */
+    size_t i;
+    for (i = 0; i < n && (ranked || sc < max); ++i) {
+        kg_entity_t *e = kg_entity_at(g, i);
+        char lowE[KG_NAME_LEN];
+        if (!kg_visible(&s, e)) continue;
+        kg_to_lower_copy(e->name, lowE, sizeof(lowE));
+        if (strncmp(lowE, lowK, klen) == 0) sc = keep_match(out, sc, max, e, ranked);
+    }
+    scanned += i;
+    if (prof) prof_phase(prof, KG_PHASE_SEARCH_PREFIX, &t);
+    if (sc) { *count = sc; m = KG_MATCH_PREFIX; goto done; }
+
+    /* Pass 3: substring (case-insensitive) */
+    for (i = 0; i < n && (ranked || sc < max); ++i) {
+        kg_entity_t *e = kg_entity_at(g, i);
+        if (kg_visible(&s, e) && kg_ci_contains(e->name, key)) sc = keep_match(out, sc, max, e, ranked);
+    }
+    scanned += i;
+    if (prof) prof_phase(prof, KG_PHASE_SEARCH_SUBSTRING, &t);
+    *count = sc;
+    if (sc) m = KG_MATCH_SUBSTRING;
+done:
+    kg_snapshot_release(&s);
+    if (prof) {
+        prof->candidates += scanned;
+        prof->matches += (unsigned long)*count;
+    }
+    return m;
+}
+
+/*
+   [SECTION] BFS Path Finding
+   - prev[] doubles as the visited mark; the queue never needs to grow
+     because each entity is enqueued at most once.
+   - Runs against one snapshot: entities and edges born after it are
+     invisible, so a concurrent batch is seen entirely or not at all.
+ */
+/* Accounting for one of the two scratch arrays (each n unsigneds). */
+static void bfs_release(const kg_graph_t *g, size_t n) {
+    mem_account(g, KG_MEM_BFS, -(long)(n * sizeof(unsigned)), -(long)(n * sizeof(unsigned)), -1);
+}
+
+kg_status_t kg_shortest_path_pruned_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                       const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                       const unsigned *comp, unsigned floor, kg_path_t *out) {
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    if (!src || !tgt || !kg_visible(s, src) || !kg_visible(s, tgt)) return KG_ERR_NOT_FOUND;
+    if (!kg_connected(s->g, src, tgt)) return KG_ERR_NO_PATH;
+    if (comp && (comp[src->id] < floor || comp[tgt->id] < floor)) return KG_ERR_NO_PATH;
+
+    const kg_graph_t *g = s->g;
+    size_t n = s->n_entities;
+    kg_profile_t *prof = tl_profile;
+    unsigned long t = prof ? prof_now() : 0;
+    unsigned *prev = (unsigned*)malloc(n * sizeof(unsigned));
+    unsigned *Q = (unsigned*)malloc(n * sizeof(unsigned));
+    if (!prev || !Q) { free(prev); free(Q); return KG_ERR_NOMEM; }
+    mem_account(g, KG_MEM_BFS, (long)(2 * n * sizeof(unsigned)), (long)(2 * n * sizeof(unsigned)), 2);
+    memset(prev, 0xff, n * sizeof(unsigned));   /* KG_NO_ENTITY */
+
+    size_t head = 0, tail = 0, hwm = 1;
+    prev[src->id] = src->id; Q[tail++] = src->id;
+    int found = 0;
+    unsigned long scanned = 0;
+    if (prof) prof_phase(prof, KG_PHASE_BFS_RESET, &t);
+
+    while (head < tail) {
+        unsigned cur = Q[head++];
+        if (cur == tgt->id) { found = 1; break; }
+
+        for (kg_relation_t *r = kg_snapshot_relations(s, kg_entity_at(g, cur)); r; r = r->next) {
+            unsigned nx = r->target->id;
+            scanned++;
+            if (f && !kg_label_allowed(f, r->label)) continue;
+            if (prev[nx] == KG_NO_ENTITY && (!comp || comp[nx] >= floor)) {
+                prev[nx] = cur;
+                Q[tail++] = nx;
+            }
+        }
+        if (tail - head > hwm) hwm = tail - head;
+    }
+    free(Q);
+    bfs_release(g, n);
+
+    kg_graph_counters_t *c = &((kg_graph_t*)g)->counters;
+    atomic_fetch_add_explicit(&c->bfs_runs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->bfs_edges, scanned, memory_order_relaxed);
+    kg_hist_record(&c->bfs_visited, head);
+    if (prof) {
+        prof_phase(prof, KG_PHASE_BFS_EXPAND, &t);
+        prof->nodes_visited += head;
+        prof->edges_scanned += scanned;
+        if (hwm > prof->queue_hwm) prof->queue_hwm = hwm;
+    }
+    if (!found) { free(prev); bfs_release(g, n); return KG_ERR_NO_PATH; }
+
+    /* Reconstruct path (walk prev back to the source, then fill in reverse) */
+    size_t len = 1;
+    for (unsigned p = tgt->id; p != src->id; p = prev[p]) len++;
+    out->nodes = (kg_entity_t**)malloc(len * sizeof(kg_entity_t*));
+    if (!out->nodes) { free(prev); bfs_release(g, n); return KG_ERR_NOMEM; }
+    out->len = len;
+    out->cost = (double)(len - 1);
+    unsigned p = tgt->id;
+    for (size_t i = len; i-- > 0; p = prev[p]) out->nodes[i] = kg_entity_at(g, p);
+
+    free(prev);
+    bfs_release(g, n);
+    if (prof) {
+        prof_phase(prof, KG_PHASE_BFS_PATH, &t);
+        prof->path_len = len;
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_shortest_path_filtered_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                         const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                         kg_path_t *out) {
+    return kg_shortest_path_pruned_at(s, src, tgt, f, NULL, 0, out);
+}
+
+kg_status_t kg_shortest_path_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                const kg_entity_t *tgt, kg_path_t *out) {
+    return kg_shortest_path_filtered_at(s, src, tgt, NULL, out);
+}
+
+kg_status_t kg_shortest_path_filtered(const kg_graph_t *g, const kg_entity_t *src,
+                                      const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                      kg_path_t *out) {
+    kg_snapshot_t s;
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_shortest_path_filtered_at(&s, src, tgt, f, out);
+    kg_snapshot_release(&s);
+    return st;
+}
+
+kg_status_t kg_shortest_path(const kg_graph_t *g, const kg_entity_t *src,
+                             const kg_entity_t *tgt, kg_path_t *out) {
+    return kg_shortest_path_filtered(g, src, tgt, NULL, out);
+}
+
+void kg_path_free(kg_path_t *p) {
+    free(p->nodes);
+    p->nodes = NULL; p->len = 0; p->cost = 0;
+}
+
+/*
+   [SECTION] Weighted Paths (Dijkstra / A*)
+   - Lazy deletion: a node is pushed again whenever its distance drops and
+     stale entries are skipped when popped, so no position index is kept.
+   - The heap stores the key next to the id; keys of the four children of a
+     slot are adjacent in memory.
+ */
+typedef struct heap_item {
+    double key;                  /* dist + h */
+    unsigned v;
+} heap_item_t;
+
+typedef struct dheap {
+    heap_item_t *a;
+    size_t n, cap;
+} dheap_t;
+
+#define DHEAP_D 4
+
+static int dheap_push(dheap_t *h, double key, unsigned v) {
+    if (h->n == h->cap) {
+        size_t cap = h->cap ? h->cap * 2 : 256;
+        heap_item_t *a = (heap_item_t*)realloc(h->a, cap * sizeof(heap_item_t));
+        if (!a) return 0;
+        h->a = a; h->cap = cap;
+    }
+    size_t i = h->n++;
+    while (i > 0) {
+        size_t p = (i - 1) / DHEAP_D;
+        if (h->a[p].key <= key) break;
+        h->a[i] = h->a[p];
+        i = p;
+    }
+    h->a[i].key = key; h->a[i].v = v;
+    return 1;
+}
+
+static heap_item_t dheap_pop(dheap_t *h) {
+    heap_item_t top = h->a[0], last = h->a[--h->n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = i * DHEAP_D + 1;
+        if (c >= h->n) break;
+        size_t end = c + DHEAP_D < h->n ? c + DHEAP_D : h->n, m = c;
+        for (size_t k = c + 1; k < end; ++k) if (h->a[k].key < h->a[m].key) m = k;
+        if (h->a[m].key >= last.key) break;
+        h->a[i] = h->a[m];
+        i = m;
+    }
+    if (h->n) h->a[i] = last;
+    return top;
+}
+
+kg_status_t kg_weighted_path_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                                const kg_label_filter_t *f, kg_heuristic_fn hfn, void *hctx,
+                                kg_path_t *out) {
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    if (!src || !tgt || !kg_visible(s, src) || !kg_visible(s, tgt)) return KG_ERR_NOT_FOUND;
+    if (!kg_connected(s->g, src, tgt)) return KG_ERR_NO_PATH;
+
+    const kg_graph_t *g = s->g;
+    size_t n = s->n_entities;
+    kg_profile_t *prof = tl_profile;
+    unsigned long t = prof ? prof_now() : 0;
+    double *dist = (double*)malloc(n * sizeof(double));
+    unsigned *prev = (unsigned*)malloc(n * sizeof(unsigned));
+    dheap_t h = { NULL, 0, 0 };
+    if (!dist || !prev) { free(dist); free(prev); return KG_ERR_NOMEM; }
+    mem_account(g, KG_MEM_BFS, (long)(n * (sizeof(double) + sizeof(unsigned))),
+                (long)(n * (sizeof(double) + sizeof(unsigned))), 2);
+    for (size_t i = 0; i < n; ++i) dist[i] = INFINITY;
+    memset(prev, 0xff, n * sizeof(unsigned));   /* KG_NO_ENTITY */
+    if (prof) prof_phase(prof, KG_PHASE_BFS_RESET, &t);
+
+    kg_status_t st = KG_ERR_NO_PATH;
+    unsigned long scanned = 0, settled = 0;
+    size_t hwm = 1;
+    dist[src->id] = 0.0;
+    prev[src->id] = src->id;
+    if (!dheap_push(&h, hfn ? hfn(hctx, src, tgt) : 0.0, src->id)) st = KG_ERR_NOMEM;
+
+    while (st == KG_ERR_NO_PATH && h.n) {
+        heap_item_t it = dheap_pop(&h);
+        unsigned cur = it.v;
+        double d = dist[cur];
+        kg_entity_t *ce = kg_entity_at(g, cur);
+        if (it.key > d + (hfn ? hfn(hctx, ce, tgt) : 0.0)) continue;   /* stale entry */
+        settled++;
+        if (cur == tgt->id) { st = KG_OK; break; }
+
+        for (kg_relation_t *r = kg_snapshot_relations(s, ce); r; r = r->next) {
+            scanned++;
+            if (f && !kg_label_allowed(f, r->label)) continue;
+            unsigned nx = r->target->id;
+            double nd = d + (double)r->weight;
+            if (nd < dist[nx]) {
+                dist[nx] = nd;
+                prev[nx] = cur;
+                double hv = hfn ? hfn(hctx, r->target, tgt) : 0.0;
+                if (hv == INFINITY) continue;       /* heuristic proved tgt unreachable from nx */
+                if (!dheap_push(&h, nd + hv, nx)) { st = KG_ERR_NOMEM; break; }
+            }
+        }
+        if (h.n > hwm) hwm = h.n;
+    }
+    free(h.a);
+
+    kg_graph_counters_t *c = &((kg_graph_t*)g)->counters;
+    atomic_fetch_add_explicit(&c->bfs_runs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->bfs_edges, scanned, memory_order_relaxed);
+    kg_hist_record(&c->bfs_visited, settled);
+    if (prof) {
+        prof_phase(prof, KG_PHASE_HEAP_EXPAND, &t);
+        prof->nodes_visited += settled;
+        prof->edges_scanned += scanned;
+        if (hwm > prof->queue_hwm) prof->queue_hwm = hwm;
+    }
+
+    if (st == KG_OK) {
+        size_t len = 1;
+        for (unsigned p = tgt->id; p != src->id; p = prev[p]) len++;
+        out->nodes = (kg_entity_t**)malloc(len * sizeof(kg_entity_t*));
+        if (!out->nodes) st = KG_ERR_NOMEM;
+        else {
+            out->len = len;
+            out->cost = dist[tgt->id];
+            unsigned p = tgt->id;
+            for (size_t i = len; i-- > 0; p = prev[p]) out->nodes[i] = kg_entity_at(g, p);
+        }
+        if (prof) {
+            prof_phase(prof, KG_PHASE_BFS_PATH, &t);
+            prof->path_len = len;
+        }
+    }
+    free(dist); free(prev);
+    mem_account(g, KG_MEM_BFS, -(long)(n * (sizeof(double) + sizeof(unsigned))),
+                -(long)(n * (sizeof(double) + sizeof(unsigned))), -2);
+    return st;
+}
+
+kg_status_t kg_weighted_path(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                             const kg_label_filter_t *f, kg_heuristic_fn h, void *hctx,
+                             kg_path_t *out) {
+    kg_snapshot_t s;
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_weighted_path_at(&s, src, tgt, f, h, hctx, out);
+    kg_snapshot_release(&s);
+    return st;
+}
+
+double kg_path_weight_filtered(const kg_snapshot_t *s, const kg_path_t *p, const kg_label_filter_t *f) {
+    double total = 0.0;
+    for (size_t i = 0; i + 1 < p->len; ++i) {
+        double best = INFINITY;
+        for (kg_relation_t *r = kg_snapshot_relations(s, p->nodes[i]); r; r = r->next)
+            if (r->target == p->nodes[i + 1] && (double)r->weight < best && (!f || kg_label_allowed(f, r->label)))
+                best = (double)r->weight;
+        total += best;
+    }
+    return total;
+}
+
+double kg_path_weight(const kg_snapshot_t *s, const kg_path_t *p) {
+    return kg_path_weight_filtered(s, p, NULL);
+}
+
+/*
+   [SECTION] Memory Report
+   - Counters come from the accounting above; name sizes and the edge
+     count from one pass over a snapshot.
+ */
+
+kg_status_t kg_memory_report(const kg_graph_t *g, kg_mem_report_t *out) {
+    memset(out, 0, sizeof(*out));
+    kg_snapshot_t s;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+
+    size_t name_bytes = 0, n = 0, m = 0, used = kg_label_count(g);
+    for (size_t i = 0; i < s.n_entities; ++i) {
+        kg_entity_t *e = kg_entity_at(g, i);
+        if (!kg_visible(&s, e)) continue;
+        n++;
+        name_bytes += strlen(e->name) + 1;
+        for (kg_relation_t *r = kg_snapshot_relations(&s, e); r; r = r->next) m++;
+    }
+    kg_snapshot_release(&s);
+
+    for (int c = 0; c < KG_MEM_CATS; ++c) {
+        const kg_mem_account_t *a = &g->mem[c];
+        out->cat[c].bytes = (size_t)atomic_load_explicit(&((kg_mem_account_t*)a)->bytes, memory_order_relaxed);
+        out->cat[c].payload = (size_t)atomic_load_explicit(&((kg_mem_account_t*)a)->payload, memory_order_relaxed);
+        out->cat[c].objects = (size_t)atomic_load_explicit(&((kg_mem_account_t*)a)->objects, memory_order_relaxed);
+        out->cat[c].peak = (size_t)atomic_load_explicit(&((kg_mem_account_t*)a)->peak, memory_order_relaxed);
+        if (c != KG_MEM_BFS) out->total += out->cat[c].bytes;
+    }
+    /* Index structures carry one pointer of data per entity. */
+    out->cat[KG_MEM_BUCKETS].payload = n * sizeof(kg_entity_t*);
+    out->cat[KG_MEM_DIRECTORY].payload = n * sizeof(kg_entity_t*);
+
+    out->entities = n;
+    out->edges = m;
+    out->distinct_labels = used;
+    if (n) {
+        out->bytes_per_entity = (double)(out->cat[KG_MEM_NAMES].bytes + out->cat[KG_MEM_ENTITIES].bytes +
+                                         out->cat[KG_MEM_BUCKETS].bytes + out->cat[KG_MEM_DIRECTORY].bytes) / (double)n;
+        out->min_per_entity = (double)name_bytes / (double)n + 8.0;
+    }
+    if (m) {
+        unsigned bits = 0;
+        while (used > 1 && ((size_t)1 << bits) < used) bits++;
+        out->bytes_per_edge = (double)(out->cat[KG_MEM_LABELS].bytes + out->cat[KG_MEM_ADJACENCY].bytes) / (double)m;
+        out->min_per_edge = 4.0 + bits / 8.0;
+    }
+    return KG_OK;
+}
+
+/*
+   [SECTION] File I/O: Robust Load & Save
+   - Trims & normalizes spaces around tokens
+ */
+int kg_parse_relation_line_weighted(char *line, char *src, char *rel, char *tgt, double *weight) {
+    /* Expect two '|' separators, optionally a third before the weight */
+    char *p1 = strchr(line, '|');
+    if (!p1) return 0;
+    char *p2 = strchr(p1 + 1, '|');
+    if (!p2) return 0;
+    char *p3 = strchr(p2 + 1, '|');
+
+    *weight = 1.0;
+    if (p3) {
+        char *end;
+        errno = 0;
+        double w = strtod(p3 + 1, &end);
+        while (isspace((unsigned char)*end)) end++;
+        if (end == p3 + 1 || *end != '\0' || errno == ERANGE) return 0;
+        if (!(w >= 0.0 && w <= FLT_MAX)) return 0;
+        *weight = w;
+    }
+
+    /* Extract substrings */
+    size_t L1 = (size_t)(p1 - line);
+    size_t L2 = (size_t)(p2 - (p1 + 1));
+    size_t L3 = p3 ? (size_t)(p3 - (p2 + 1)) : strlen(p2 + 1);
+
+    if (L1 == 0 || L2 == 0 || L3 == 0) return 0;
+
+    if (L1 >= KG_NAME_LEN) L1 = KG_NAME_LEN - 1;
+    if (L2 >= KG_REL_LEN)  L2 = KG_REL_LEN - 1;
+    if (L3 >= KG_NAME_LEN) L3 = KG_NAME_LEN - 1;
+
+    memcpy(src, line, L1); src[L1] = '\0';
+    memcpy(rel, p1 + 1, L2); rel[L2] = '\0';
+    memcpy(tgt, p2 + 1, L3); tgt[L3] = '\0';
+
+    kg_trim(src); kg_trim(rel); kg_trim(tgt);
+    kg_squeeze_spaces(src); kg_squeeze_spaces(rel); kg_squeeze_spaces(tgt);
+    return src[0] && rel[0] && tgt[0];
+}
+
+int kg_parse_relation_line(char *line, char *src, char *rel, char *tgt) {
+    double w;
+    return kg_parse_relation_line_weighted(line, src, rel, tgt, &w);
+}
+
+typedef struct staged_edge {
+    kg_entity_t *src;
+    kg_relation_t *rel;
+} staged_edge_t;
+
+kg_status_t kg_load_file(kg_graph_t *g, const char *filename,
+                         kg_load_stats_t *stats, kg_load_cb cb, void *ctx) {
+    kg_load_stats_t local = { 0, 0 };
+    if (!stats) stats = &local;
+    stats->loaded = stats->skipped = 0;
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return KG_ERR_IO;
+
+    char line[KG_LINE_BUF];
+    int lineNo = 0;
+    kg_status_t st = KG_OK;
+    staged_edge_t *staged = NULL;
+    size_t n_staged = 0, cap = 0;
+
+    write_begin(g);
+    size_t n0 = atomic_load_explicit(&g->n_entities, memory_order_relaxed);
+    while (fgets(line, sizeof(line), fp)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = 0;
+        kg_trim(line);
+        if (line[0] == '\0') continue;      /* skip blanks */
+        if (line[0] == '#')  continue;      /* skip comments */
+
+        char src[KG_NAME_LEN], rel[KG_REL_LEN], tgt[KG_NAME_LEN];
+        double w;
+        if (!kg_parse_relation_line_weighted(line, src, rel, tgt, &w)) {
+            stats->skipped++;
+            if (cb) cb(ctx, lineNo, line, NULL, NULL);
+            continue;
+        }
+        if (n_staged == cap) {
+            size_t ncap = cap ? cap * 2 : 1024;
+            staged_edge_t *grown = (staged_edge_t*)realloc(staged, ncap * sizeof(staged_edge_t));
+            if (!grown) { st = KG_ERR_NOMEM; break; }
+            staged = grown; cap = ncap;
+        }
+        staged_edge_t *e = &staged[n_staged];
+        if ((st = stage_edge(g, src, rel, tgt, w, &e->src, &e->rel)) != KG_OK) break;
+        n_staged++;
+        stats->loaded++;
+        if (cb) cb(ctx, lineNo, line, e->src, e->rel);
+    }
+    if (st == KG_OK && ferror(fp)) st = KG_ERR_IO;
+    if (st == KG_OK && !degree_reserve(g, 2 * n_staged)) st = KG_ERR_NOMEM;
+
+    if (st == KG_OK) {
+        for (size_t i = 0; i < n_staged; ++i) link_edge(g, staged[i].src, staged[i].rel);
+    } else {
+        /* Nothing was linked: drop the edges and hide the entities this
+           load created, or revived (older ids; outside a nested batch,
+           whose own entities share the pending version) */
+        for (size_t i = 0; i < n_staged; ++i) free(staged[i].rel);
+        unsigned long pending = atomic_load_explicit(&g->version, memory_order_relaxed) + 1;
+        size_t n = atomic_load_explicit(&g->n_entities, memory_order_relaxed);
+        for (size_t id = g->write_depth == 1 ? 0 : n0; id < n; ++id) {
+            kg_entity_t *e = kg_entity_at(g, id);
+            unsigned long born = atomic_load_explicit(&e->born, memory_order_relaxed);
+            if (born == KG_BORN_NEVER || (id < n0 && born != pending)) continue;
+            atomic_store_explicit(&e->born, KG_BORN_NEVER, memory_order_relaxed);
+            component_count(g, -1);
+        }
+        if (!atomic_load_explicit(&g->n_components, memory_order_relaxed))
+            atomic_store_explicit(&g->largest_component, 0, memory_order_relaxed);
+        stats->loaded = 0;
+    }
+    free(staged);
+    write_end(g);
+    fclose(fp);
+    return st;
+}
+
+kg_status_t kg_save_file_at(const kg_snapshot_t *s, const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if (!fp) return KG_ERR_IO;
+
+    for (size_t i = 0; i < s->n_entities; ++i) {
+        kg_entity_t *e = kg_entity_at(s->g, i);
+        if (!kg_visible(s, e)) continue;
+        for (kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next) {
+            if (r->weight == 1.0f) fprintf(fp, "%s|%s|%s\n", e->name, r->rel, r->target->name);
+            else fprintf(fp, "%s|%s|%s|%g\n", e->name, r->rel, r->target->name, (double)r->weight);
+        }
+    }
+    return fclose(fp) == 0 ? KG_OK : KG_ERR_IO;
+}
+
+kg_status_t kg_save_file(const kg_graph_t *g, const char *filename) {
+    kg_snapshot_t s;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_save_file_at(&s, filename);
+    kg_snapshot_release(&s);
+    return st;
+}
+
+/*
+   [SECTION] GraphViz .dot Export (for PNG rendering externally)
+*/
+kg_status_t kg_export_dot_at(const kg_snapshot_t *s, const char *dotfile) {
+    FILE *fp = fopen(dotfile, "w");
+    if (!fp) return KG_ERR_IO;
+
+    // Modern GraphViz Styling
+    fprintf(fp, "digraph KnowledgeGraph {\n");
+    fprintf(fp, "  rankdir=LR;\n");
+    fprintf(fp, "  layout=dot;\n");
+    fprintf(fp, "  graph [splines=true, overlap=false, ranksep=1.3, nodesep=1.0, fontsize=12, fontname=\"Calibri\", bgcolor=\"#FFFFFF\"];\n");
+
+    // Node Style (Soft Blue | Rounded Box | Drop Shadow-ish contrast)
+    fprintf(fp, "  node [shape=box, style=filled, fontname=\"Calibri\", fontsize=11, penwidth=1.5, "
+                "color=\"#1A73E8\", fillcolor=\"#E8F0FE\", fontcolor=\"#202124\"];\n");
+    // Edge Style (Smooth dark gray arrows with nice labels)
+    fprintf(fp, "  edge [color=\"#5F6368\", fontname=\"Calibri\", fontsize=10, penwidth=1.3, arrowsize=0.85, fontcolor=\"#3C4043\"];\n\n");
+
+    // Entities & Relations Output
+    for (size_t i = 0; i < s->n_entities; ++i) {
+        kg_entity_t *e = kg_entity_at(s->g, i);
+        if (!kg_visible(s, e)) continue;
+        kg_relation_t *head = kg_snapshot_relations(s, e);
+        if (!head) {
+            fprintf(fp, "  \"%s\";\n", e->name);
+        }
+        for (kg_relation_t *r = head; r; r = r->next) {
+            if (r->weight == 1.0f)
+                fprintf(fp, "  \"%s\" -> \"%s\" [label=\"%s\"];\n", e->name, r->target->name, r->rel);
+            else
+                fprintf(fp, "  \"%s\" -> \"%s\" [label=\"%s (%g)\"];\n",
+                        e->name, r->target->name, r->rel, (double)r->weight);
+        }
+    }
+
+    fprintf(fp, "}\n");
+    return fclose(fp) == 0 ? KG_OK : KG_ERR_IO;
+}
+
+kg_status_t kg_export_dot(const kg_graph_t *g, const char *dotfile) {
+    kg_snapshot_t s;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_export_dot_at(&s, dotfile);
+    kg_snapshot_release(&s);
+    return st;
+}
@@ -0,0 +1,569 @@
+/* =========================================================================
+   Knowledge Graph Engine — Library API
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     The embeddable graph engine behind the console menu (ipproject.c).
+     No global state: every call takes a kg_graph_t, so several graphs can
+     live in one process. Nothing here prints; results come back as status
+     codes and result structs. Readers never block behind writers.
+->   Build:
+     gcc -c -pthread kg_graph.c
+     (link kg_graph.o into any program that includes this header)
+
+   ========================================================================= */
+#ifndef KG_GRAPH_H
+#define KG_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "kg_hist.h"
+
+/* [SECTION] Limits */
+
+#define KG_NAME_LEN     128
+#define KG_REL_LEN      128
+#define KG_LINE_BUF     512
+#define KG_HASH_INIT    128      /* initial slot count (power of two) */
+#define KG_NO_ENTITY    ((unsigned)-1)
+#define KG_NO_LABEL     ((unsigned)-1)
+
+/* [SECTION] Status Codes */
+
+typedef enum kg_status {
+    KG_OK = 0,
+    KG_ERR_NOMEM,        /* allocation failed */
+    KG_ERR_INVALID,      /* empty / malformed argument */
+    KG_ERR_NOT_FOUND,    /* entity does not exist */
+    KG_ERR_EXISTS,       /* entity already exists */
+    KG_ERR_NO_PATH,      /* source cannot reach target */
+    KG_ERR_IO            /* file could not be opened / written */
+} kg_status_t;
+
+const char *kg_strerror(kg_status_t st);
+
+/* =========================================================================
+   [SECTION] Data Structures
+   - kg_relation_t: labeled directed edge to a target entity; labels are
+     interned, so an edge holds a dense label id plus the shared text
+   - kg_entity_t: node with name, dense id, adjacency list head, and its
+     place in the union-find forest of weakly connected components
+   - kg_graph_t: open-addressing name index + segmented id directory
+
+   Concurrency: writers (kg_add_*, kg_load_file, batches) serialize on an
+   internal mutex. Readers take no locks at all: a new entity, edge or hash
+   table is fully built first and then published with a single release
+   store. Entities and edges are never moved or freed before kg_graph_free().
+
+   Versions (MVCC): every write is stamped with the version it belongs to
+   and becomes visible when that version is published — one version per
+   standalone write, one per batch. Readers pin a snapshot (a version) and
+   ignore anything born after it, so a traversal never sees half a batch.
+   Adjacency lists are prepend-only, so "as of version v" is simply the
+   list minus its newer prefix; no copies are needed.
+   ========================================================================= */
+typedef struct kg_entity kg_entity_t;
+
+typedef struct kg_relation {
+    const char *rel;             /* interned label text (kg_label_name) */
+    unsigned label;              /* interned label id */
+    float weight;                /* cost, >= 0; 1 unless the file gave one */
+    unsigned long born;          /* version that published this edge */
+    kg_entity_t *target;
+    struct kg_relation *next;    /* adjacency next (immutable once published) */
+} kg_relation_t;
+
+struct kg_entity {
+    char name[KG_NAME_LEN];
+    unsigned id;                 /* dense index, see kg_entity_at() */
+    _Atomic unsigned long born;  /* version that published this entity;
+                                    KG_BORN_NEVER after a failed load */
+    kg_relation_t *_Atomic relations;    /* adjacency list head, newest first */
+    _Atomic unsigned uf_parent;  /* union-find parent id (itself at a root) */
+    unsigned uf_rank;            /* writer only */
+    _Atomic unsigned uf_size;    /* entities in the component, at a root */
+    _Atomic float score;         /* importance, see kg_set_scores(); 0 until set */
+};
+
+/* Linear-probing table of entity pointers, kept at most half full. A grow
+   publishes a new table and retires the old one, which is freed once no
+   pinned reader can still be probing it. */
+typedef struct kg_htable {
+    size_t mask;
+    unsigned long retired_at;    /* last version that could have seen it */
+    struct kg_htable *retired_next;
+    kg_entity_t *_Atomic slots[];
+} kg_htable_t;
+
+/* Entity / label directories: segment k holds KG_DIR_BASE << k entries,
+   so slots never move as the graph grows and readers index without a lock. */
+#define KG_DIR_BASE_BITS  6
+#define KG_DIR_BASE       (1u << KG_DIR_BASE_BITS)
+#define KG_DIR_SEGMENTS   26
+
+static inline unsigned kg_dir_segment(size_t id) {
+    size_t x = id + KG_DIR_BASE;
+    unsigned k = 0;
+#if defined(__GNUC__)
+    k = (unsigned)(sizeof(unsigned long long) * 8 - 1 - (unsigned)__builtin_clzll(x)) - KG_DIR_BASE_BITS;
+#else
+    while ((x >> (k + KG_DIR_BASE_BITS + 1)) != 0) k++;
+#endif
+    return k;
+}
+
+static inline size_t kg_dir_offset(size_t id, unsigned k) {
+    return id + KG_DIR_BASE - ((size_t)KG_DIR_BASE << k);
+}
+
+/* Per-label counters behind kg_label_stats(): written by the writer with
+   relaxed atomics, one directory segment per label_dir segment. */
+#define KG_DEGREE_BUCKETS 32     /* bucket k: degree in [2^k, 2^(k+1)) */
+
+typedef struct kg_label_counts {
+    _Atomic unsigned long edges, subjects, objects, max_out, max_in;
+    _Atomic unsigned long out_hist[KG_DEGREE_BUCKETS];
+    _Atomic unsigned long in_hist[KG_DEGREE_BUCKETS];
+} kg_label_counts_t;
+
+/* Writer-only degree of each (entity, label, direction), open addressing;
+   a slot is empty while its count is 0. */
+typedef struct kg_degree_slot {
+    unsigned entity;
+    unsigned label_dir;          /* label << 1 | 1 for in-degree */
+    unsigned count;
+} kg_degree_slot_t;
+
+typedef struct kg_degree_index {
+    size_t mask, used;
+    kg_degree_slot_t *slots;
+} kg_degree_index_t;
+
+/* Writer-only map from label text to id (readers use the directory). */
+typedef struct kg_label_index {
+    size_t mask, used;
+    unsigned *slots;             /* id + 1, 0 = empty */
+} kg_label_index_t;
+
+/* Entities created by a load that failed: their ids stay taken, but no
+   snapshot sees them until a later write adds the same name again. */
+#define KG_BORN_NEVER ((unsigned long)-1)
+
+/* One per reading thread per graph (see kg_snapshot_acquire). */
+#define KG_PIN_IDLE  ((unsigned long)-1)
+
+typedef struct kg_pin {
+    _Atomic unsigned long version;   /* oldest version held, or KG_PIN_IDLE */
+    int depth;                       /* nested snapshots on the owning thread */
+    struct kg_pin *next;
+} kg_pin_t;
+
+/* Work counters, bumped by readers with relaxed atomics (one update per
+   call, not per probe / edge). Timing is left to the caller. */
+typedef struct kg_graph_counters {
+    _Atomic unsigned long lookups;       /* kg_find_entity() calls */
+    _Atomic unsigned long probes;        /* hash slots they inspected */
+    _Atomic unsigned long bfs_runs;
+    _Atomic unsigned long bfs_edges;     /* adjacency entries scanned */
+    kg_hist_t bfs_visited;               /* entities dequeued per BFS */
+} kg_graph_counters_t;
+
+/* Memory accounting: bytes the library asked malloc for, per subsystem.
+   An entity record is split between its name and the rest, so the report
+   shows what the inline fixed-size name costs. */
+typedef enum kg_mem_cat {
+    KG_MEM_NAMES = 0,    /* entity name arrays */
+    KG_MEM_ENTITIES,     /* rest of each entity record */
+    KG_MEM_LABELS,       /* interned label texts, label directory and index */
+    KG_MEM_ADJACENCY,    /* edge records */
+    KG_MEM_BUCKETS,      /* hash tables, retired ones included until freed */
+    KG_MEM_DIRECTORY,    /* id -> entity segments */
+    KG_MEM_STATS,        /* per-label counters and the degree index behind them */
+    KG_MEM_BFS,          /* BFS scratch (visited + queue) of running queries */
+    KG_MEM_CATS
+} kg_mem_cat_t;
+
+typedef struct kg_mem_account {
+    _Atomic long bytes;          /* currently allocated */
+    _Atomic long payload;        /* of which holds data, e.g. strlen + 1 */
+    _Atomic long objects;
+    _Atomic long peak;           /* high-water mark of bytes */
+} kg_mem_account_t;
+
+typedef struct kg_graph {
+    kg_htable_t *_Atomic table;
+    kg_htable_t *retired;        /* superseded tables awaiting reclamation */
+    size_t table_used;
+    kg_entity_t **dir[KG_DIR_SEGMENTS];
+    const char **label_dir[KG_DIR_SEGMENTS];
+    _Atomic size_t n_labels;     /* published after the label is in label_dir */
+    kg_label_index_t label_index;
+    kg_label_counts_t *label_counts[KG_DIR_SEGMENTS];
+    kg_degree_index_t degrees;
+    _Atomic size_t n_entities;   /* published after the entity is in dir */
+    _Atomic size_t n_edges;
+    _Atomic size_t n_weighted;   /* edges whose weight is not 1 */
+    _Atomic size_t n_components; /* weakly connected, lone entities included */
+    _Atomic size_t largest_component;
+    _Atomic unsigned long component_hist[KG_DEGREE_BUCKETS];   /* by floor(log2 size) */
+    _Atomic unsigned long scores_version;    /* snapshot the scores came from, 0 = none */
+    _Atomic unsigned long version;   /* newest published version */
+    kg_pin_t *_Atomic pins;      /* reader registry, append-only */
+    unsigned long gen;           /* tells graphs apart in thread-local caches */
+    pthread_mutex_t write_lock;
+    void *_Atomic write_owner;   /* thread holding write_lock (re-entrancy) */
+    int write_depth;
+    int write_dirty;             /* something was stamped with version + 1 */
+    _Alignas(64) kg_graph_counters_t counters;   /* own cache lines: readers write here */
+    kg_mem_account_t mem[KG_MEM_CATS];
+} kg_graph_t;
+
+/* A consistent, read-only view of the graph as of `version`. Snapshots are
+   thread-bound: release on the thread that acquired, innermost first. */
+typedef struct kg_snapshot {
+    const kg_graph_t *g;
+    unsigned long version;
+    size_t n_entities;           /* every visible entity has id below this */
+    kg_pin_t *pin;
+} kg_snapshot_t;
+
+/* Result of a path query. nodes[0] is the source, nodes[len-1] the target. */
+typedef struct kg_path {
+    kg_entity_t **nodes;
+    size_t len;
+    double cost;                 /* hops for BFS, sum of weights for Dijkstra / A* */
+} kg_path_t;
+
+/* Fuzzy search outcome, in the order the passes are tried. */
+typedef enum kg_match {
+    KG_MATCH_NONE = 0,
+    KG_MATCH_EXACT,              /* case-insensitive full match (1 result) */
+    KG_MATCH_PREFIX,
+    KG_MATCH_SUBSTRING
+} kg_match_t;
+
+/* Per-line load report. `rel` is NULL when the line was skipped as invalid. */
+typedef void (*kg_load_cb)(void *ctx, int line_no, const char *line,
+                           const kg_entity_t *src, const kg_relation_t *rel);
+
+typedef struct kg_load_stats {
+    int loaded;
+    int skipped;
+} kg_load_stats_t;
+
+/* Per-query breakdown (EXPLAIN / profile). Install one on the calling
+   thread with kg_profile_begin(); every library call made on that thread
+   until kg_profile_end() adds its phase times and work counts to it.
+   Without a profile installed the calls only pay one thread-local load. */
+typedef enum kg_phase {
+    KG_PHASE_LOOKUP = 0,         /* exact hash lookup */
+    KG_PHASE_SEARCH_EXACT,       /* fuzzy search, case-insensitive full-match pass */
+    KG_PHASE_SEARCH_PREFIX,
+    KG_PHASE_SEARCH_SUBSTRING,
+    KG_PHASE_BFS_RESET,          /* scratch allocation + visited reset */
+    KG_PHASE_BFS_EXPAND,         /* frontier expansion */
+    KG_PHASE_BFS_PATH,           /* path reconstruction */
+    KG_PHASE_HEAP_EXPAND,        /* Dijkstra / A*: settle + relax */
+    KG_PHASE_COUNT
+} kg_phase_t;
+
+typedef struct kg_profile {
+    unsigned long phase_ns[KG_PHASE_COUNT];
+    unsigned long phase_calls[KG_PHASE_COUNT];
+    unsigned long lookups, probes;           /* hash lookups and slots inspected */
+    unsigned long candidates;                /* entities compared by fuzzy search */
+    unsigned long matches;                   /* of which returned */
+    unsigned long nodes_visited;             /* BFS dequeues */
+    unsigned long edges_scanned;
+    unsigned long queue_hwm;                 /* largest BFS frontier (queued, not yet dequeued) */
+    unsigned long path_len;
+} kg_profile_t;
+
+typedef struct kg_mem_usage {
+    size_t bytes, payload, objects, peak;
+} kg_mem_usage_t;
+
+/* Where the bytes go, and what the same graph would need at minimum:
+   per entity its name (strlen + 1) plus a 4-byte id slot in the index
+   and a 4-byte adjacency offset; per edge a 4-byte target id plus just
+   enough bits to tell the distinct labels apart. */
+typedef struct kg_mem_report {
+    kg_mem_usage_t cat[KG_MEM_CATS];
+    size_t total;                /* all categories, BFS scratch excluded */
+    size_t entities, edges, distinct_labels;
+    double bytes_per_entity;     /* names + entity records + buckets + directory */
+    double bytes_per_edge;       /* labels + adjacency */
+    double min_per_entity, min_per_edge;
+} kg_mem_report_t;
+
+/* [SECTION] Graph Lifecycle */
+
+kg_graph_t *kg_graph_new(void);
+void kg_graph_free(kg_graph_t *g);
+
+/* [SECTION] Snapshots & Batches */
+
+kg_status_t kg_snapshot_acquire(const kg_graph_t *g, kg_snapshot_t *snap);
+void kg_snapshot_release(kg_snapshot_t *snap);
+
+static inline unsigned long kg_graph_version(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->version, memory_order_acquire);
+}
+
+static inline int kg_visible(const kg_snapshot_t *s, const kg_entity_t *e) {
+    return e->id < s->n_entities
+        && atomic_load_explicit(&((kg_entity_t*)e)->born, memory_order_relaxed) <= s->version;
+}
+
+/* First edge of `e` that exists in the snapshot; everything after it in
+   the list is older, so callers just follow ->next from here. */
+static inline kg_relation_t *kg_snapshot_relations(const kg_snapshot_t *s, const kg_entity_t *e) {
+    kg_relation_t *r = atomic_load_explicit(&((kg_entity_t*)e)->relations, memory_order_acquire);
+    while (r && r->born > s->version) r = r->next;
+    return r;
+}
+
+/* Group writes into one version: readers see all of them or none. Holds
+   the writer lock until commit; other writes on this thread nest inside. */
+void kg_batch_begin(kg_graph_t *g);
+void kg_batch_commit(kg_graph_t *g);
+
+/* [SECTION] Entities & Edges */
+
+static inline size_t kg_entity_count(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->n_entities, memory_order_acquire);
+}
+
+static inline size_t kg_edge_count(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->n_edges, memory_order_relaxed);
+}
+
+/* Non-zero once any edge carries a weight other than 1. */
+static inline int kg_graph_weighted(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->n_weighted, memory_order_relaxed) != 0;
+}
+
+/* id must be below a kg_entity_count() the caller has already read. */
+static inline kg_entity_t *kg_entity_at(const kg_graph_t *g, size_t id) {
+    unsigned k = kg_dir_segment(id);
+    return g->dir[k][kg_dir_offset(id, k)];
+}
+
+/* Returns only committed entities (not those of a batch still open). */
+kg_entity_t *kg_find_entity(const kg_graph_t *g, const char *name);
+kg_status_t kg_add_entity(kg_graph_t *g, const char *name, kg_entity_t **out);
+kg_status_t kg_get_or_add_entity(kg_graph_t *g, const char *name, kg_entity_t **out);
+kg_status_t kg_add_edge(kg_graph_t *g, const char *src, const char *rel, const char *tgt,
+                        kg_relation_t **out);
+/* Same with a cost; KG_ERR_INVALID unless 0 <= weight < inf. */
+kg_status_t kg_add_edge_weighted(kg_graph_t *g, const char *src, const char *rel, const char *tgt,
+                                 double weight, kg_relation_t **out);
+
+/*
+   [SECTION] Relation Labels
+   - Every distinct label text gets a dense id the first time an edge uses
+     it; ids are never reused. Lookups by name are case-insensitive.
+ */
+static inline size_t kg_label_count(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->n_labels, memory_order_acquire);
+}
+
+/* id must be below a kg_label_count() the caller has already read. */
+static inline const char *kg_label_name(const kg_graph_t *g, unsigned id) {
+    unsigned k = kg_dir_segment(id);
+    return g->label_dir[k][kg_dir_offset(id, k)];
+}
+
+/* KG_NO_LABEL if no edge has used this label yet. */
+unsigned kg_find_label(const kg_graph_t *g, const char *name);
+
+/* Which labels a traversal may follow: a bitmask over label ids, built
+   from an allow-list or a deny-list. Labels interned after the filter was
+   built are denied by an allow-list and followed under a deny-list. */
+typedef struct kg_label_filter {
+    size_t nbits;
+    uint64_t *bits;              /* bit set = follow edges with this label */
+    int allow_new;
+} kg_label_filter_t;
+
+/* KG_ERR_NOT_FOUND if a listed label does not exist (its index goes to
+   *bad when bad is not NULL); nothing to free in that case. */
+kg_status_t kg_label_filter_init(const kg_graph_t *g, kg_label_filter_t *f, int deny,
+                                 const char *const *labels, size_t n_labels, size_t *bad);
+/* Same from text: "a, b" allows those labels, "!a, b" follows all but
+   them. An unknown label is copied into bad[bad_len] (may be NULL). */
+kg_status_t kg_label_filter_parse(const kg_graph_t *g, kg_label_filter_t *f, const char *spec,
+                                  char *bad, size_t bad_len);
+void kg_label_filter_free(kg_label_filter_t *f);
+
+static inline int kg_label_allowed(const kg_label_filter_t *f, unsigned label) {
+    if (label >= f->nbits) return f->allow_new;
+    return (int)((f->bits[label >> 6] >> (label & 63)) & 1u);
+}
+
+/*
+   [SECTION] Relation Statistics
+   - Kept per label as edges are added (kg_add_edge*, kg_load_file), for
+     query planning: edge count, distinct subjects and objects, and how
+     many subjects / objects have each out- / in-degree. Parallel edges
+     count once per copy.
+   - A copy may already include a batch still being written: fine for
+     estimates, not for answers.
+ */
+typedef struct kg_label_stats {
+    unsigned long edges;
+    unsigned long subjects, objects;             /* distinct */
+    unsigned long max_out, max_in;               /* largest degree of one subject / object */
+    unsigned long out_hist[KG_DEGREE_BUCKETS];   /* subjects by out-degree, bucket floor(log2 d) */
+    unsigned long in_hist[KG_DEGREE_BUCKETS];    /* objects by in-degree */
+} kg_label_stats_t;
+
+/* KG_ERR_NOT_FOUND unless label < kg_label_count(g). */
+kg_status_t kg_label_stats(const kg_graph_t *g, unsigned label, kg_label_stats_t *out);
+
+/*
+   [SECTION] Connected Components
+   - Union-find over every edge, ignoring direction, updated by each
+     insert (union by rank, under the write lock) and by readers (path
+     halving with CAS: a parent only ever moves up its own tree, so
+     racing readers and the writer never break it). O(α(n)) per call.
+   - Components only ever merge, so "not connected" also holds for every
+     older snapshot, and no path can exist in either direction. "Connected"
+     may already count edges of a batch still being written.
+ */
+typedef struct kg_component_stats {
+    size_t components;
+    size_t largest;                              /* entities in the biggest one */
+    unsigned long size_hist[KG_DEGREE_BUCKETS];  /* components by size, bucket floor(log2 size) */
+} kg_component_stats_t;
+
+/* Id of the entity at the root of e's component; stable until its
+   component merges with another. */
+unsigned kg_component_of(const kg_graph_t *g, const kg_entity_t *e);
+size_t kg_component_size(const kg_graph_t *g, const kg_entity_t *e);
+int kg_connected(const kg_graph_t *g, const kg_entity_t *a, const kg_entity_t *b);
+void kg_component_stats(const kg_graph_t *g, kg_component_stats_t *out);
+
+/*
+   [SECTION] Importance Scores
+   - One float per entity (e.g. PageRank from kg_rank.h), replaced as a
+     whole under the write lock and read without one.
+   - While scores are set, kg_search() returns the best-scoring prefix or
+     substring matches, highest first, instead of the first ones by id.
+     Entities added later score 0 until the next kg_set_scores().
+ */
+/* score[i] for the entity with id i; entities from id n on get 0.
+   version is the snapshot the scores describe (kg_scores_version()). */
+void kg_set_scores(kg_graph_t *g, const double *score, size_t n, unsigned long version);
+void kg_clear_scores(kg_graph_t *g);
+
+static inline float kg_score(const kg_entity_t *e) {
+    return atomic_load_explicit(&((kg_entity_t*)e)->score, memory_order_relaxed);
+}
+
+/* 0 while no scores are set. */
+static inline unsigned long kg_scores_version(const kg_graph_t *g) {
+    return atomic_load_explicit(&((kg_graph_t*)g)->scores_version, memory_order_relaxed);
+}
+
+/* [SECTION] Queries */
+
+/* Exact -> prefix -> substring, all case-insensitive. Fills up to `max`
+   candidates into `out` and stores how many in *count: the first ones by
+   id, or the highest-scoring ones first while scores are set. */
+kg_match_t kg_search(const kg_graph_t *g, const char *query,
+                     kg_entity_t **out, int max, int *count);
+
+/* Unweighted (hop-count) shortest path via BFS. On KG_OK, release the
+   result with kg_path_free(). KG_ERR_NO_PATH without a search when the two
+   are in different components. Traversal state is per call, so any number
+   of these can run alongside each other and alongside writers. The plain
+   form pins its own snapshot for the duration of the call. */
+kg_status_t kg_shortest_path(const kg_graph_t *g, const kg_entity_t *src,
+                             const kg_entity_t *tgt, kg_path_t *out);
+kg_status_t kg_shortest_path_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                const kg_entity_t *tgt, kg_path_t *out);
+/* Same, following only edges whose label the filter allows (NULL = all). */
+kg_status_t kg_shortest_path_filtered(const kg_graph_t *g, const kg_entity_t *src,
+                                      const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                      kg_path_t *out);
+kg_status_t kg_shortest_path_filtered_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                         const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                         kg_path_t *out);
+/* Same, never queueing an entity v with comp[v] < floor (comp NULL = no
+   pruning); for indexes that prove such entities cannot lie on a path,
+   see kg_scc.h. */
+kg_status_t kg_shortest_path_pruned_at(const kg_snapshot_t *s, const kg_entity_t *src,
+                                       const kg_entity_t *tgt, const kg_label_filter_t *f,
+                                       const unsigned *comp, unsigned floor, kg_path_t *out);
+void kg_path_free(kg_path_t *p);
+
+/*
+   [SECTION] Weighted Paths
+   - Dijkstra over edge weights on a 4-ary heap (children of slot i at
+     4i+1..4i+4, so a sift-down compares one cache line of keys).
+   - A* when a heuristic is given: h(v) must never overestimate the cost
+     from v to the target, or the path returned may not be the cheapest.
+ */
+typedef double (*kg_heuristic_fn)(void *ctx, const kg_entity_t *v, const kg_entity_t *tgt);
+
+/* Cheapest path by total weight; out->cost holds it. f may be NULL. */
+kg_status_t kg_weighted_path(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                             const kg_label_filter_t *f, kg_heuristic_fn h, void *hctx,
+                             kg_path_t *out);
+kg_status_t kg_weighted_path_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                                const kg_label_filter_t *f, kg_heuristic_fn h, void *hctx,
+                                kg_path_t *out);
+
+/* Total weight of an existing path, taking the cheapest edge between each
+   pair of consecutive nodes (e.g. to price a hop-count BFS result). */
+double kg_path_weight(const kg_snapshot_t *s, const kg_path_t *p);
+/* Same, among the edges whose label the filter allows (NULL = all), as a
+   path found with that filter was priced. */
+double kg_path_weight_filtered(const kg_snapshot_t *s, const kg_path_t *p, const kg_label_filter_t *f);
+
+/* [SECTION] Query Profiling */
+
+/* Zeroes *p and makes it the calling thread's profile. Not nested. */
+void kg_profile_begin(kg_profile_t *p);
+void kg_profile_end(void);
+const char *kg_phase_name(kg_phase_t ph);
+
+/* [SECTION] Memory Accounting */
+
+const char *kg_mem_cat_name(kg_mem_cat_t cat);
+/* Reads the counters and scans one snapshot for the label / name sizes. */
+kg_status_t kg_memory_report(const kg_graph_t *g, kg_mem_report_t *out);
+
+/* [SECTION] File I/O
+   - Format per line:  Source|Relationship|Target[|Weight]
+   - Skips: blanks, lines starting with '#'
+ */
+int kg_parse_relation_line(char *line, char *src, char *rel, char *tgt);
+/* Same, also returning the optional weight (1 when absent). Rejects a
+   weight that is not a non-negative finite number. */
+int kg_parse_relation_line_weighted(char *line, char *src, char *rel, char *tgt, double *weight);
+/* A whole file is loaded as one batch, all or nothing: every line is
+   staged first (entities, labels, the edge itself) and linked only once
+   the file is through. On an error nothing of the file becomes visible,
+   stats->loaded is 0, and lines the callback already saw are dropped
+   (its src / rel pointers are only valid during the call). */
+kg_status_t kg_load_file(kg_graph_t *g, const char *filename,
+                         kg_load_stats_t *stats, kg_load_cb cb, void *ctx);
+kg_status_t kg_save_file(const kg_graph_t *g, const char *filename);
+kg_status_t kg_save_file_at(const kg_snapshot_t *s, const char *filename);
+kg_status_t kg_export_dot(const kg_graph_t *g, const char *dotfile);
+kg_status_t kg_export_dot_at(const kg_snapshot_t *s, const char *dotfile);
+
+/* [SECTION] String Helpers (shared with the UI) */
+
+void kg_trim(char *s);
+void kg_squeeze_spaces(char *s);
+void kg_to_lower_copy(const char *src, char *dst, size_t dstsz);
+int kg_ci_cmp(const char *a, const char *b);
+int kg_ci_contains(const char *hay, const char *needle);
+unsigned long kg_hash_name(const char *s);
+
+#endif /* KG_GRAPH_H */
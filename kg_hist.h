@@ -0,0 +1,85 @@
+/* =========================================================================
+   Knowledge Graph Engine — HDR-style Histogram
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Fixed-size, lock-free histogram of unsigned values (latencies in ns,
+     nodes visited, ...). Buckets are log-linear: 16 linear sub-buckets per
+     power of two, so any recorded value is reported within 1/16 (6.25%)
+     of its true value across the full 64-bit range. Recording is one
+     relaxed increment plus a sum; no allocation, safe from any thread.
+
+   ========================================================================= */
+#ifndef KG_HIST_H
+#define KG_HIST_H
+
+#include <stdatomic.h>
+
+#define KG_HIST_SUB_BITS  4
+#define KG_HIST_SUB       (1u << KG_HIST_SUB_BITS)
+#define KG_HIST_BUCKETS   (KG_HIST_SUB * (64 - KG_HIST_SUB_BITS + 1))
+
+typedef struct kg_hist {
+    _Atomic unsigned long counts[KG_HIST_BUCKETS];
+    _Atomic unsigned long n;
+    _Atomic unsigned long sum;
+    _Atomic unsigned long max;
+} kg_hist_t;
+
+/* Values below KG_HIST_SUB get a bucket each; above, the top
+   KG_HIST_SUB_BITS + 1 significant bits pick the bucket. */
+static inline unsigned kg_hist_bucket(unsigned long v) {
+    if (v < KG_HIST_SUB) return (unsigned)v;
+    unsigned e = 63u - (unsigned)__builtin_clzl(v);
+    return (e - KG_HIST_SUB_BITS + 1) * KG_HIST_SUB + (unsigned)((v >> (e - KG_HIST_SUB_BITS)) & (KG_HIST_SUB - 1));
+}
+
+/* Largest value that lands in bucket `i`. */
+static inline unsigned long kg_hist_bucket_high(unsigned i) {
+    if (i < KG_HIST_SUB) return i;
+    unsigned shift = i / KG_HIST_SUB - 1;
+    unsigned long low = (unsigned long)(KG_HIST_SUB + i % KG_HIST_SUB) << shift;
+    return low + ((1ul << shift) - 1);
+}
+
+static inline void kg_hist_record(kg_hist_t *h, unsigned long v) {
+    atomic_fetch_add_explicit(&h->counts[kg_hist_bucket(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->n, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, v, memory_order_relaxed);
+    unsigned long m = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (v > m && !atomic_compare_exchange_weak_explicit(&h->max, &m, v,
+                                                           memory_order_relaxed, memory_order_relaxed)) { }
+}
+
+static inline unsigned long kg_hist_count(const kg_hist_t *h) {
+    return atomic_load_explicit(&((kg_hist_t*)h)->n, memory_order_relaxed);
+}
+
+static inline double kg_hist_mean(const kg_hist_t *h) {
+    unsigned long n = kg_hist_count(h);
+    return n ? (double)atomic_load_explicit(&((kg_hist_t*)h)->sum, memory_order_relaxed) / (double)n : 0.0;
+}
+
+static inline unsigned long kg_hist_max(const kg_hist_t *h) {
+    return atomic_load_explicit(&((kg_hist_t*)h)->max, memory_order_relaxed);
+}
+
+/* Value at percentile p (0..100): the upper edge of the bucket holding
+   it, capped at the observed max. Concurrent records may skew it by a
+   sample or two, never more. */
+static inline unsigned long kg_hist_percentile(const kg_hist_t *h, double p) {
+    unsigned long n = kg_hist_count(h);
+    if (n == 0) return 0;
+    unsigned long rank = (unsigned long)(p / 100.0 * (double)n + 0.5);
+    if (rank < 1) rank = 1;
+    unsigned long seen = 0, mx = kg_hist_max(h);
+    for (unsigned i = 0; i < KG_HIST_BUCKETS; ++i) {
+        seen += atomic_load_explicit(&((kg_hist_t*)h)->counts[i], memory_order_relaxed);
+        if (seen >= rank) {
+            unsigned long v = kg_hist_bucket_high(i);
+            return v < mx ? v : mx;
+        }
+    }
+    return mx;
+}
+
+#endif /* KG_HIST_H */
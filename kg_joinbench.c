@@ -0,0 +1,249 @@
+/* =========================================================================
+   Knowledge Graph Engine — Cyclic Join Benchmark
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Counts triangles and 4-cycles over the most frequent relation of a
+     synthetic graph three ways and times each:
+       - nested loops: walk the adjacency lists, a -> b -> c (-> d), then
+         scan the last entity's list for the closing edge
+       - pairwise: kg_query_run(), one sort-merge join per pattern
+       - lftj: kg_query_run_lftj(), Leapfrog Triejoin
+     Pairwise joins build every open path before the last pattern closes
+     it; when that would exceed -r rows the run is skipped and the number
+     of paths is shown instead. Nested loops stop after -b seconds, and
+     count an edge the generator repeated once per copy, so their total
+     can exceed the distinct answers the index-based joins report.
+->   Build & Run:
+     gcc -O2 -pthread -o kg_joinbench kg_joinbench.c kg_synth.c kg_graph.c kg_query.c -lm
+     ./kg_joinbench                               (10K, 100K, 1M edges)
+     ./kg_joinbench -s 1000000 -m ba -b 60
+
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kg_synth.h"
+#include "kg_query.h"
+
+/* [SECTION] Configuration */
+
+#define DEFAULT_SIZES     "10000,100000,1000000"
+#define DEFAULT_DEGREE    8
+#define DEFAULT_BUDGET_S  20.0
+#define DEFAULT_MAX_ROWS  50000000.0
+
+typedef struct bench_opts {
+    kg_synth_opts_t synth;
+    unsigned degree;
+    double budget_ns;
+    double max_rows;
+    const char *tmpdir;
+} bench_opts_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const char *fmt_ns(double ns, char *buf, size_t n) {
+    if (ns < 1e3) snprintf(buf, n, "%.0fns", ns);
+    else if (ns < 1e6) snprintf(buf, n, "%.1fus", ns / 1e3);
+    else if (ns < 1e9) snprintf(buf, n, "%.2fms", ns / 1e6);
+    else snprintf(buf, n, "%.2fs", ns / 1e9);
+    return buf;
+}
+
+/*
+   [SECTION] Nested-Loop Baseline
+   - Returns -1 once the deadline passes (checked per start entity).
+ */
+static int has_edge(const kg_snapshot_t *s, kg_entity_t *from, unsigned label, kg_entity_t *to) {
+    for (kg_relation_t *r = kg_snapshot_relations(s, from); r; r = r->next)
+        if (r->label == label && r->target == to) return 1;
+    return 0;
+}
+
+static double naive_cycles(const kg_snapshot_t *s, unsigned label, int len, double deadline) {
+    double count = 0;
+    for (size_t i = 0; i < s->n_entities; ++i) {
+        if (now_ns() > deadline) return -1;
+        kg_entity_t *a = kg_entity_at(s->g, i);
+        for (kg_relation_t *ab = kg_snapshot_relations(s, a); ab; ab = ab->next) {
+            if (ab->label != label) continue;
+            for (kg_relation_t *bc = kg_snapshot_relations(s, ab->target); bc; bc = bc->next) {
+                if (bc->label != label) continue;
+                if (len == 3) { count += has_edge(s, a, label, bc->target); continue; }
+                for (kg_relation_t *cd = kg_snapshot_relations(s, bc->target); cd; cd = cd->next)
+                    if (cd->label == label) count += has_edge(s, cd->target, label, a);
+            }
+        }
+    }
+    return count;
+}
+
+/* Open paths the pairwise plan materializes before the closing pattern:
+   2-paths for a triangle, 3-paths for a 4-cycle. */
+static double open_paths(const kg_triples_t *t, unsigned label, int len) {
+    size_t n = t->n_entities;
+    double *in = (double*)calloc(n, sizeof(double)), *out = (double*)calloc(n, sizeof(double));
+    double paths = 0;
+    if (!in || !out) { free(in); free(out); return 0; }
+    const unsigned *spo = t->t[KG_SPO];
+    for (size_t i = 0; i < t->n; ++i)
+        if (spo[3 * i + 1] == label) { out[spo[3 * i]]++; in[spo[3 * i + 2]]++; }
+    if (len == 3) {
+        for (size_t v = 0; v < n; ++v) paths += in[v] * out[v];
+    } else {
+        for (size_t i = 0; i < t->n; ++i)
+            if (spo[3 * i + 1] == label) paths += in[spo[3 * i]] * out[spo[3 * i + 2]];
+    }
+    free(in); free(out);
+    return paths;
+}
+
+/* [SECTION] One Size */
+
+static int run_size(const bench_opts_t *bo, unsigned long edges) {
+    kg_synth_opts_t so = bo->synth;
+    so.edges = edges;
+    so.nodes = edges / bo->degree;
+    if (so.nodes < 16) so.nodes = 16;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/kg_joinbench_XXXXXX", bo->tmpdir);
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    FILE *fp = fdopen(fd, "w");
+    kg_status_t st = fp ? kg_synth_write(fp, &so) : KG_ERR_IO;
+    if (fp && fclose(fp) != 0 && st == KG_OK) st = KG_ERR_IO;
+    kg_graph_t *g = st == KG_OK ? kg_graph_new() : NULL;
+    kg_load_stats_t ls;
+    if (st == KG_OK) st = g ? kg_load_file(g, path, &ls, NULL, NULL) : KG_ERR_NOMEM;
+    unlink(path);
+    if (st != KG_OK) { fprintf(stderr, "generate/load: %s\n", kg_strerror(st)); return 1; }
+
+    kg_snapshot_t s;
+    kg_triples_t *t = NULL;
+    double t0 = now_ns();
+    st = kg_snapshot_acquire(g, &s);
+    if (st == KG_OK) st = kg_triples_build(&s, KG_TRIPLES_ALL_ORDERS, &t);
+    double build_ns = now_ns() - t0;
+    if (st != KG_OK) { fprintf(stderr, "index: %s\n", kg_strerror(st)); return 1; }
+
+    char label[KG_REL_LEN], text[4 * KG_REL_LEN + 64];
+    kg_synth_label_name(0, label, sizeof(label));
+    unsigned lid = kg_find_label(g, label);
+    char b[3][32];
+
+    for (int len = 3; len <= 4; ++len) {
+        if (len == 3)
+            snprintf(text, sizeof(text), "?a \"%s\" ?b . ?b \"%s\" ?c . ?a \"%s\" ?c", label, label, label);
+        else
+            snprintf(text, sizeof(text), "?a \"%s\" ?b . ?b \"%s\" ?c . ?c \"%s\" ?d . ?d \"%s\" ?a",
+                     label, label, label, label);
+        kg_query_t *q;
+        if (kg_query_parse(g, text, &q, NULL, 0) != KG_OK) { fprintf(stderr, "parse failed\n"); return 1; }
+
+        t0 = now_ns();
+        double naive = naive_cycles(&s, lid, len, t0 + bo->budget_ns);
+        double naive_ns = now_ns() - t0;
+
+        double open = open_paths(t, lid, len), pair_ns = -1;
+        size_t pair_rows = 0;
+        kg_query_result_t r;
+        if (open <= bo->max_rows) {
+            t0 = now_ns();
+            st = kg_query_run(t, q, 0, &r);
+            pair_ns = now_ns() - t0;
+            if (st == KG_OK) { pair_rows = r.n_rows; kg_query_result_free(&r); }
+            else pair_ns = -1;
+        }
+
+        t0 = now_ns();
+        st = kg_query_run_lftj(t, q, 0, &r);
+        double lftj_ns = now_ns() - t0;
+        if (st != KG_OK) { fprintf(stderr, "lftj: %s\n", kg_strerror(st)); return 1; }
+        size_t lftj_rows = r.n_rows;
+        kg_query_result_free(&r);
+        kg_query_free(q);
+
+        if (pair_ns >= 0 && pair_rows != lftj_rows)
+            fprintf(stderr, "MISMATCH %d-cycles: pairwise %zu, lftj %zu\n", len, pair_rows, lftj_rows);
+        printf("%11lu %9zu %9s %8s %12zu %12.0f | ", edges, kg_entity_count(g),
+               len == 3 ? "triangle" : "4-cycle", fmt_ns(build_ns, b[0], sizeof(b[0])), lftj_rows, open);
+        if (naive < 0) printf("%10s %12s | ", "> budget", "-");
+        else printf("%10s %12.0f | ", fmt_ns(naive_ns, b[1], sizeof(b[1])), naive);
+        if (pair_ns < 0) printf("%10s | ", "skipped");
+        else printf("%10s | ", fmt_ns(pair_ns, b[2], sizeof(b[2])));
+        printf("%10s\n", fmt_ns(lftj_ns, b[0], sizeof(b[0])));
+        fflush(stdout);
+    }
+    kg_triples_free(t);
+    kg_snapshot_release(&s);
+    kg_graph_free(g);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-s sizes (edges, comma separated)] [-d avg out-degree] [-m rmat|ba]\n"
+        "          [-l labels] [-z label skew] [-b nested-loop budget, s]\n"
+        "          [-r max open paths for pairwise] [-S seed] [-t tmpdir]\n", prog);
+}
+
+/*
+   [SECTION] Main
+ */
+int main(int argc, char **argv) {
+    bench_opts_t bo;
+    kg_synth_defaults(&bo.synth);
+    bo.degree = DEFAULT_DEGREE;
+    bo.budget_ns = DEFAULT_BUDGET_S * 1e9;
+    bo.max_rows = DEFAULT_MAX_ROWS;
+    bo.tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    char sizes[256];
+    snprintf(sizes, sizeof(sizes), "%s", DEFAULT_SIZES);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:m:l:z:b:r:S:t:h")) != -1) {
+        switch (opt) {
+        case 's': snprintf(sizes, sizeof(sizes), "%s", optarg); break;
+        case 'd': bo.degree = (unsigned)atoi(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "rmat") == 0) bo.synth.model = KG_SYNTH_RMAT;
+            else if (strcmp(optarg, "ba") == 0) bo.synth.model = KG_SYNTH_BA;
+            else { usage(argv[0]); return 2; }
+            break;
+        case 'l': bo.synth.labels = (unsigned)atoi(optarg); break;
+        case 'z': bo.synth.label_skew = atof(optarg); break;
+        case 'b': bo.budget_ns = atof(optarg) * 1e9; break;
+        case 'r': bo.max_rows = atof(optarg); break;
+        case 'S': bo.synth.seed = strtoull(optarg, NULL, 10); break;
+        case 't': bo.tmpdir = optarg; break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (bo.degree == 0) { usage(argv[0]); return 2; }
+
+    char label[KG_REL_LEN];
+    kg_synth_label_name(0, label, sizeof(label));
+    printf("model=%s degree=%u labels=%u skew=%.2f seed=%llu relation=\"%s\"\n",
+           bo.synth.model == KG_SYNTH_RMAT ? "rmat" : "ba", bo.degree,
+           bo.synth.labels, bo.synth.label_skew, (unsigned long long)bo.synth.seed, label);
+    printf("%11s %9s %9s %8s %12s %12s | %23s | %10s | %10s\n",
+           "edges", "entities", "pattern", "index", "answers", "open paths", "nested loops", "pairwise", "lftj");
+    fflush(stdout);
+
+    int failed = 0;
+    for (char *tok = strtok(sizes, ","); tok; tok = strtok(NULL, ",")) {
+        unsigned long edges = strtoul(tok, NULL, 10);
+        if (edges && run_size(&bo, edges) != 0) { printf("%11lu   (failed)\n", edges); failed = 1; }
+    }
+    return failed;
+}
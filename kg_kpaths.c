@@ -0,0 +1,602 @@
+/* =========================================================================
+   Knowledge Graph Engine — Alternative Paths (implementation)
+   ========================================================================= */
+
+#include "kg_kpaths.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#define NONE ((unsigned)-1)
+
+static int edge_ok(const kg_label_filter_t *f, const kg_relation_t *r) {
+    return !f || kg_label_allowed(f, r->label);
+}
+
+static int emit(kg_path_fn fn, void *ctx, kg_entity_t **nodes, size_t len, double cost) {
+    kg_path_t p = { nodes, len, cost };
+    return fn(ctx, &p);
+}
+
+/*
+   [SECTION] Paths
+   - acc[i] is the cost from the source to nodes[i], so a root prefix
+     keeps its cost when a detour is appended to it.
+ */
+typedef struct kpath {
+    kg_entity_t **nodes;
+    double *acc;
+    size_t len;
+    size_t dev;                  /* index where it left the path it came from */
+    uint64_t hash;
+} kpath_t;
+
+static void kpath_free(kpath_t *p) {
+    free(p->nodes); free(p->acc);
+    p->nodes = NULL; p->acc = NULL; p->len = 0;
+}
+
+static int kpath_alloc(kpath_t *p, size_t len) {
+    p->nodes = (kg_entity_t**)malloc(len * sizeof(kg_entity_t*));
+    p->acc = (double*)malloc(len * sizeof(double));
+    p->len = len;
+    if (!p->nodes || !p->acc) { kpath_free(p); return 0; }
+    return 1;
+}
+
+static uint64_t kpath_hash(const kpath_t *p) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < p->len; ++i) h = (h ^ p->nodes[i]->id) * 0x100000001b3ull;
+    return h;
+}
+
+static int kpath_equal(const kpath_t *a, const kpath_t *b) {
+    return a->hash == b->hash && a->len == b->len && memcmp(a->nodes, b->nodes, a->len * sizeof(kg_entity_t*)) == 0;
+}
+
+/* Cheaper first, then fewer hops. */
+static int kpath_less(const kpath_t *a, const kpath_t *b) {
+    double ca = a->acc[a->len - 1], cb = b->acc[b->len - 1];
+    return ca < cb || (ca == cb && a->len < b->len);
+}
+
+/*
+   [SECTION] Distances to the Target
+   - Both enumerators first search backwards from the target, over a
+     reverse index of the allowed edges built for the call (O(n + m)):
+     Yen's detours use the distances as an A* heuristic, the simple-path
+     search to cut branches that cannot arrive in the hops left.
+ */
+typedef struct rev_index {
+    size_t *row;                 /* n + 1 offsets */
+    unsigned *src;               /* sources of the edges into each entity */
+    float *w;
+} rev_index_t;
+
+static void rev_free(rev_index_t *R) {
+    free(R->row); free(R->src); free(R->w);
+}
+
+/* One walk of the adjacency lists (the slow part: a cache miss per edge)
+   into an edge array, then a counting sort by target. */
+static kg_status_t rev_build(const kg_snapshot_t *s, const kg_label_filter_t *f, rev_index_t *R) {
+    size_t n = s->n_entities, m = 0, cap = 1024;
+    memset(R, 0, sizeof(*R));
+    unsigned *from = (unsigned*)malloc(cap * sizeof(unsigned)), *to = (unsigned*)malloc(cap * sizeof(unsigned));
+    float *w = (float*)malloc(cap * sizeof(float));
+    R->row = (size_t*)calloc(n + 1, sizeof(size_t));
+    kg_status_t st = (from && to && w && R->row) ? KG_OK : KG_ERR_NOMEM;
+    for (size_t u = 0; u < n && st == KG_OK; ++u) {
+        const kg_entity_t *e = kg_entity_at(s->g, u);
+        if (!kg_visible(s, e)) continue;
+        for (const kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next) {
+            if (!edge_ok(f, r)) continue;
+            if (m == cap) {
+                cap *= 2;
+                unsigned *a = (unsigned*)realloc(from, cap * sizeof(unsigned));
+                if (a) from = a;
+                unsigned *b = (unsigned*)realloc(to, cap * sizeof(unsigned));
+                if (b) to = b;
+                float *c = (float*)realloc(w, cap * sizeof(float));
+                if (c) w = c;
+                if (!a || !b || !c) { st = KG_ERR_NOMEM; break; }
+            }
+            from[m] = (unsigned)u; to[m] = r->target->id; w[m] = r->weight;
+            R->row[to[m] + 1]++;
+            m++;
+        }
+    }
+    if (st == KG_OK) {
+        R->src = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+        R->w = (float*)malloc((m ? m : 1) * sizeof(float));
+        if (!R->src || !R->w) st = KG_ERR_NOMEM;
+    }
+    if (st == KG_OK) {
+        for (size_t v = 0; v < n; ++v) R->row[v + 1] += R->row[v];
+        for (size_t i = 0; i < m; ++i) {          /* row[v] runs ahead as v fills, then shifts back */
+            size_t k = R->row[to[i]]++;
+            R->src[k] = from[i];
+            R->w[k] = w[i];
+        }
+        for (size_t v = n; v > 0; --v) R->row[v] = R->row[v - 1];
+        R->row[0] = 0;
+    }
+    free(from); free(to); free(w);
+    if (st != KG_OK) rev_free(R);
+    return st;
+}
+
+/* Hops to tgt, NONE beyond max_hops or when it cannot be reached. */
+static kg_status_t hops_to_target(const kg_snapshot_t *s, const kg_label_filter_t *f, unsigned tgt,
+                                  unsigned max_hops, unsigned *dt) {
+    size_t n = s->n_entities;
+    rev_index_t R;
+    kg_status_t st = rev_build(s, f, &R);
+    unsigned *queue = st == KG_OK ? (unsigned*)malloc((n ? n : 1) * sizeof(unsigned)) : NULL;
+    if (!queue) { if (st == KG_OK) rev_free(&R); return KG_ERR_NOMEM; }
+    for (size_t v = 0; v < n; ++v) dt[v] = NONE;
+    size_t head = 0, tail = 0;
+    dt[tgt] = 0;
+    queue[tail++] = tgt;
+    while (head < tail) {
+        unsigned v = queue[head++];
+        if (dt[v] == max_hops) continue;
+        for (size_t i = R.row[v]; i < R.row[v + 1]; ++i)
+            if (dt[R.src[i]] == NONE) { dt[R.src[i]] = dt[v] + 1; queue[tail++] = R.src[i]; }
+    }
+    free(queue);
+    rev_free(&R);
+    return KG_OK;
+}
+
+/*
+   [SECTION] Restricted Shortest Path
+   - A* guided by the exact distance to the target in the unrestricted
+     graph (a lower bound once nodes and edges are removed), so a detour
+     search only expands nodes that can still lead somewhere: it may not
+     enter blocked nodes and may not leave the start towards skipped
+     ones (Yen's removed nodes and edges, without touching the graph).
+   - Scratch is stamped with an epoch, so a new search costs nothing to
+     reset however large the graph is.
+ */
+typedef struct heap_item {
+    double d;                    /* dist + h */
+    double g;                    /* dist: ties go to the deeper node */
+    unsigned v;
+} heap_item_t;
+
+static int item_less(const heap_item_t *a, const heap_item_t *b) {
+    return a->d < b->d || (a->d == b->d && a->g > b->g);
+}
+
+typedef struct search {
+    const kg_snapshot_t *s;
+    const kg_label_filter_t *f;
+    int weighted;
+    size_t n;
+    unsigned epoch;
+    unsigned *seen;              /* == epoch: dist / prev are set */
+    unsigned *block;             /* == epoch: may not be entered */
+    unsigned *skip;              /* == epoch: not a first hop from the start */
+    unsigned *prev;
+    double *dist;
+    double *h;                   /* cost to the target, DBL_MAX if unreachable */
+    heap_item_t *heap;           /* lazy deletion */
+    size_t heap_n, heap_cap;
+} search_t;
+
+static void search_free(search_t *S) {
+    free(S->seen); free(S->block); free(S->skip); free(S->prev);
+    free(S->dist); free(S->h); free(S->heap);
+}
+
+static int heap_push(search_t *S, double d, double g, unsigned v) {
+    if (S->heap_n == S->heap_cap) {
+        size_t cap = S->heap_cap ? 2 * S->heap_cap : 64;
+        heap_item_t *h = (heap_item_t*)realloc(S->heap, cap * sizeof(heap_item_t));
+        if (!h) return 0;
+        S->heap = h; S->heap_cap = cap;
+    }
+    heap_item_t it = { d, g, v };
+    size_t i = S->heap_n++;
+    while (i > 0 && item_less(&it, &S->heap[(i - 1) / 2])) {
+        S->heap[i] = S->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    S->heap[i] = it;
+    return 1;
+}
+
+static heap_item_t heap_pop(search_t *S) {
+    heap_item_t top = S->heap[0], last = S->heap[--S->heap_n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= S->heap_n) break;
+        if (c + 1 < S->heap_n && item_less(&S->heap[c + 1], &S->heap[c])) c++;
+        if (!item_less(&S->heap[c], &last)) break;
+        S->heap[i] = S->heap[c];
+        i = c;
+    }
+    if (S->heap_n) S->heap[i] = last;
+    return top;
+}
+
+/* Dijkstra backwards from tgt over the reverse index: h[v] is exact. */
+static kg_status_t fill_heuristic(search_t *S, unsigned tgt) {
+    rev_index_t R;
+    kg_status_t st = rev_build(S->s, S->f, &R);
+    if (st != KG_OK) return st;
+    for (size_t v = 0; v < S->n; ++v) S->h[v] = DBL_MAX;
+    S->h[tgt] = 0;
+    S->heap_n = 0;
+    if (!heap_push(S, 0, 0, tgt)) st = KG_ERR_NOMEM;
+    while (st == KG_OK && S->heap_n) {
+        heap_item_t it = heap_pop(S);
+        if (it.d > S->h[it.v]) continue;
+        for (size_t i = R.row[it.v]; i < R.row[it.v + 1]; ++i) {
+            double d = it.d + (S->weighted ? (double)R.w[i] : 1.0);
+            if (d >= S->h[R.src[i]]) continue;
+            S->h[R.src[i]] = d;
+            if (!heap_push(S, d, 0, R.src[i])) { st = KG_ERR_NOMEM; break; }
+        }
+    }
+    rev_free(&R);
+    return st;
+}
+
+static kg_status_t search_init(search_t *S, const kg_snapshot_t *s, const kg_label_filter_t *f,
+                               int weighted, unsigned tgt) {
+    memset(S, 0, sizeof(*S));
+    S->s = s; S->f = f; S->weighted = weighted;
+    S->n = s->n_entities;
+    S->seen = (unsigned*)calloc(S->n, sizeof(unsigned));
+    S->block = (unsigned*)calloc(S->n, sizeof(unsigned));
+    S->skip = (unsigned*)calloc(S->n, sizeof(unsigned));
+    S->prev = (unsigned*)malloc(S->n * sizeof(unsigned));
+    S->dist = (double*)malloc(S->n * sizeof(double));
+    S->h = (double*)malloc(S->n * sizeof(double));
+    kg_status_t st = (S->seen && S->block && S->skip && S->prev && S->dist && S->h) ? KG_OK : KG_ERR_NOMEM;
+    if (st == KG_OK) st = fill_heuristic(S, tgt);
+    if (st != KG_OK) search_free(S);
+    return st;
+}
+
+static void new_epoch(search_t *S) {
+    if (++S->epoch == 0) {
+        memset(S->seen, 0, S->n * sizeof(unsigned));
+        memset(S->block, 0, S->n * sizeof(unsigned));
+        memset(S->skip, 0, S->n * sizeof(unsigned));
+        S->epoch = 1;
+    }
+}
+
+/* Cheapest from -> tgt under the current epoch's restrictions; out->acc
+   starts at base. The caller has called new_epoch() and set them up.
+   KG_ERR_NO_PATH as well when every path would cost more than cap. */
+static kg_status_t restricted_path(search_t *S, unsigned from, unsigned tgt, double base, double cap,
+                                   kpath_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (S->h[from] == DBL_MAX) return KG_ERR_NO_PATH;
+    const kg_graph_t *g = S->s->g;
+    S->seen[from] = S->epoch;
+    S->dist[from] = 0;
+    S->prev[from] = NONE;
+    S->heap_n = 0;
+    if (!heap_push(S, S->h[from], 0, from)) return KG_ERR_NOMEM;
+    int found = 0;
+    while (S->heap_n) {
+        heap_item_t it = heap_pop(S);
+        unsigned u = it.v;
+        if (it.d > S->dist[u] + S->h[u]) continue;
+        if (base + it.d > cap) break;
+        if (u == tgt) { found = 1; break; }
+        for (const kg_relation_t *r = kg_snapshot_relations(S->s, kg_entity_at(g, u)); r; r = r->next) {
+            if (!edge_ok(S->f, r)) continue;
+            unsigned v = r->target->id;
+            if (S->h[v] == DBL_MAX || S->block[v] == S->epoch || (u == from && S->skip[v] == S->epoch)) continue;
+            double d = S->dist[u] + (S->weighted ? (double)r->weight : 1.0);
+            if (S->seen[v] == S->epoch && d >= S->dist[v]) continue;
+            S->seen[v] = S->epoch;
+            S->dist[v] = d;
+            S->prev[v] = u;
+            if (!heap_push(S, d + S->h[v], d, v)) return KG_ERR_NOMEM;
+        }
+    }
+    if (!found) return KG_ERR_NO_PATH;
+
+    size_t len = 1;
+    for (unsigned v = tgt; v != from; v = S->prev[v]) len++;
+    if (!kpath_alloc(out, len)) return KG_ERR_NOMEM;
+    size_t i = len;
+    for (unsigned v = tgt;; v = S->prev[v]) {
+        --i;
+        out->nodes[i] = kg_entity_at(g, v);
+        out->acc[i] = base + S->dist[v];
+        if (v == from) break;
+    }
+    return KG_OK;
+}
+
+/*
+   [SECTION] k Shortest Loopless Paths (Yen)
+   - With Lawler's refinement: a path only spawns detours from the node
+     where it left its parent onwards; earlier ones were already tried
+     with the same prefix.
+   - Candidates wait in a binary heap; a detour that rebuilds a path
+     already found or queued is dropped.
+ */
+typedef struct cand_heap {
+    kpath_t *a;
+    size_t n, cap;
+} cand_heap_t;
+
+static int cand_push(cand_heap_t *B, kpath_t p) {
+    if (B->n == B->cap) {
+        size_t cap = B->cap ? 2 * B->cap : 16;
+        kpath_t *a = (kpath_t*)realloc(B->a, cap * sizeof(kpath_t));
+        if (!a) return 0;
+        B->a = a; B->cap = cap;
+    }
+    size_t i = B->n++;
+    while (i > 0 && kpath_less(&p, &B->a[(i - 1) / 2])) {
+        B->a[i] = B->a[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    B->a[i] = p;
+    return 1;
+}
+
+static kpath_t cand_pop(cand_heap_t *B) {
+    kpath_t top = B->a[0], last = B->a[--B->n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= B->n) break;
+        if (c + 1 < B->n && kpath_less(&B->a[c + 1], &B->a[c])) c++;
+        if (!kpath_less(&B->a[c], &last)) break;
+        B->a[i] = B->a[c];
+        i = c;
+    }
+    if (B->n) B->a[i] = last;
+    return top;
+}
+
+static int known(const kpath_t *A, size_t nA, const cand_heap_t *B, const kpath_t *p) {
+    for (size_t i = 0; i < nA; ++i) if (kpath_equal(&A[i], p)) return 1;
+    for (size_t i = 0; i < B->n; ++i) if (kpath_equal(&B->a[i], p)) return 1;
+    return 0;
+}
+
+/* Once `need` candidates are queued, a detour dearer than all of them
+   can never be among the paths still to come. */
+static double cand_cap(const cand_heap_t *B, size_t need) {
+    if (B->n < need) return DBL_MAX;
+    double cap = 0;
+    for (size_t i = 0; i < B->n; ++i) {
+        double c = B->a[i].acc[B->a[i].len - 1];
+        if (c > cap) cap = c;
+    }
+    return cap;
+}
+
+/* Detours from every node of A[last] at or after its deviation point;
+   need is how many more paths the caller wants. */
+static kg_status_t spur_all(search_t *S, kpath_t *A, size_t nA, cand_heap_t *B, size_t need) {
+    const kpath_t *last = &A[nA - 1];
+    const kg_entity_t *tgt = last->nodes[last->len - 1];
+    for (size_t i = last->dev; i + 1 < last->len; ++i) {
+        new_epoch(S);
+        for (size_t j = 0; j < i; ++j) S->block[last->nodes[j]->id] = S->epoch;
+        for (size_t a = 0; a < nA; ++a)
+            if (A[a].len > i + 1 && memcmp(A[a].nodes, last->nodes, (i + 1) * sizeof(kg_entity_t*)) == 0)
+                S->skip[A[a].nodes[i + 1]->id] = S->epoch;
+
+        kpath_t spur, p;
+        kg_status_t st = restricted_path(S, last->nodes[i]->id, tgt->id, last->acc[i], cand_cap(B, need), &spur);
+        if (st == KG_ERR_NO_PATH) continue;
+        if (st != KG_OK) return st;
+        if (!kpath_alloc(&p, i + spur.len)) { kpath_free(&spur); return KG_ERR_NOMEM; }
+        memcpy(p.nodes, last->nodes, i * sizeof(kg_entity_t*));
+        memcpy(p.acc, last->acc, i * sizeof(double));
+        memcpy(p.nodes + i, spur.nodes, spur.len * sizeof(kg_entity_t*));
+        memcpy(p.acc + i, spur.acc, spur.len * sizeof(double));
+        kpath_free(&spur);
+        p.dev = i;
+        p.hash = kpath_hash(&p);
+        if (known(A, nA, B, &p)) { kpath_free(&p); continue; }
+        if (!cand_push(B, p)) { kpath_free(&p); return KG_ERR_NOMEM; }
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_k_shortest_paths_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                                   const kg_label_filter_t *f, size_t k, int weighted,
+                                   kg_path_fn fn, void *ctx, size_t *found) {
+    if (found) *found = 0;
+    if (k == 0 || !fn) return KG_ERR_INVALID;
+    if (!src || !tgt || !kg_visible(s, src) || !kg_visible(s, tgt)) return KG_ERR_NOT_FOUND;
+    search_t S;
+    kg_status_t st = search_init(&S, s, f, weighted, tgt->id);
+    if (st != KG_OK) return st;
+
+    kpath_t *A = NULL;
+    size_t nA = 0, capA = 0;
+    cand_heap_t B = { NULL, 0, 0 };
+    kpath_t p;
+    new_epoch(&S);
+    st = restricted_path(&S, src->id, tgt->id, 0, DBL_MAX, &p);
+    p.dev = 0;
+    while (st == KG_OK) {
+        if (nA == capA) {
+            size_t cap = capA ? 2 * capA : 8;
+            kpath_t *a = (kpath_t*)realloc(A, cap * sizeof(kpath_t));
+            if (!a) { kpath_free(&p); st = KG_ERR_NOMEM; break; }
+            A = a; capA = cap;
+        }
+        p.hash = kpath_hash(&p);
+        A[nA++] = p;
+        if (found) *found = nA;
+        if (emit(fn, ctx, p.nodes, p.len, p.acc[p.len - 1]) || nA == k) break;
+        st = spur_all(&S, A, nA, &B, k - nA);
+        if (st != KG_OK || B.n == 0) break;
+        p = cand_pop(&B);
+    }
+    for (size_t i = 0; i < nA; ++i) kpath_free(&A[i]);
+    for (size_t i = 0; i < B.n; ++i) kpath_free(&B.a[i]);
+    free(A); free(B.a);
+    search_free(&S);
+    return st;
+}
+
+kg_status_t kg_k_shortest_paths(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                                const kg_label_filter_t *f, size_t k, int weighted,
+                                kg_path_fn fn, void *ctx, size_t *found) {
+    kg_snapshot_t s;
+    if (found) *found = 0;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_k_shortest_paths_at(&s, src, tgt, f, k, weighted, fn, ctx, found);
+    kg_snapshot_release(&s);
+    return st;
+}
+
+/*
+   [SECTION] Bounded Simple Paths
+   - Hop distances to the target prune every branch that cannot arrive
+     in the hops left, so the search only walks nodes that lie on some
+     short enough path.
+   - Each frame lists its node's distinct next hops up front on a shared
+     candidate stack; parallel edges collapse into one (the cheapest).
+ */
+typedef struct frame {
+    unsigned v;
+    size_t begin, next, end;     /* its candidates on the shared stack */
+} frame_t;
+
+typedef struct dfs {
+    const kg_snapshot_t *s;
+    const kg_label_filter_t *f;
+    unsigned *dt;
+    unsigned char *on_path;
+    unsigned *mark, *slot, stamp;
+    unsigned *cand;
+    double *cand_w;
+    size_t n_cand, cap_cand;
+} dfs_t;
+
+/* Pushes v's distinct next hops that can still reach the target within
+   `left` more hops. */
+static kg_status_t list_next(dfs_t *D, unsigned v, unsigned left) {
+    if (++D->stamp == 0) { memset(D->mark, 0, D->s->n_entities * sizeof(unsigned)); D->stamp = 1; }
+    for (const kg_relation_t *r = kg_snapshot_relations(D->s, kg_entity_at(D->s->g, v)); r; r = r->next) {
+        if (!edge_ok(D->f, r)) continue;
+        unsigned w = r->target->id;
+        if (D->on_path[w] || D->dt[w] == NONE || D->dt[w] + 1 > left) continue;
+        if (D->mark[w] == D->stamp) {
+            if (r->weight < D->cand_w[D->slot[w]]) D->cand_w[D->slot[w]] = r->weight;
+            continue;
+        }
+        if (D->n_cand == D->cap_cand) {
+            size_t cap = D->cap_cand ? 2 * D->cap_cand : 256;
+            unsigned *c = (unsigned*)realloc(D->cand, cap * sizeof(unsigned));
+            if (c) D->cand = c;
+            double *cw = (double*)realloc(D->cand_w, cap * sizeof(double));
+            if (cw) D->cand_w = cw;
+            if (!c || !cw) return KG_ERR_NOMEM;
+            D->cap_cand = cap;
+        }
+        D->mark[w] = D->stamp;
+        D->slot[w] = (unsigned)D->n_cand;
+        D->cand[D->n_cand] = w;
+        D->cand_w[D->n_cand] = r->weight;
+        D->n_cand++;
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_simple_paths_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                               const kg_label_filter_t *f, unsigned max_hops, size_t max_results,
+                               kg_path_fn fn, void *ctx, size_t *found) {
+    if (found) *found = 0;
+    if (!fn) return KG_ERR_INVALID;
+    if (!src || !tgt || !kg_visible(s, src) || !kg_visible(s, tgt)) return KG_ERR_NOT_FOUND;
+    if (src == tgt) {
+        kg_entity_t *only = (kg_entity_t*)src;
+        emit(fn, ctx, &only, 1, 0);
+        if (found) *found = 1;
+        return KG_OK;
+    }
+    if (max_hops == 0) return KG_ERR_NO_PATH;
+
+    size_t n = s->n_entities;
+    dfs_t D;
+    memset(&D, 0, sizeof(D));
+    D.s = s; D.f = f;
+    D.dt = (unsigned*)malloc(n * sizeof(unsigned));
+    D.on_path = (unsigned char*)calloc(n, 1);
+    D.mark = (unsigned*)calloc(n, sizeof(unsigned));
+    D.slot = (unsigned*)malloc(n * sizeof(unsigned));
+    frame_t *stack = (frame_t*)malloc((max_hops + 1) * sizeof(frame_t));
+    kg_entity_t **nodes = (kg_entity_t**)malloc((max_hops + 1) * sizeof(kg_entity_t*));
+    double *acc = (double*)malloc((max_hops + 1) * sizeof(double));
+    kg_status_t st = (D.dt && D.on_path && D.mark && D.slot && stack && nodes && acc) ? KG_OK : KG_ERR_NOMEM;
+    if (st == KG_OK) st = hops_to_target(s, f, tgt->id, max_hops, D.dt);
+
+    int weighted = kg_graph_weighted(s->g);
+    size_t count = 0;
+    if (st == KG_OK && D.dt[src->id] != NONE) {
+        size_t depth = 0;
+        stack[0].v = src->id;
+        stack[0].begin = stack[0].next = 0;
+        D.on_path[src->id] = 1;
+        nodes[0] = (kg_entity_t*)src;
+        acc[0] = 0;
+        st = list_next(&D, src->id, max_hops);
+        stack[0].end = D.n_cand;
+        while (st == KG_OK) {
+            frame_t *F = &stack[depth];
+            if (F->next == F->end) {
+                D.on_path[F->v] = 0;
+                D.n_cand = F->begin;
+                if (depth-- == 0) break;
+                continue;
+            }
+            unsigned w = D.cand[F->next];
+            double cost = weighted ? D.cand_w[F->next] : 1.0;
+            F->next++;
+            nodes[depth + 1] = kg_entity_at(s->g, w);
+            acc[depth + 1] = acc[depth] + cost;
+            if (w == tgt->id) {
+                count++;
+                if (emit(fn, ctx, nodes, depth + 2, acc[depth + 1]) || count == max_results) break;
+                continue;
+            }
+            frame_t *C = &stack[++depth];
+            C->v = w;
+            C->begin = C->next = D.n_cand;
+            D.on_path[w] = 1;
+            st = list_next(&D, w, max_hops - (unsigned)depth);
+            C->end = D.n_cand;
+        }
+    }
+    if (found) *found = count;
+    if (st == KG_OK && count == 0) st = KG_ERR_NO_PATH;
+    free(D.dt); free(D.on_path); free(D.mark); free(D.slot);
+    free(D.cand); free(D.cand_w);
+    free(stack); free(nodes); free(acc);
+    return st;
+}
+
+kg_status_t kg_simple_paths(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                            const kg_label_filter_t *f, unsigned max_hops, size_t max_results,
+                            kg_path_fn fn, void *ctx, size_t *found) {
+    kg_snapshot_t s;
+    if (found) *found = 0;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_simple_paths_at(&s, src, tgt, f, max_hops, max_results, fn, ctx, found);
+    kg_snapshot_release(&s);
+    return st;
+}
@@ -0,0 +1,56 @@
+/* =========================================================================
+   Knowledge Graph Engine — Alternative Paths
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     More than one route between two entities, for "other ways to get
+     from A to B" suggestions:
+       - k shortest loopless paths (Yen): the shortest path, then for each
+         node of the last path found a detour ("spur") that leaves it by
+         an edge no earlier path with the same prefix used and never
+         revisits the prefix. The cheapest detour is the next path. Each
+         detour search is A*, guided by exact distances to the target
+         from one backward search.
+       - every simple path of at most max_hops edges, up to max_results,
+         by depth-first search. Branches that cannot reach the target in
+         the hops left are cut using hop distances from one backward BFS.
+     Both build a reverse index for the call: O(n + m) before the first
+     path.
+     Paths are node sequences (parallel edges give one path), heap
+     allocated, and handed to a callback as soon as each is final, so a
+     caller can print or stop before the rest are computed.
+->   Build:
+     add kg_kpaths.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_KPATHS_H
+#define KG_KPATHS_H
+
+#include "kg_graph.h"
+
+/* Receives each path in turn; p is only valid during the call (copy what
+   you keep). Return non-zero to stop the enumeration. */
+typedef int (*kg_path_fn)(void *ctx, const kg_path_t *p);
+
+/* Up to k loopless paths, cheapest first: by hops, or by summed weight
+   when weighted (the cheapest allowed edge between each pair of nodes).
+   f may be NULL. *found (may be NULL) gets the number handed to fn;
+   KG_ERR_NO_PATH when there is none. The plain form pins its own snapshot
+   for the duration of the call. */
+kg_status_t kg_k_shortest_paths(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                                const kg_label_filter_t *f, size_t k, int weighted,
+                                kg_path_fn fn, void *ctx, size_t *found);
+kg_status_t kg_k_shortest_paths_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                                   const kg_label_filter_t *f, size_t k, int weighted,
+                                   kg_path_fn fn, void *ctx, size_t *found);
+
+/* Simple paths of at most max_hops edges, the first max_results found
+   (0 = no limit), in depth-first order; cost is hops, or summed weight
+   once the graph is weighted. Same conventions as above. */
+kg_status_t kg_simple_paths(const kg_graph_t *g, const kg_entity_t *src, const kg_entity_t *tgt,
+                            const kg_label_filter_t *f, unsigned max_hops, size_t max_results,
+                            kg_path_fn fn, void *ctx, size_t *found);
+kg_status_t kg_simple_paths_at(const kg_snapshot_t *s, const kg_entity_t *src, const kg_entity_t *tgt,
+                               const kg_label_filter_t *f, unsigned max_hops, size_t max_results,
+                               kg_path_fn fn, void *ctx, size_t *found);
+
+#endif /* KG_KPATHS_H */
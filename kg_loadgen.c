@@ -0,0 +1,273 @@
+/* =========================================================================
+   Knowledge Graph Engine — Load Generator for kg_server
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Opens C connections (one thread each), keeps D requests in flight on
+     every connection (pipelining) and reports QPS plus p50/p90/p99/max
+     latency. Entity names for the queries come from a relations file.
+->   Build & Run (Linux):
+     gcc -O2 -pthread -o kg_loadgen kg_loadgen.c kg_graph.c
+     ./kg_loadgen -u /tmp/kg.sock -f relations.txt -c 8 -d 16 -n 20000
+
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "kg_graph.h"
+
+/* [SECTION] Configuration */
+
+#define DEFAULT_CONNS     4
+#define DEFAULT_DEPTH     8
+#define DEFAULT_REQUESTS  10000     /* per connection */
+#define DEFAULT_PATH_PCT  30
+#define DEFAULT_SEARCH_PCT 10
+#define RX_BUF            65536
+
+typedef struct options {
+    const char *upath, *host;
+    int port, conns, depth, requests, path_pct, search_pct;
+} options_t;
+
+typedef struct client {
+    const options_t *opt;
+    const kg_graph_t *graph;     /* source of entity names */
+    size_t n_names;
+    unsigned seed;
+    double *lat_us;          /* one sample per completed request */
+    int done, errors;
+    int failed;              /* connection-level failure */
+} client_t;
+
+/* [SECTION] Helpers */
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connect_server(const options_t *o) {
+    int fd;
+    if (o->upath) {
+        struct sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        strncpy(sa.sun_path, o->upath, sizeof(sa.sun_path) - 1);
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0) { close(fd); return -1; }
+    } else {
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons((unsigned short)o->port);
+        if (inet_pton(AF_INET, o->host, &sa.sin_addr) != 1) return -1;
+        if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0) { close(fd); return -1; }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static int write_all(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return 0;
+        p += w; n -= (size_t)w;
+    }
+    return 1;
+}
+
+/* Minimal buffered line reader over a blocking socket. */
+typedef struct reader {
+    int fd;
+    char buf[RX_BUF];
+    size_t off, len;
+} reader_t;
+
+static int read_line_fd(reader_t *r, char *line, size_t cap) {
+    size_t n = 0;
+    for (;;) {
+        if (r->off == r->len) {
+            ssize_t got = read(r->fd, r->buf, sizeof(r->buf));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return 0;
+            r->off = 0; r->len = (size_t)got;
+        }
+        char ch = r->buf[r->off++];
+        if (ch == '\n') { line[n < cap ? n : cap - 1] = '\0'; return 1; }
+        if (n + 1 < cap) line[n] = ch;
+        n++;
+    }
+}
+
+static void build_request(client_t *c, char *req, size_t cap) {
+    const options_t *o = c->opt;
+    int dice = rand_r(&c->seed) % 100;
+    const char *a = kg_entity_at(c->graph, (size_t)rand_r(&c->seed) % c->n_names)->name;
+    if (dice < o->path_pct) {
+        const char *b = kg_entity_at(c->graph, (size_t)rand_r(&c->seed) % c->n_names)->name;
+        snprintf(req, cap, "PATH %s|%s\n", a, b);
+    } else if (dice < o->path_pct + o->search_pct) {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "%.3s", a);
+        snprintf(req, cap, "SEARCH %s\n", prefix);
+    } else {
+        snprintf(req, cap, "NEIGHBORS %s\n", a);
+    }
+}
+
+/*
+   [SECTION] Client Thread: keep `depth` requests in flight
+ */
+static void *client_main(void *arg) {
+    client_t *c = (client_t*)arg;
+    const options_t *o = c->opt;
+    int fd = connect_server(o);
+    if (fd < 0) { c->failed = 1; return NULL; }
+
+    reader_t *rd = (reader_t*)calloc(1, sizeof(reader_t));
+    double *sent_at = (double*)malloc(sizeof(double) * (size_t)o->depth);
+    if (!rd || !sent_at) { c->failed = 1; free(rd); free(sent_at); close(fd); return NULL; }
+    rd->fd = fd;
+
+    char req[KG_LINE_BUF], line[KG_LINE_BUF];
+    int sent = 0, head = 0;
+
+    /* Replies arrive in request order, so a ring of send times suffices. */
+    while (sent < o->requests && sent < o->depth) {
+        build_request(c, req, sizeof(req));
+        sent_at[sent % o->depth] = now_us();
+        if (!write_all(fd, req, strlen(req))) { c->failed = 1; goto out; }
+        sent++;
+    }
+    while (c->done < sent) {
+        if (!read_line_fd(rd, line, sizeof(line))) { c->failed = 1; goto out; }
+        if (strncmp(line, "OK ", 3) == 0) {
+            long n = atol(line + 3);
+            for (long i = 0; i < n; ++i)
+                if (!read_line_fd(rd, line, sizeof(line))) { c->failed = 1; goto out; }
+        } else {
+            c->errors++;        /* "ERR no path" is an ordinary answer under random load */
+        }
+        c->lat_us[c->done++] = now_us() - sent_at[head];
+        head = (head + 1) % o->depth;
+
+        if (sent < o->requests) {
+            build_request(c, req, sizeof(req));
+            sent_at[sent % o->depth] = now_us();
+            if (!write_all(fd, req, strlen(req))) { c->failed = 1; goto out; }
+            sent++;
+        }
+    }
+out:
+    free(rd);
+    free(sent_at);
+    close(fd);
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double pct(const double *sorted, size_t n, double p) {
+    if (!n) return 0;
+    size_t i = (size_t)(p / 100.0 * (double)(n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s (-u <socket path> | -p <port> [-H <addr>]) -f <relations file>\n"
+        "          [-c conns] [-d depth] [-n requests/conn] [-P path%%] [-S search%%]\n", prog);
+}
+
+/*
+   [SECTION] Main
+ */
+int main(int argc, char **argv) {
+    options_t o = { NULL, "127.0.0.1", 0, DEFAULT_CONNS, DEFAULT_DEPTH, DEFAULT_REQUESTS,
+                    DEFAULT_PATH_PCT, DEFAULT_SEARCH_PCT };
+    const char *file = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "u:p:H:f:c:d:n:P:S:h")) != -1) {
+        switch (opt) {
+        case 'u': o.upath = optarg; break;
+        case 'p': o.port = atoi(optarg); break;
+        case 'H': o.host = optarg; break;
+        case 'f': file = optarg; break;
+        case 'c': o.conns = atoi(optarg); break;
+        case 'd': o.depth = atoi(optarg); break;
+        case 'n': o.requests = atoi(optarg); break;
+        case 'P': o.path_pct = atoi(optarg); break;
+        case 'S': o.search_pct = atoi(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if ((!o.upath && o.port <= 0) || !file || o.conns <= 0 || o.depth <= 0 || o.requests <= 0) {
+        usage(argv[0]); return 2;
+    }
+
+    kg_graph_t *g = kg_graph_new();
+    if (!g || kg_load_file(g, file, NULL, NULL, NULL) != KG_OK || kg_entity_count(g) == 0) {
+        fprintf(stderr, "cannot load entity names from '%s'\n", file);
+        return 1;
+    }
+
+    client_t *cl = (client_t*)calloc((size_t)o.conns, sizeof(client_t));
+    pthread_t *th = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)o.conns);
+    if (!cl || !th) { fprintf(stderr, "Memory allocation failed\n"); return 1; }
+    for (int i = 0; i < o.conns; ++i) {
+        cl[i].opt = &o;
+        cl[i].graph = g;
+        cl[i].n_names = kg_entity_count(g);
+        cl[i].seed = 0x9e3779b9u * (unsigned)(i + 1);
+        cl[i].lat_us = (double*)malloc(sizeof(double) * (size_t)o.requests);
+        if (!cl[i].lat_us) { fprintf(stderr, "Memory allocation failed\n"); return 1; }
+    }
+
+    double t0 = now_us();
+    for (int i = 0; i < o.conns; ++i) pthread_create(&th[i], NULL, client_main, &cl[i]);
+    for (int i = 0; i < o.conns; ++i) pthread_join(th[i], NULL);
+    double elapsed = (now_us() - t0) / 1e6;
+
+    size_t total = 0; int errors = 0, failed = 0;
+    for (int i = 0; i < o.conns; ++i) { total += (size_t)cl[i].done; errors += cl[i].errors; failed += cl[i].failed; }
+    double *all = (double*)malloc(sizeof(double) * (total ? total : 1));
+    if (!all) { fprintf(stderr, "Memory allocation failed\n"); return 1; }
+    size_t k = 0;
+    for (int i = 0; i < o.conns; ++i) {
+        memcpy(all + k, cl[i].lat_us, sizeof(double) * (size_t)cl[i].done);
+        k += (size_t)cl[i].done;
+        free(cl[i].lat_us);
+    }
+    qsort(all, total, sizeof(double), cmp_double);
+
+    printf("connections   : %d (depth %d)\n", o.conns, o.depth);
+    printf("requests      : %zu in %.3f s (%d ERR replies, %d failed connections)\n",
+           total, elapsed, errors, failed);
+    printf("throughput    : %.0f req/s\n", elapsed > 0 ? (double)total / elapsed : 0.0);
+    printf("latency (us)  : p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           pct(all, total, 50), pct(all, total, 90), pct(all, total, 99),
+           total ? all[total - 1] : 0.0);
+
+    free(all); free(cl); free(th);
+    kg_graph_free(g);
+    return failed ? 1 : 0;
+}
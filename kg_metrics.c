@@ -0,0 +1,285 @@
+/* =========================================================================
+   Knowledge Graph Engine — Command Metrics (implementation)
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include "kg_metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+
+static const char *const OP_NAMES[KG_OP_COUNT] = {
+    "lookup", "search", "path", "query", "add", "load", "save", "export"
+};
+
+const char *kg_op_name(kg_op_t op) {
+    return (unsigned)op < KG_OP_COUNT ? OP_NAMES[op] : "unknown";
+}
+
+static unsigned long counter(const _Atomic unsigned long *c) {
+    return atomic_load_explicit((_Atomic unsigned long*)c, memory_order_relaxed);
+}
+
+/* Human-scaled duration, e.g. "812ns", "14.2us", "3.10ms", "1.25s". */
+static const char *fmt_ns(double ns, char *buf, size_t n) {
+    if (ns < 1e3) snprintf(buf, n, "%.0fns", ns);
+    else if (ns < 1e6) snprintf(buf, n, "%.1fus", ns / 1e3);
+    else if (ns < 1e9) snprintf(buf, n, "%.2fms", ns / 1e6);
+    else snprintf(buf, n, "%.2fs", ns / 1e9);
+    return buf;
+}
+
+/* [SECTION] Human-readable Report */
+
+void kg_metrics_report(const kg_metrics_t *m, const kg_graph_t *g, FILE *fp) {
+    char b[5][32];
+    fprintf(fp, "%-8s %10s %8s %9s %9s %9s %9s %9s\n",
+            "command", "count", "errors", "p50", "p90", "p99", "max", "mean");
+    for (int op = 0; op < KG_OP_COUNT; ++op) {
+        const kg_hist_t *h = &m->latency_ns[op];
+        unsigned long n = kg_hist_count(h);
+        if (n == 0) { fprintf(fp, "%-8s %10lu %8s\n", OP_NAMES[op], 0ul, "-"); continue; }
+        fprintf(fp, "%-8s %10lu %8lu %9s %9s %9s %9s %9s\n", OP_NAMES[op], n, counter(&m->errors[op]),
+                fmt_ns((double)kg_hist_percentile(h, 50), b[0], sizeof(b[0])),
+                fmt_ns((double)kg_hist_percentile(h, 90), b[1], sizeof(b[1])),
+                fmt_ns((double)kg_hist_percentile(h, 99), b[2], sizeof(b[2])),
+                fmt_ns((double)kg_hist_max(h), b[3], sizeof(b[3])),
+                fmt_ns(kg_hist_mean(h), b[4], sizeof(b[4])));
+    }
+    if (!g) return;
+
+    const kg_graph_counters_t *c = &g->counters;
+    unsigned long lookups = counter(&c->lookups), runs = counter(&c->bfs_runs);
+    fprintf(fp, "\nentities %zu, edges %zu, version %lu\n",
+            kg_entity_count(g), kg_edge_count(g), kg_graph_version(g));
+    kg_component_stats_t cs;
+    kg_component_stats(g, &cs);
+    fprintf(fp, "components %zu (largest %zu entities, %lu lone entities)\n",
+            cs.components, cs.largest, cs.size_hist[0]);
+    fprintf(fp, "hash lookups %lu, probes %lu (%.2f per lookup)\n", lookups, counter(&c->probes),
+            lookups ? (double)counter(&c->probes) / (double)lookups : 0.0);
+    fprintf(fp, "bfs runs %lu, edges scanned %lu, nodes visited p50 %lu p99 %lu max %lu (mean %.1f)\n",
+            runs, counter(&c->bfs_edges),
+            kg_hist_percentile(&c->bfs_visited, 50), kg_hist_percentile(&c->bfs_visited, 99),
+            kg_hist_max(&c->bfs_visited), kg_hist_mean(&c->bfs_visited));
+}
+
+/* [SECTION] Memory Report */
+
+static const char *fmt_bytes(double b, char *buf, size_t n) {
+    if (b < 1024) snprintf(buf, n, "%.0f B", b);
+    else if (b < 1024.0 * 1024) snprintf(buf, n, "%.1f KiB", b / 1024);
+    else if (b < 1024.0 * 1024 * 1024) snprintf(buf, n, "%.1f MiB", b / (1024.0 * 1024));
+    else snprintf(buf, n, "%.2f GiB", b / (1024.0 * 1024 * 1024));
+    return buf;
+}
+
+kg_status_t kg_metrics_memory(const kg_graph_t *g, FILE *fp) {
+    kg_mem_report_t r;
+    kg_status_t st = kg_memory_report(g, &r);
+    if (st != KG_OK) return st;
+
+    char b[3][32];
+    fprintf(fp, "%-10s %10s %12s %12s %6s\n", "category", "objects", "bytes", "payload", "used");
+    int worst = -1;
+    size_t worst_waste = 0;
+    for (int c = 0; c < KG_MEM_CATS; ++c) {
+        const kg_mem_usage_t *u = &r.cat[c];
+        if (c == KG_MEM_BFS) continue;
+        fprintf(fp, "%-10s %10zu %12s %12s %5.0f%%\n", kg_mem_cat_name((kg_mem_cat_t)c), u->objects,
+                fmt_bytes((double)u->bytes, b[0], sizeof(b[0])), fmt_bytes((double)u->payload, b[1], sizeof(b[1])),
+                u->bytes ? 100.0 * (double)u->payload / (double)u->bytes : 0.0);
+        if (u->bytes - u->payload > worst_waste) { worst_waste = u->bytes - u->payload; worst = c; }
+    }
+    fprintf(fp, "%-10s %10s %12s\n", "total", "", fmt_bytes((double)r.total, b[0], sizeof(b[0])));
+    fprintf(fp, "%-10s %10s %12s   (live now; peak %s)\n", "bfs", "",
+            fmt_bytes((double)r.cat[KG_MEM_BFS].bytes, b[0], sizeof(b[0])),
+            fmt_bytes((double)r.cat[KG_MEM_BFS].peak, b[1], sizeof(b[1])));
+
+    fprintf(fp, "\n%zu entities, %zu edges, %zu distinct labels (malloc headers not included)\n",
+            r.entities, r.edges, r.distinct_labels);
+    if (r.entities)
+        fprintf(fp, "per entity: %8.1f B   minimum %6.1f B   (%.1fx)\n", r.bytes_per_entity,
+                r.min_per_entity, r.bytes_per_entity / r.min_per_entity);
+    if (r.edges)
+        fprintf(fp, "per edge:   %8.1f B   minimum %6.1f B   (%.1fx)\n", r.bytes_per_edge,
+                r.min_per_edge, r.bytes_per_edge / r.min_per_edge);
+    if (worst >= 0)
+        fprintf(fp, "largest overhead: %s, %s allocated beyond its payload\n",
+                kg_mem_cat_name((kg_mem_cat_t)worst), fmt_bytes((double)worst_waste, b[2], sizeof(b[2])));
+    return KG_OK;
+}
+
+/* [SECTION] EXPLAIN */
+
+void kg_metrics_explain(const kg_profile_t *p, unsigned long total_ns, FILE *fp) {
+    char b[32];
+    unsigned long inside = 0;
+    fprintf(fp, "%-28s %6s %10s %7s\n", "phase", "calls", "time", "share");
+    for (int ph = 0; ph < KG_PHASE_COUNT; ++ph) {
+        inside += p->phase_ns[ph];
+        if (!p->phase_calls[ph]) continue;
+        fprintf(fp, "%-28s %6lu %10s %6.1f%%\n", kg_phase_name((kg_phase_t)ph), p->phase_calls[ph],
+                fmt_ns((double)p->phase_ns[ph], b, sizeof(b)),
+                total_ns ? 100.0 * (double)p->phase_ns[ph] / (double)total_ns : 0.0);
+    }
+    unsigned long outside = total_ns > inside ? total_ns - inside : 0;
+    fprintf(fp, "%-28s %6s %10s %6.1f%%\n", "outside the library", "",
+            fmt_ns((double)outside, b, sizeof(b)), total_ns ? 100.0 * (double)outside / (double)total_ns : 0.0);
+    fprintf(fp, "%-28s %6s %10s\n", "total", "", fmt_ns((double)total_ns, b, sizeof(b)));
+
+    fprintf(fp, "\nhash lookups %lu, probes %lu\n", p->lookups, p->probes);
+    fprintf(fp, "search candidates %lu, returned %lu\n", p->candidates, p->matches);
+    fprintf(fp, "bfs nodes visited %lu, edges scanned %lu, queue high-water %lu, path length %lu\n",
+            p->nodes_visited, p->edges_scanned, p->queue_hwm, p->path_len);
+}
+
+/* [SECTION] Relation Statistics */
+
+/* Upper edge of the power-of-two bucket holding percentile p. */
+static unsigned long degree_percentile(const unsigned long *hist, unsigned long n, unsigned long max, double p) {
+    unsigned long rank = (unsigned long)(p / 100.0 * (double)n + 0.5), seen = 0;
+    if (rank < 1) rank = 1;
+    for (int k = 0; k < KG_DEGREE_BUCKETS; ++k) {
+        seen += hist[k];
+        if (seen >= rank) {
+            unsigned long v = (2ul << k) - 1;
+            return v < max ? v : max;
+        }
+    }
+    return max;
+}
+
+kg_status_t kg_metrics_relations(const kg_graph_t *g, size_t top, FILE *fp) {
+    size_t n = kg_label_count(g);
+    kg_label_stats_t *st = (kg_label_stats_t*)malloc((n ? n : 1) * sizeof(kg_label_stats_t));
+    unsigned *order = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    if (!st || !order) { free(st); free(order); return KG_ERR_NOMEM; }
+    for (size_t l = 0; l < n; ++l) { kg_label_stats(g, (unsigned)l, &st[l]); order[l] = (unsigned)l; }
+    for (size_t i = 1; i < n; ++i)
+        for (size_t j = i; j > 0 && st[order[j]].edges > st[order[j - 1]].edges; --j) {
+            unsigned x = order[j]; order[j] = order[j - 1]; order[j - 1] = x;
+        }
+    if (top == 0 || top > n) top = n;
+
+    fprintf(fp, "%-24s %10s %9s %9s | %20s | %20s\n", "relation", "edges", "subjects", "objects",
+            "out mean/p90/max", "in mean/p90/max");
+    for (size_t i = 0; i < top; ++i) {
+        const kg_label_stats_t *s = &st[order[i]];
+        char out[32], in[32];
+        snprintf(out, sizeof(out), "%.1f/%lu/%lu", s->subjects ? (double)s->edges / s->subjects : 0.0,
+                 degree_percentile(s->out_hist, s->subjects, s->max_out, 90), s->max_out);
+        snprintf(in, sizeof(in), "%.1f/%lu/%lu", s->objects ? (double)s->edges / s->objects : 0.0,
+                 degree_percentile(s->in_hist, s->objects, s->max_in, 90), s->max_in);
+        fprintf(fp, "%-24.24s %10lu %9lu %9lu | %20s | %20s\n", kg_label_name(g, order[i]),
+                s->edges, s->subjects, s->objects, out, in);
+    }
+    if (top < n) fprintf(fp, "(%zu more relations)\n", n - top);
+    free(st); free(order);
+    return KG_OK;
+}
+
+/*
+   [SECTION] Prometheus Text Format
+   - Latencies as summaries in seconds (quantiles from the histogram).
+   - Graph counters as counters / gauges.
+ */
+static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+#define N_QUANTILES (sizeof(QUANTILES) / sizeof(QUANTILES[0]))
+
+void kg_metrics_prometheus(const kg_metrics_t *m, const kg_graph_t *g, FILE *fp) {
+    fprintf(fp, "# HELP kg_command_latency_seconds Latency per command type.\n");
+    fprintf(fp, "# TYPE kg_command_latency_seconds summary\n");
+    for (int op = 0; op < KG_OP_COUNT; ++op) {
+        const kg_hist_t *h = &m->latency_ns[op];
+        for (size_t q = 0; q < N_QUANTILES; ++q)
+            fprintf(fp, "kg_command_latency_seconds{command=\"%s\",quantile=\"%g\"} %.9f\n", OP_NAMES[op],
+                    QUANTILES[q], (double)kg_hist_percentile(h, QUANTILES[q] * 100) / 1e9);
+        fprintf(fp, "kg_command_latency_seconds_sum{command=\"%s\"} %.9f\n", OP_NAMES[op],
+                (double)counter(&h->sum) / 1e9);
+        fprintf(fp, "kg_command_latency_seconds_count{command=\"%s\"} %lu\n", OP_NAMES[op], kg_hist_count(h));
+    }
+    fprintf(fp, "# HELP kg_command_errors_total Commands that did not succeed.\n");
+    fprintf(fp, "# TYPE kg_command_errors_total counter\n");
+    for (int op = 0; op < KG_OP_COUNT; ++op)
+        fprintf(fp, "kg_command_errors_total{command=\"%s\"} %lu\n", OP_NAMES[op], counter(&m->errors[op]));
+    if (!g) return;
+
+    const kg_graph_counters_t *c = &g->counters;
+    fprintf(fp, "# TYPE kg_entities gauge\nkg_entities %zu\n", kg_entity_count(g));
+    fprintf(fp, "# TYPE kg_edges gauge\nkg_edges %zu\n", kg_edge_count(g));
+    fprintf(fp, "# TYPE kg_graph_version gauge\nkg_graph_version %lu\n", kg_graph_version(g));
+    kg_component_stats_t cs;
+    kg_component_stats(g, &cs);
+    fprintf(fp, "# TYPE kg_components gauge\nkg_components %zu\n", cs.components);
+    fprintf(fp, "# TYPE kg_largest_component gauge\nkg_largest_component %zu\n", cs.largest);
+    fprintf(fp, "# HELP kg_components_by_size Connected components with min <= size < 2 * min.\n");
+    fprintf(fp, "# TYPE kg_components_by_size gauge\n");
+    for (int k = 0; k < KG_DEGREE_BUCKETS; ++k)
+        if (cs.size_hist[k]) fprintf(fp, "kg_components_by_size{min=\"%lu\"} %lu\n", 1ul << k, cs.size_hist[k]);
+    fprintf(fp, "# TYPE kg_hash_lookups_total counter\nkg_hash_lookups_total %lu\n", counter(&c->lookups));
+    fprintf(fp, "# TYPE kg_hash_probes_total counter\nkg_hash_probes_total %lu\n", counter(&c->probes));
+    fprintf(fp, "# TYPE kg_bfs_runs_total counter\nkg_bfs_runs_total %lu\n", counter(&c->bfs_runs));
+    fprintf(fp, "# TYPE kg_bfs_edges_scanned_total counter\nkg_bfs_edges_scanned_total %lu\n", counter(&c->bfs_edges));
+    fprintf(fp, "# HELP kg_bfs_nodes_visited Entities dequeued per BFS.\n");
+    fprintf(fp, "# TYPE kg_bfs_nodes_visited summary\n");
+    for (size_t q = 0; q < N_QUANTILES; ++q)
+        fprintf(fp, "kg_bfs_nodes_visited{quantile=\"%g\"} %lu\n", QUANTILES[q],
+                kg_hist_percentile(&c->bfs_visited, QUANTILES[q] * 100));
+    fprintf(fp, "kg_bfs_nodes_visited_sum %lu\n", counter(&c->bfs_visited.sum));
+    fprintf(fp, "kg_bfs_nodes_visited_count %lu\n", kg_hist_count(&c->bfs_visited));
+
+    fprintf(fp, "# HELP kg_memory_bytes Bytes allocated per subsystem (bfs: live scratch).\n");
+    fprintf(fp, "# TYPE kg_memory_bytes gauge\n");
+    for (int k = 0; k < KG_MEM_CATS; ++k)
+        fprintf(fp, "kg_memory_bytes{category=\"%s\"} %ld\n", kg_mem_cat_name((kg_mem_cat_t)k),
+                atomic_load_explicit(&((kg_graph_t*)g)->mem[k].bytes, memory_order_relaxed));
+    fprintf(fp, "# TYPE kg_memory_bfs_peak_bytes gauge\nkg_memory_bfs_peak_bytes %ld\n",
+            atomic_load_explicit(&((kg_graph_t*)g)->mem[KG_MEM_BFS].peak, memory_order_relaxed));
+}
+
+kg_status_t kg_metrics_dump(const kg_metrics_t *m, const kg_graph_t *g, const char *path) {
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) return KG_ERR_IO;
+    kg_metrics_prometheus(m, g, fp);
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) { remove(tmp); return KG_ERR_IO; }
+    return KG_OK;
+}
+
+/* [SECTION] Dump on Signal (a sigwait thread, so no async-signal limits) */
+
+typedef struct dump_job {
+    const kg_metrics_t *m;
+    const kg_graph_t *g;
+    const char *path;
+    sigset_t set;
+} dump_job_t;
+
+static void *dump_thread(void *arg) {
+    dump_job_t *job = (dump_job_t*)arg;
+    for (;;) {
+        int sig;
+        if (sigwait(&job->set, &sig) != 0) continue;
+        kg_metrics_dump(job->m, job->g, job->path);
+    }
+    return NULL;
+}
+
+kg_status_t kg_metrics_dump_on_signal(const kg_metrics_t *m, const kg_graph_t *g,
+                                      const char *path, int signo) {
+    dump_job_t *job = (dump_job_t*)malloc(sizeof(dump_job_t));
+    if (!job) return KG_ERR_NOMEM;
+    job->m = m; job->g = g; job->path = path;
+    sigemptyset(&job->set);
+    sigaddset(&job->set, signo);
+    if (pthread_sigmask(SIG_BLOCK, &job->set, NULL) != 0) { free(job); return KG_ERR_INVALID; }
+
+    pthread_t th;
+    if (pthread_create(&th, NULL, dump_thread, job) != 0) { free(job); return KG_ERR_NOMEM; }
+    pthread_detach(th);
+    return KG_OK;      /* job lives as long as the thread, i.e. the process */
+}
@@ -0,0 +1,90 @@
+/* =========================================================================
+   Knowledge Graph Engine — Command Metrics
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Per-command latency histograms for the programs built on the library
+     (console, server), plus reporting of the graph's own work counters
+     (kg_graph_counters_t). Recording is a clock read and a few relaxed
+     atomic adds, so it stays on in production.
+       - kg_metrics_report():     human-readable table ("stats" command)
+       - kg_metrics_memory():     memory per subsystem vs. the minimum
+       - kg_metrics_explain():    one query's kg_profile_t, phase by phase
+       - kg_metrics_relations():  per-relation counts and degrees
+       - kg_metrics_prometheus(): Prometheus text exposition format
+       - kg_metrics_dump_on_signal(): rewrite a .prom file on SIGUSR1
+->   Build:
+     add kg_metrics.c to any program that reports; the library itself
+     only needs kg_hist.h
+
+   ========================================================================= */
+#ifndef KG_METRICS_H
+#define KG_METRICS_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "kg_graph.h"
+#include "kg_hist.h"
+
+/* Command types with their own latency histogram. */
+typedef enum kg_op {
+    KG_OP_LOOKUP = 0,    /* exact entity / neighbor lookup */
+    KG_OP_SEARCH,        /* fuzzy search */
+    KG_OP_PATH,          /* BFS shortest path */
+    KG_OP_QUERY,         /* triple-pattern query */
+    KG_OP_ADD,           /* entity or edge insert */
+    KG_OP_LOAD,
+    KG_OP_SAVE,
+    KG_OP_EXPORT,
+    KG_OP_COUNT
+} kg_op_t;
+
+typedef struct kg_metrics {
+    kg_hist_t latency_ns[KG_OP_COUNT];
+    _Atomic unsigned long errors[KG_OP_COUNT];
+} kg_metrics_t;
+
+const char *kg_op_name(kg_op_t op);
+
+static inline unsigned long kg_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000ul + (unsigned long)ts.tv_nsec;
+}
+
+/* Typical use:  unsigned long t0 = kg_now_ns(); ...; kg_metrics_record(m, KG_OP_PATH, t0, ok); */
+static inline void kg_metrics_record(kg_metrics_t *m, kg_op_t op, unsigned long start_ns, int ok) {
+    kg_hist_record(&m->latency_ns[op], kg_now_ns() - start_ns);
+    if (!ok) atomic_fetch_add_explicit(&m->errors[op], 1, memory_order_relaxed);
+}
+
+/* [SECTION] Reporting (g may be NULL to leave out graph counters) */
+
+void kg_metrics_report(const kg_metrics_t *m, const kg_graph_t *g, FILE *fp);
+void kg_metrics_prometheus(const kg_metrics_t *m, const kg_graph_t *g, FILE *fp);
+
+/* Table of kg_memory_report(): bytes, objects and payload per category,
+   then bytes per entity / per edge next to the theoretical minimum. */
+kg_status_t kg_metrics_memory(const kg_graph_t *g, FILE *fp);
+
+/* Phase table of a profile taken with kg_profile_begin/end, plus its work
+   counters. total_ns is the caller's wall time for the whole command; the
+   part no phase accounts for is shown as "outside the library". */
+void kg_metrics_explain(const kg_profile_t *p, unsigned long total_ns, FILE *fp);
+
+/* The `top` relations by edge count (0 = all): distinct subjects and
+   objects, mean / p90 / max out- and in-degree from kg_label_stats(). */
+kg_status_t kg_metrics_relations(const kg_graph_t *g, size_t top, FILE *fp);
+
+/* Writes the Prometheus text to `path` via a temp file + rename, so a
+   scraper never reads half a dump. */
+kg_status_t kg_metrics_dump(const kg_metrics_t *m, const kg_graph_t *g, const char *path);
+
+/* Starts a thread that calls kg_metrics_dump() each time `signo` arrives.
+   Blocks `signo` in the calling thread, so call it before creating any
+   other threads (they inherit the mask). m, g and path must stay valid
+   for the rest of the process. */
+kg_status_t kg_metrics_dump_on_signal(const kg_metrics_t *m, const kg_graph_t *g,
+                                      const char *path, int signo);
+
+#endif /* KG_METRICS_H */
@@ -0,0 +1,535 @@
+/* =========================================================================
+   Knowledge Graph Engine — Microbenchmarks for the Hot Primitives
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Times the primitives every query is built from, over inputs taken
+     from a synthetic graph: the djb2 hash, exact lookup, line parsing,
+     trim / squeeze, case-insensitive compare and the BFS inner loop,
+     over the linked adjacency lists and over the CSR index (plain and
+     label-partitioned, with a relation filter).
+     Each case is warmed up, then run for R repetitions; a repetition is
+     a batch sized to take about T ms. Reports median, MAD and min ns/op.
+     Results are JSON (one case per line), so two runs can be compared:
+     with -c, a case whose median grew by more than the threshold (and by
+     more than 3 MADs of noise) is flagged and the exit status is 1.
+->   Build & Run:
+     gcc -O2 -pthread -o kg_microbench kg_microbench.c kg_synth.c kg_graph.c kg_csr.c -lm
+     ./kg_microbench -o base.json
+     ./kg_microbench -c base.json                 (exit 1 on a regression)
+
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kg_synth.h"
+#include "kg_csr.h"
+
+/* [SECTION] Configuration */
+
+#define DEFAULT_NODES      20000
+#define DEFAULT_DEGREE     8
+#define DEFAULT_REPS       15
+#define DEFAULT_WARMUP     3
+#define DEFAULT_TARGET_MS  20.0
+#define DEFAULT_THRESHOLD  10.0     /* % slowdown that counts as a regression */
+#define INPUT_POOL         4096     /* distinct inputs cycled through per case */
+#define MAX_CASES          16
+#define FILTER_LABELS      4        /* filtered cases follow this many labels */
+
+typedef struct bench_env {
+    kg_graph_t *g;
+    size_t n;
+    char (*names)[KG_NAME_LEN];         /* existing entity names */
+    char (*missing)[KG_NAME_LEN];       /* names that are not in the graph */
+    char (*upper)[KG_NAME_LEN];         /* names[i] in upper case */
+    char (*lines)[KG_LINE_BUF];         /* raw relation lines, with padding */
+    unsigned *prev, *queue;             /* BFS scratch */
+    kg_csr_t *csr, *csr_part;           /* plain and label-partitioned index */
+    kg_label_filter_t filter;           /* first FILTER_LABELS labels */
+} bench_env_t;
+
+/* A case runs `iters` operations and returns how many it actually did
+   (the BFS case counts edges scanned, not calls). */
+typedef size_t (*bench_fn)(bench_env_t *env, size_t iters);
+
+typedef struct bench_case {
+    const char *name;
+    bench_fn fn;
+} bench_case_t;
+
+typedef struct bench_result {
+    char name[64];
+    double median, mad, min;            /* ns/op */
+    size_t ops_per_rep;
+    int reps;
+} bench_result_t;
+
+/* Results feed this, so the compiler cannot drop the work. */
+static volatile unsigned long sink;
+
+/* [SECTION] Timing & Statistics */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double median_of(double *v, size_t n) {
+    qsort(v, n, sizeof(double), cmp_double);
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* [SECTION] Cases */
+
+static size_t bm_hash(bench_env_t *env, size_t iters) {
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) acc += kg_hash_name(env->names[i % INPUT_POOL]);
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_find_hit(bench_env_t *env, size_t iters) {
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) acc += (unsigned long)(size_t)kg_find_entity(env->g, env->names[i % INPUT_POOL]);
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_find_miss(bench_env_t *env, size_t iters) {
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) acc += (unsigned long)(size_t)kg_find_entity(env->g, env->missing[i % INPUT_POOL]);
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_parse_line(bench_env_t *env, size_t iters) {
+    char src[KG_NAME_LEN], rel[KG_REL_LEN], tgt[KG_NAME_LEN];
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) {
+        acc += (unsigned long)kg_parse_relation_line(env->lines[i % INPUT_POOL], src, rel, tgt);
+        acc += (unsigned char)tgt[0];
+    }
+    sink += acc;
+    return iters;
+}
+
+/* trim and squeeze work in place, so each op starts from a fresh copy;
+   the copy is part of the measured cost (a few ns, constant across runs). */
+static size_t bm_trim(bench_env_t *env, size_t iters) {
+    char buf[KG_LINE_BUF];
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) {
+        const char *s = env->lines[i % INPUT_POOL];
+        memcpy(buf, s, strlen(s) + 1);
+        kg_trim(buf);
+        acc += (unsigned char)buf[0];
+    }
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_squeeze(bench_env_t *env, size_t iters) {
+    char buf[KG_LINE_BUF];
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) {
+        const char *s = env->lines[i % INPUT_POOL];
+        memcpy(buf, s, strlen(s) + 1);
+        kg_squeeze_spaces(buf);
+        acc += (unsigned char)buf[0];
+    }
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_ci_cmp_equal(bench_env_t *env, size_t iters) {
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i) {
+        size_t k = i % INPUT_POOL;
+        acc += (unsigned long)kg_ci_cmp(env->names[k], env->upper[k]);
+    }
+    sink += acc;
+    return iters;
+}
+
+static size_t bm_ci_cmp_differ(bench_env_t *env, size_t iters) {
+    unsigned long acc = 0;
+    for (size_t i = 0; i < iters; ++i)
+        acc += (unsigned long)kg_ci_cmp(env->names[i % INPUT_POOL], env->upper[(i + 1) % INPUT_POOL]);
+    sink += acc;
+    return iters;
+}
+
+/* The loop of kg_shortest_path_at() without the allocation and path
+   rebuild: full BFS from a rotating source, timed per edge scanned. */
+static size_t bm_bfs_inner(bench_env_t *env, size_t iters) {
+    kg_snapshot_t s;
+    if (kg_snapshot_acquire(env->g, &s) != KG_OK) return 0;
+    size_t scanned = 0;
+    static size_t next_src;
+    while (scanned < iters) {
+        unsigned src = (unsigned)(next_src++ * 2654435761u % env->n);
+        memset(env->prev, 0xff, env->n * sizeof(unsigned));
+        size_t head = 0, tail = 0;
+        env->prev[src] = src; env->queue[tail++] = src;
+        while (head < tail) {
+            unsigned cur = env->queue[head++];
+            for (kg_relation_t *r = kg_snapshot_relations(&s, kg_entity_at(env->g, cur)); r; r = r->next) {
+                unsigned nx = r->target->id;
+                scanned++;
+                if (env->prev[nx] == KG_NO_ENTITY) { env->prev[nx] = cur; env->queue[tail++] = nx; }
+            }
+        }
+        if (tail == 1) scanned++;   /* isolated source: still one op */
+        sink += tail;
+    }
+    kg_snapshot_release(&s);
+    return scanned;
+}
+
+/* Same BFS over the CSR arrays, timed per edge scanned. */
+static size_t bm_bfs_csr(bench_env_t *env, size_t iters) {
+    const kg_csr_t *c = env->csr;
+    size_t scanned = 0;
+    static size_t next_src;
+    while (scanned < iters) {
+        unsigned src = (unsigned)(next_src++ * 2654435761u % env->n);
+        memset(env->prev, 0xff, env->n * sizeof(unsigned));
+        size_t head = 0, tail = 0;
+        env->prev[src] = src; env->queue[tail++] = src;
+        while (head < tail) {
+            unsigned cur = env->queue[head++];
+            for (size_t k = c->row[cur]; k < c->row[cur + 1]; ++k) {
+                unsigned nx = c->tgt[k];
+                scanned++;
+                if (env->prev[nx] == KG_NO_ENTITY) { env->prev[nx] = cur; env->queue[tail++] = nx; }
+            }
+        }
+        if (tail == 1) scanned++;
+        sink += tail;
+    }
+    return scanned;
+}
+
+/* Relation-filtered BFS, one op = one full traversal, so the three
+   layouts are comparable: lists test every edge's label, the plain CSR
+   does the same from flat arrays, the partitioned CSR tests one label
+   per run and never loads the targets of the others. */
+static size_t bm_bfs_filtered_list(bench_env_t *env, size_t iters) {
+    kg_snapshot_t s;
+    if (kg_snapshot_acquire(env->g, &s) != KG_OK) return 0;
+    static size_t next_src;
+    for (size_t i = 0; i < iters; ++i) {
+        unsigned src = (unsigned)(next_src++ * 2654435761u % env->n);
+        memset(env->prev, 0xff, env->n * sizeof(unsigned));
+        size_t head = 0, tail = 0;
+        env->prev[src] = src; env->queue[tail++] = src;
+        while (head < tail) {
+            unsigned cur = env->queue[head++];
+            for (kg_relation_t *r = kg_snapshot_relations(&s, kg_entity_at(env->g, cur)); r; r = r->next) {
+                if (!kg_label_allowed(&env->filter, r->label)) continue;
+                unsigned nx = r->target->id;
+                if (env->prev[nx] == KG_NO_ENTITY) { env->prev[nx] = cur; env->queue[tail++] = nx; }
+            }
+        }
+        sink += tail;
+    }
+    kg_snapshot_release(&s);
+    return iters;
+}
+
+/* The loops of kg_csr_shortest_path(), without allocation or early exit. */
+static size_t bfs_filtered_csr(bench_env_t *env, const kg_csr_t *c, size_t iters) {
+    const kg_label_filter_t *f = &env->filter;
+    static size_t next_src;
+    for (size_t i = 0; i < iters; ++i) {
+        unsigned src = (unsigned)(next_src++ * 2654435761u % env->n);
+        memset(env->prev, 0xff, env->n * sizeof(unsigned));
+        size_t head = 0, tail = 0;
+        env->prev[src] = src; env->queue[tail++] = src;
+        while (head < tail) {
+            unsigned cur = env->queue[head++];
+            if (c->run_row) {
+                for (size_t r = c->run_row[cur]; r < c->run_row[cur + 1]; ++r) {
+                    if (!kg_label_allowed(f, c->run_lab[r])) continue;
+                    for (size_t k = c->run_start[r]; k < c->run_start[r + 1]; ++k) {
+                        unsigned nx = c->tgt[k];
+                        if (env->prev[nx] == KG_NO_ENTITY) { env->prev[nx] = cur; env->queue[tail++] = nx; }
+                    }
+                }
+            } else {
+                for (size_t k = c->row[cur]; k < c->row[cur + 1]; ++k) {
+                    if (!kg_label_allowed(f, c->lab[k])) continue;
+                    unsigned nx = c->tgt[k];
+                    if (env->prev[nx] == KG_NO_ENTITY) { env->prev[nx] = cur; env->queue[tail++] = nx; }
+                }
+            }
+        }
+        sink += tail;
+    }
+    return iters;
+}
+
+static size_t bm_bfs_filtered_csr(bench_env_t *env, size_t iters) {
+    return bfs_filtered_csr(env, env->csr, iters);
+}
+
+static size_t bm_bfs_filtered_csr_part(bench_env_t *env, size_t iters) {
+    return bfs_filtered_csr(env, env->csr_part, iters);
+}
+
+static const bench_case_t CASES[] = {
+    { "hash_djb2",           bm_hash },
+    { "find_entity_hit",     bm_find_hit },
+    { "find_entity_miss",    bm_find_miss },
+    { "parse_relation_line", bm_parse_line },
+    { "trim",                bm_trim },
+    { "squeeze_spaces",      bm_squeeze },
+    { "ci_cmp_equal",        bm_ci_cmp_equal },
+    { "ci_cmp_differ",       bm_ci_cmp_differ },
+    { "bfs_inner_per_edge",  bm_bfs_inner },
+    { "bfs_csr_per_edge",    bm_bfs_csr },
+    { "bfs_filtered_list",   bm_bfs_filtered_list },
+    { "bfs_filtered_csr",    bm_bfs_filtered_csr },
+    { "bfs_filtered_csr_part", bm_bfs_filtered_csr_part },
+};
+#define N_CASES (sizeof(CASES) / sizeof(CASES[0]))
+
+/* [SECTION] Inputs (a synthetic graph plus strings drawn from it) */
+
+static int env_init(bench_env_t *env, unsigned long nodes, unsigned degree, uint64_t seed) {
+    memset(env, 0, sizeof(*env));
+    kg_synth_opts_t so;
+    kg_synth_defaults(&so);
+    so.nodes = nodes; so.edges = nodes * degree; so.seed = seed;
+
+    FILE *fp = tmpfile();
+    if (!fp || kg_synth_write(fp, &so) != KG_OK) return 0;
+    rewind(fp);
+    env->lines = (char (*)[KG_LINE_BUF])malloc(sizeof(*env->lines) * INPUT_POOL);
+    if (!env->lines) return 0;
+
+    /* First INPUT_POOL lines become parse/trim inputs, with the stray
+       spacing that hand-written files have. */
+    char raw[KG_LINE_BUF], a[KG_NAME_LEN], r[KG_REL_LEN], b[KG_NAME_LEN];
+    size_t nl = 0;
+    while (nl < INPUT_POOL && fgets(raw, sizeof(raw), fp)) {
+        raw[strcspn(raw, "\r\n")] = 0;
+        if (!kg_parse_relation_line(raw, a, r, b)) continue;
+        snprintf(env->lines[nl], KG_LINE_BUF, nl % 2 ? "  %s |  %s| %s  " : "%s|%s  |%s", a, r, b);
+        nl++;
+    }
+    for (; nl < INPUT_POOL && nl > 0; ++nl) memcpy(env->lines[nl], env->lines[nl % 64], KG_LINE_BUF);
+    fclose(fp);
+
+    env->g = kg_graph_new();
+    if (!env->g) return 0;
+    kg_rng_t rng;
+    kg_rng_seed(&rng, seed);
+    kg_batch_begin(env->g);
+    for (unsigned long i = 0; i < so.edges; ++i) {
+        unsigned long u = kg_rng_below(&rng, nodes), v = kg_rng_below(&rng, nodes);
+        kg_synth_entity_name(u, a, sizeof(a));
+        kg_synth_entity_name(v, b, sizeof(b));
+        kg_synth_label_name((unsigned)(i % so.labels), r, sizeof(r));
+        if (kg_add_edge(env->g, a, r, b, NULL) != KG_OK) { kg_batch_commit(env->g); return 0; }
+    }
+    kg_batch_commit(env->g);
+    env->n = kg_entity_count(env->g);
+
+    env->names = (char (*)[KG_NAME_LEN])malloc(sizeof(*env->names) * INPUT_POOL);
+    env->missing = (char (*)[KG_NAME_LEN])malloc(sizeof(*env->missing) * INPUT_POOL);
+    env->upper = (char (*)[KG_NAME_LEN])malloc(sizeof(*env->upper) * INPUT_POOL);
+    env->prev = (unsigned*)malloc(sizeof(unsigned) * env->n);
+    env->queue = (unsigned*)malloc(sizeof(unsigned) * env->n);
+    if (!env->names || !env->missing || !env->upper || !env->prev || !env->queue) return 0;
+    for (size_t i = 0; i < INPUT_POOL; ++i) {
+        const char *nm = kg_entity_at(env->g, kg_rng_below(&rng, env->n))->name;
+        snprintf(env->names[i], KG_NAME_LEN, "%s", nm);
+        kg_synth_entity_name(nodes + i, env->missing[i], KG_NAME_LEN);
+        size_t k = 0;
+        for (; nm[k]; ++k) env->upper[i][k] = (char)(nm[k] >= 'a' && nm[k] <= 'z' ? nm[k] - 32 : nm[k]);
+        env->upper[i][k] = '\0';
+    }
+
+    kg_snapshot_t snap;
+    if (kg_snapshot_acquire(env->g, &snap) != KG_OK) return 0;
+    kg_status_t st = kg_csr_build(&snap, 0, &env->csr);
+    if (st == KG_OK) st = kg_csr_build(&snap, 1, &env->csr_part);
+    kg_snapshot_release(&snap);
+    if (st != KG_OK) return 0;
+    char labels[FILTER_LABELS][KG_REL_LEN];
+    const char *lp[FILTER_LABELS];
+    for (unsigned i = 0; i < FILTER_LABELS; ++i) {
+        kg_synth_label_name(i, labels[i], KG_REL_LEN);
+        lp[i] = labels[i];
+    }
+    return kg_label_filter_init(env->g, &env->filter, 0, lp, FILTER_LABELS, NULL) == KG_OK;
+}
+
+static void env_free(bench_env_t *env) {
+    kg_graph_free(env->g);
+    free(env->names); free(env->missing); free(env->upper); free(env->lines);
+    free(env->prev); free(env->queue);
+    kg_csr_free(env->csr); kg_csr_free(env->csr_part);
+    kg_label_filter_free(&env->filter);
+}
+
+/*
+   [SECTION] Runner
+   - Calibrate: double the batch until one batch takes target_ms.
+   - Warm up, then time `reps` batches; ns/op per batch is one sample.
+ */
+static void run_case(const bench_case_t *c, bench_env_t *env, int reps, int warmup,
+                     double target_ms, bench_result_t *out) {
+    size_t batch = 16;
+    for (;;) {
+        double t0 = now_ns();
+        c->fn(env, batch);
+        if (now_ns() - t0 >= target_ms * 1e6 / 4 || batch >= ((size_t)1 << 34)) break;
+        batch *= 2;
+    }
+    batch *= 4;
+    for (int i = 0; i < warmup; ++i) c->fn(env, batch);
+
+    double *ns = (double*)malloc(sizeof(double) * (size_t)reps);
+    double *dev = (double*)malloc(sizeof(double) * (size_t)reps);
+    size_t ops = 0;
+    for (int i = 0; i < reps; ++i) {
+        double t0 = now_ns();
+        ops = c->fn(env, batch);
+        ns[i] = (now_ns() - t0) / (double)(ops ? ops : 1);
+    }
+    snprintf(out->name, sizeof(out->name), "%s", c->name);
+    out->reps = reps;
+    out->ops_per_rep = ops;
+    out->median = median_of(ns, (size_t)reps);
+    out->min = ns[0];
+    for (int i = 0; i < reps; ++i) dev[i] = ns[i] > out->median ? ns[i] - out->median : out->median - ns[i];
+    out->mad = median_of(dev, (size_t)reps);
+    free(ns); free(dev);
+}
+
+/* [SECTION] JSON Output & Baseline Comparison */
+
+static void write_json(FILE *fp, const bench_result_t *res, size_t n,
+                       unsigned long nodes, unsigned degree, int reps, double target_ms) {
+    fprintf(fp, "{\n  \"tool\": \"kg_microbench\",\n  \"time\": %ld,\n", (long)time(NULL));
+    fprintf(fp, "  \"config\": {\"nodes\": %lu, \"degree\": %u, \"reps\": %d, \"target_ms\": %.1f},\n",
+            nodes, degree, reps, target_ms);
+    fprintf(fp, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < n; ++i)
+        fprintf(fp, "    {\"name\": \"%s\", \"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, "
+                    "\"ops_per_rep\": %zu, \"reps\": %d}%s\n",
+                res[i].name, res[i].median, res[i].mad, res[i].min,
+                res[i].ops_per_rep, res[i].reps, i + 1 < n ? "," : "");
+    fprintf(fp, "  ]\n}\n");
+}
+
+/* Reads back what write_json() wrote: one benchmark object per line. */
+static size_t read_baseline(const char *path, bench_result_t *base, size_t max) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    char line[KG_LINE_BUF];
+    size_t n = 0;
+    while (n < max && fgets(line, sizeof(line), fp)) {
+        char *p = strstr(line, "{\"name\": \"");
+        if (!p) continue;
+        if (sscanf(p, "{\"name\": \"%63[^\"]\", \"median_ns\": %lf, \"mad_ns\": %lf",
+                   base[n].name, &base[n].median, &base[n].mad) == 3) n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+static int compare(const bench_result_t *res, size_t n, const bench_result_t *base, size_t nb,
+                   double threshold) {
+    int regressions = 0;
+    fprintf(stderr, "%-22s %10s %10s %8s\n", "case", "base ns", "now ns", "change");
+    for (size_t i = 0; i < n; ++i) {
+        const bench_result_t *b = NULL;
+        for (size_t j = 0; j < nb; ++j) if (strcmp(base[j].name, res[i].name) == 0) b = &base[j];
+        if (!b || b->median <= 0) { fprintf(stderr, "%-22s %10s %10.2f\n", res[i].name, "-", res[i].median); continue; }
+        double change = 100.0 * (res[i].median - b->median) / b->median;
+        double noise = 3.0 * (res[i].mad > b->mad ? res[i].mad : b->mad);
+        int slow = change > threshold && res[i].median - b->median > noise;
+        regressions += slow;
+        fprintf(stderr, "%-22s %10.2f %10.2f %+7.1f%%%s\n", res[i].name, b->median, res[i].median,
+                change, slow ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-n nodes] [-d degree] [-r reps] [-w warmup reps] [-t ms per rep]\n"
+        "          [-b case substring] [-o out.json] [-c baseline.json] [-T threshold%%] [-S seed]\n", prog);
+}
+
+/*
+   [SECTION] Main
+ */
+int main(int argc, char **argv) {
+    unsigned long nodes = DEFAULT_NODES;
+    unsigned degree = DEFAULT_DEGREE;
+    int reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+    double target_ms = DEFAULT_TARGET_MS, threshold = DEFAULT_THRESHOLD;
+    const char *out = NULL, *baseline = NULL, *filter = NULL;
+    uint64_t seed = 42;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:r:w:t:b:o:c:T:S:h")) != -1) {
+        switch (opt) {
+        case 'n': nodes = strtoul(optarg, NULL, 10); break;
+        case 'd': degree = (unsigned)atoi(optarg); break;
+        case 'r': reps = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 't': target_ms = atof(optarg); break;
+        case 'b': filter = optarg; break;
+        case 'o': out = optarg; break;
+        case 'c': baseline = optarg; break;
+        case 'T': threshold = atof(optarg); break;
+        case 'S': seed = strtoull(optarg, NULL, 10); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (nodes < 16 || degree == 0 || reps <= 0 || warmup < 0 || target_ms <= 0) { usage(argv[0]); return 2; }
+
+    bench_env_t env;
+    if (!env_init(&env, nodes, degree, seed)) { fprintf(stderr, "cannot build benchmark inputs\n"); return 1; }
+
+    bench_result_t res[MAX_CASES];
+    size_t nr = 0;
+    for (size_t i = 0; i < N_CASES; ++i) {
+        if (filter && !strstr(CASES[i].name, filter)) continue;
+        run_case(&CASES[i], &env, reps, warmup, target_ms, &res[nr]);
+        fprintf(stderr, "%-22s %9.2f ns/op  (MAD %.2f, min %.2f)\n",
+                res[nr].name, res[nr].median, res[nr].mad, res[nr].min);
+        nr++;
+    }
+    env_free(&env);
+
+    FILE *fp = out ? fopen(out, "w") : stdout;
+    if (!fp) { perror(out); return 1; }
+    write_json(fp, res, nr, nodes, degree, reps, target_ms);
+    if (out && fclose(fp) != 0) { perror(out); return 1; }
+
+    if (baseline) {
+        bench_result_t base[MAX_CASES];
+        size_t nb = read_baseline(baseline, base, MAX_CASES);
+        if (nb == 0) { fprintf(stderr, "cannot read baseline '%s'\n", baseline); return 1; }
+        int slow = compare(res, nr, base, nb, threshold);
+        if (slow) { fprintf(stderr, "%d regression(s) over %.0f%%\n", slow, threshold); return 1; }
+    }
+    return 0;
+}
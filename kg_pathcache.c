@@ -0,0 +1,245 @@
+/* =========================================================================
+   Knowledge Graph Engine — Path Result Cache (implementation)
+   ========================================================================= */
+
+#include "kg_pathcache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NIL ((unsigned)-1)
+
+struct kg_path_cache_entry {
+    /* key */
+    unsigned src, tgt;
+    int weighted;
+    int has_filter, allow_new;
+    size_t nbits;
+    uint64_t *bits;              /* (nbits + 63) / 64 words, bits past nbits cleared */
+    uint64_t hash;
+    /* value */
+    unsigned long version;
+    kg_status_t result;          /* KG_OK or KG_ERR_NO_PATH */
+    kg_entity_t **nodes;
+    size_t len;
+    double cost;
+    /* links */
+    unsigned chain;              /* next in bucket, or next free */
+    unsigned prev, next;         /* LRU */
+};
+
+/*
+   [SECTION] Keys
+   - A filter is compared bit for bit over its nbits; the tail of the last
+     word is masked off so two parses of the same list compare equal.
+ */
+static size_t filter_words(const kg_label_filter_t *f) { return (f->nbits + 63) / 64; }
+
+static uint64_t filter_word(const kg_label_filter_t *f, size_t i) {
+    uint64_t w = f->bits[i];
+    if (i == filter_words(f) - 1 && (f->nbits & 63)) w &= ((uint64_t)1 << (f->nbits & 63)) - 1;
+    return w;
+}
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static uint64_t key_hash(unsigned src, unsigned tgt, const kg_label_filter_t *f, int weighted) {
+    uint64_t h = mix(mix((uint64_t)src * 0xff51afd7ed558ccdull, tgt), (uint64_t)weighted);
+    if (f) {
+        h = mix(mix(h, f->nbits), (uint64_t)f->allow_new + 2);
+        for (size_t i = 0; i < filter_words(f); ++i) h = mix(h, filter_word(f, i));
+    }
+    return h;
+}
+
+static int key_equal(const kg_path_cache_entry_t *e, uint64_t h, unsigned src, unsigned tgt,
+                     const kg_label_filter_t *f, int weighted) {
+    if (e->hash != h || e->src != src || e->tgt != tgt || e->weighted != weighted) return 0;
+    if (e->has_filter != (f != NULL)) return 0;
+    if (!f) return 1;
+    if (e->nbits != f->nbits || e->allow_new != f->allow_new) return 0;
+    for (size_t i = 0; i < filter_words(f); ++i)
+        if (e->bits[i] != filter_word(f, i)) return 0;
+    return 1;
+}
+
+/* [SECTION] Lifetime */
+
+kg_status_t kg_path_cache_new(size_t cap, kg_path_cache_t **out) {
+    *out = NULL;
+    if (cap == 0) cap = KG_PATH_CACHE_DEFAULT;
+    if (cap >= NIL) return KG_ERR_INVALID;
+    kg_path_cache_t *c = (kg_path_cache_t*)calloc(1, sizeof(kg_path_cache_t));
+    if (!c) return KG_ERR_NOMEM;
+    c->cap = cap;
+    c->nbuckets = 1;
+    while (c->nbuckets < 2 * cap) c->nbuckets <<= 1;
+    c->slots = (kg_path_cache_entry_t*)calloc(cap, sizeof(kg_path_cache_entry_t));
+    c->buckets = (unsigned*)malloc(c->nbuckets * sizeof(unsigned));
+    if (!c->slots || !c->buckets) { free(c->slots); free(c->buckets); free(c); return KG_ERR_NOMEM; }
+    memset(c->buckets, 0xff, c->nbuckets * sizeof(unsigned));
+    for (size_t i = 0; i < cap; ++i) c->slots[i].chain = i + 1 < cap ? (unsigned)(i + 1) : NIL;
+    c->free_list = 0;
+    c->head = c->tail = NIL;
+    pthread_mutex_init(&c->lock, NULL);
+    *out = c;
+    return KG_OK;
+}
+
+void kg_path_cache_free(kg_path_cache_t *c) {
+    if (!c) return;
+    for (size_t i = 0; i < c->cap; ++i) { free(c->slots[i].bits); free(c->slots[i].nodes); }
+    pthread_mutex_destroy(&c->lock);
+    free(c->slots); free(c->buckets);
+    free(c);
+}
+
+size_t kg_path_cache_bytes(const kg_path_cache_t *c) {
+    size_t b = sizeof(*c) + c->cap * sizeof(kg_path_cache_entry_t) + c->nbuckets * sizeof(unsigned);
+    pthread_mutex_lock(&((kg_path_cache_t*)c)->lock);
+    for (unsigned i = c->head; i != NIL; i = c->slots[i].next) {
+        const kg_path_cache_entry_t *e = &c->slots[i];
+        b += e->len * sizeof(kg_entity_t*) + (e->bits ? (e->nbits + 63) / 64 * sizeof(uint64_t) : 0);
+    }
+    pthread_mutex_unlock(&((kg_path_cache_t*)c)->lock);
+    return b;
+}
+
+/*
+   [SECTION] LRU List & Table (caller holds the lock)
+ */
+static void lru_unlink(kg_path_cache_t *c, unsigned i) {
+    kg_path_cache_entry_t *e = &c->slots[i];
+    if (e->prev != NIL) c->slots[e->prev].next = e->next; else c->head = e->next;
+    if (e->next != NIL) c->slots[e->next].prev = e->prev; else c->tail = e->prev;
+}
+
+static void lru_push_front(kg_path_cache_t *c, unsigned i) {
+    kg_path_cache_entry_t *e = &c->slots[i];
+    e->prev = NIL; e->next = c->head;
+    if (c->head != NIL) c->slots[c->head].prev = i; else c->tail = i;
+    c->head = i;
+}
+
+static unsigned *bucket_of(kg_path_cache_t *c, uint64_t h) {
+    return &c->buckets[h & (c->nbuckets - 1)];
+}
+
+static void drop(kg_path_cache_t *c, unsigned i) {
+    kg_path_cache_entry_t *e = &c->slots[i];
+    unsigned *p = bucket_of(c, e->hash);
+    while (*p != i) p = &c->slots[*p].chain;
+    *p = e->chain;
+    lru_unlink(c, i);
+    free(e->bits); free(e->nodes);
+    e->bits = NULL; e->nodes = NULL;
+    e->chain = c->free_list;
+    c->free_list = i;
+    c->used--;
+}
+
+static unsigned find(kg_path_cache_t *c, uint64_t h, unsigned src, unsigned tgt,
+                     const kg_label_filter_t *f, int weighted) {
+    for (unsigned i = *bucket_of(c, h); i != NIL; i = c->slots[i].chain)
+        if (key_equal(&c->slots[i], h, src, tgt, f, weighted)) return i;
+    return NIL;
+}
+
+/* [SECTION] Lookup & Insert */
+
+kg_status_t kg_path_cache_get(kg_path_cache_t *c, unsigned long version, const kg_entity_t *src,
+                              const kg_entity_t *tgt, const kg_label_filter_t *f, int weighted,
+                              kg_path_t *out) {
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    weighted = !!weighted;
+    uint64_t h = key_hash(src->id, tgt->id, f, weighted);
+
+    pthread_mutex_lock(&c->lock);
+    unsigned i = find(c, h, src->id, tgt->id, f, weighted);
+    if (i == NIL || c->slots[i].version != version) {
+        if (i != NIL && c->slots[i].version < version) {   /* newer ones serve newer readers */
+            drop(c, i);
+            atomic_fetch_add_explicit(&c->stats.stale, 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&c->lock);
+        atomic_fetch_add_explicit(&c->stats.misses, 1, memory_order_relaxed);
+        return KG_ERR_NOT_FOUND;
+    }
+    kg_path_cache_entry_t *e = &c->slots[i];
+    lru_unlink(c, i);
+    lru_push_front(c, i);
+    kg_status_t st = e->result;
+    if (st == KG_OK) {
+        out->nodes = (kg_entity_t**)malloc(e->len * sizeof(kg_entity_t*));
+        if (out->nodes) {
+            memcpy(out->nodes, e->nodes, e->len * sizeof(kg_entity_t*));
+            out->len = e->len;
+            out->cost = e->cost;
+        } else st = KG_ERR_NOMEM;
+    }
+    pthread_mutex_unlock(&c->lock);
+    atomic_fetch_add_explicit(&c->stats.hits, 1, memory_order_relaxed);
+    return st;
+}
+
+void kg_path_cache_put(kg_path_cache_t *c, unsigned long version, const kg_entity_t *src,
+                       const kg_entity_t *tgt, const kg_label_filter_t *f, int weighted,
+                       kg_status_t result, const kg_path_t *p) {
+    if (result != KG_OK && result != KG_ERR_NO_PATH) return;
+    weighted = !!weighted;
+
+    /* Copies are made outside the lock */
+    uint64_t *bits = NULL;
+    kg_entity_t **nodes = NULL;
+    if (f) {
+        bits = (uint64_t*)malloc((filter_words(f) ? filter_words(f) : 1) * sizeof(uint64_t));
+        if (!bits) return;
+        for (size_t k = 0; k < filter_words(f); ++k) bits[k] = filter_word(f, k);
+    }
+    if (result == KG_OK) {
+        nodes = (kg_entity_t**)malloc(p->len * sizeof(kg_entity_t*));
+        if (!nodes) { free(bits); return; }
+        memcpy(nodes, p->nodes, p->len * sizeof(kg_entity_t*));
+    }
+    uint64_t h = key_hash(src->id, tgt->id, f, weighted);
+
+    pthread_mutex_lock(&c->lock);
+    unsigned i = find(c, h, src->id, tgt->id, f, weighted);
+    if (i != NIL) {
+        /* Another thread got there first; keep whichever is newer */
+        if (c->slots[i].version >= version) {
+            pthread_mutex_unlock(&c->lock);
+            free(bits); free(nodes);
+            return;
+        }
+        drop(c, i);
+    }
+    if (c->free_list == NIL) {
+        drop(c, c->tail);
+        atomic_fetch_add_explicit(&c->stats.evictions, 1, memory_order_relaxed);
+    }
+    i = c->free_list;
+    kg_path_cache_entry_t *e = &c->slots[i];
+    c->free_list = e->chain;
+    e->src = src->id; e->tgt = tgt->id;
+    e->weighted = weighted;
+    e->has_filter = f != NULL;
+    e->allow_new = f ? f->allow_new : 0;
+    e->nbits = f ? f->nbits : 0;
+    e->bits = bits;
+    e->hash = h;
+    e->version = version;
+    e->result = result;
+    e->nodes = nodes;
+    e->len = result == KG_OK ? p->len : 0;
+    e->cost = result == KG_OK ? p->cost : 0;
+    unsigned *b = bucket_of(c, h);
+    e->chain = *b;
+    *b = i;
+    lru_push_front(c, i);
+    c->used++;
+    pthread_mutex_unlock(&c->lock);
+}
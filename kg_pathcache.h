@@ -0,0 +1,76 @@
+/* =========================================================================
+   Knowledge Graph Engine — Path Result Cache
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Bounded LRU cache of path query results keyed by (source, target,
+     relation filter, BFS or weighted). "No path" answers are cached too:
+     they are the expensive ones.
+->   Invalidation:
+     Every entry carries the graph version it was computed at and is only
+     served to a reader at that same version. Each insert (entity
+     or edge) publishes a new version, so any write retires the whole
+     cache at the cost of one comparison per lookup; stale entries are
+     dropped as they are found.
+->   Threads:
+     One mutex around the table; lookups copy the path out, so callers
+     own what they get and free it with kg_path_free() as usual.
+->   Build:
+     add kg_pathcache.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_PATHCACHE_H
+#define KG_PATHCACHE_H
+
+#include "kg_graph.h"
+
+#define KG_PATH_CACHE_DEFAULT 1024
+
+typedef struct kg_path_cache_stats {
+    _Atomic unsigned long hits;
+    _Atomic unsigned long misses;        /* includes stale */
+    _Atomic unsigned long stale;         /* found, but older than the graph */
+    _Atomic unsigned long evictions;     /* least recently used, to make room */
+} kg_path_cache_stats_t;
+
+typedef struct kg_path_cache_entry kg_path_cache_entry_t;
+
+typedef struct kg_path_cache {
+    pthread_mutex_t lock;
+    size_t cap, used;
+    kg_path_cache_entry_t *slots;        /* cap entries */
+    unsigned *buckets;                   /* nbuckets chain heads */
+    size_t nbuckets;
+    unsigned head, tail;                 /* LRU list: head = most recent */
+    unsigned free_list;
+    kg_path_cache_stats_t stats;
+} kg_path_cache_t;
+
+/* cap entries (0 = KG_PATH_CACHE_DEFAULT). */
+kg_status_t kg_path_cache_new(size_t cap, kg_path_cache_t **out);
+void kg_path_cache_free(kg_path_cache_t *c);
+size_t kg_path_cache_bytes(const kg_path_cache_t *c);
+
+/* KG_OK with a copy of the cached path in *out, KG_ERR_NO_PATH when "no
+   path" is cached, KG_ERR_NOT_FOUND on a miss (or KG_ERR_NOMEM). Only an
+   entry computed at exactly `version` (kg_graph_version(), or the version
+   of the snapshot the caller works in) is served. f may be NULL (all
+   relations); weighted tells BFS and cheapest-path apart. */
+kg_status_t kg_path_cache_get(kg_path_cache_t *c, unsigned long version, const kg_entity_t *src,
+                              const kg_entity_t *tgt, const kg_label_filter_t *f, int weighted,
+                              kg_path_t *out);
+
+/* Remembers the outcome of a query (KG_OK with p, or KG_ERR_NO_PATH; any
+   other status is ignored). version is kg_graph_version() read before the
+   query ran, or the snapshot's version: if the graph moved on meanwhile
+   the entry is simply never served. */
+void kg_path_cache_put(kg_path_cache_t *c, unsigned long version, const kg_entity_t *src,
+                       const kg_entity_t *tgt, const kg_label_filter_t *f, int weighted,
+                       kg_status_t result, const kg_path_t *p);
+
+static inline double kg_path_cache_hit_rate(const kg_path_cache_t *c) {
+    unsigned long h = atomic_load_explicit(&((kg_path_cache_t*)c)->stats.hits, memory_order_relaxed);
+    unsigned long m = atomic_load_explicit(&((kg_path_cache_t*)c)->stats.misses, memory_order_relaxed);
+    return h + m ? (double)h / (double)(h + m) : 0.0;
+}
+
+#endif /* KG_PATHCACHE_H */
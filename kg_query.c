@@ -0,0 +1,880 @@
+/* =========================================================================
+   Knowledge Graph Engine — Triple-Pattern Queries (implementation)
+   ========================================================================= */
+
+#include "kg_query.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <float.h>
+
+#define NO_VAR ((unsigned)-1)
+
+/* PERM[o][k]: which triple position (0 = s, 1 = p, 2 = o) is component k of order o */
+static const unsigned char PERM[KG_ORDERS][3] = {
+    { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 },      /* SPO POS OSP */
+    { 0, 2, 1 }, { 1, 0, 2 }, { 2, 1, 0 }       /* SOP PSO OPS */
+};
+
+void kg_triples_free(kg_triples_t *t) {
+    if (!t) return;
+    for (int o = 0; o < KG_ORDERS; ++o) free(t->t[o]);
+    free(t);
+}
+
+size_t kg_triples_bytes(const kg_triples_t *t) {
+    size_t b = sizeof(*t);
+    for (int o = 0; o < KG_ORDERS; ++o)
+        if (t->t[o]) b += 3 * t->n * sizeof(unsigned);
+    return b;
+}
+
+/*
+   [SECTION] Index Build
+   - Each order is three stable counting-sort passes (LSD: last component
+     first), O(n + ids) per pass and no comparisons.
+ */
+static void counting_pass(const unsigned *src, unsigned *dst, size_t n, int k, size_t range, size_t *cnt) {
+    memset(cnt, 0, (range + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; ++i) cnt[src[3 * i + k] + 1]++;
+    for (size_t v = 0; v < range; ++v) cnt[v + 1] += cnt[v];
+    for (size_t i = 0; i < n; ++i) {
+        size_t d = cnt[src[3 * i + k]]++;
+        memcpy(dst + 3 * d, src + 3 * i, 3 * sizeof(unsigned));
+    }
+}
+
+/* spo: n distinct triples sorted as SPO; fills a (3n) in order o. */
+static kg_status_t sort_order(const kg_triples_t *t, const unsigned *spo, int o, unsigned *a) {
+    size_t n = t->n, range[3] = { t->n_entities, t->n_labels, t->n_entities };
+    size_t cnt_len = (t->n_entities > t->n_labels ? t->n_entities : t->n_labels) + 1;
+    unsigned *tmp = (unsigned*)malloc((n ? 3 * n : 1) * sizeof(unsigned));
+    size_t *cnt = (size_t*)malloc(cnt_len * sizeof(size_t));
+    if (!tmp || !cnt) { free(tmp); free(cnt); return KG_ERR_NOMEM; }
+    for (size_t i = 0; i < n; ++i)
+        for (int k = 0; k < 3; ++k) a[3 * i + k] = spo[3 * i + PERM[o][k]];
+    /* a -> tmp -> a -> tmp, then back into a */
+    counting_pass(a, tmp, n, 2, range[PERM[o][2]], cnt);
+    counting_pass(tmp, a, n, 1, range[PERM[o][1]], cnt);
+    counting_pass(a, tmp, n, 0, range[PERM[o][0]], cnt);
+    memcpy(a, tmp, 3 * n * sizeof(unsigned));
+    free(tmp); free(cnt);
+    return KG_OK;
+}
+
+kg_status_t kg_triples_build(const kg_snapshot_t *s, int flags, kg_triples_t **out) {
+    *out = NULL;
+    kg_triples_t *t = (kg_triples_t*)calloc(1, sizeof(kg_triples_t));
+    if (!t) return KG_ERR_NOMEM;
+    t->g = s->g;
+    t->version = s->version;
+    t->n_entities = s->n_entities;
+
+    size_t m = 0;
+    for (size_t v = 0; v < t->n_entities; ++v) {
+        kg_entity_t *e = kg_entity_at(s->g, v);
+        if (!kg_visible(s, e)) continue;
+        for (kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next) m++;
+    }
+    unsigned *raw = (unsigned*)malloc((m ? 3 * m : 1) * sizeof(unsigned));
+    if (!raw) { kg_triples_free(t); return KG_ERR_NOMEM; }
+    size_t k = 0;
+    for (size_t v = 0; v < t->n_entities; ++v) {
+        kg_entity_t *e = kg_entity_at(s->g, v);
+        if (!kg_visible(s, e)) continue;
+        for (kg_relation_t *r = kg_snapshot_relations(s, e); r; r = r->next, ++k) {
+            raw[3 * k] = (unsigned)v;
+            raw[3 * k + 1] = r->label;
+            raw[3 * k + 2] = r->target->id;
+            if (r->label + 1 > t->n_labels) t->n_labels = r->label + 1;
+        }
+    }
+
+    /* SPO first, then drop repeated edges (same relation added twice) */
+    t->n = m;
+    int n_orders = (flags & KG_TRIPLES_ALL_ORDERS) ? KG_ORDERS : KG_SOP;
+    for (int o = 0; o < n_orders; ++o) {
+        t->t[o] = (unsigned*)malloc((m ? 3 * m : 1) * sizeof(unsigned));
+        if (!t->t[o]) { free(raw); kg_triples_free(t); return KG_ERR_NOMEM; }
+    }
+    kg_status_t st = sort_order(t, raw, KG_SPO, t->t[KG_SPO]);
+    free(raw);
+    if (st != KG_OK) { kg_triples_free(t); return st; }
+    unsigned *a = t->t[KG_SPO];
+    size_t n = 0;
+    for (size_t i = 0; i < m; ++i)
+        if (n == 0 || memcmp(a + 3 * (n - 1), a + 3 * i, 3 * sizeof(unsigned)) != 0)
+            memmove(a + 3 * n++, a + 3 * i, 3 * sizeof(unsigned));
+    t->n = n;
+    for (int o = KG_POS; o < n_orders; ++o) {
+        st = sort_order(t, a, o, t->t[o]);
+        if (st != KG_OK) { kg_triples_free(t); return st; }
+    }
+    *out = t;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Parsing
+   - Tokens split on blanks; "..." keeps blanks inside a name; a lone "."
+     closes a pattern (the last one may omit it).
+ */
+void kg_query_free(kg_query_t *q) {
+    if (!q) return;
+    for (size_t i = 0; i < q->n_vars; ++i) free(q->vars[i]);
+    free(q->vars); free(q->var_is_label); free(q->pat);
+    free(q);
+}
+
+static kg_status_t fail(kg_status_t st, char *err, size_t err_len, const char *fmt, const char *arg) {
+    if (err && err_len) snprintf(err, err_len, fmt, arg);
+    return st;
+}
+
+static kg_status_t add_var(kg_query_t *q, const char *name, int is_label, unsigned *id,
+                           char *err, size_t err_len) {
+    for (size_t i = 0; i < q->n_vars; ++i)
+        if (strcmp(q->vars[i], name) == 0) {
+            if (q->var_is_label[i] != is_label)
+                return fail(KG_ERR_INVALID, err, err_len, "?%s is used as both a relation and an entity", name);
+            *id = (unsigned)i;
+            return KG_OK;
+        }
+    char **vars = (char**)realloc(q->vars, (q->n_vars + 1) * sizeof(char*));
+    if (!vars) return KG_ERR_NOMEM;
+    q->vars = vars;
+    unsigned char *kinds = (unsigned char*)realloc(q->var_is_label, q->n_vars + 1);
+    if (!kinds) return KG_ERR_NOMEM;
+    q->var_is_label = kinds;
+    q->vars[q->n_vars] = (char*)malloc(strlen(name) + 1);
+    if (!q->vars[q->n_vars]) return KG_ERR_NOMEM;
+    strcpy(q->vars[q->n_vars], name);
+    q->var_is_label[q->n_vars] = (unsigned char)is_label;
+    *id = (unsigned)q->n_vars++;
+    return KG_OK;
+}
+
+static kg_status_t make_term(const kg_graph_t *g, kg_query_t *q, const char *tok, int quoted, int pos,
+                             kg_term_t *term, char *err, size_t err_len) {
+    if (!quoted && tok[0] == '?') {
+        const char *name = tok + 1;
+        if (!*name) return fail(KG_ERR_INVALID, err, err_len, "%s", "empty variable name");
+        for (const char *c = name; *c; ++c)
+            if (!isalnum((unsigned char)*c) && *c != '_')
+                return fail(KG_ERR_INVALID, err, err_len, "bad variable name: ?%s", name);
+        term->is_var = 1;
+        return add_var(q, name, pos == 1, &term->id, err, err_len);
+    }
+    term->is_var = 0;
+    if (pos == 1) {
+        term->id = kg_find_label(g, tok);
+        if (term->id == KG_NO_LABEL) return fail(KG_ERR_NOT_FOUND, err, err_len, "unknown relation: %s", tok);
+    } else {
+        kg_entity_t *e = kg_find_entity(g, tok);
+        if (!e) return fail(KG_ERR_NOT_FOUND, err, err_len, "unknown entity: %s", tok);
+        term->id = e->id;
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_query_parse(const kg_graph_t *g, const char *text, kg_query_t **out,
+                           char *err, size_t err_len) {
+    *out = NULL;
+    if (err && err_len) err[0] = '\0';
+    kg_query_t *q = (kg_query_t*)calloc(1, sizeof(kg_query_t));
+    char *buf = (char*)malloc(strlen(text) + 1);
+    if (!q || !buf) { free(q); free(buf); return KG_ERR_NOMEM; }
+    strcpy(buf, text);
+
+    kg_status_t st = KG_OK;
+    size_t cap = 0;
+    int pos = 0;                 /* terms read for the current pattern */
+    char *p = buf;
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        int end = *p == '\0';
+        int dot = !end && p[0] == '.' && (p[1] == '\0' || isspace((unsigned char)p[1]));
+        if (end || dot) {
+            if (pos != 0 && pos != 3) {
+                st = fail(KG_ERR_INVALID, err, err_len, "%s", "each pattern needs a subject, a relation and an object");
+                break;
+            }
+            if (pos == 3) q->n_patterns++;
+            pos = 0;
+            if (end) break;
+            p++;
+            continue;
+        }
+        if (pos == 3) {
+            st = fail(KG_ERR_INVALID, err, err_len, "expected \".\" before %s", p);
+            break;
+        }
+        char *tok = p;
+        int quoted = *p == '"';
+        if (quoted) {
+            tok = ++p;
+            while (*p && *p != '"') p++;
+            if (!*p) { st = fail(KG_ERR_INVALID, err, err_len, "%s", "unterminated quote"); break; }
+        } else {
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+        int more = *p != '\0';
+        *p = '\0';
+        if (pos == 0 && q->n_patterns == cap) {
+            cap = cap ? 2 * cap : 4;
+            kg_pattern_t *pat = (kg_pattern_t*)realloc(q->pat, cap * sizeof(kg_pattern_t));
+            if (!pat) { st = KG_ERR_NOMEM; break; }
+            q->pat = pat;
+        }
+        st = make_term(g, q, tok, quoted, pos, &q->pat[q->n_patterns].t[pos], err, err_len);
+        if (st != KG_OK) break;
+        pos++;
+        if (more) p++;
+    }
+    free(buf);
+    if (st == KG_OK && q->n_patterns == 0) st = fail(KG_ERR_INVALID, err, err_len, "%s", "no patterns");
+    if (st != KG_OK) { kg_query_free(q); return st; }
+    *out = q;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Execution
+   - rows: the partial answers, n_vars ids each; a column holds something
+     only once its variable is bound (the same for every row).
+ */
+typedef struct rowset {
+    unsigned *v;
+    size_t n, cap, w;
+} rowset_t;
+
+static unsigned *row_push(rowset_t *r) {
+    if (r->n == r->cap) {
+        size_t cap = r->cap ? 2 * r->cap : 64;
+        unsigned *v = (unsigned*)realloc(r->v, cap * (r->w ? r->w : 1) * sizeof(unsigned));
+        if (!v) return NULL;
+        r->v = v; r->cap = cap;
+    }
+    return r->v + r->n++ * r->w;
+}
+
+static int key_cmp(const unsigned *a, const unsigned *b, size_t nb) {
+    for (size_t j = 0; j < nb; ++j)
+        if (a[j] != b[j]) return a[j] < b[j] ? -1 : 1;
+    return 0;
+}
+
+/* First i >= from whose prefix is >= key (upper: > key); galloping, so a
+   cursor that moves forward a little pays a little. */
+static size_t gallop(const unsigned *a, size_t n, size_t from, const unsigned *key, size_t nb, int upper) {
+    size_t lo = from, hi = from, step = 1;
+    while (hi < n) {
+        int c = key_cmp(a + 3 * hi, key, nb);
+        if (upper ? c > 0 : c >= 0) break;
+        lo = hi + 1; hi += step; step <<= 1;
+    }
+    if (hi > n) hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = key_cmp(a + 3 * mid, key, nb);
+        if (upper ? c <= 0 : c < 0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* Bottom-up merge sort of row numbers by their nb-wide keys (stable). */
+static void sort_by_key(unsigned *idx, unsigned *tmp, size_t n, const unsigned *keys, size_t nb) {
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n, hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+                tmp[k++] = key_cmp(keys + (size_t)idx[j] * nb, keys + (size_t)idx[i] * nb, nb) < 0 ? idx[j++] : idx[i++];
+            while (i < mid) tmp[k++] = idx[i++];
+            while (j < hi) tmp[k++] = idx[j++];
+        }
+        memcpy(idx, tmp, n * sizeof(unsigned));
+    }
+}
+
+/* The order whose leading components are exactly the bound positions. */
+static int choose_order(const int bound[3], size_t *nb) {
+    *nb = (size_t)(bound[0] + bound[1] + bound[2]);
+    if (*nb == 0 || *nb == 3) return KG_SPO;
+    for (int o = 0; o < KG_SOP; ++o) {
+        int ok = 1;
+        for (size_t j = 0; j < *nb; ++j) ok &= bound[PERM[o][j]];
+        if (ok) return o;
+    }
+    return KG_SPO;
+}
+
+static kg_status_t join_pattern(const kg_triples_t *t, const kg_pattern_t *p, const unsigned char *var_bound,
+                                rowset_t *in, rowset_t *out, size_t limit, int *truncated) {
+    int bound[3];
+    for (int k = 0; k < 3; ++k) bound[k] = !p->t[k].is_var || var_bound[p->t[k].id];
+    size_t nb;
+    int o = choose_order(bound, &nb);
+    const unsigned *a = t->t[o];
+
+    size_t n = in->n;
+    unsigned *keys = (unsigned*)malloc((n && nb ? n * nb : 1) * sizeof(unsigned));
+    unsigned *idx = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    unsigned *tmp = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    if (!keys || !idx || !tmp) { free(keys); free(idx); free(tmp); return KG_ERR_NOMEM; }
+    for (size_t r = 0; r < n; ++r) {
+        const unsigned *row = in->v + r * in->w;
+        for (size_t j = 0; j < nb; ++j) {
+            const kg_term_t *term = &p->t[PERM[o][j]];
+            keys[r * nb + j] = term->is_var ? row[term->id] : term->id;
+        }
+        idx[r] = (unsigned)r;
+    }
+    sort_by_key(idx, tmp, n, keys, nb);
+    free(tmp);
+
+    kg_status_t st = KG_OK;
+    size_t cursor = 0, lo = 0, hi = 0;
+    for (size_t i = 0; i < n && !*truncated; ++i) {
+        const unsigned *key = keys + (size_t)idx[i] * nb;
+        if (i == 0 || key_cmp(key, keys + (size_t)idx[i - 1] * nb, nb) != 0) {
+            lo = gallop(a, t->n, cursor, key, nb, 0);
+            hi = gallop(a, t->n, lo, key, nb, 1);
+            cursor = lo;
+        }
+        const unsigned *row = in->v + (size_t)idx[i] * in->w;
+        for (size_t k = lo; k < hi; ++k) {
+            unsigned val[3];
+            for (int j = 0; j < 3; ++j) val[PERM[o][j]] = a[3 * k + j];
+            /* ?x rel ?x: a variable repeated in the pattern must match itself */
+            int ok = 1;
+            for (int x = 0; x < 3 && ok; ++x)
+                for (int y = x + 1; y < 3 && ok; ++y)
+                    if (p->t[x].is_var && p->t[y].is_var && p->t[x].id == p->t[y].id && val[x] != val[y]) ok = 0;
+            if (!ok) continue;
+            if (limit && out->n == limit) { *truncated = 1; break; }
+            unsigned *nr = row_push(out);
+            if (!nr) { st = KG_ERR_NOMEM; *truncated = 1; break; }
+            memcpy(nr, row, out->w * sizeof(unsigned));
+            for (int x = 0; x < 3; ++x)
+                if (p->t[x].is_var) nr[p->t[x].id] = val[x];
+        }
+    }
+    free(keys); free(idx);
+    return st;
+}
+
+void kg_query_result_free(kg_query_result_t *r) {
+    free(r->rows);
+    r->rows = NULL; r->n_rows = 0;
+}
+
+/* Patterns in the plan's order; each step's actual row count goes into it. */
+static kg_status_t run_pairwise(const kg_triples_t *t, const kg_query_t *q, kg_query_plan_t *plan,
+                                size_t limit, kg_query_result_t *out) {
+    unsigned char *var_bound = (unsigned char*)calloc(q->n_vars ? q->n_vars : 1, 1);
+    rowset_t cur = { NULL, 0, 0, q->n_vars }, next = { NULL, 0, 0, q->n_vars };
+    kg_status_t st = KG_ERR_NOMEM;
+    if (!var_bound || !row_push(&cur)) goto out;
+    if (q->n_vars) memset(cur.v, 0, q->n_vars * sizeof(unsigned));
+
+    st = KG_OK;
+    for (size_t step = 0; step < plan->n_steps && cur.n > 0; ++step) {
+        size_t i = plan->steps[step].item;
+        int last = step + 1 == plan->n_steps;
+        next.n = 0;
+        st = join_pattern(t, &q->pat[i], var_bound, &cur, &next, last ? limit : 0, &out->truncated);
+        if (st != KG_OK) goto out;
+        for (int k = 0; k < 3; ++k)
+            if (q->pat[i].t[k].is_var) var_bound[q->pat[i].t[k].id] = 1;
+        plan->steps[step].rows = next.n;
+        rowset_t swap = cur; cur = next; next = swap;
+    }
+    out->n_rows = cur.n;
+    out->rows = cur.v;
+    cur.v = NULL;
+out:
+    free(cur.v); free(next.v); free(var_bound);
+    return st;
+}
+
+/*
+   [SECTION] Leapfrog Triejoin
+   - Each pattern reads its triples as a trie: constants first, then its
+     variables in the global order, which picks one of the six orders.
+   - At variable depth d the iterators of all patterns mentioning it are
+     intersected: repeatedly seek the smallest one to the largest key
+     until all agree (leapfrog), then recurse one level down.
+ */
+typedef struct trie_it {
+    const unsigned *a;           /* triples in this pattern's order */
+    size_t n;
+    int depth;                   /* level the iterator is on, -1 = root */
+    size_t hi[3];                /* end of the current range per level */
+    size_t pos[3];               /* position per level */
+} trie_it_t;
+
+/* First i in [from, hi) whose component d is >= key (upper: > key). */
+static size_t gallop_col(const unsigned *a, size_t hi_end, size_t from, int d, unsigned key, int upper) {
+    size_t lo = from, hi = from, step = 1;
+    while (hi < hi_end) {
+        unsigned v = a[3 * hi + d];
+        if (upper ? v > key : v >= key) break;
+        lo = hi + 1; hi += step; step <<= 1;
+    }
+    if (hi > hi_end) hi = hi_end;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        unsigned v = a[3 * mid + d];
+        if (upper ? v <= key : v < key) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static unsigned it_key(const trie_it_t *it) { return it->a[3 * it->pos[it->depth] + it->depth]; }
+static int it_at_end(const trie_it_t *it) { return it->pos[it->depth] >= it->hi[it->depth]; }
+
+static void it_open(trie_it_t *it) {
+    if (it->depth < 0) {
+        it->depth = 0; it->pos[0] = 0; it->hi[0] = it->n;
+        return;
+    }
+    int d = it->depth;
+    size_t p = it->pos[d];
+    it->hi[d + 1] = gallop_col(it->a, it->hi[d], p, d, it->a[3 * p + d], 1);
+    it->pos[d + 1] = p;
+    it->depth = d + 1;
+}
+
+static void it_up(trie_it_t *it) { it->depth--; }
+
+static void it_seek(trie_it_t *it, unsigned key) {
+    int d = it->depth;
+    it->pos[d] = gallop_col(it->a, it->hi[d], it->pos[d], d, key, 0);
+}
+
+static void it_next(trie_it_t *it) {
+    int d = it->depth;
+    it->pos[d] = gallop_col(it->a, it->hi[d], it->pos[d], d, it_key(it), 1);
+}
+
+typedef struct lftj {
+    const kg_query_t *q;
+    trie_it_t *its;              /* one per pattern */
+    unsigned *var_order;         /* global variable order */
+    unsigned **parts;            /* per depth: patterns mentioning that variable */
+    size_t *n_parts;
+    trie_it_t **work;            /* scratch for one leapfrog */
+    unsigned *val;               /* current binding, by variable index */
+    kg_plan_step_t *steps;       /* per depth: bindings found */
+    rowset_t *out;
+    size_t limit;
+    int *truncated;
+    kg_status_t st;
+} lftj_t;
+
+/* Leaves every iterator on the same key; 0 once one runs out. */
+static int leapfrog_search(trie_it_t **w, size_t k, size_t *p) {
+    unsigned max = it_key(w[(*p + k - 1) % k]);
+    for (;;) {
+        trie_it_t *it = w[*p];
+        if (it_key(it) == max) return 1;
+        it_seek(it, max);
+        if (it_at_end(it)) return 0;
+        max = it_key(it);
+        *p = (*p + 1) % k;
+    }
+}
+
+static void lftj_depth(lftj_t *L, size_t depth) {
+    if (*L->truncated) return;
+    if (depth == L->q->n_vars) {
+        if (L->limit && L->out->n == L->limit) { *L->truncated = 1; return; }
+        unsigned *row = row_push(L->out);
+        if (!row) { L->st = KG_ERR_NOMEM; *L->truncated = 1; return; }
+        memcpy(row, L->val, L->q->n_vars * sizeof(unsigned));
+        return;
+    }
+    size_t k = L->n_parts[depth];
+    trie_it_t **w = L->work + depth * L->q->n_patterns;
+    for (size_t i = 0; i < k; ++i) { w[i] = &L->its[L->parts[depth][i]]; it_open(w[i]); }
+
+    /* Start with the iterators sorted by key */
+    int empty = 0;
+    for (size_t i = 0; i < k; ++i) empty |= it_at_end(w[i]);
+    if (!empty) {
+        for (size_t i = 1; i < k; ++i)
+            for (size_t j = i; j > 0 && it_key(w[j]) < it_key(w[j - 1]); --j) {
+                trie_it_t *x = w[j]; w[j] = w[j - 1]; w[j - 1] = x;
+            }
+        size_t p = 0;
+        while (leapfrog_search(w, k, &p)) {
+            L->val[L->var_order[depth]] = it_key(w[0]);
+            L->steps[depth].rows++;
+            lftj_depth(L, depth + 1);
+            if (*L->truncated) break;
+            it_next(w[p]);
+            if (it_at_end(w[p])) break;
+            p = (p + 1) % k;
+        }
+    }
+    for (size_t i = 0; i < k; ++i) it_up(w[i]);
+}
+
+/* Variables in the plan's order; each depth counts the bindings it reached. */
+static kg_status_t run_lftj(const kg_triples_t *t, const kg_query_t *q, kg_query_plan_t *plan,
+                            size_t limit, kg_query_result_t *out) {
+    size_t nv = q->n_vars, np = q->n_patterns;
+    lftj_t L = { 0 };
+    rowset_t rows = { NULL, 0, 0, nv };
+    size_t *rank = (size_t*)malloc((nv ? nv : 1) * sizeof(size_t));
+    L.q = q; L.steps = plan->steps; L.out = &rows; L.limit = limit; L.truncated = &out->truncated; L.st = KG_OK;
+    L.its = (trie_it_t*)calloc(np, sizeof(trie_it_t));
+    L.var_order = (unsigned*)malloc((nv ? nv : 1) * sizeof(unsigned));
+    L.parts = (unsigned**)calloc(nv ? nv : 1, sizeof(unsigned*));
+    L.n_parts = (size_t*)calloc(nv ? nv : 1, sizeof(size_t));
+    L.work = (trie_it_t**)malloc((nv && np ? nv * np : 1) * sizeof(trie_it_t*));
+    L.val = (unsigned*)calloc(nv ? nv : 1, sizeof(unsigned));
+    kg_status_t st = KG_ERR_NOMEM;
+    if (!rank || !L.its || !L.var_order || !L.parts || !L.n_parts || !L.work || !L.val) goto out;
+    for (size_t d = 0; d < nv; ++d) L.var_order[d] = (unsigned)plan->steps[d].item;
+    for (size_t d = 0; d < nv; ++d) rank[L.var_order[d]] = d;
+    for (size_t d = 0; d < nv; ++d)
+        if (!(L.parts[d] = (unsigned*)malloc(np * sizeof(unsigned)))) goto out;
+
+    /* Each pattern: constants, then variables by rank -> its order; walk
+       down through the constants now */
+    st = KG_OK;
+    int empty = 0;
+    for (size_t i = 0; i < np && !empty; ++i) {
+        const kg_term_t *p = q->pat[i].t;
+        unsigned char want[3];
+        int n = 0;
+        for (int k = 0; k < 3; ++k) if (!p[k].is_var) want[n++] = (unsigned char)k;
+        int nc = n;
+        for (int k = 0; k < 3; ++k) if (p[k].is_var) want[n++] = (unsigned char)k;
+        for (int x = nc + 1; x < 3; ++x)
+            for (int y = x; y > nc && rank[p[want[y]].id] < rank[p[want[y - 1]].id]; --y) {
+                unsigned char c = want[y]; want[y] = want[y - 1]; want[y - 1] = c;
+            }
+        int o = 0;
+        while (memcmp(PERM[o], want, 3) != 0) o++;
+        trie_it_t *it = &L.its[i];
+        it->a = t->t[o]; it->n = t->n; it->depth = -1;
+        for (int c = 0; c < nc && !empty; ++c) {
+            it_open(it);
+            if (it_at_end(it)) { empty = 1; break; }
+            it_seek(it, p[want[c]].id);
+            empty = it_at_end(it) || it_key(it) != p[want[c]].id;
+        }
+        for (int k = nc; k < 3; ++k) {
+            size_t d = rank[p[want[k]].id];
+            L.parts[d][L.n_parts[d]++] = (unsigned)i;
+        }
+    }
+    if (!empty) lftj_depth(&L, 0);
+    st = L.st;
+    if (st == KG_OK) {
+        out->n_rows = rows.n;
+        out->rows = rows.v;
+        rows.v = NULL;
+    }
+out:
+    if (L.parts) for (size_t d = 0; d < nv; ++d) free(L.parts[d]);
+    free(rows.v); free(rank); free(L.its); free(L.var_order); free(L.parts);
+    free(L.n_parts); free(L.work); free(L.val);
+    return st;
+}
+
+/*
+   [SECTION] Planning
+   - Estimates per pattern: the triples matching its constants are
+     counted exactly (one index range); each position bound by an earlier
+     pattern then divides by how many distinct values that position has
+     under the pattern's relation (kg_label_stats), i.e. uniform degrees.
+   - Pairwise: the order with the fewest estimated intermediate rows in
+     total, searched over all subsets up to KG_PLAN_EXHAUSTIVE patterns;
+     beyond that the pattern with the fewest rows goes next.
+   - LFTJ: next the variable with the fewest estimated bindings, each
+     bounded by the tightest pattern that mentions it.
+ */
+typedef struct plan_est {
+    double n;                    /* triples matching the pattern's constants */
+    double d[3];                 /* distinct values per position under its relation */
+} plan_est_t;
+
+static const char *const ORDER_NAMES[KG_ORDERS] = { "SPO", "POS", "OSP", "SOP", "PSO", "OPS" };
+
+static void estimate_patterns(const kg_triples_t *t, const kg_query_t *q, plan_est_t *e) {
+    size_t nl = kg_label_count(t->g);
+    double all_s = 0, all_o = 0;
+    kg_label_stats_t ls;
+    for (size_t i = 0; i < q->n_patterns; ++i)
+        if (q->pat[i].t[1].is_var) {
+            for (unsigned l = 0; l < nl; ++l)
+                if (kg_label_stats(t->g, l, &ls) == KG_OK) { all_s += ls.subjects; all_o += ls.objects; }
+            break;
+        }
+    if (all_s > t->n_entities) all_s = (double)t->n_entities;
+    if (all_o > t->n_entities) all_o = (double)t->n_entities;
+
+    for (size_t i = 0; i < q->n_patterns; ++i) {
+        const kg_pattern_t *p = &q->pat[i];
+        int bound[3];
+        for (int k = 0; k < 3; ++k) bound[k] = !p->t[k].is_var;
+        size_t nb;
+        int o = choose_order(bound, &nb);
+        e[i].n = (double)t->n;
+        if (nb) {
+            unsigned key[3];
+            for (size_t j = 0; j < nb; ++j) key[j] = p->t[PERM[o][j]].id;
+            size_t lo = gallop(t->t[o], t->n, 0, key, nb, 0);
+            e[i].n = (double)(gallop(t->t[o], t->n, lo, key, nb, 1) - lo);
+        }
+        if (!p->t[1].is_var && kg_label_stats(t->g, p->t[1].id, &ls) == KG_OK) {
+            e[i].d[0] = (double)ls.subjects; e[i].d[1] = 1; e[i].d[2] = (double)ls.objects;
+        } else {
+            e[i].d[0] = all_s; e[i].d[1] = (double)nl; e[i].d[2] = all_o;
+        }
+        for (int k = 0; k < 3; ++k) if (e[i].d[k] < 1) e[i].d[k] = 1;
+    }
+}
+
+/* Estimated matches of pattern i per partial answer, given the bound
+   variables (a variable repeated in the pattern counts as bound the
+   second time). */
+static double fanout(const kg_query_t *q, const plan_est_t *e, size_t i, const unsigned char *bound) {
+    const kg_term_t *p = q->pat[i].t;
+    double f = e[i].n;
+    for (int k = 0; k < 3; ++k) {
+        if (!p[k].is_var) continue;
+        int b = bound[p[k].id];
+        for (int j = 0; j < k; ++j) b |= p[j].is_var && p[j].id == p[k].id;
+        if (b) f /= e[i].d[k];
+    }
+    return f;
+}
+
+static void bind_pattern(const kg_query_t *q, size_t i, unsigned char *bound) {
+    for (int k = 0; k < 3; ++k)
+        if (q->pat[i].t[k].is_var) bound[q->pat[i].t[k].id] = 1;
+}
+
+/* Fills steps[].item with a pattern order (exhaustive or greedy). */
+static kg_status_t order_patterns(const kg_query_t *q, const plan_est_t *e, unsigned char *bound,
+                                  kg_plan_step_t *steps) {
+    size_t np = q->n_patterns;
+    if (np <= KG_PLAN_EXHAUSTIVE) {
+        size_t full = (size_t)1 << np;
+        double *cost = (double*)malloc(full * sizeof(double)), *card = (double*)malloc(full * sizeof(double));
+        unsigned char *last = (unsigned char*)malloc(full);
+        if (!cost || !card || !last) { free(cost); free(card); free(last); return KG_ERR_NOMEM; }
+        for (size_t m = 0; m < full; ++m) cost[m] = DBL_MAX;
+        cost[0] = 0; card[0] = 1;
+        for (size_t m = 0; m + 1 < full; ++m) {
+            if (cost[m] == DBL_MAX) continue;
+            memset(bound, 0, q->n_vars ? q->n_vars : 1);
+            for (size_t i = 0; i < np; ++i) if (m >> i & 1) bind_pattern(q, i, bound);
+            for (size_t i = 0; i < np; ++i) {
+                if (m >> i & 1) continue;
+                double c = card[m] * fanout(q, e, i, bound);
+                size_t nm = m | (size_t)1 << i;
+                if (cost[m] + c < cost[nm]) { cost[nm] = cost[m] + c; card[nm] = c; last[nm] = (unsigned char)i; }
+            }
+        }
+        for (size_t m = full - 1, k = np; k > 0; m ^= (size_t)1 << last[m]) steps[--k].item = last[m];
+        free(cost); free(card); free(last);
+        return KG_OK;
+    }
+    unsigned char *done = (unsigned char*)calloc(np, 1);
+    if (!done) return KG_ERR_NOMEM;
+    memset(bound, 0, q->n_vars ? q->n_vars : 1);
+    for (size_t step = 0; step < np; ++step) {
+        size_t best = np;
+        double best_f = DBL_MAX;
+        for (size_t i = 0; i < np; ++i) {
+            if (done[i]) continue;
+            double f = fanout(q, e, i, bound);
+            if (best == np || f < best_f) { best = i; best_f = f; }
+        }
+        steps[step].item = best;
+        done[best] = 1;
+        bind_pattern(q, best, bound);
+    }
+    free(done);
+    return KG_OK;
+}
+
+static void order_vars(const kg_query_t *q, const plan_est_t *e, unsigned char *bound, kg_plan_step_t *steps) {
+    double rows = 1;
+    memset(bound, 0, q->n_vars);
+    for (size_t d = 0; d < q->n_vars; ++d) {
+        size_t best = q->n_vars;
+        double best_est = DBL_MAX;
+        for (size_t v = 0; v < q->n_vars; ++v) {
+            if (bound[v]) continue;
+            /* Values each pattern allows (x of its d), intersected as if
+               independent: the tightest x times every other x / d */
+            double x_min = DBL_MAX, d_min = 1, share = 1;
+            for (size_t i = 0; i < q->n_patterns; ++i)
+                for (int k = 0; k < 3; ++k) {
+                    if (!q->pat[i].t[k].is_var || q->pat[i].t[k].id != v) continue;
+                    double x = fanout(q, e, i, bound);
+                    if (x > e[i].d[k]) x = e[i].d[k];
+                    if (x < x_min) { x_min = x; d_min = e[i].d[k]; }
+                    share *= x / e[i].d[k];
+                    break;
+                }
+            double est = share * d_min;
+            if (best == q->n_vars || est < best_est) { best = v; best_est = est; }
+        }
+        rows *= best_est;
+        steps[d].item = best;
+        steps[d].order = -1;
+        steps[d].est_rows = rows;
+        bound[best] = 1;
+    }
+}
+
+static int repeats_var(const kg_query_t *q) {
+    for (size_t i = 0; i < q->n_patterns; ++i) {
+        const kg_term_t *p = q->pat[i].t;
+        for (int x = 0; x < 3; ++x)
+            for (int y = x + 1; y < 3; ++y)
+                if (p[x].is_var && p[y].is_var && p[x].id == p[y].id) return 1;
+    }
+    return 0;
+}
+
+void kg_query_plan_free(kg_query_plan_t *p) {
+    free(p->steps);
+    p->steps = NULL; p->n_steps = 0;
+}
+
+kg_status_t kg_query_plan(const kg_triples_t *t, const kg_query_t *q, int lftj, kg_query_plan_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->lftj = lftj && !repeats_var(q);
+    out->n_steps = out->lftj ? q->n_vars : q->n_patterns;
+    out->steps = (kg_plan_step_t*)calloc(out->n_steps ? out->n_steps : 1, sizeof(kg_plan_step_t));
+    plan_est_t *e = (plan_est_t*)malloc((q->n_patterns ? q->n_patterns : 1) * sizeof(plan_est_t));
+    unsigned char *bound = (unsigned char*)calloc(q->n_vars ? q->n_vars : 1, 1);
+    kg_status_t st = KG_ERR_NOMEM;
+    if (!out->steps || !e || !bound) goto out;
+    estimate_patterns(t, q, e);
+
+    if (out->lftj) {
+        order_vars(q, e, bound, out->steps);
+    } else {
+        st = order_patterns(q, e, bound, out->steps);
+        if (st != KG_OK) goto out;
+        double rows = 1;
+        memset(bound, 0, q->n_vars ? q->n_vars : 1);
+        for (size_t step = 0; step < out->n_steps; ++step) {
+            size_t i = out->steps[step].item;
+            int b[3];
+            for (int k = 0; k < 3; ++k) b[k] = !q->pat[i].t[k].is_var || bound[q->pat[i].t[k].id];
+            size_t nb;
+            out->steps[step].order = choose_order(b, &nb);
+            rows *= fanout(q, e, i, bound);
+            out->steps[step].est_rows = rows;
+            bind_pattern(q, i, bound);
+        }
+    }
+    for (size_t step = 0; step < out->n_steps; ++step) out->est_cost += out->steps[step].est_rows;
+    st = KG_OK;
+out:
+    free(e); free(bound);
+    if (st != KG_OK) kg_query_plan_free(out);
+    return st;
+}
+
+kg_status_t kg_query_explain(const kg_triples_t *t, const kg_query_t *q, int lftj, size_t limit,
+                             kg_query_plan_t *plan, kg_query_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->n_vars = q->n_vars;
+    if (plan) memset(plan, 0, sizeof(*plan));
+    if (lftj)
+        for (int o = 0; o < KG_ORDERS; ++o)
+            if (!t->t[o]) return KG_ERR_INVALID;
+    kg_query_plan_t p;
+    kg_status_t st = kg_query_plan(t, q, lftj, &p);
+    if (st != KG_OK) return st;
+    st = p.lftj ? run_lftj(t, q, &p, limit, out) : run_pairwise(t, q, &p, limit, out);
+    p.truncated = out->truncated;
+    if (plan && st == KG_OK) *plan = p;
+    else kg_query_plan_free(&p);
+    return st;
+}
+
+kg_status_t kg_query_run(const kg_triples_t *t, const kg_query_t *q, size_t limit,
+                         kg_query_result_t *out) {
+    return kg_query_explain(t, q, 0, limit, NULL, out);
+}
+
+kg_status_t kg_query_run_lftj(const kg_triples_t *t, const kg_query_t *q, size_t limit,
+                              kg_query_result_t *out) {
+    return kg_query_explain(t, q, 1, limit, NULL, out);
+}
+
+static void term_text(const kg_graph_t *g, const kg_query_t *q, const kg_term_t *term, int pos,
+                      char *buf, size_t len) {
+    if (term->is_var) { snprintf(buf, len, "?%s", q->vars[term->id]); return; }
+    const char *s = pos == 1 ? kg_label_name(g, term->id) : kg_entity_at(g, term->id)->name;
+    const char *quote = strchr(s, ' ') ? "\"" : "";
+    snprintf(buf, len, "%s%s%s", quote, s, quote);
+}
+
+void kg_query_plan_print(const kg_graph_t *g, const kg_query_t *q, const kg_query_plan_t *p, FILE *fp) {
+    char a[KG_NAME_LEN + 3], b[KG_REL_LEN + 3], c[KG_NAME_LEN + 3], text[3 * (KG_NAME_LEN + 4)];
+    if (p->lftj) {
+        fprintf(fp, "plan: leapfrog triejoin, %zu variables (est cost %.0f)\n", p->n_steps, p->est_cost);
+        fprintf(fp, "%4s  %-24s %14s %12s\n", "step", "variable", "est bindings", "actual");
+    } else {
+        fprintf(fp, "plan: pairwise joins, %zu patterns (est cost %.0f)\n", p->n_steps, p->est_cost);
+        fprintf(fp, "%4s  %-40s %5s %14s %12s\n", "step", "pattern", "index", "est rows", "actual");
+    }
+    for (size_t k = 0; k < p->n_steps; ++k) {
+        const kg_plan_step_t *s = &p->steps[k];
+        if (p->lftj) {
+            snprintf(text, sizeof(text), "?%s", q->vars[s->item]);
+            fprintf(fp, "%4zu  %-24s %14.0f %12zu\n", k + 1, text, s->est_rows, s->rows);
+            continue;
+        }
+        const kg_term_t *t = q->pat[s->item].t;
+        term_text(g, q, &t[0], 0, a, sizeof(a));
+        term_text(g, q, &t[1], 1, b, sizeof(b));
+        term_text(g, q, &t[2], 2, c, sizeof(c));
+        snprintf(text, sizeof(text), "%s %s %s", a, b, c);
+        fprintf(fp, "%4zu  %-40s %5s %14.0f %12zu\n", k + 1, text, ORDER_NAMES[s->order], s->est_rows, s->rows);
+    }
+    if (p->truncated) fprintf(fp, "(stopped at the row limit: actual counts are partial)\n");
+}
+
+/* Union-find over variables: a pattern joining two already-connected
+   variables closes a cycle. */
+static unsigned uf_find(unsigned *up, unsigned x) {
+    while (up[x] != x) x = up[x] = up[up[x]];
+    return x;
+}
+
+int kg_query_is_cyclic(const kg_query_t *q) {
+    unsigned *up = (unsigned*)malloc((q->n_vars ? q->n_vars : 1) * sizeof(unsigned));
+    if (!up) return 0;
+    for (size_t v = 0; v < q->n_vars; ++v) up[v] = (unsigned)v;
+    int cyclic = 0;
+    for (size_t i = 0; i < q->n_patterns && !cyclic; ++i) {
+        unsigned first = NO_VAR;
+        for (int k = 0; k < 3 && !cyclic; ++k) {
+            const kg_term_t *term = &q->pat[i].t[k];
+            if (!term->is_var) continue;
+            if (first == NO_VAR) { first = term->id; continue; }
+            if (term->id == first) continue;
+            unsigned a = uf_find(up, first), b = uf_find(up, term->id);
+            if (a == b) cyclic = 1; else up[a] = b;
+        }
+    }
+    free(up);
+    return cyclic;
+}
@@ -0,0 +1,166 @@
+/* =========================================================================
+   Knowledge Graph Engine — Triple-Pattern Queries
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Conjunctive queries over (subject, relation, object) triples:
+         ?x Requires Python . ?x "Subset of" ?y
+     Terms are ?variables, bare words or "quoted names"; a lone "." ends a
+     pattern. Any position may be a variable, the relation included.
+->   Indexes:
+     A snapshot's edges as interned id triples, deduplicated and sorted in
+     three orders: SPO, POS and OSP. Every set of one or two bound
+     positions is a prefix of exactly one of them (S, P, O, SP, PO, OS), so
+     each pattern reads one contiguous range.
+->   Execution:
+     Patterns run one after another, in the order a cost-based planner
+     picks from per-relation statistics (kg_label_stats). Before each
+     join the partial answers are sorted on the pattern's bound positions
+     in the chosen index's order, and one cursor gallops forward through
+     the index: a sort-merge join in index order, with no per-answer
+     search from the start.
+     Cyclic patterns (triangles, "A requires B, B requires C, A requires
+     C") blow up under pairwise joins: every intermediate answer of the
+     first two patterns is built before the third prunes it. For those,
+     kg_query_run_lftj() runs Leapfrog Triejoin: one variable at a time,
+     intersecting all patterns that mention it by leapfrogging sorted
+     iterators, which is worst-case optimal (never more work than the
+     largest possible output, up to a log factor). It walks each pattern's
+     triples as a trie with its variables in one global order, so it needs
+     all six index orders (KG_TRIPLES_ALL_ORDERS).
+->   Build:
+     add kg_query.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_QUERY_H
+#define KG_QUERY_H
+
+#include <stdio.h>
+
+#include "kg_graph.h"
+
+/* Component order of each permutation: SPO = (s,p,o), POS = (p,o,s), ...
+   The first three are always built; the rest only for Leapfrog Triejoin. */
+typedef enum kg_triple_order {
+    KG_SPO = 0,
+    KG_POS,
+    KG_OSP,
+    KG_SOP,
+    KG_PSO,
+    KG_OPS,
+    KG_ORDERS
+} kg_triple_order_t;
+
+#define KG_TRIPLES_ALL_ORDERS 1
+
+typedef struct kg_triples {
+    const kg_graph_t *g;
+    unsigned long version;       /* snapshot the index was built from */
+    size_t n_entities, n_labels; /* ids below these */
+    size_t n;                    /* distinct triples */
+    unsigned *t[KG_ORDERS];      /* 3 * n ids each, in the order's components; NULL if not built */
+} kg_triples_t;
+
+/* flags: 0 or KG_TRIPLES_ALL_ORDERS (twice the memory). */
+kg_status_t kg_triples_build(const kg_snapshot_t *s, int flags, kg_triples_t **out);
+void kg_triples_free(kg_triples_t *t);
+size_t kg_triples_bytes(const kg_triples_t *t);
+
+static inline int kg_triples_is_current(const kg_triples_t *t) {
+    return t->version == kg_graph_version(t->g);
+}
+
+/* [SECTION] Queries */
+
+typedef struct kg_term {
+    int is_var;
+    unsigned id;                 /* variable index, or entity / label id */
+} kg_term_t;
+
+typedef struct kg_pattern {
+    kg_term_t t[3];              /* subject, relation, object */
+} kg_pattern_t;
+
+typedef struct kg_query {
+    size_t n_patterns;
+    kg_pattern_t *pat;
+    size_t n_vars;
+    char **vars;                 /* names without the '?' */
+    unsigned char *var_is_label; /* used in relation position */
+} kg_query_t;
+
+/* Constants are resolved against g. On failure err (if not NULL) gets a
+   one-line reason: KG_ERR_INVALID for syntax, KG_ERR_NOT_FOUND for an
+   unknown entity or relation. */
+kg_status_t kg_query_parse(const kg_graph_t *g, const char *text, kg_query_t **out,
+                           char *err, size_t err_len);
+void kg_query_free(kg_query_t *q);
+
+typedef struct kg_query_result {
+    size_t n_vars;
+    size_t n_rows;
+    unsigned *rows;              /* n_rows * n_vars ids, columns as in q->vars */
+    int truncated;               /* stopped at the limit */
+} kg_query_result_t;
+
+/* All answers, or the first `limit` found (0 = no limit). */
+kg_status_t kg_query_run(const kg_triples_t *t, const kg_query_t *q, size_t limit,
+                         kg_query_result_t *out);
+void kg_query_result_free(kg_query_result_t *r);
+
+/* Same answers (in another order) by Leapfrog Triejoin. Needs an index
+   built with KG_TRIPLES_ALL_ORDERS (KG_ERR_INVALID otherwise); a pattern
+   that repeats a variable (?x rel ?x) is left to kg_query_run(). */
+kg_status_t kg_query_run_lftj(const kg_triples_t *t, const kg_query_t *q, size_t limit,
+                              kg_query_result_t *out);
+
+/*
+   [SECTION] Planning & EXPLAIN
+   - Pairwise: the pattern order with the fewest estimated intermediate
+     rows; every order is costed up to KG_PLAN_EXHAUSTIVE patterns, longer
+     queries are ordered greedily.
+   - LFTJ: the variable order, fewest estimated bindings first.
+   - Estimates count the constants of each pattern exactly in the index
+     and assume uniform degrees for the rest (distinct subjects / objects
+     per relation).
+ */
+#define KG_PLAN_EXHAUSTIVE 12
+
+typedef struct kg_plan_step {
+    size_t item;                 /* pattern index; variable index under LFTJ */
+    int order;                   /* kg_triple_order_t read (-1 under LFTJ) */
+    double est_rows;             /* estimated partial answers after this step */
+    size_t rows;                 /* actual, once run */
+} kg_plan_step_t;
+
+typedef struct kg_query_plan {
+    int lftj;                    /* steps bind variables, not patterns */
+    size_t n_steps;
+    kg_plan_step_t *steps;
+    double est_cost;             /* sum of est_rows */
+    int truncated;               /* the run stopped at its limit: rows partial */
+} kg_query_plan_t;
+
+/* Plan without running it (lftj is ignored when a pattern repeats a variable). */
+kg_status_t kg_query_plan(const kg_triples_t *t, const kg_query_t *q, int lftj, kg_query_plan_t *out);
+void kg_query_plan_free(kg_query_plan_t *p);
+
+/* Plans and runs; when plan is not NULL it receives the plan with actual
+   row counts (free with kg_query_plan_free). kg_query_run() and
+   kg_query_run_lftj() are this with lftj 0 / 1 and no plan. */
+kg_status_t kg_query_explain(const kg_triples_t *t, const kg_query_t *q, int lftj, size_t limit,
+                             kg_query_plan_t *plan, kg_query_result_t *out);
+/* Step table: estimated vs actual rows. */
+void kg_query_plan_print(const kg_graph_t *g, const kg_query_t *q, const kg_query_plan_t *p, FILE *fp);
+
+/* Whether the patterns' variables form a cycle (two patterns sharing two
+   variables count): the case where kg_query_run_lftj() pays off. */
+int kg_query_is_cyclic(const kg_query_t *q);
+
+/* Entity name or relation label of one cell. */
+static inline const char *kg_query_value(const kg_graph_t *g, const kg_query_t *q,
+                                         const kg_query_result_t *r, size_t row, size_t col) {
+    unsigned id = r->rows[row * r->n_vars + col];
+    return q->var_is_label[col] ? kg_label_name(g, id) : kg_entity_at(g, id)->name;
+}
+
+#endif /* KG_QUERY_H */
@@ -0,0 +1,377 @@
+/* =========================================================================
+   Knowledge Graph Engine — Importance Ranking (implementation)
+   ========================================================================= */
+#define _POSIX_C_SOURCE 200809L      /* pthread_barrier_t, sysconf under -std=c11 */
+#include "kg_rank.h"
+#include "kg_csr.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RANK_MAX_THREADS 64
+#define RANK_MIN_WORK    65536       /* entities + edges per thread */
+
+void kg_rank_defaults(kg_rank_opts_t *o) {
+    o->damping = 0.85;
+    o->tolerance = 1e-9;
+    o->max_iter = 100;
+    o->threads = 0;
+    o->precision = KG_RANK_DOUBLE;
+    o->f = NULL;
+    o->seeds = NULL;
+    o->n_seeds = 0;
+}
+
+void kg_rank_free(kg_rank_t *r) {
+    if (!r) return;
+    free(r->score);
+    free(r);
+}
+
+/*
+   [SECTION] Reverse Index
+   - In-edges of every entity from the forward CSR, filtered once, plus
+     1 / out-degree per entity (0 for one without allowed relations).
+ */
+typedef struct rank_graph {
+    size_t n, m;
+    size_t *in_row;              /* n + 1 offsets into in_src */
+    unsigned *in_src;
+    double *inv_deg;
+} rank_graph_t;
+
+static void rank_graph_free(rank_graph_t *G) {
+    free(G->in_row); free(G->in_src); free(G->inv_deg);
+}
+
+static kg_status_t rank_graph_build(const kg_snapshot_t *s, const kg_label_filter_t *f, rank_graph_t *G) {
+    memset(G, 0, sizeof(*G));
+    kg_csr_t *c;
+    kg_status_t st = kg_csr_build(s, 0, &c);
+    if (st != KG_OK) return st;
+    size_t n = c->n;
+    G->n = n;
+    G->in_row = (size_t*)calloc(n + 1, sizeof(size_t));
+    G->inv_deg = (double*)malloc((n ? n : 1) * sizeof(double));
+    size_t *pos = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    if (!G->in_row || !G->inv_deg || !pos) goto nomem;
+
+    for (size_t u = 0; u < n; ++u) {
+        size_t deg = 0;
+        for (size_t k = c->row[u]; k < c->row[u + 1]; ++k)
+            if (!f || kg_label_allowed(f, c->lab[k])) { G->in_row[c->tgt[k] + 1]++; deg++; }
+        G->inv_deg[u] = deg ? 1.0 / (double)deg : 0.0;
+        G->m += deg;
+    }
+    for (size_t v = 0; v < n; ++v) G->in_row[v + 1] += G->in_row[v];
+    G->in_src = (unsigned*)malloc((G->m ? G->m : 1) * sizeof(unsigned));
+    if (!G->in_src) goto nomem;
+    memcpy(pos, G->in_row, n * sizeof(size_t));
+    for (size_t u = 0; u < n; ++u)
+        for (size_t k = c->row[u]; k < c->row[u + 1]; ++k)
+            if (!f || kg_label_allowed(f, c->lab[k])) G->in_src[pos[c->tgt[k]]++] = (unsigned)u;
+    free(pos);
+    kg_csr_free(c);
+    return KG_OK;
+nomem:
+    free(pos);
+    kg_csr_free(c);
+    rank_graph_free(G);
+    return KG_ERR_NOMEM;
+}
+
+/*
+   [SECTION] Power Iteration
+   - x holds the scores, cx each entity's share (score / out-degree) as
+     its in-neighbors will read it; an iteration writes y and cy, then
+     thread 0 swaps the pairs between two barriers.
+   - Worker threads wait at a gate until the caller knows how many it
+     could start; the ranges and the barrier are sized for those.
+ */
+typedef struct rank_part {
+    _Alignas(64) double dangling;    /* score of the range's entities without out-edges */
+    double residual;
+} rank_part_t;
+
+typedef struct rank_job {
+    const rank_graph_t *G;
+    const unsigned char *tele;   /* teleport set */
+    double tele_w;               /* 1 / its size */
+    double damping, tolerance;
+    unsigned max_iter;
+    kg_rank_precision_t precision;
+    void *x, *y, *cx, *cy;       /* double or float, per precision */
+    size_t lo[RANK_MAX_THREADS + 1];
+    rank_part_t part[RANK_MAX_THREADS];
+    unsigned threads;
+    pthread_barrier_t barrier;
+    pthread_mutex_t gate_lock;
+    pthread_cond_t gate;
+    int open;
+    double dangling;
+    unsigned iterations;
+    double residual;
+    int done;
+} rank_job_t;
+
+typedef struct rank_worker {
+    rank_job_t *J;
+    unsigned t;
+} rank_worker_t;
+
+static double absd(double d) { return d < 0 ? -d : d; }
+
+static void pull_double(rank_job_t *J, size_t lo, size_t hi, double base, rank_part_t *p) {
+    const rank_graph_t *G = J->G;
+    const double *x = (const double*)J->x, *cx = (const double*)J->cx;
+    double *y = (double*)J->y, *cy = (double*)J->cy;
+    double dangling = 0, residual = 0;
+    for (size_t v = lo; v < hi; ++v) {
+        double sum = 0;
+        for (size_t k = G->in_row[v]; k < G->in_row[v + 1]; ++k) sum += cx[G->in_src[k]];
+        double yv = J->damping * sum + (J->tele[v] ? base : 0.0);
+        y[v] = yv;
+        cy[v] = yv * G->inv_deg[v];
+        if (G->inv_deg[v] == 0.0) dangling += yv;
+        residual += absd(yv - x[v]);
+    }
+    p->dangling = dangling;
+    p->residual = residual;
+}
+
+static void pull_float(rank_job_t *J, size_t lo, size_t hi, double base, rank_part_t *p) {
+    const rank_graph_t *G = J->G;
+    const float *x = (const float*)J->x, *cx = (const float*)J->cx;
+    float *y = (float*)J->y, *cy = (float*)J->cy;
+    double dangling = 0, residual = 0;
+    for (size_t v = lo; v < hi; ++v) {
+        double sum = 0;
+        for (size_t k = G->in_row[v]; k < G->in_row[v + 1]; ++k) sum += cx[G->in_src[k]];
+        float yv = (float)(J->damping * sum + (J->tele[v] ? base : 0.0));
+        y[v] = yv;
+        cy[v] = (float)(yv * G->inv_deg[v]);
+        if (G->inv_deg[v] == 0.0) dangling += yv;
+        residual += absd((double)yv - (double)x[v]);
+    }
+    p->dangling = dangling;
+    p->residual = residual;
+}
+
+static void rank_sync(rank_job_t *J) {
+    if (J->threads > 1) pthread_barrier_wait(&J->barrier);
+}
+
+static void *rank_worker(void *arg) {
+    rank_worker_t *W = (rank_worker_t*)arg;
+    rank_job_t *J = W->J;
+    unsigned t = W->t;
+    pthread_mutex_lock(&J->gate_lock);
+    while (!J->open) pthread_cond_wait(&J->gate, &J->gate_lock);
+    pthread_mutex_unlock(&J->gate_lock);
+    if (t >= J->threads) return NULL;
+
+    for (;;) {
+        /* teleport plus what entities without out-edges hand back */
+        double base = J->tele_w * ((1.0 - J->damping) + J->damping * J->dangling);
+        if (J->precision == KG_RANK_FLOAT) pull_float(J, J->lo[t], J->lo[t + 1], base, &J->part[t]);
+        else pull_double(J, J->lo[t], J->lo[t + 1], base, &J->part[t]);
+        rank_sync(J);
+        if (t == 0) {
+            double dangling = 0, residual = 0;
+            for (unsigned i = 0; i < J->threads; ++i) {
+                dangling += J->part[i].dangling;
+                residual += J->part[i].residual;
+            }
+            void *p = J->x; J->x = J->y; J->y = p;
+            p = J->cx; J->cx = J->cy; J->cy = p;
+            J->dangling = dangling;
+            J->residual = residual;
+            J->iterations++;
+            J->done = residual < J->tolerance || J->iterations >= J->max_iter;
+        }
+        rank_sync(J);
+        if (J->done) return NULL;
+    }
+}
+
+/* Ranges of about equal entities + in-edges. */
+static void split_ranges(rank_job_t *J) {
+    const rank_graph_t *G = J->G;
+    size_t total = G->n + G->m;
+    J->lo[0] = 0;
+    for (unsigned t = 1; t < J->threads; ++t) {
+        size_t want = total / J->threads * t, a = J->lo[t - 1], b = G->n;
+        while (a < b) {
+            size_t mid = a + (b - a) / 2;
+            if (G->in_row[mid] + mid < want) a = mid + 1; else b = mid;
+        }
+        J->lo[t] = a;
+    }
+    J->lo[J->threads] = G->n;
+}
+
+static unsigned pick_threads(const kg_rank_opts_t *o, const rank_graph_t *G) {
+    long cpus = o->threads ? (long)o->threads : sysconf(_SC_NPROCESSORS_ONLN);
+    size_t by_size = (G->n + G->m) / RANK_MIN_WORK + 1;
+    if (cpus < 1) cpus = 1;
+    if ((size_t)cpus > by_size) cpus = (long)by_size;
+    return cpus > RANK_MAX_THREADS ? RANK_MAX_THREADS : (unsigned)cpus;
+}
+
+static void run_job(rank_job_t *J, unsigned want) {
+    pthread_t th[RANK_MAX_THREADS];
+    rank_worker_t W[RANK_MAX_THREADS];
+    unsigned started = 1;
+    pthread_mutex_init(&J->gate_lock, NULL);
+    pthread_cond_init(&J->gate, NULL);
+    for (unsigned t = 0; t < want; ++t) { W[t].J = J; W[t].t = t; }
+    for (unsigned t = 1; t < want; ++t, ++started)
+        if (pthread_create(&th[t], NULL, rank_worker, &W[t]) != 0) break;
+    J->threads = started;
+    if (started > 1 && pthread_barrier_init(&J->barrier, NULL, started) != 0) J->threads = 1;
+    split_ranges(J);
+
+    pthread_mutex_lock(&J->gate_lock);
+    J->open = 1;
+    pthread_cond_broadcast(&J->gate);
+    pthread_mutex_unlock(&J->gate_lock);
+    rank_worker(&W[0]);
+    for (unsigned t = 1; t < started; ++t) pthread_join(th[t], NULL);
+    if (J->threads > 1) pthread_barrier_destroy(&J->barrier);
+    pthread_cond_destroy(&J->gate);
+    pthread_mutex_destroy(&J->gate_lock);
+}
+
+kg_status_t kg_pagerank(const kg_snapshot_t *s, const kg_rank_opts_t *o, kg_rank_t **out) {
+    *out = NULL;
+    if (!(o->damping >= 0.0 && o->damping < 1.0)) return KG_ERR_INVALID;
+    size_t n = s->n_entities;
+    for (size_t i = 0; i < o->n_seeds; ++i)
+        if (o->seeds[i] >= n || !kg_visible(s, kg_entity_at(s->g, o->seeds[i]))) return KG_ERR_NOT_FOUND;
+
+    rank_graph_t G;
+    kg_status_t st = rank_graph_build(s, o->f, &G);
+    if (st != KG_OK) return st;
+    kg_rank_t *r = (kg_rank_t*)calloc(1, sizeof(kg_rank_t));
+    size_t job_bytes = (sizeof(rank_job_t) + 63) / 64 * 64;     /* partial sums on their own lines */
+    rank_job_t *J = (rank_job_t*)aligned_alloc(64, job_bytes);
+    if (J) memset(J, 0, sizeof(*J));
+    unsigned char *tele = (unsigned char*)calloc(n ? n : 1, 1);
+    size_t width = o->precision == KG_RANK_FLOAT ? sizeof(float) : sizeof(double);
+    char *vec = (char*)malloc((n ? n : 1) * 4 * width);
+    if (r) r->score = (double*)malloc((n ? n : 1) * sizeof(double));
+    if (!r || !J || !tele || !vec || !r->score) {
+        free(J); free(tele); free(vec); kg_rank_free(r); rank_graph_free(&G);
+        return KG_ERR_NOMEM;
+    }
+
+    size_t members = 0;
+    if (o->n_seeds) {
+        for (size_t i = 0; i < o->n_seeds; ++i) {
+            members += !tele[o->seeds[i]];
+            tele[o->seeds[i]] = 1;
+        }
+    } else {
+        for (size_t v = 0; v < n; ++v) {
+            tele[v] = (unsigned char)kg_visible(s, kg_entity_at(s->g, v));
+            members += tele[v];
+        }
+    }
+    J->G = &G;
+    J->tele = tele;
+    J->tele_w = members ? 1.0 / (double)members : 0.0;
+    J->damping = o->damping;
+    J->tolerance = o->tolerance;
+    J->max_iter = o->max_iter;
+    J->precision = o->precision;
+    J->x = vec; J->y = vec + n * width; J->cx = vec + 2 * n * width; J->cy = vec + 3 * n * width;
+
+    /* Start from the teleport distribution */
+    for (size_t v = 0; v < n; ++v) {
+        double x0 = tele[v] ? J->tele_w : 0.0;
+        if (o->precision == KG_RANK_FLOAT) {
+            ((float*)J->x)[v] = (float)x0;
+            ((float*)J->cx)[v] = (float)(x0 * G.inv_deg[v]);
+        } else {
+            ((double*)J->x)[v] = x0;
+            ((double*)J->cx)[v] = x0 * G.inv_deg[v];
+        }
+        if (G.inv_deg[v] == 0.0) J->dangling += x0;
+    }
+    J->threads = 1;
+    if (n && o->max_iter) run_job(J, pick_threads(o, &G));
+
+    for (size_t v = 0; v < n; ++v)
+        r->score[v] = o->precision == KG_RANK_FLOAT ? (double)((float*)J->x)[v] : ((double*)J->x)[v];
+    r->g = s->g;
+    r->version = s->version;
+    r->n = n;
+    r->iterations = J->iterations;
+    r->residual = J->residual;
+    r->converged = J->iterations > 0 && J->residual < o->tolerance;
+    r->threads = J->threads;
+    free(J); free(tele); free(vec);
+    rank_graph_free(&G);
+    *out = r;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Top k
+   - A min-heap of the k best so far (root = worst of them), O(n log k),
+     emptied from the back so the best comes first.
+ */
+static int worse(const double *score, unsigned a, unsigned b) {
+    return score[a] < score[b] || (score[a] == score[b] && a > b);
+}
+
+static void sift_down(const double *score, unsigned *h, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, w = i;
+        if (l < n && worse(score, h[l], h[w])) w = l;
+        if (l + 1 < n && worse(score, h[l + 1], h[w])) w = l + 1;
+        if (w == i) return;
+        unsigned t = h[i]; h[i] = h[w]; h[w] = t;
+        i = w;
+    }
+}
+
+kg_status_t kg_top_scores(const double *score, size_t n_scores, size_t k, const unsigned *skip, size_t n_skip,
+                          unsigned **ids, size_t *n) {
+    *ids = NULL; *n = 0;
+    if (k > n_scores) k = n_scores;
+    if (!k) return KG_OK;
+    unsigned *h = (unsigned*)malloc(k * sizeof(unsigned));
+    unsigned char *skipped = n_skip ? (unsigned char*)calloc(n_scores, 1) : NULL;
+    if (!h || (n_skip && !skipped)) { free(h); free(skipped); return KG_ERR_NOMEM; }
+    for (size_t i = 0; i < n_skip; ++i)
+        if (skip[i] < n_scores) skipped[skip[i]] = 1;
+
+    size_t len = 0;
+    for (size_t v = 0; v < n_scores; ++v) {
+        if ((skipped && skipped[v]) || score[v] <= 0.0) continue;
+        if (len < k) {
+            h[len++] = (unsigned)v;
+            for (size_t i = len - 1; i > 0 && worse(score, h[i], h[(i - 1) / 2]); i = (i - 1) / 2) {
+                unsigned t = h[i]; h[i] = h[(i - 1) / 2]; h[(i - 1) / 2] = t;
+            }
+        } else if (worse(score, h[0], (unsigned)v)) {
+            h[0] = (unsigned)v;
+            sift_down(score, h, len, 0);
+        }
+    }
+    free(skipped);
+    for (size_t end = len; end > 1; --end) {
+        unsigned t = h[0]; h[0] = h[end - 1]; h[end - 1] = t;
+        sift_down(score, h, end - 1, 0);
+    }
+    if (!len) { free(h); return KG_OK; }
+    *ids = h; *n = len;
+    return KG_OK;
+}
+
+kg_status_t kg_rank_top(const kg_rank_t *r, size_t k, const unsigned *skip, size_t n_skip,
+                        unsigned **ids, size_t *n) {
+    return kg_top_scores(r->score, r->n, k, skip, n_skip, ids, n);
+}
@@ -0,0 +1,173 @@
+/* =========================================================================
+   Knowledge Graph Engine — Reachability Index (implementation)
+   ========================================================================= */
+
+#include "kg_reach.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define UNSEEN ((unsigned)-1)
+
+void kg_reach_free(kg_reach_t *r) {
+    if (!r) return;
+    kg_scc_free(r->scc);
+    free(r->lo); free(r->post);
+    free(r);
+}
+
+size_t kg_reach_bytes(const kg_reach_t *r) {
+    return sizeof(*r) + kg_scc_bytes(r->scc) + 2 * r->scc->n_comps * r->d * sizeof(unsigned);
+}
+
+/*
+   [SECTION] Interval Labels (GRAIL)
+   - Labeling j: DFS from the DAG's roots in a random order, children in a
+     random rotation, post-order rank post[c]; lo[c] is the smallest rank
+     in c's subtree including already-labeled descendants, so
+     reach(u, v) => lo[u] <= lo[v] && post[v] <= post[u].
+ */
+static unsigned long rng_next(unsigned long *s) {
+    *s ^= *s << 13; *s ^= *s >> 7; *s ^= *s << 17;
+    return *s;
+}
+
+static kg_status_t label(kg_reach_t *r, unsigned j, unsigned long *seed) {
+    const kg_scc_t *c = r->scc;
+    size_t nc = c->n_comps;
+    unsigned d = r->d;
+    unsigned *indeg = (unsigned*)calloc(nc ? nc : 1, sizeof(unsigned));
+    unsigned *roots = (unsigned*)malloc((nc ? nc : 1) * sizeof(unsigned));
+    unsigned *call = (unsigned*)malloc((nc ? nc : 1) * sizeof(unsigned));
+    size_t *left = (size_t*)malloc((nc ? nc : 1) * sizeof(size_t));   /* children still to visit */
+    size_t *rot = (size_t*)malloc((nc ? nc : 1) * sizeof(size_t));    /* rotation offset */
+    if (!indeg || !roots || !call || !left || !rot) {
+        free(indeg); free(roots); free(call); free(left); free(rot);
+        return KG_ERR_NOMEM;
+    }
+    for (size_t e = 0; e < c->dag_row[nc]; ++e) indeg[c->dag[e]]++;
+    size_t n_roots = 0;
+    for (size_t cu = 0; cu < nc; ++cu) if (!indeg[cu]) roots[n_roots++] = (unsigned)cu;
+    for (size_t i = n_roots; i > 1; --i) {
+        size_t k = rng_next(seed) % i;
+        unsigned t = roots[i - 1]; roots[i - 1] = roots[k]; roots[k] = t;
+    }
+    for (size_t cu = 0; cu < nc; ++cu) r->post[cu * d + j] = UNSEEN;
+
+    unsigned rank = 0;
+    for (size_t ri = 0; ri < n_roots; ++ri) {
+        size_t cp = 0;
+        unsigned root = roots[ri];
+        call[cp++] = root;
+        left[root] = c->dag_row[root + 1] - c->dag_row[root];
+        rot[root] = left[root] ? rng_next(seed) % left[root] : 0;
+        while (cp) {
+            unsigned u = call[cp - 1];
+            size_t deg = c->dag_row[u + 1] - c->dag_row[u];
+            if (left[u]) {
+                /* Acyclic: an unlabeled child is never on the current path */
+                left[u]--;
+                unsigned w = c->dag[c->dag_row[u] + (rot[u] + left[u]) % deg];
+                if (r->post[w * d + j] == UNSEEN) {
+                    call[cp++] = w;
+                    left[w] = c->dag_row[w + 1] - c->dag_row[w];
+                    rot[w] = left[w] ? rng_next(seed) % left[w] : 0;
+                }
+                continue;
+            }
+            /* All children labeled: lo = min(own rank, children's lo) */
+            unsigned lo = rank;
+            for (size_t e = c->dag_row[u]; e < c->dag_row[u + 1]; ++e) {
+                unsigned cl = r->lo[c->dag[e] * d + j];
+                if (cl < lo) lo = cl;
+            }
+            r->lo[u * d + j] = lo;
+            r->post[u * d + j] = rank++;
+            cp--;
+        }
+    }
+    free(indeg); free(roots); free(call); free(left); free(rot);
+    return KG_OK;
+}
+
+/* [SECTION] Build */
+
+kg_status_t kg_reach_build(const kg_snapshot_t *s, unsigned d, unsigned long seed, kg_reach_t **out) {
+    *out = NULL;
+    if (d == 0) d = KG_REACH_DEFAULT_LABELINGS;
+    if (d > KG_REACH_MAX_LABELINGS) return KG_ERR_INVALID;
+
+    kg_reach_t *r = (kg_reach_t*)calloc(1, sizeof(kg_reach_t));
+    if (!r) return KG_ERR_NOMEM;
+    r->g = s->g;
+    r->version = s->version;
+    r->d = d;
+    kg_status_t st = kg_scc_build(s, NULL, &r->scc);
+    if (st == KG_OK) {
+        size_t nc = r->scc->n_comps;
+        r->lo = (unsigned*)malloc((nc ? nc : 1) * d * sizeof(unsigned));
+        r->post = (unsigned*)malloc((nc ? nc : 1) * d * sizeof(unsigned));
+        if (!r->lo || !r->post) st = KG_ERR_NOMEM;
+    }
+    unsigned long rs = seed ? seed : 0x2545f4914f6cdd1dul;
+    for (unsigned j = 0; st == KG_OK && j < d; ++j) st = label(r, j, &rs);
+    if (st != KG_OK) { kg_reach_free(r); return st; }
+    *out = r;
+    return KG_OK;
+}
+
+/* [SECTION] Queries */
+
+static inline int nests(const kg_reach_t *r, unsigned cu, unsigned cv) {
+    const unsigned *lu = r->lo + (size_t)cu * r->d, *pu = r->post + (size_t)cu * r->d;
+    const unsigned *lv = r->lo + (size_t)cv * r->d, *pv = r->post + (size_t)cv * r->d;
+    for (unsigned j = 0; j < r->d; ++j)
+        if (lv[j] < lu[j] || pv[j] > pu[j]) return 0;
+    return 1;
+}
+
+#define STAT(r, f) atomic_fetch_add_explicit(&((kg_reach_t*)(r))->stats.f, 1, memory_order_relaxed)
+
+/* Pruned DFS over the DAG; visited marks are per call (calloc hands back
+   untouched zero pages, so only the part visited costs anything). */
+static kg_reach_answer_t search(const kg_reach_t *r, unsigned cu, unsigned cv) {
+    const kg_scc_t *c = r->scc;
+    unsigned char *seen = (unsigned char*)calloc(c->n_comps, 1);
+    unsigned *stack = (unsigned*)malloc(c->n_comps * sizeof(unsigned));
+    if (!seen || !stack) { free(seen); free(stack); return KG_REACH_UNKNOWN; }
+    size_t sp = 0;
+    unsigned long visits = 0;
+    kg_reach_answer_t ans = KG_REACH_NO;
+    stack[sp++] = cu; seen[cu] = 1;
+    while (sp && ans == KG_REACH_NO) {
+        unsigned x = stack[--sp];
+        visits++;
+        for (size_t e = c->dag_row[x]; e < c->dag_row[x + 1]; ++e) {
+            unsigned w = c->dag[e];
+            if (w == cv) { ans = KG_REACH_YES; break; }
+            if (seen[w] || w < cv || !nests(r, w, cv)) continue;
+            seen[w] = 1;
+            stack[sp++] = w;
+        }
+    }
+    atomic_fetch_add_explicit(&((kg_reach_t*)r)->stats.search_visits, visits, memory_order_relaxed);
+    free(seen); free(stack);
+    return ans;
+}
+
+kg_reach_answer_t kg_reach_query(const kg_reach_t *r, const kg_entity_t *src, const kg_entity_t *tgt) {
+    STAT(r, queries);
+    if (src == tgt) { STAT(r, same_component); return KG_REACH_YES; }
+    unsigned cu = kg_scc_component(r->scc, src), cv = kg_scc_component(r->scc, tgt);
+    if (cu == KG_NO_COMPONENT || cv == KG_NO_COMPONENT) { STAT(r, unknown); return KG_REACH_UNKNOWN; }
+
+    kg_reach_answer_t ans;
+    if (cu == cv) { STAT(r, same_component); return KG_REACH_YES; }
+    if (cu < cv) { STAT(r, order_pruned); ans = KG_REACH_NO; }
+    else if (!nests(r, cu, cv)) { STAT(r, label_pruned); ans = KG_REACH_NO; }
+    else { STAT(r, searched); ans = search(r, cu, cv); }
+
+    /* A "no" only holds for the graph the index was built from */
+    if (ans == KG_REACH_NO && !kg_reach_is_current(r)) { STAT(r, unknown); return KG_REACH_UNKNOWN; }
+    return ans;
+}
@@ -0,0 +1,74 @@
+/* =========================================================================
+   Knowledge Graph Engine — Reachability Index
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Answers "can X reach Y?" without a traversal most of the time, so a
+     path query with no answer stops before exploring X's whole reachable
+     set. Built from one snapshot:
+       - Strongly connected components (kg_scc.h). Ids come out in
+         reverse topological order, so an edge between components always
+         goes from a higher id to a lower one: comp(X) < comp(Y) => no.
+       - Their condensation DAG, labeled GRAIL-style with d randomized DFS
+         post-order intervals per component. If Y is reachable from X,
+         Y's interval nests inside X's in every labeling, so one labeling
+         without nesting proves "no" in O(d).
+     When the labels cannot decide, a DFS over the DAG pruned by the same
+     two tests settles it.
+->   Staleness:
+     Inserts only add reachability, so a "yes" from an old index still
+     holds; its "no" does not. Past its version the index answers
+     KG_REACH_UNKNOWN instead of "no" and the caller searches (or
+     rebuilds; building is O(n + m)).
+->   Build:
+     add kg_reach.c, kg_scc.c and kg_csr.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_REACH_H
+#define KG_REACH_H
+
+#include "kg_graph.h"
+#include "kg_scc.h"
+
+#define KG_REACH_DEFAULT_LABELINGS 3
+#define KG_REACH_MAX_LABELINGS     8
+
+typedef enum kg_reach_answer {
+    KG_REACH_NO = 0,
+    KG_REACH_YES,
+    KG_REACH_UNKNOWN             /* stale index, entity newer than it, or no memory */
+} kg_reach_answer_t;
+
+/* How queries were answered, for tuning d and judging the index. */
+typedef struct kg_reach_stats {
+    _Atomic unsigned long queries;
+    _Atomic unsigned long same_component;    /* yes in O(1) */
+    _Atomic unsigned long order_pruned;      /* no from component order */
+    _Atomic unsigned long label_pruned;      /* no from the intervals */
+    _Atomic unsigned long searched;          /* needed the pruned DFS */
+    _Atomic unsigned long search_visits;     /* components it visited */
+    _Atomic unsigned long unknown;
+} kg_reach_stats_t;
+
+typedef struct kg_reach {
+    const kg_graph_t *g;
+    unsigned long version;       /* snapshot the index was built from */
+    kg_scc_t *scc;               /* components over every relation, and their DAG */
+    unsigned d;                  /* labelings */
+    unsigned *lo, *post;         /* [c * d + j]: interval of c in labeling j */
+    kg_reach_stats_t stats;
+} kg_reach_t;
+
+/* d labelings (1..KG_REACH_MAX_LABELINGS; 0 = default). seed picks the
+   random child orders, so a build is reproducible. */
+kg_status_t kg_reach_build(const kg_snapshot_t *s, unsigned d, unsigned long seed, kg_reach_t **out);
+void kg_reach_free(kg_reach_t *r);
+size_t kg_reach_bytes(const kg_reach_t *r);
+
+static inline int kg_reach_is_current(const kg_reach_t *r) {
+    return r->version == kg_graph_version(r->g);
+}
+
+/* Following edges of every label. Safe from any number of threads. */
+kg_reach_answer_t kg_reach_query(const kg_reach_t *r, const kg_entity_t *src, const kg_entity_t *tgt);
+
+#endif /* KG_REACH_H */
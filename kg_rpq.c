@@ -0,0 +1,351 @@
+/* =========================================================================
+   Knowledge Graph Engine — Regular Path Queries (implementation)
+   ========================================================================= */
+
+#include "kg_rpq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define NO_STEP   ((size_t)-1)
+#define MAX_DEPTH 64             /* nested parentheses */
+
+struct kg_rpq_step {
+    kg_entity_t *entity;
+    unsigned state;
+    unsigned hops;
+    size_t parent;               /* trail index, NO_STEP at the source */
+    const kg_relation_t *via;
+};
+
+static unsigned lowest_bit(uint64_t m) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(m);
+#else
+    unsigned k = 0;
+    while (!(m & 1)) { m >>= 1; k++; }
+    return k;
+#endif
+}
+
+/*
+   [SECTION] Parsing & Glushkov Construction
+   - Each fragment carries the states it can start and end with and
+     whether it matches the empty path; follow sets are filled in as
+     fragments combine, so the automaton is done when parsing is.
+ */
+typedef struct frag {
+    uint64_t first, last;
+    int nullable;
+} frag_t;
+
+typedef struct parser {
+    const kg_graph_t *g;
+    const char *p;
+    kg_rpq_t *r;
+    unsigned label[KG_RPQ_MAX_STATES];   /* state -> label id */
+    int depth;
+    char *err;
+    size_t err_len;
+} parser_t;
+
+static kg_status_t fail(parser_t *ps, kg_status_t st, const char *fmt, const char *arg) {
+    if (ps->err && ps->err_len) snprintf(ps->err, ps->err_len, fmt, arg);
+    return st;
+}
+
+static void skip_blanks(parser_t *ps) {
+    while (isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+/* Every state in `from` may move to every state in `to`. */
+static void link_states(kg_rpq_t *r, uint64_t from, uint64_t to) {
+    while (from) {
+        r->follow[lowest_bit(from)] |= to;
+        from &= from - 1;
+    }
+}
+
+static int is_operator(char c) {
+    return c == '/' || c == '|' || c == '(' || c == ')' || c == '*' || c == '+' || c == '?' || c == '"';
+}
+
+static kg_status_t parse_alt(parser_t *ps, frag_t *out);
+
+static kg_status_t parse_label(parser_t *ps, frag_t *out) {
+    char name[KG_REL_LEN];
+    size_t n = 0;
+    if (*ps->p == '"') {
+        const char *q = strchr(ps->p + 1, '"');
+        if (!q) return fail(ps, KG_ERR_INVALID, "%s", "unterminated quote");
+        n = (size_t)(q - ps->p - 1);
+        if (n >= sizeof(name)) return fail(ps, KG_ERR_INVALID, "%s", "relation name too long");
+        memcpy(name, ps->p + 1, n);
+        ps->p = q + 1;
+    } else {
+        const char *q = ps->p;
+        while (*q && !is_operator(*q)) q++;
+        n = (size_t)(q - ps->p);
+        if (n >= sizeof(name)) return fail(ps, KG_ERR_INVALID, "%s", "relation name too long");
+        memcpy(name, ps->p, n);
+        ps->p = q;
+    }
+    name[n] = '\0';
+    kg_trim(name);
+    if (!name[0]) {
+        if (!*ps->p) return fail(ps, KG_ERR_INVALID, "%s", "expected a relation at the end");
+        return fail(ps, KG_ERR_INVALID, "expected a relation before %s", ps->p);
+    }
+    unsigned id = kg_find_label(ps->g, name);
+    if (id == KG_NO_LABEL) return fail(ps, KG_ERR_NOT_FOUND, "unknown relation: %s", name);
+    if (ps->r->n_states == KG_RPQ_MAX_STATES)
+        return fail(ps, KG_ERR_INVALID, "%s", "expression too long (at most 63 relations)");
+    unsigned state = ps->r->n_states++;
+    ps->label[state] = id;
+    out->first = out->last = (uint64_t)1 << state;
+    out->nullable = 0;
+    return KG_OK;
+}
+
+static kg_status_t parse_atom(parser_t *ps, frag_t *out) {
+    skip_blanks(ps);
+    if (*ps->p != '(') return parse_label(ps, out);
+    if (++ps->depth > MAX_DEPTH) return fail(ps, KG_ERR_INVALID, "%s", "parentheses nested too deep");
+    ps->p++;
+    kg_status_t st = parse_alt(ps, out);
+    if (st != KG_OK) return st;
+    skip_blanks(ps);
+    if (*ps->p != ')') return fail(ps, KG_ERR_INVALID, "%s", "missing \")\"");
+    ps->p++;
+    ps->depth--;
+    return KG_OK;
+}
+
+static kg_status_t parse_postfix(parser_t *ps, frag_t *out) {
+    kg_status_t st = parse_atom(ps, out);
+    if (st != KG_OK) return st;
+    for (;;) {
+        skip_blanks(ps);
+        char c = *ps->p;
+        if (c != '*' && c != '+' && c != '?') return KG_OK;
+        ps->p++;
+        if (c != '?') link_states(ps->r, out->last, out->first);   /* loop back */
+        if (c != '+') out->nullable = 1;
+    }
+}
+
+static kg_status_t parse_seq(parser_t *ps, frag_t *out) {
+    kg_status_t st = parse_postfix(ps, out);
+    while (st == KG_OK) {
+        skip_blanks(ps);
+        if (*ps->p != '/') break;
+        ps->p++;
+        frag_t b;
+        st = parse_postfix(ps, &b);
+        if (st != KG_OK) break;
+        link_states(ps->r, out->last, b.first);
+        if (out->nullable) b.first |= out->first;
+        else b.first = out->first;
+        if (b.nullable) b.last |= out->last;
+        b.nullable = b.nullable && out->nullable;
+        *out = b;
+    }
+    return st;
+}
+
+static kg_status_t parse_alt(parser_t *ps, frag_t *out) {
+    kg_status_t st = parse_seq(ps, out);
+    while (st == KG_OK) {
+        skip_blanks(ps);
+        if (*ps->p != '|') break;
+        ps->p++;
+        frag_t b;
+        st = parse_seq(ps, &b);
+        if (st != KG_OK) break;
+        out->first |= b.first;
+        out->last |= b.last;
+        out->nullable = out->nullable || b.nullable;
+    }
+    return st;
+}
+
+void kg_rpq_free(kg_rpq_t *r) {
+    if (!r) return;
+    free(r->label_mask);
+    free(r);
+}
+
+kg_status_t kg_rpq_compile(const kg_graph_t *g, const char *expr, kg_rpq_t **out,
+                           char *err, size_t err_len) {
+    *out = NULL;
+    if (err && err_len) err[0] = '\0';
+    parser_t ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.g = g; ps.p = expr; ps.err = err; ps.err_len = err_len;
+    skip_blanks(&ps);
+    if (!*ps.p) return fail(&ps, KG_ERR_INVALID, "%s", "empty expression");
+
+    ps.r = (kg_rpq_t*)calloc(1, sizeof(kg_rpq_t));
+    if (!ps.r) return KG_ERR_NOMEM;
+    kg_rpq_t *r = ps.r;
+    r->n_states = 1;                     /* state 0: start */
+    frag_t f;
+    kg_status_t st = parse_alt(&ps, &f);
+    if (st == KG_OK) {
+        skip_blanks(&ps);
+        if (*ps.p == ')') st = fail(&ps, KG_ERR_INVALID, "%s", "unmatched \")\"");
+        else if (*ps.p) st = fail(&ps, KG_ERR_INVALID, "unexpected %s", ps.p);
+    }
+    if (st != KG_OK) { kg_rpq_free(r); return st; }
+
+    r->follow[0] = f.first;
+    r->accept = f.last | (f.nullable ? 1u : 0u);
+    for (unsigned q = 1; q < r->n_states; ++q)
+        if (ps.label[q] + 1 > r->n_masks) r->n_masks = ps.label[q] + 1;
+    r->label_mask = (uint64_t*)calloc(r->n_masks ? r->n_masks : 1, sizeof(uint64_t));
+    if (!r->label_mask) { kg_rpq_free(r); return KG_ERR_NOMEM; }
+    for (unsigned q = 1; q < r->n_states; ++q) r->label_mask[ps.label[q]] |= (uint64_t)1 << q;
+    *out = r;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Product Search
+   - BFS over (entity, state) pairs; the trail is the queue and, because
+     nothing is ever removed from it, also the search tree for witnesses.
+   - An entity is a match the first time it is reached in an accepting
+     state, which in BFS order is along a shortest matching path.
+ */
+typedef struct search {
+    const kg_rpq_t *r;
+    const kg_entity_t *tgt;
+    size_t limit;
+    kg_rpq_step_t *trail;
+    size_t n, cap;
+    uint64_t *visited;           /* per entity: states it was reached in */
+    kg_rpq_result_t *out;
+    size_t out_cap;
+    int done;                    /* target found or limit reached */
+} search_t;
+
+static kg_status_t add_match(search_t *S, kg_entity_t *e, size_t at) {
+    kg_rpq_result_t *res = S->out;
+    if (S->limit && res->n == S->limit) { res->truncated = 1; S->done = 1; return KG_OK; }
+    if (res->n == S->out_cap) {
+        size_t c = S->out_cap ? 2 * S->out_cap : 16;
+        kg_entity_t **nodes = (kg_entity_t**)realloc(res->nodes, c * sizeof(kg_entity_t*));
+        if (nodes) res->nodes = nodes;
+        size_t *h = (size_t*)realloc(res->hops, c * sizeof(size_t));
+        if (h) res->hops = h;
+        size_t *a = (size_t*)realloc(res->at, c * sizeof(size_t));
+        if (a) res->at = a;
+        if (!nodes || !h || !a) return KG_ERR_NOMEM;
+        S->out_cap = c;
+    }
+    res->nodes[res->n] = e;
+    res->hops[res->n] = S->trail[at].hops;
+    res->at[res->n] = at;
+    res->n++;
+    if (S->tgt) S->done = 1;
+    return KG_OK;
+}
+
+/* Steps are pushed in order of hops, so the first push of an entity in
+   any accepting state is its shortest match. */
+static kg_status_t push_step(search_t *S, kg_entity_t *e, unsigned state, size_t parent,
+                             const kg_relation_t *via) {
+    if (S->n == S->cap) {
+        size_t cap = S->cap ? 2 * S->cap : 256;
+        kg_rpq_step_t *t = (kg_rpq_step_t*)realloc(S->trail, cap * sizeof(kg_rpq_step_t));
+        if (!t) return KG_ERR_NOMEM;
+        S->trail = t; S->cap = cap;
+    }
+    kg_rpq_step_t *x = &S->trail[S->n];
+    x->entity = e;
+    x->state = state;
+    x->hops = parent == NO_STEP ? 0 : S->trail[parent].hops + 1;
+    x->parent = parent;
+    x->via = via;
+    uint64_t bit = (uint64_t)1 << state;
+    int match = (S->r->accept & bit) && !(S->visited[e->id] & S->r->accept) && (!S->tgt || e == S->tgt);
+    S->visited[e->id] |= bit;
+    return match ? add_match(S, e, S->n++) : (S->n++, KG_OK);
+}
+
+void kg_rpq_result_free(kg_rpq_result_t *res) {
+    free(res->nodes); free(res->hops); free(res->trail); free(res->at);
+    memset(res, 0, sizeof(*res));
+}
+
+kg_status_t kg_rpq_eval_at(const kg_snapshot_t *s, const kg_rpq_t *r, const kg_entity_t *src,
+                           const kg_entity_t *tgt, size_t limit, int witnesses, kg_rpq_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!src || !kg_visible(s, src) || (tgt && !kg_visible(s, tgt))) return KG_ERR_NOT_FOUND;
+
+    search_t S;
+    memset(&S, 0, sizeof(S));
+    S.r = r; S.tgt = tgt; S.limit = limit; S.out = out;
+    S.visited = (uint64_t*)calloc(s->n_entities, sizeof(uint64_t));
+    if (!S.visited) return KG_ERR_NOMEM;
+    kg_status_t st = push_step(&S, (kg_entity_t*)src, 0, NO_STEP, NULL);
+
+    for (size_t head = 0; st == KG_OK && !S.done && head < S.n; ++head) {
+        uint64_t from = r->follow[S.trail[head].state];
+        if (!from) continue;
+        const kg_entity_t *e = S.trail[head].entity;
+        for (const kg_relation_t *rel = kg_snapshot_relations(s, e); rel && !S.done; rel = rel->next) {
+            if (rel->label >= r->n_masks) continue;
+            uint64_t next = from & r->label_mask[rel->label] & ~S.visited[rel->target->id];
+            for (; next && st == KG_OK && !S.done; next &= next - 1)
+                st = push_step(&S, rel->target, lowest_bit(next), head, rel);
+            if (st != KG_OK) break;
+        }
+    }
+    free(S.visited);
+    if (st == KG_OK && tgt && out->n == 0) st = KG_ERR_NO_PATH;
+    if (st != KG_OK) { free(S.trail); kg_rpq_result_free(out); return st; }
+    if (witnesses) {
+        out->trail = S.trail;
+    } else {
+        free(S.trail);
+        free(out->at); out->at = NULL;
+    }
+    return KG_OK;
+}
+
+kg_status_t kg_rpq_eval(const kg_graph_t *g, const kg_rpq_t *r, const kg_entity_t *src,
+                        const kg_entity_t *tgt, size_t limit, int witnesses, kg_rpq_result_t *out) {
+    kg_snapshot_t s;
+    memset(out, 0, sizeof(*out));
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_rpq_eval_at(&s, r, src, tgt, limit, witnesses, out);
+    kg_snapshot_release(&s);
+    return st;
+}
+
+/* [SECTION] Witness Paths */
+
+kg_status_t kg_rpq_witness(const kg_rpq_result_t *res, size_t i, kg_rpq_path_t *out) {
+    out->nodes = NULL; out->rels = NULL; out->len = 0;
+    if (!res->trail || i >= res->n) return KG_ERR_INVALID;
+    size_t len = res->hops[i];
+    out->nodes = (kg_entity_t**)malloc((len + 1) * sizeof(kg_entity_t*));
+    out->rels = (const kg_relation_t**)malloc((len ? len : 1) * sizeof(kg_relation_t*));
+    if (!out->nodes || !out->rels) { kg_rpq_path_free(out); return KG_ERR_NOMEM; }
+    size_t k = len;
+    for (size_t at = res->at[i]; at != NO_STEP; at = res->trail[at].parent) {
+        const kg_rpq_step_t *x = &res->trail[at];
+        out->nodes[k] = x->entity;
+        if (x->via) out->rels[--k] = x->via;
+    }
+    out->len = len;
+    return KG_OK;
+}
+
+void kg_rpq_path_free(kg_rpq_path_t *p) {
+    free(p->nodes); free((void*)p->rels);
+    p->nodes = NULL; p->rels = NULL; p->len = 0;
+}
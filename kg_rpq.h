@@ -0,0 +1,83 @@
+/* =========================================================================
+   Knowledge Graph Engine — Regular Path Queries
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     "Everything reachable from X along paths whose relation labels match
+     a regular expression":
+         Requires/("Subset of")*        one Requires, then any number of Subset of
+         (Includes)+                    Includes, transitively
+         Requires | Uses/Requires?
+     Operators: a/b (sequence), a|b (either), a* (zero or more), a+ (one
+     or more), a? (optional), parentheses. A label is a run of other
+     characters (inner blanks kept, outer ones trimmed) or "quoted" when it
+     contains an operator. Edges are followed forward only.
+->   Evaluation:
+     The expression compiles to a Glushkov automaton: one state per label
+     occurrence plus a start state, no epsilon moves, every move into a
+     state reading that occurrence's label. A query is one BFS over the
+     product of graph and automaton, with visited state kept per (entity,
+     automaton state) as a bitmask per entity, so each pair is expanded
+     at most once: O((n + m) * states). Matches come out in order of fewest
+     hops, each with the shortest witness path that proves it.
+->   Build:
+     add kg_rpq.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_RPQ_H
+#define KG_RPQ_H
+
+#include "kg_graph.h"
+
+#define KG_RPQ_MAX_STATES 64     /* start state + 63 label occurrences */
+
+typedef struct kg_rpq {
+    unsigned n_states;
+    uint64_t follow[KG_RPQ_MAX_STATES];  /* states reachable in one move from each */
+    uint64_t accept;                     /* bit 0 when the empty path matches */
+    size_t n_masks;
+    uint64_t *label_mask;                /* label id -> states entered on that label */
+} kg_rpq_t;
+
+/* Labels are resolved against g. On failure err (if not NULL) gets a
+   one-line reason: KG_ERR_INVALID for syntax or too many occurrences,
+   KG_ERR_NOT_FOUND for an unknown relation. */
+kg_status_t kg_rpq_compile(const kg_graph_t *g, const char *expr, kg_rpq_t **out,
+                           char *err, size_t err_len);
+void kg_rpq_free(kg_rpq_t *r);
+
+typedef struct kg_rpq_step kg_rpq_step_t;
+
+typedef struct kg_rpq_result {
+    size_t n;
+    kg_entity_t **nodes;         /* matches, fewest hops first */
+    size_t *hops;                /* length of each one's shortest witness */
+    int truncated;               /* stopped at the limit */
+    /* private: the search tree, kept for kg_rpq_witness() */
+    kg_rpq_step_t *trail;
+    size_t *at;
+} kg_rpq_result_t;
+
+/* Entities src reaches along a matching path, the first `limit` (0 = all).
+   With tgt, the search stops as soon as tgt matches: KG_ERR_NO_PATH if it
+   never does. witnesses = 0 drops the search tree as soon as the call
+   returns; kg_rpq_witness() then answers KG_ERR_INVALID. The plain form
+   pins its own snapshot for the duration of the call. */
+kg_status_t kg_rpq_eval(const kg_graph_t *g, const kg_rpq_t *r, const kg_entity_t *src,
+                        const kg_entity_t *tgt, size_t limit, int witnesses, kg_rpq_result_t *out);
+kg_status_t kg_rpq_eval_at(const kg_snapshot_t *s, const kg_rpq_t *r, const kg_entity_t *src,
+                           const kg_entity_t *tgt, size_t limit, int witnesses, kg_rpq_result_t *out);
+void kg_rpq_result_free(kg_rpq_result_t *res);
+
+/* A witness: nodes[0] is the source, rels[k] the edge from nodes[k] to
+   nodes[k + 1]. An entity may appear twice when the expression needed it
+   (a cycle walked in another automaton state). */
+typedef struct kg_rpq_path {
+    kg_entity_t **nodes;         /* len + 1 */
+    const kg_relation_t **rels;  /* len */
+    size_t len;
+} kg_rpq_path_t;
+
+kg_status_t kg_rpq_witness(const kg_rpq_result_t *res, size_t i, kg_rpq_path_t *out);
+void kg_rpq_path_free(kg_rpq_path_t *p);
+
+#endif /* KG_RPQ_H */
@@ -0,0 +1,233 @@
+/* =========================================================================
+   Knowledge Graph Engine — Strongly Connected Components (implementation)
+   ========================================================================= */
+
+#include "kg_scc.h"
+#include "kg_csr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define UNSEEN ((unsigned)-1)
+
+static inline int follows(const kg_scc_t *c, unsigned label) {
+    return !c->f.bits || kg_label_allowed(&c->f, label);
+}
+
+void kg_scc_free(kg_scc_t *c) {
+    if (!c) return;
+    free(c->f.bits);
+    free(c->comp); free(c->member_row); free(c->members);
+    free(c->dag_row); free(c->dag); free(c->cyclic);
+    free(c);
+}
+
+size_t kg_scc_bytes(const kg_scc_t *c) {
+    size_t b = sizeof(*c) + 2 * c->n * sizeof(unsigned) + 2 * (c->n_comps + 1) * sizeof(size_t)
+             + c->dag_row[c->n_comps] * sizeof(unsigned) + c->n_comps;
+    if (c->f.bits) b += ((c->f.nbits + 63) / 64 + 1) * sizeof(uint64_t);
+    return b;
+}
+
+/*
+   [SECTION] Tarjan (iterative)
+   - An explicit call stack of (vertex, next edge) replaces recursion, so
+     long chains cannot overflow the C stack.
+   - Components are numbered as they complete: sinks first.
+ */
+static kg_status_t tarjan(const kg_csr_t *g, kg_scc_t *c) {
+    size_t n = g->n;
+    unsigned *index = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    unsigned *low = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    unsigned *stack = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    unsigned *call = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    size_t *edge = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    if (!index || !low || !stack || !call || !edge) {
+        free(index); free(low); free(stack); free(call); free(edge);
+        return KG_ERR_NOMEM;
+    }
+    unsigned *comp = c->comp;
+    memset(index, 0xff, n * sizeof(unsigned));
+    for (size_t v = 0; v < n; ++v) comp[v] = UNSEEN;
+
+    unsigned next_index = 0, nc = 0;
+    size_t sp = 0, cp = 0;
+    for (size_t root = 0; root < n; ++root) {
+        if (index[root] != UNSEEN) continue;
+        index[root] = low[root] = next_index++;
+        stack[sp++] = (unsigned)root;
+        call[cp] = (unsigned)root; edge[cp++] = g->row[root];
+
+        while (cp) {
+            unsigned v = call[cp - 1];
+            if (edge[cp - 1] < g->row[v + 1]) {
+                size_t e = edge[cp - 1]++;
+                if (!follows(c, g->lab[e])) continue;
+                unsigned w = g->tgt[e];
+                if (index[w] == UNSEEN) {
+                    index[w] = low[w] = next_index++;
+                    stack[sp++] = w;
+                    call[cp] = w; edge[cp++] = g->row[w];
+                } else if (comp[w] == UNSEEN && index[w] < low[v]) {
+                    low[v] = index[w];             /* w still on the stack */
+                }
+                continue;
+            }
+            cp--;
+            if (low[v] == index[v]) {
+                unsigned w;
+                do { w = stack[--sp]; comp[w] = nc; } while (w != v);
+                nc++;
+            }
+            if (cp && low[v] < low[call[cp - 1]]) low[call[cp - 1]] = low[v];
+        }
+    }
+    c->n_comps = nc;
+    free(index); free(low); free(stack); free(call); free(edge);
+    return KG_OK;
+}
+
+/*
+   [SECTION] Condensation
+   - Members grouped by component (counting sort), then successor lists
+     per component with duplicates dropped by a "last source that added
+     it" stamp. A component is cyclic with two or more members, or one
+     member with an edge to itself.
+ */
+static kg_status_t condense(const kg_csr_t *g, kg_scc_t *c) {
+    size_t n = g->n, nc = c->n_comps;
+    unsigned *stamp = (unsigned*)malloc((nc ? nc : 1) * sizeof(unsigned));
+    c->member_row = (size_t*)calloc(nc + 1, sizeof(size_t));
+    c->members = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    c->dag_row = (size_t*)calloc(nc + 1, sizeof(size_t));
+    c->cyclic = (unsigned char*)calloc(nc ? nc : 1, 1);
+    if (!stamp || !c->member_row || !c->members || !c->dag_row || !c->cyclic) { free(stamp); return KG_ERR_NOMEM; }
+
+    /* The fill advances each start to the next component's start, so
+       shift back after */
+    size_t *row = c->member_row;
+    for (size_t v = 0; v < n; ++v) row[c->comp[v] + 1]++;
+    for (size_t k = 0; k < nc; ++k) row[k + 1] += row[k];
+    for (size_t v = 0; v < n; ++v) c->members[row[c->comp[v]]++] = (unsigned)v;
+    for (size_t k = nc; k > 0; --k) row[k] = row[k - 1];
+    row[0] = 0;
+
+    /* Two passes over the members of each component: count, then fill */
+    for (int pass = 0; pass < 2; ++pass) {
+        memset(stamp, 0xff, nc * sizeof(unsigned));
+        size_t k = 0;
+        for (size_t cu = 0; cu < nc; ++cu) {
+            if (pass == 1) k = c->dag_row[cu];
+            if (pass == 0 && row[cu + 1] - row[cu] > 1) c->cyclic[cu] = 1;
+            for (size_t i = row[cu]; i < row[cu + 1]; ++i) {
+                unsigned v = c->members[i];
+                for (size_t e = g->row[v]; e < g->row[v + 1]; ++e) {
+                    if (!follows(c, g->lab[e])) continue;
+                    unsigned cw = c->comp[g->tgt[e]];
+                    if (cw == cu) { if (g->tgt[e] == v) c->cyclic[cu] = 1; continue; }
+                    if (stamp[cw] == cu) continue;
+                    stamp[cw] = (unsigned)cu;
+                    if (pass == 0) c->dag_row[cu + 1]++;
+                    else c->dag[k++] = cw;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (size_t cu = 0; cu < nc; ++cu) c->dag_row[cu + 1] += c->dag_row[cu];
+            c->dag = (unsigned*)malloc((c->dag_row[nc] ? c->dag_row[nc] : 1) * sizeof(unsigned));
+            if (!c->dag) { free(stamp); return KG_ERR_NOMEM; }
+        }
+    }
+    for (size_t cu = 0; cu < nc; ++cu) c->n_cyclic += c->cyclic[cu];
+    free(stamp);
+    return KG_OK;
+}
+
+/* [SECTION] Build */
+
+kg_status_t kg_scc_build(const kg_snapshot_t *s, const kg_label_filter_t *f, kg_scc_t **out) {
+    *out = NULL;
+    kg_scc_t *c = (kg_scc_t*)calloc(1, sizeof(kg_scc_t));
+    if (!c) return KG_ERR_NOMEM;
+    c->g = s->g;
+    c->version = s->version;
+    if (f) {
+        size_t words = (f->nbits + 63) / 64 + 1;
+        c->f.bits = (uint64_t*)malloc(words * sizeof(uint64_t));
+        if (!c->f.bits) { kg_scc_free(c); return KG_ERR_NOMEM; }
+        memcpy(c->f.bits, f->bits, words * sizeof(uint64_t));
+        c->f.nbits = f->nbits;
+        c->f.allow_new = f->allow_new;
+    }
+
+    kg_csr_t *g;
+    kg_status_t st = kg_csr_build(s, 0, &g);
+    if (st != KG_OK) { kg_scc_free(c); return st; }
+    c->n = g->n;
+    c->comp = (unsigned*)malloc((c->n ? c->n : 1) * sizeof(unsigned));
+    st = c->comp ? tarjan(g, c) : KG_ERR_NOMEM;
+    if (st == KG_OK) st = condense(g, c);
+    kg_csr_free(g);
+    if (st != KG_OK) { kg_scc_free(c); return st; }
+    *out = c;
+    return KG_OK;
+}
+
+/* [SECTION] Cyclic Components */
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+kg_status_t kg_scc_cycles(const kg_scc_t *c, unsigned **ids, size_t *n) {
+    *ids = NULL; *n = 0;
+    if (!c->n_cyclic) return KG_OK;
+    unsigned *a = (unsigned*)malloc(c->n_cyclic * sizeof(unsigned));
+    uint64_t *key = (uint64_t*)malloc(c->n_cyclic * sizeof(uint64_t));
+    if (!a || !key) { free(a); free(key); return KG_ERR_NOMEM; }
+    /* (size complement, id) in one key: ascending = largest first */
+    size_t k = 0;
+    for (size_t cu = 0; cu < c->n_comps; ++cu)
+        if (c->cyclic[cu]) key[k++] = (uint64_t)(UINT32_MAX - kg_scc_size(c, (unsigned)cu)) << 32 | cu;
+    qsort(key, k, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i < k; ++i) a[i] = (unsigned)key[i];
+    free(key);
+    *ids = a; *n = k;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Pruned BFS
+   - Every entity on a path from X to Y has a component id between
+     comp(Y) and comp(X); those below comp(Y) are never queued.
+ */
+
+/* Every relation f allows, the index followed too. */
+static int covers(const kg_scc_t *c, const kg_label_filter_t *f) {
+    if (!c->f.bits) return 1;
+    if (!f) return 0;
+    size_t nbits = f->nbits > c->f.nbits ? f->nbits : c->f.nbits;
+    for (unsigned l = 0; l < nbits; ++l)
+        if (kg_label_allowed(f, l) && !kg_label_allowed(&c->f, l)) return 0;
+    return !f->allow_new || c->f.allow_new;
+}
+
+kg_status_t kg_scc_shortest_path_at(const kg_scc_t *c, const kg_snapshot_t *s, const kg_entity_t *src,
+                                    const kg_entity_t *tgt, const kg_label_filter_t *f, kg_path_t *out) {
+    if (c->version != s->version || c->g != s->g || !covers(c, f))
+        return kg_shortest_path_filtered_at(s, src, tgt, f, out);
+    unsigned floor = tgt && kg_visible(s, tgt) ? c->comp[tgt->id] : 0;
+    return kg_shortest_path_pruned_at(s, src, tgt, f, c->comp, floor, out);
+}
+
+kg_status_t kg_scc_shortest_path(const kg_scc_t *c, const kg_graph_t *g, const kg_entity_t *src,
+                                 const kg_entity_t *tgt, const kg_label_filter_t *f, kg_path_t *out) {
+    kg_snapshot_t s;
+    out->nodes = NULL; out->len = 0; out->cost = 0;
+    kg_status_t st = kg_snapshot_acquire(g, &s);
+    if (st != KG_OK) return st;
+    st = kg_scc_shortest_path_at(c, &s, src, tgt, f, out);
+    kg_snapshot_release(&s);
+    return st;
+}
@@ -0,0 +1,1310 @@
+/* =========================================================================
+   Knowledge Graph Engine — Query Server
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Serves graph lookups to many client processes over a Unix or TCP
+     socket. One epoll thread owns all socket I/O; a pool of workers runs
+     the queries. Reads (NEIGHBORS / PATH / SEARCH) never wait: the library
+     lets them run lock-free alongside ADDs.
+->   Protocol (one request per line, pipelining allowed):
+       PING
+       NEIGHBORS <entity>
+       PATH <source>|<target>[|<relations>]
+                                   (relations: "a,b" follows only those,
+                                    "!a,b" all but them)
+       WPATH <source>|<target>[|<relations>]
+                                   (cheapest path by weight; lines are
+                                    <entity>|<cost from source>)
+       DIST <source>|<target>      (landmark bounds, no traversal:
+                                    one line <lower>|<upper>; needs -L)
+       REACH <source>|<target>     (one line: yes or no; an index outdated
+                                    by ADDs is rebuilt when it cannot tell)
+       CONNECTED <a>|<b>           (one line: yes|<component size> or no;
+                                    any chain of relations, either direction)
+       KPATHS <source>|<target>|<k>[|<relations>]
+                                   (k shortest loopless paths, by weight once
+                                    any edge has one; one line per path:
+                                    <cost>|<entity>|<entity>|...)
+       ALLPATHS <source>|<target>|<max hops>[|<relations>]
+                                   (every simple path that short, same lines,
+                                    at most QUERY_MAX)
+       CYCLES [<relations>]        (groups of entities that reach each other
+                                    along those relations, largest first, at
+                                    most QUERY_MAX: <size>|<entity>|<entity>|...)
+       EGO <entity>|<hops>[|out|in|both[|<relations>]]
+                                   (the neighborhood that many hops away, at
+                                    most QUERY_MAX entities; one line per edge
+                                    among them: <source>|<relation>|<target>[|<weight>])
+       ORDER [<before> / <after>]  (learning order along those relations,
+                                    defaults in kg_topo.h: one <entity> line
+                                    each, prerequisites first, at most
+                                    QUERY_MAX; then cycle|<entity>|... per
+                                    cycle that holds the rest back)
+       PREREQS <entity>[|<before> / <after>]
+                                   (everything it needs, one <entity> line
+                                    each in the same order, at most QUERY_MAX)
+       PAGERANK [<k>]              (recomputes and stores the scores SEARCH
+                                    ranks by; the k best, at most QUERY_MAX,
+                                    one <entity>|<score> line each)
+       PPR <entity>[|<entity>...]  (personalized PageRank from those: the
+                                    QUERY_MAX best others, same lines)
+       CENTRALITY [<samples>]      (betweenness and harmonic closeness from
+                                    that many random sources, CENTRAL_SAMPLES
+                                    by default, exact when there are no more
+                                    entities: a <sources>|<error> header, the
+                                    bound holding with 95% confidence, then
+                                    the QUERY_MAX best bridges, one
+                                    <entity>|<betweenness>|<closeness> line each)
+       RPQ <source>|<path>         (entities reached along relations matching
+                                    the path expression, e.g. Requires/("Subset of")*;
+                                    lines are <entity>|<hops>, nearest first,
+                                    at most QUERY_MAX)
+       RPQPATH <source>|<target>|<path>
+                                   (shortest matching path: <source>, then
+                                    one <relation>|<entity> line per hop)
+       QUERY <patterns>            (e.g. ?x Requires Python . ?x "Subset of" ?y;
+                                    a ?x|?y header, then one line per answer,
+                                    at most QUERY_MAX)
+       SEARCH <text>               (best PageRank first among equal matches)
+       ADD <source>|<relation>|<target>[|<weight>]
+       STATS                       (Prometheus text, one metric per line)
+       EXPLAIN <request>           (runs it; replies with its status line
+                                    and a per-phase profile instead of data;
+                                    for QUERY also the plan, estimated vs
+                                    actual rows per step)
+     Replies are "OK <n>" followed by n payload lines, or "ERR <message>".
+     Replies to one connection always come back in request order.
+->   Build & Run (Linux):
+     gcc -O2 -pthread -o kg_server kg_server.c kg_graph.c kg_metrics.c kg_alt.c kg_reach.c kg_scc.c kg_csr.c kg_pathcache.c kg_query.c kg_rpq.c kg_kpaths.c kg_ego.c kg_topo.c kg_rank.c kg_central.c -lm
+     ./kg_server -f relations.txt -u /tmp/kg.sock      (or -p 7070)
+     ./kg_server -f relations.txt -u /tmp/kg.sock -L 16   (landmarks: A* for WPATH, DIST)
+     ./kg_server -f relations.txt -u /tmp/kg.sock -c 0    (no path cache; default 4096)
+     kill -USR1 <pid>     (writes Prometheus text to kg_metrics.prom, see -m)
+
+   ========================================================================= */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "kg_graph.h"
+#include "kg_metrics.h"
+#include "kg_alt.h"
+#include "kg_reach.h"
+#include "kg_scc.h"
+#include "kg_pathcache.h"
+#include "kg_query.h"
+#include "kg_rpq.h"
+#include "kg_kpaths.h"
+#include "kg_ego.h"
+#include "kg_topo.h"
+#include "kg_rank.h"
+#include "kg_central.h"
+
+/* [SECTION] Configuration */
+
+#define DEFAULT_THREADS   4
+#define DEFAULT_BACKLOG   128
+#define MAX_EVENTS        64
+#define READ_CHUNK        16384
+#define OUT_HIGH_WATER    (4u << 20)   /* stop dispatching while this much is unsent */
+#define SEARCH_MAX        32
+#define QUERY_MAX         1000
+#define SEED_MAX          64           /* entities one PPR starts from */
+#define CENTRAL_SAMPLES   1000         /* CENTRALITY sources without a count */
+#define DEFAULT_METRICS   "kg_metrics.prom"
+#define DEFAULT_PATH_CACHE 4096
+
+/* =========================================================================
+   [SECTION] Data Structures
+   - buf_t: growable byte buffer
+   - conn_t: one client; at most one batch of its lines is in a worker at a
+     time, which keeps pipelined replies in order without sequencing
+   ========================================================================= */
+typedef struct buf {
+    char *p;
+    size_t len, cap;
+} buf_t;
+
+typedef struct conn {
+    int fd;
+    buf_t in;                /* bytes read, not yet dispatched */
+    buf_t out;               /* replies not yet written */
+    size_t out_off;
+    buf_t job;               /* complete lines handed to a worker */
+    buf_t resp;              /* worker-built replies for `job` */
+    int busy;                /* a worker owns job/resp */
+    int closing;             /* peer gone; free once the worker is done */
+    int eof;                 /* peer finished sending; close once answered */
+    int want_out;            /* EPOLLOUT armed */
+    int polled;              /* fd registered with epoll */
+    int dead;                /* closed; freed once the current event batch is over */
+    struct conn *qnext;      /* work queue / done list / dead list link */
+} conn_t;
+
+static kg_graph_t *gGraph = NULL;
+static kg_metrics_t gMetrics;
+static kg_alt_t *gAlt = NULL;        /* built once after loading (-L); read-only */
+static kg_reach_t *gReach = NULL;    /* built after loading, rebuilt lazily; see reach_query() */
+static kg_topo_t *gTopo = NULL;      /* default relations, built once after loading; read-only */
+static kg_path_cache_t *gPathCache = NULL;   /* PATH / WPATH results, until the next ADD */
+
+/* Triple indexes for QUERY, built at load. After ADDs the first QUERY to
+   notice rebuilds them and the others wait for that build, so a client
+   always sees its own ADDs; the rwlock is only contended for the swap. */
+static kg_triples_t *gTriples = NULL;
+static pthread_rwlock_t gTriplesLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t gTriplesBuild = PTHREAD_MUTEX_INITIALIZER;
+
+/* gReach is read under gReachLock; only a holder of gReachBuild swaps it. */
+static pthread_rwlock_t gReachLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t gReachBuild = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t gQueueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gQueueCond = PTHREAD_COND_INITIALIZER;
+static conn_t *gQueueHead = NULL, *gQueueTail = NULL;
+static conn_t *gDone = NULL;
+static conn_t *gDead = NULL;         /* event loop only: closed during this batch */
+static int gWakeFd = -1;
+static volatile sig_atomic_t gStop = 0;
+
+/* [SECTION] Buffers */
+
+static int buf_reserve(buf_t *b, size_t extra) {
+    if (b->len + extra <= b->cap) return 1;
+    size_t cap = b->cap ? b->cap : 256;
+    while (cap < b->len + extra) cap *= 2;
+    char *p = (char*)realloc(b->p, cap);
+    if (!p) return 0;
+    b->p = p; b->cap = cap;
+    return 1;
+}
+
+static int buf_append(buf_t *b, const char *s, size_t n) {
+    if (!buf_reserve(b, n)) return 0;
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+    return 1;
+}
+
+static int buf_printf(buf_t *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static int buf_printf(buf_t *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || !buf_reserve(b, (size_t)n + 1)) return 0;
+    va_start(ap, fmt);
+    vsnprintf(b->p + b->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->len += (size_t)n;
+    return 1;
+}
+
+static void buf_free(buf_t *b) { free(b->p); b->p = NULL; b->len = b->cap = 0; }
+
+/*
+   [SECTION] Request Execution (runs on worker threads)
+ */
+
+/* Exact name first, then a unique case-insensitive / fuzzy match. */
+static kg_entity_t *resolve(const char *name) {
+    unsigned long t0 = kg_now_ns();
+    kg_entity_t *e = kg_find_entity(gGraph, name);
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, e != NULL);
+    if (e) return e;
+    kg_entity_t *cand[2]; int n = 0;
+    t0 = kg_now_ns();
+    kg_match_t m = kg_search(gGraph, name, cand, 2, &n);
+    kg_metrics_record(&gMetrics, KG_OP_SEARCH, t0, n > 0);
+    return (m == KG_MATCH_EXACT || n == 1) ? cand[0] : NULL;
+}
+
+/* Rebuilds the reachability index unless it already matches the graph
+   (another worker may have rebuilt it while this one waited). */
+static void refresh_reach(void) {
+    pthread_mutex_lock(&gReachBuild);
+    if (!gReach || !kg_reach_is_current(gReach)) {
+        kg_snapshot_t snap;
+        kg_reach_t *fresh = NULL, *old;
+        if (kg_snapshot_acquire(gGraph, &snap) == KG_OK) {
+            kg_reach_build(&snap, 0, 0, &fresh);
+            kg_snapshot_release(&snap);
+        }
+        if (fresh) {
+            pthread_rwlock_wrlock(&gReachLock);
+            old = gReach; gReach = fresh;
+            pthread_rwlock_unlock(&gReachLock);
+            kg_reach_free(old);
+        }
+    }
+    pthread_mutex_unlock(&gReachBuild);
+}
+
+/* Like the console: a stale index still answers "yes", and is rebuilt
+   (linear time) only when it cannot answer at all. */
+static kg_reach_answer_t reach_query(const kg_entity_t *s, const kg_entity_t *t) {
+    pthread_rwlock_rdlock(&gReachLock);
+    kg_reach_answer_t a = gReach ? kg_reach_query(gReach, s, t) : KG_REACH_UNKNOWN;
+    int current = gReach && kg_reach_is_current(gReach);
+    pthread_rwlock_unlock(&gReachLock);
+    if (a != KG_REACH_UNKNOWN || current) return a;
+    refresh_reach();
+    pthread_rwlock_rdlock(&gReachLock);
+    a = gReach ? kg_reach_query(gReach, s, t) : KG_REACH_UNKNOWN;
+    pthread_rwlock_unlock(&gReachLock);
+    return a;
+}
+
+static void cmd_neighbors(buf_t *r, const char *arg) {
+    kg_entity_t *e = resolve(arg);
+    if (!e) { buf_printf(r, "ERR entity not found\n"); return; }
+    /* Edges of one snapshot: an ADD in flight is not published yet. */
+    kg_snapshot_t snap;
+    kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    if (!kg_visible(&snap, e)) { kg_snapshot_release(&snap); buf_printf(r, "ERR entity not found\n"); return; }
+    kg_relation_t *head = kg_snapshot_relations(&snap, e);
+    size_t n = 0;
+    for (kg_relation_t *x = head; x; x = x->next) n++;
+    buf_printf(r, "OK %zu\n", n);
+    for (kg_relation_t *x = head; x; x = x->next) {
+        if (x->weight == 1.0f) buf_printf(r, "%s|%s\n", x->rel, x->target->name);
+        else buf_printf(r, "%s|%s|%g\n", x->rel, x->target->name, (double)x->weight);
+    }
+    kg_snapshot_release(&snap);
+}
+
+static void cmd_path(buf_t *r, char *arg, int weighted) {
+    char *bar = strchr(arg, '|');
+    if (!bar) { buf_printf(r, "ERR usage: %s <source>|<target>[|<relations>]\n", weighted ? "WPATH" : "PATH"); return; }
+    *bar = '\0';
+    char *labels = strchr(bar + 1, '|');
+    if (labels) *labels++ = '\0';
+    kg_trim(arg); kg_trim(bar + 1);
+    kg_entity_t *s = resolve(arg), *t = resolve(bar + 1);
+    if (!s) { buf_printf(r, "ERR source not found\n"); return; }
+    if (!t) { buf_printf(r, "ERR target not found\n"); return; }
+
+    kg_label_filter_t filter, *f = NULL;
+    if (labels && labels[strspn(labels, " \t")]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, labels, bad, sizeof(bad));
+        if (fst == KG_ERR_NOT_FOUND) { buf_printf(r, "ERR unknown relation: %s\n", bad); return; }
+        if (fst != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(fst)); return; }
+        f = &filter;
+    }
+
+    kg_snapshot_t snap;
+    kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+    if (st != KG_OK) { if (f) kg_label_filter_free(f); buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    kg_path_t p;
+    unsigned long t0 = kg_now_ns();
+    st = gPathCache ? kg_path_cache_get(gPathCache, snap.version, s, t, f, weighted, &p) : KG_ERR_NOT_FOUND;
+    if (st == KG_ERR_NOT_FOUND) {
+        /* A proven "no" skips the search; a stale index only ever says yes/unknown */
+        if (reach_query(s, t) == KG_REACH_NO) st = KG_ERR_NO_PATH;
+        else if (!weighted) {
+            pthread_rwlock_rdlock(&gReachLock);
+            st = gReach ? kg_scc_shortest_path_at(gReach->scc, &snap, s, t, f, &p)
+                        : kg_shortest_path_filtered_at(&snap, s, t, f, &p);
+            pthread_rwlock_unlock(&gReachLock);
+        }
+        else if (gAlt) st = kg_alt_path(gAlt, &snap, s, t, f, &p);   /* Dijkstra once stale */
+        else st = kg_weighted_path_at(&snap, s, t, f, NULL, NULL, &p);
+        if (gPathCache) kg_path_cache_put(gPathCache, snap.version, s, t, f, weighted, st, &p);
+    }
+    kg_metrics_record(&gMetrics, KG_OP_PATH, t0, st == KG_OK);
+    if (st != KG_OK) {
+        if (f) kg_label_filter_free(f);
+        kg_snapshot_release(&snap);
+        buf_printf(r, "ERR %s\n", kg_strerror(st));
+        return;
+    }
+    buf_printf(r, "OK %zu\n", p.len);
+    double cost = 0;
+    for (size_t i = 0; i < p.len; ++i) {
+        if (!weighted) { buf_printf(r, "%s\n", p.nodes[i]->name); continue; }
+        if (i > 0) {   /* priced over the relations the search followed */
+            kg_path_t step = { p.nodes + i - 1, 2, 0 };
+            cost += kg_path_weight_filtered(&snap, &step, f);
+        }
+        buf_printf(r, "%s|%g\n", p.nodes[i]->name, cost);
+    }
+    if (f) kg_label_filter_free(f);
+    kg_snapshot_release(&snap);
+    kg_path_free(&p);
+}
+
+/* Paths stream into a side buffer: the count goes out before them. */
+static int put_path(void *ctx, const kg_path_t *p) {
+    buf_t *b = (buf_t*)ctx;
+    buf_printf(b, "%g", p->cost);
+    for (size_t i = 0; i < p->len; ++i) buf_printf(b, "|%s", p->nodes[i]->name);
+    buf_printf(b, "\n");
+    return 0;
+}
+
+static void cmd_paths(buf_t *r, char *arg, int all) {
+    const char *usage = all ? "ALLPATHS <source>|<target>|<max hops>[|<relations>]"
+                            : "KPATHS <source>|<target>|<k>[|<relations>]";
+    char *tname = strchr(arg, '|');
+    char *num = tname ? strchr(tname + 1, '|') : NULL;
+    if (!num) { buf_printf(r, "ERR usage: %s\n", usage); return; }
+    *tname++ = '\0';
+    *num++ = '\0';
+    char *labels = strchr(num, '|');
+    if (labels) *labels++ = '\0';
+    char *end;
+    long limit = strtol(num, &end, 10);
+    if (end == num || limit <= 0 || limit > QUERY_MAX) { buf_printf(r, "ERR %s must be 1..%d\n", all ? "max hops" : "k", QUERY_MAX); return; }
+    kg_trim(arg); kg_trim(tname);
+    kg_entity_t *s = resolve(arg), *t = resolve(tname);
+    if (!s) { buf_printf(r, "ERR source not found\n"); return; }
+    if (!t) { buf_printf(r, "ERR target not found\n"); return; }
+
+    kg_label_filter_t filter, *f = NULL;
+    if (labels && labels[strspn(labels, " \t")]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, labels, bad, sizeof(bad));
+        if (fst == KG_ERR_NOT_FOUND) { buf_printf(r, "ERR unknown relation: %s\n", bad); return; }
+        if (fst != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(fst)); return; }
+        f = &filter;
+    }
+    buf_t out = { 0 };
+    size_t n = 0;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = all ? kg_simple_paths(gGraph, s, t, f, (unsigned)limit, QUERY_MAX, put_path, &out, &n)
+                         : kg_k_shortest_paths(gGraph, s, t, f, (size_t)limit, kg_graph_weighted(gGraph), put_path, &out, &n);
+    kg_metrics_record(&gMetrics, KG_OP_PATH, t0, st == KG_OK);
+    if (f) kg_label_filter_free(f);
+    if (st != KG_OK) buf_printf(r, "ERR %s\n", kg_strerror(st));
+    else {
+        buf_printf(r, "OK %zu\n", n);
+        buf_append(r, out.p, out.len);
+    }
+    buf_free(&out);
+}
+
+/* Over every relation the load-time index answers while no ADD has
+   outdated it; anything else is computed for the request. */
+static void cmd_cycles(buf_t *r, const char *arg) {
+    kg_label_filter_t filter, *f = NULL;
+    if (arg[0]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, arg, bad, sizeof(bad));
+        if (fst == KG_ERR_NOT_FOUND) { buf_printf(r, "ERR unknown relation: %s\n", bad); return; }
+        if (fst != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(fst)); return; }
+        f = &filter;
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_scc_t *own = NULL;
+    pthread_rwlock_rdlock(&gReachLock);
+    const kg_scc_t *c = !f && gReach && kg_reach_is_current(gReach) ? gReach->scc : NULL;
+    kg_status_t st = KG_OK;
+    if (!c) {
+        kg_snapshot_t snap;
+        st = kg_snapshot_acquire(gGraph, &snap);
+        if (st == KG_OK) {
+            st = kg_scc_build(&snap, f, &own);
+            kg_snapshot_release(&snap);
+        }
+        c = own;
+    }
+    unsigned *ids = NULL;
+    size_t n = 0;
+    if (st == KG_OK) st = kg_scc_cycles(c, &ids, &n);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (f) kg_label_filter_free(f);
+    if (st != KG_OK) {
+        pthread_rwlock_unlock(&gReachLock);
+        kg_scc_free(own);
+        buf_printf(r, "ERR %s\n", kg_strerror(st));
+        return;
+    }
+    if (n > QUERY_MAX) n = QUERY_MAX;
+    buf_printf(r, "OK %zu\n", n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t size = kg_scc_size(c, ids[i]);
+        const unsigned *m = c->members + c->member_row[ids[i]];
+        buf_printf(r, "%zu", size);
+        for (size_t k = 0; k < size; ++k) buf_printf(r, "|%s", kg_entity_at(gGraph, m[k])->name);
+        buf_printf(r, "\n");
+    }
+    pthread_rwlock_unlock(&gReachLock);   /* c may be gReach->scc */
+    free(ids);
+    kg_scc_free(own);
+}
+
+static void cmd_ego(buf_t *r, char *arg) {
+    const char *usage = "EGO <entity>|<hops>[|out|in|both[|<relations>]]";
+    char *num = strchr(arg, '|');
+    if (!num) { buf_printf(r, "ERR usage: %s\n", usage); return; }
+    *num++ = '\0';
+    char *dir = strchr(num, '|');
+    if (dir) *dir++ = '\0';
+    char *labels = dir ? strchr(dir, '|') : NULL;
+    if (labels) *labels++ = '\0';
+    kg_ego_opts_t o;
+    kg_ego_defaults(&o);
+    o.max_nodes = QUERY_MAX;
+    char *end;
+    long hops = strtol(num, &end, 10);
+    if (end == num || hops < 0 || hops > QUERY_MAX) { buf_printf(r, "ERR hops must be 0..%d\n", QUERY_MAX); return; }
+    o.hops = (unsigned)hops;
+    if (dir) {
+        kg_trim(dir);
+        if (!*dir || strcmp(dir, "out") == 0) o.dir = KG_EGO_OUT;
+        else if (strcmp(dir, "in") == 0) o.dir = KG_EGO_IN;
+        else if (strcmp(dir, "both") == 0) o.dir = KG_EGO_BOTH;
+        else { buf_printf(r, "ERR usage: %s\n", usage); return; }
+    }
+    kg_trim(arg);
+    kg_entity_t *e = resolve(arg);
+    if (!e) { buf_printf(r, "ERR entity not found\n"); return; }
+
+    kg_label_filter_t filter;
+    if (labels && labels[strspn(labels, " \t")]) {
+        char bad[KG_REL_LEN];
+        kg_status_t fst = kg_label_filter_parse(gGraph, &filter, labels, bad, sizeof(bad));
+        if (fst == KG_ERR_NOT_FOUND) { buf_printf(r, "ERR unknown relation: %s\n", bad); return; }
+        if (fst != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(fst)); return; }
+        o.f = &filter;
+    }
+    kg_ego_t ego;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_ego_extract(gGraph, e, &o, &ego);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (o.f) kg_label_filter_free(&filter);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    buf_printf(r, "OK %zu\n", ego.n_edges);
+    for (size_t i = 0; i < ego.n_edges; ++i) {
+        const kg_relation_t *x = ego.edges[i].rel;
+        if (x->weight == 1.0f) buf_printf(r, "%s|%s|%s\n", ego.edges[i].src->name, x->rel, x->target->name);
+        else buf_printf(r, "%s|%s|%s|%g\n", ego.edges[i].src->name, x->rel, x->target->name, (double)x->weight);
+    }
+    kg_ego_free(&ego);
+}
+
+/* The load-time index serves the default relations while no ADD has
+   outdated it; anything else is built for the request. *own is what the
+   caller frees. */
+static const kg_topo_t *topo_for(buf_t *r, const char *spec, kg_topo_t **own) {
+    *own = NULL;
+    if (!spec[strspn(spec, " \t")] && gTopo && kg_topo_is_current(gTopo)) return gTopo;
+    char bad[KG_REL_LEN];
+    kg_topo_rels_t rels;
+    kg_status_t st = kg_topo_rels_parse(gGraph, spec, &rels, bad, sizeof(bad));
+    if (st == KG_ERR_NOT_FOUND) { buf_printf(r, "ERR unknown relation: %s\n", bad); return NULL; }
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return NULL; }
+    kg_snapshot_t snap;
+    st = kg_snapshot_acquire(gGraph, &snap);
+    if (st == KG_OK) {
+        st = kg_topo_build(&snap, &rels, own);
+        kg_snapshot_release(&snap);
+    }
+    kg_topo_rels_free(&rels);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return NULL; }
+    return *own;
+}
+
+static void cmd_order(buf_t *r, const char *arg) {
+    unsigned long t0 = kg_now_ns();
+    kg_topo_t *own;
+    const kg_topo_t *t = topo_for(r, arg, &own);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, t != NULL);
+    if (!t) return;
+    size_t n = t->n_ordered < QUERY_MAX ? t->n_ordered : QUERY_MAX;
+    size_t nc = t->n_cycles < QUERY_MAX ? t->n_cycles : QUERY_MAX;
+    buf_printf(r, "OK %zu\n", n + nc);
+    for (size_t i = 0; i < n; ++i) buf_printf(r, "%s\n", kg_entity_at(gGraph, t->order[i])->name);
+    for (size_t k = 0; k < nc; ++k) {
+        buf_printf(r, "cycle");
+        for (size_t i = t->cycle_row[k]; i < t->cycle_row[k + 1]; ++i)
+            buf_printf(r, "|%s", kg_entity_at(gGraph, t->cycle[i])->name);
+        buf_printf(r, "\n");
+    }
+    kg_topo_free(own);
+}
+
+static void cmd_prereqs(buf_t *r, char *arg) {
+    char *spec = strchr(arg, '|');
+    if (spec) *spec++ = '\0';
+    kg_trim(arg);
+    kg_entity_t *e = resolve(arg);
+    if (!e) { buf_printf(r, "ERR entity not found\n"); return; }
+
+    unsigned long t0 = kg_now_ns();
+    kg_topo_t *own;
+    const kg_topo_t *t = topo_for(r, spec ? spec : "", &own);
+    unsigned *ids = NULL;
+    size_t n = 0;
+    kg_status_t st = t ? kg_topo_prerequisites(t, e, &ids, &n) : KG_ERR_INVALID;
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    kg_topo_free(own);
+    if (!t) return;
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    if (n > QUERY_MAX) n = QUERY_MAX;
+    buf_printf(r, "OK %zu\n", n);
+    for (size_t i = 0; i < n; ++i) buf_printf(r, "%s\n", kg_entity_at(gGraph, ids[i])->name);
+    free(ids);
+}
+
+static void put_ranked(buf_t *r, const kg_rank_t *rank, size_t k, const unsigned *skip, size_t n_skip) {
+    unsigned *ids = NULL;
+    size_t n = 0;
+    kg_status_t st = kg_rank_top(rank, k, skip, n_skip, &ids, &n);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    buf_printf(r, "OK %zu\n", n);
+    for (size_t i = 0; i < n; ++i) buf_printf(r, "%s|%.6g\n", kg_entity_at(gGraph, ids[i])->name, rank->score[ids[i]]);
+    free(ids);
+}
+
+static kg_status_t pagerank(const unsigned *seeds, size_t n_seeds, kg_rank_t **out) {
+    kg_rank_opts_t o;
+    kg_rank_defaults(&o);
+    o.seeds = seeds;
+    o.n_seeds = n_seeds;
+    kg_snapshot_t snap;
+    kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+    if (st != KG_OK) return st;
+    st = kg_pagerank(&snap, &o, out);
+    kg_snapshot_release(&snap);
+    return st;
+}
+
+static void cmd_pagerank(buf_t *r, const char *arg) {
+    long k = QUERY_MAX;
+    if (arg[0]) {
+        char *end;
+        k = strtol(arg, &end, 10);
+        if (end == arg || *end || k < 0 || k > QUERY_MAX) { buf_printf(r, "ERR k must be 0..%d\n", QUERY_MAX); return; }
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_rank_t *rank;
+    kg_status_t st = pagerank(NULL, 0, &rank);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    kg_set_scores(gGraph, rank->score, rank->n, rank->version);
+    put_ranked(r, rank, (size_t)k, NULL, 0);
+    kg_rank_free(rank);
+}
+
+static void cmd_ppr(buf_t *r, char *arg) {
+    unsigned seeds[SEED_MAX];
+    size_t n_seeds = 0;
+    for (char *p = arg; p; ) {
+        char *next = strchr(p, '|');
+        if (next) *next++ = '\0';
+        kg_trim(p);
+        if (n_seeds == SEED_MAX) { buf_printf(r, "ERR at most %d entities\n", SEED_MAX); return; }
+        kg_entity_t *e = resolve(p);
+        if (!e) { buf_printf(r, "ERR entity not found: %s\n", p); return; }
+        seeds[n_seeds++] = e->id;
+        p = next;
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_rank_t *rank;
+    kg_status_t st = pagerank(seeds, n_seeds, &rank);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    put_ranked(r, rank, QUERY_MAX, seeds, n_seeds);
+    kg_rank_free(rank);
+}
+
+static void cmd_centrality(buf_t *r, const char *arg) {
+    kg_central_opts_t o;
+    kg_central_defaults(&o);
+    o.samples = CENTRAL_SAMPLES;
+    if (arg[0]) {
+        char *end;
+        long k = strtol(arg, &end, 10);
+        if (end == arg || *end || k < 1) { buf_printf(r, "ERR samples must be at least 1\n"); return; }
+        o.samples = (size_t)k;
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_central_t *c = NULL;
+    kg_snapshot_t snap;
+    kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+    if (st == KG_OK) {
+        st = kg_centrality(&snap, &o, &c);
+        kg_snapshot_release(&snap);
+    }
+    unsigned *ids = NULL;
+    size_t n = 0;
+    if (st == KG_OK) st = kg_top_scores(c->betweenness, c->n, QUERY_MAX, NULL, 0, &ids, &n);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (st != KG_OK) { kg_central_free(c); buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    buf_printf(r, "OK %zu\n%zu|%.6g\n", n + 1, c->sources, c->error);
+    for (size_t i = 0; i < n; ++i)
+        buf_printf(r, "%s|%.6g|%.6g\n", kg_entity_at(gGraph, ids[i])->name, c->betweenness[ids[i]], c->closeness[ids[i]]);
+    free(ids);
+    kg_central_free(c);
+}
+
+static void cmd_search(buf_t *r, const char *arg) {
+    kg_entity_t *cand[SEARCH_MAX]; int n = 0;
+    unsigned long t0 = kg_now_ns();
+    kg_search(gGraph, arg, cand, SEARCH_MAX, &n);
+    kg_metrics_record(&gMetrics, KG_OP_SEARCH, t0, n > 0);
+    buf_printf(r, "OK %d\n", n);
+    for (int i = 0; i < n; ++i) buf_printf(r, "%s\n", cand[i]->name);
+}
+
+static void cmd_add(buf_t *r, char *arg) {
+    char src[KG_NAME_LEN], rel[KG_REL_LEN], tgt[KG_NAME_LEN];
+    double w;
+    if (!kg_parse_relation_line_weighted(arg, src, rel, tgt, &w)) {
+        buf_printf(r, "ERR usage: ADD <source>|<relation>|<target>[|<weight>]\n");
+        return;
+    }
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_add_edge_weighted(gGraph, src, rel, tgt, w, NULL);
+    kg_metrics_record(&gMetrics, KG_OP_ADD, t0, st == KG_OK);
+    if (st != KG_OK) buf_printf(r, "ERR %s\n", kg_strerror(st));
+    else buf_printf(r, "OK 0\n");
+}
+
+/* The index describes the graph as loaded; after an ADD its bounds may
+   be wrong, so DIST refuses rather than guess. */
+static void cmd_dist(buf_t *r, char *arg) {
+    if (!gAlt) { buf_printf(r, "ERR no landmark index (start with -L <k>)\n"); return; }
+    char *bar = strchr(arg, '|');
+    if (!bar) { buf_printf(r, "ERR usage: DIST <source>|<target>\n"); return; }
+    *bar = '\0';
+    kg_trim(arg); kg_trim(bar + 1);
+    kg_entity_t *s = resolve(arg), *t = resolve(bar + 1);
+    if (!s) { buf_printf(r, "ERR source not found\n"); return; }
+    if (!t) { buf_printf(r, "ERR target not found\n"); return; }
+    if (!kg_alt_is_current(gAlt)) { buf_printf(r, "ERR landmark index is stale\n"); return; }
+    double lo, hi;
+    unsigned long t0 = kg_now_ns();
+    kg_alt_estimate(gAlt, s, t, &lo, &hi);
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, 1);
+    buf_printf(r, "OK 1\n%g|%g\n", lo, hi);
+}
+
+static void cmd_connected(buf_t *r, char *arg) {
+    char *bar = strchr(arg, '|');
+    if (!bar) { buf_printf(r, "ERR usage: CONNECTED <a>|<b>\n"); return; }
+    *bar = '\0';
+    kg_trim(arg); kg_trim(bar + 1);
+    kg_entity_t *a = resolve(arg), *b = resolve(bar + 1);
+    if (!a || !b) { buf_printf(r, "ERR entity not found\n"); return; }
+    unsigned long t0 = kg_now_ns();
+    int linked = kg_connected(gGraph, a, b);
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, 1);
+    if (linked) buf_printf(r, "OK 1\nyes|%zu\n", kg_component_size(gGraph, a));
+    else buf_printf(r, "OK 1\nno\n");
+}
+
+static void cmd_reach(buf_t *r, char *arg) {
+    char *bar = strchr(arg, '|');
+    if (!bar) { buf_printf(r, "ERR usage: REACH <source>|<target>\n"); return; }
+    *bar = '\0';
+    kg_trim(arg); kg_trim(bar + 1);
+    kg_entity_t *s = resolve(arg), *t = resolve(bar + 1);
+    if (!s) { buf_printf(r, "ERR source not found\n"); return; }
+    if (!t) { buf_printf(r, "ERR target not found\n"); return; }
+    unsigned long t0 = kg_now_ns();
+    kg_reach_answer_t a = reach_query(s, t);
+    if (a == KG_REACH_UNKNOWN && !kg_connected(gGraph, s, t)) a = KG_REACH_NO;   /* e.g. no memory to rebuild */
+    kg_metrics_record(&gMetrics, KG_OP_LOOKUP, t0, a != KG_REACH_UNKNOWN);
+    buf_printf(r, "OK 1\n%s\n", a == KG_REACH_YES ? "yes" : a == KG_REACH_NO ? "no" : "unknown");
+}
+
+/* The path expression may itself contain '|', so it comes last and is
+   split off only after the names before it. */
+static void cmd_rpq(buf_t *r, char *arg, int with_target) {
+    const char *usage = with_target ? "RPQPATH <source>|<target>|<path>" : "RPQ <source>|<path>";
+    char *expr = strchr(arg, '|'), *tname = NULL;
+    if (expr && with_target) { tname = expr + 1; *expr = '\0'; expr = strchr(tname, '|'); }
+    if (!expr) { buf_printf(r, "ERR usage: %s\n", usage); return; }
+    *expr++ = '\0';
+    kg_trim(arg);
+    if (tname) kg_trim(tname);
+    kg_entity_t *s = resolve(arg), *t = tname ? resolve(tname) : NULL;
+    if (!s) { buf_printf(r, "ERR source not found\n"); return; }
+    if (tname && !t) { buf_printf(r, "ERR target not found\n"); return; }
+
+    char err[256];
+    kg_rpq_t *q;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_rpq_compile(gGraph, expr, &q, err, sizeof(err));
+    if (st != KG_OK) {
+        kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, 0);
+        buf_printf(r, "ERR %s\n", st == KG_ERR_NOMEM ? kg_strerror(st) : err);
+        return;
+    }
+    kg_rpq_result_t res;
+    st = kg_rpq_eval(gGraph, q, s, t, QUERY_MAX, with_target, &res);
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    kg_rpq_free(q);
+    if (st != KG_OK) { buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    if (!with_target) {
+        buf_printf(r, "OK %zu\n", res.n);
+        for (size_t i = 0; i < res.n; ++i) buf_printf(r, "%s|%zu\n", res.nodes[i]->name, res.hops[i]);
+    } else {
+        kg_rpq_path_t p;
+        st = kg_rpq_witness(&res, 0, &p);
+        if (st != KG_OK) { kg_rpq_result_free(&res); buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+        buf_printf(r, "OK %zu\n%s\n", p.len + 1, p.nodes[0]->name);
+        for (size_t k = 0; k < p.len; ++k) buf_printf(r, "%s|%s\n", p.rels[k]->rel, p.nodes[k + 1]->name);
+        kg_rpq_path_free(&p);
+    }
+    kg_rpq_result_free(&res);
+}
+
+static int triples_stale(void) {
+    pthread_rwlock_rdlock(&gTriplesLock);
+    int stale = !gTriples || !kg_triples_is_current(gTriples);
+    pthread_rwlock_unlock(&gTriplesLock);
+    return stale;
+}
+
+/* Current indexes on KG_OK. A build that fails leaves the old ones. */
+static kg_status_t refresh_triples(void) {
+    if (!triples_stale()) return KG_OK;
+    pthread_mutex_lock(&gTriplesBuild);
+    kg_status_t st = KG_OK;
+    if (triples_stale()) {              /* not already rebuilt while we waited */
+        kg_snapshot_t snap;
+        kg_triples_t *fresh = NULL, *old;
+        st = kg_snapshot_acquire(gGraph, &snap);
+        if (st == KG_OK) {
+            st = kg_triples_build(&snap, KG_TRIPLES_ALL_ORDERS, &fresh);
+            kg_snapshot_release(&snap);
+        }
+        if (st == KG_OK) {
+            pthread_rwlock_wrlock(&gTriplesLock);
+            old = gTriples; gTriples = fresh;
+            pthread_rwlock_unlock(&gTriplesLock);
+            kg_triples_free(old);
+        }
+    }
+    pthread_mutex_unlock(&gTriplesBuild);
+    return st;
+}
+
+/* plan_fp: EXPLAIN wants the plan table there. */
+static void cmd_query(buf_t *r, const char *arg, FILE *plan_fp) {
+    char err[256];
+    kg_query_t *q;
+    unsigned long t0 = kg_now_ns();
+    kg_status_t st = kg_query_parse(gGraph, arg, &q, err, sizeof(err));
+    if (st != KG_OK) {
+        kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, 0);
+        buf_printf(r, "ERR %s\n", st == KG_ERR_NOMEM ? kg_strerror(st) : err);
+        return;
+    }
+    kg_query_result_t res = { 0 };
+    kg_query_plan_t plan;
+    st = refresh_triples();
+    if (st == KG_OK) {
+        pthread_rwlock_rdlock(&gTriplesLock);
+        st = kg_query_explain(gTriples, q, kg_query_is_cyclic(q), QUERY_MAX, plan_fp ? &plan : NULL, &res);
+        pthread_rwlock_unlock(&gTriplesLock);
+    }
+    kg_metrics_record(&gMetrics, KG_OP_QUERY, t0, st == KG_OK);
+    if (st != KG_OK) { kg_query_free(q); buf_printf(r, "ERR %s\n", kg_strerror(st)); return; }
+    if (plan_fp) {
+        kg_query_plan_print(gGraph, q, &plan, plan_fp);
+        kg_query_plan_free(&plan);
+    }
+    buf_printf(r, "OK %zu\n", res.n_rows + 1);
+    for (size_t v = 0; v < q->n_vars; ++v) buf_printf(r, "%s?%s", v ? "|" : "", q->vars[v]);
+    buf_printf(r, "\n");
+    for (size_t i = 0; i < res.n_rows; ++i) {
+        for (size_t v = 0; v < q->n_vars; ++v) buf_printf(r, "%s%s", v ? "|" : "", kg_query_value(gGraph, q, &res, i, v));
+        buf_printf(r, "\n");
+    }
+    kg_query_result_free(&res);
+    kg_query_free(q);
+}
+
+/* Prometheus text, comment lines included, counted like any payload. */
+static void cmd_stats(buf_t *r) {
+    char *text = NULL; size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    if (!fp) { buf_printf(r, "ERR %s\n", kg_strerror(KG_ERR_NOMEM)); return; }
+    kg_metrics_prometheus(&gMetrics, gGraph, fp);
+    if (gPathCache) {
+        const kg_path_cache_stats_t *pc = &gPathCache->stats;
+        fprintf(fp, "# TYPE kg_path_cache_hits_total counter\nkg_path_cache_hits_total %lu\n", pc->hits);
+        fprintf(fp, "# TYPE kg_path_cache_misses_total counter\nkg_path_cache_misses_total %lu\n", pc->misses);
+        fprintf(fp, "# TYPE kg_path_cache_stale_total counter\nkg_path_cache_stale_total %lu\n", pc->stale);
+        fprintf(fp, "# TYPE kg_path_cache_evictions_total counter\nkg_path_cache_evictions_total %lu\n", pc->evictions);
+        fprintf(fp, "# TYPE kg_path_cache_hit_ratio gauge\nkg_path_cache_hit_ratio %.4f\n", kg_path_cache_hit_rate(gPathCache));
+    }
+    fclose(fp);
+    size_t n = 0;
+    for (size_t i = 0; i < len; ++i) n += text[i] == '\n';
+    buf_printf(r, "OK %zu\n", n);
+    buf_append(r, text, len);
+    free(text);
+}
+
+static void execute_line(buf_t *r, char *line);
+
+/* The request's own reply is dropped except for its first line. */
+static void cmd_explain(buf_t *r, char *arg) {
+    if (strncmp(arg, "EXPLAIN", 7) == 0) { buf_printf(r, "ERR nested EXPLAIN\n"); return; }
+    buf_t inner = { 0 };
+    char *plan = NULL; size_t plan_len = 0;
+    FILE *plan_fp = NULL;
+    if (strncmp(arg, "QUERY ", 6) == 0 && !(plan_fp = open_memstream(&plan, &plan_len))) {
+        buf_printf(r, "ERR %s\n", kg_strerror(KG_ERR_NOMEM));
+        return;
+    }
+    kg_profile_t prof;
+    kg_profile_begin(&prof);
+    unsigned long t0 = kg_now_ns();
+    if (plan_fp) cmd_query(&inner, arg + 6, plan_fp);
+    else execute_line(&inner, arg);
+    unsigned long total = kg_now_ns() - t0;
+    kg_profile_end();
+    if (plan_fp) fclose(plan_fp);
+
+    char *text = NULL; size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    if (!fp) { buf_free(&inner); free(plan); buf_printf(r, "ERR %s\n", kg_strerror(KG_ERR_NOMEM)); return; }
+    size_t first = inner.p ? strcspn(inner.p, "\n") : 0;
+    fprintf(fp, "result: %.*s\n", (int)first, inner.p ? inner.p : "");
+    kg_metrics_explain(&prof, total, fp);
+    if (plan) fwrite(plan, 1, plan_len, fp);
+    fclose(fp);
+    buf_free(&inner);
+    free(plan);
+
+    size_t n = 0;
+    for (size_t i = 0; i < len; ++i) n += text[i] == '\n';
+    buf_printf(r, "OK %zu\n", n);
+    buf_append(r, text, len);
+    free(text);
+}
+
+static void execute_line(buf_t *r, char *line) {
+    line[strcspn(line, "\r")] = '\0';
+    char *arg = line + strcspn(line, " ");
+    if (*arg) *arg++ = '\0';
+    kg_trim(arg);
+
+    if (strcmp(line, "PING") == 0) buf_printf(r, "OK 0\n");
+    else if (strcmp(line, "ADD") == 0) cmd_add(r, arg);
+    else if (strcmp(line, "NEIGHBORS") == 0) cmd_neighbors(r, arg);
+    else if (strcmp(line, "PATH") == 0) cmd_path(r, arg, 0);
+    else if (strcmp(line, "WPATH") == 0) cmd_path(r, arg, 1);
+    else if (strcmp(line, "DIST") == 0) cmd_dist(r, arg);
+    else if (strcmp(line, "REACH") == 0) cmd_reach(r, arg);
+    else if (strcmp(line, "CONNECTED") == 0) cmd_connected(r, arg);
+    else if (strcmp(line, "KPATHS") == 0) cmd_paths(r, arg, 0);
+    else if (strcmp(line, "ALLPATHS") == 0) cmd_paths(r, arg, 1);
+    else if (strcmp(line, "CYCLES") == 0) cmd_cycles(r, arg);
+    else if (strcmp(line, "EGO") == 0) cmd_ego(r, arg);
+    else if (strcmp(line, "ORDER") == 0) cmd_order(r, arg);
+    else if (strcmp(line, "PREREQS") == 0) cmd_prereqs(r, arg);
+    else if (strcmp(line, "PAGERANK") == 0) cmd_pagerank(r, arg);
+    else if (strcmp(line, "PPR") == 0) cmd_ppr(r, arg);
+    else if (strcmp(line, "CENTRALITY") == 0) cmd_centrality(r, arg);
+    else if (strcmp(line, "RPQ") == 0) cmd_rpq(r, arg, 0);
+    else if (strcmp(line, "RPQPATH") == 0) cmd_rpq(r, arg, 1);
+    else if (strcmp(line, "QUERY") == 0) cmd_query(r, arg, NULL);
+    else if (strcmp(line, "SEARCH") == 0) cmd_search(r, arg);
+    else if (strcmp(line, "STATS") == 0) cmd_stats(r);
+    else if (strcmp(line, "EXPLAIN") == 0) cmd_explain(r, arg);
+    else buf_printf(r, "ERR unknown command\n");
+}
+
+static void *worker_main(void *unused) {
+    (void)unused;
+    for (;;) {
+        pthread_mutex_lock(&gQueueLock);
+        while (!gQueueHead && !gStop) pthread_cond_wait(&gQueueCond, &gQueueLock);
+        if (!gQueueHead) { pthread_mutex_unlock(&gQueueLock); return NULL; }
+        conn_t *c = gQueueHead;
+        gQueueHead = c->qnext;
+        if (!gQueueHead) gQueueTail = NULL;
+        pthread_mutex_unlock(&gQueueLock);
+
+        /* job holds whole lines only; each ends in '\n' */
+        char *p = c->job.p, *end = c->job.p + c->job.len;
+        while (p < end) {
+            char *nl = memchr(p, '\n', (size_t)(end - p));
+            *nl = '\0';
+            execute_line(&c->resp, p);
+            p = nl + 1;
+        }
+        c->job.len = 0;
+
+        pthread_mutex_lock(&gQueueLock);
+        c->qnext = gDone;
+        gDone = c;
+        pthread_mutex_unlock(&gQueueLock);
+        uint64_t one = 1;
+        if (write(gWakeFd, &one, sizeof(one)) < 0) { /* loop polls gDone anyway */ }
+    }
+}
+
+/*
+   [SECTION] Event Loop (socket I/O, dispatch, completion)
+ */
+
+static void conn_free(conn_t *c) {
+    close(c->fd);
+    buf_free(&c->in); buf_free(&c->out); buf_free(&c->job); buf_free(&c->resp);
+    free(c);
+}
+
+/* With nothing to wait for the fd leaves epoll altogether: after a full
+   peer close EPOLLHUP is reported whatever the mask, and would wake the
+   loop on every round until the worker is done. */
+static void update_interest(int ep, conn_t *c) {
+    struct epoll_event ev = {
+        .events = (c->eof ? 0u : (unsigned)EPOLLIN) | (c->want_out ? (unsigned)EPOLLOUT : 0u),
+        .data.ptr = c
+    };
+    if (!ev.events) {
+        if (c->polled) epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+        c->polled = 0;
+    } else if (c->polled) epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+    else if (epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev) == 0) c->polled = 1;
+}
+
+static void set_out_interest(int ep, conn_t *c, int want) {
+    if (c->want_out == want) return;
+    c->want_out = want;
+    update_interest(ep, c);
+}
+
+/* Returns 0 if the peer is gone. */
+static int flush_out(int ep, conn_t *c) {
+    while (c->out_off < c->out.len) {
+        ssize_t n = write(c->fd, c->out.p + c->out_off, c->out.len - c->out_off);
+        if (n > 0) { c->out_off += (size_t)n; continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { set_out_interest(ep, c, 1); return 1; }
+        return 0;
+    }
+    c->out.len = c->out_off = 0;
+    set_out_interest(ep, c, 0);
+    return 1;
+}
+
+/* Hand every complete line buffered on `c` to the pool as one batch. */
+static void dispatch(conn_t *c) {
+    if (c->busy || c->closing || c->out.len - c->out_off > OUT_HIGH_WATER) return;
+    char *last_nl = NULL;
+    for (size_t i = c->in.len; i-- > 0; ) if (c->in.p[i] == '\n') { last_nl = c->in.p + i; break; }
+    if (!last_nl) return;
+
+    size_t n = (size_t)(last_nl - c->in.p) + 1;
+    if (!buf_append(&c->job, c->in.p, n)) return;
+    memmove(c->in.p, c->in.p + n, c->in.len - n);
+    c->in.len -= n;
+
+    c->busy = 1;
+    c->qnext = NULL;
+    pthread_mutex_lock(&gQueueLock);
+    if (gQueueTail) gQueueTail->qnext = c; else gQueueHead = c;
+    gQueueTail = c;
+    pthread_cond_signal(&gQueueCond);
+    pthread_mutex_unlock(&gQueueLock);
+}
+
+/* Later events of the same epoll_wait batch may still name a closed
+   conn, so it is only marked dead here and freed after the batch. */
+static void retire_conn(conn_t *c) {
+    c->dead = 1;
+    c->qnext = gDead;
+    gDead = c;
+}
+
+static void close_conn(int ep, conn_t *c) {
+    if (c->closing || c->dead) return;
+    if (c->polled) epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    c->polled = 0;
+    if (c->busy) c->closing = 1;     /* retired when the worker hands it back */
+    else retire_conn(c);
+}
+
+/* After a half-close, answer everything that was sent, then hang up.
+   Returns 1 if the connection was closed. */
+static int finish_if_drained(int ep, conn_t *c) {
+    if (!c->eof || c->busy || c->out_off < c->out.len) return 0;
+    if (memchr(c->in.p, '\n', c->in.len)) return 0;
+    close_conn(ep, c);
+    return 1;
+}
+
+static void on_readable(int ep, conn_t *c) {
+    for (;;) {
+        if (!buf_reserve(&c->in, READ_CHUNK)) { close_conn(ep, c); return; }
+        ssize_t n = read(c->fd, c->in.p + c->in.len, READ_CHUNK);
+        if (n > 0) { c->in.len += (size_t)n; continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) { close_conn(ep, c); return; }
+        c->eof = 1;                  /* EOF: stop polling for input (a busy conn
+                                        is finished by the completion path) */
+        update_interest(ep, c);
+        break;
+    }
+    dispatch(c);
+    finish_if_drained(ep, c);
+}
+
+static void on_completions(int ep) {
+    uint64_t cnt;
+    if (read(gWakeFd, &cnt, sizeof(cnt)) < 0) { /* spurious */ }
+
+    pthread_mutex_lock(&gQueueLock);
+    conn_t *c = gDone;
+    gDone = NULL;
+    pthread_mutex_unlock(&gQueueLock);
+
+    while (c) {
+        conn_t *next = c->qnext;
+        c->busy = 0;
+        if (c->closing) { retire_conn(c); c = next; continue; }
+        int ok = buf_append(&c->out, c->resp.p, c->resp.len);
+        c->resp.len = 0;
+        if (!ok || !flush_out(ep, c)) close_conn(ep, c);
+        else { dispatch(c); finish_if_drained(ep, c); }
+        c = next;
+    }
+}
+
+static void on_accept(int ep, int lfd) {
+    for (;;) {
+        int fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   /* fails harmlessly on AF_UNIX */
+        conn_t *c = (conn_t*)calloc(1, sizeof(conn_t));
+        if (!c) { close(fd); continue; }
+        c->fd = fd;
+        update_interest(ep, c);
+        if (!c->polled) conn_free(c);
+    }
+}
+
+/* [SECTION] Listener Setup */
+
+static int listen_unix(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(sa.sun_path)) { close(fd); errno = ENAMETOOLONG; return -1; }
+    strcpy(sa.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0 || listen(fd, DEFAULT_BACKLOG) < 0) {
+        close(fd); return -1;
+    }
+    return fd;
+}
+
+static int listen_tcp(const char *host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &sa.sin_addr) != 1) { close(fd); errno = EINVAL; return -1; }
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0 || listen(fd, DEFAULT_BACKLOG) < 0) {
+        close(fd); return -1;
+    }
+    return fd;
+}
+
+static void on_signal(int sig) { (void)sig; gStop = 1; }
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s (-u <socket path> | -p <port> [-b <addr>]) [-f <relations file>] [-t <threads>]\n"
+        "          [-m <metrics file written on SIGUSR1>] [-L <landmarks>]\n"
+        "          [-c <path cache entries, 0 = off>]\n", prog);
+}
+
+/*
+   [SECTION] Main
+ */
+int main(int argc, char **argv) {
+    const char *upath = NULL, *file = NULL, *bind_addr = "127.0.0.1", *metrics = DEFAULT_METRICS;
+    int port = 0, nthreads = DEFAULT_THREADS, landmarks = 0, cache = DEFAULT_PATH_CACHE, opt;
+
+    while ((opt = getopt(argc, argv, "u:p:b:f:t:m:L:c:h")) != -1) {
+        switch (opt) {
+        case 'u': upath = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'b': bind_addr = optarg; break;
+        case 'f': file = optarg; break;
+        case 't': nthreads = atoi(optarg); break;
+        case 'm': metrics = optarg; break;
+        case 'L': landmarks = atoi(optarg); break;
+        case 'c': cache = atoi(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if ((!upath && port <= 0) || nthreads <= 0 || landmarks < 0 || cache < 0) { usage(argv[0]); return 2; }
+
+    gGraph = kg_graph_new();
+    if (!gGraph || (cache > 0 && kg_path_cache_new((size_t)cache, &gPathCache) != KG_OK)) {
+        fprintf(stderr, "Memory allocation failed\n"); return 1;
+    }
+    /* Before any other thread exists, so they all inherit the blocked mask. */
+    if (kg_metrics_dump_on_signal(&gMetrics, gGraph, metrics, SIGUSR1) != KG_OK) {
+        fprintf(stderr, "cannot start metrics thread\n"); return 1;
+    }
+    if (file) {
+        kg_load_stats_t ls;
+        unsigned long t0 = kg_now_ns();
+        kg_status_t st = kg_load_file(gGraph, file, &ls, NULL, NULL);
+        kg_metrics_record(&gMetrics, KG_OP_LOAD, t0, st == KG_OK);
+        if (st != KG_OK) { fprintf(stderr, "load '%s': %s\n", file, kg_strerror(st)); return 1; }
+        fprintf(stderr, "loaded %d relations (skipped %d), %zu entities\n",
+                ls.loaded, ls.skipped, kg_entity_count(gGraph));
+    }
+    if (kg_entity_count(gGraph) > 0) {
+        kg_snapshot_t snap;
+        unsigned long t0 = kg_now_ns();
+        kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+        if (st == KG_OK) {
+            st = kg_reach_build(&snap, 0, 0, &gReach);
+            kg_snapshot_release(&snap);
+        }
+        if (st != KG_OK) { fprintf(stderr, "reachability: %s\n", kg_strerror(st)); return 1; }
+        fprintf(stderr, "reachability index: %zu components, %.1f MiB, built in %.1f ms\n", gReach->scc->n_comps,
+                (double)kg_reach_bytes(gReach) / (1024.0 * 1024.0), (double)(kg_now_ns() - t0) / 1e6);
+
+        kg_topo_rels_t rels;
+        t0 = kg_now_ns();
+        st = kg_topo_rels_parse(gGraph, NULL, &rels, NULL, 0);
+        if (st == KG_OK) st = kg_snapshot_acquire(gGraph, &snap);
+        if (st == KG_OK) {
+            st = kg_topo_build(&snap, &rels, &gTopo);
+            kg_snapshot_release(&snap);
+        }
+        kg_topo_rels_free(&rels);
+        if (st != KG_OK) { fprintf(stderr, "dependency order: %s\n", kg_strerror(st)); return 1; }
+        fprintf(stderr, "dependency order: %zu of %zu entities ordered, %zu cycles, built in %.1f ms\n",
+                gTopo->n_ordered, gTopo->n_involved, gTopo->n_cycles, (double)(kg_now_ns() - t0) / 1e6);
+
+        kg_rank_t *rank;
+        t0 = kg_now_ns();
+        st = pagerank(NULL, 0, &rank);
+        if (st != KG_OK) { fprintf(stderr, "pagerank: %s\n", kg_strerror(st)); return 1; }
+        kg_set_scores(gGraph, rank->score, rank->n, rank->version);
+        fprintf(stderr, "pagerank: %u iterations on %u threads, %.1f ms\n", rank->iterations, rank->threads,
+                (double)(kg_now_ns() - t0) / 1e6);
+        kg_rank_free(rank);
+    }
+    {
+        unsigned long t0 = kg_now_ns();
+        kg_status_t st = refresh_triples();
+        if (st != KG_OK) { fprintf(stderr, "triple index: %s\n", kg_strerror(st)); return 1; }
+        fprintf(stderr, "triple index: %zu triples, %.1f MiB, built in %.1f ms\n", gTriples->n,
+                (double)kg_triples_bytes(gTriples) / (1024.0 * 1024.0), (double)(kg_now_ns() - t0) / 1e6);
+    }
+    if (landmarks > 0 && kg_entity_count(gGraph) > 0) {
+        kg_snapshot_t snap;
+        unsigned long t0 = kg_now_ns();
+        kg_status_t st = kg_snapshot_acquire(gGraph, &snap);
+        if (st == KG_OK) {
+            st = kg_alt_build(&snap, (unsigned)landmarks, KG_ALT_FARTHEST, &gAlt);
+            kg_snapshot_release(&snap);
+        }
+        if (st != KG_OK) { fprintf(stderr, "landmarks: %s\n", kg_strerror(st)); return 1; }
+        fprintf(stderr, "landmark index: %u landmarks, %.1f MiB, built in %.1f ms\n", gAlt->k,
+                (double)kg_alt_bytes(gAlt) / (1024.0 * 1024.0), (double)(kg_now_ns() - t0) / 1e6);
+    }
+
+    int lfd = upath ? listen_unix(upath) : listen_tcp(bind_addr, port);
+    if (lfd < 0) { perror("listen"); return 1; }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    gWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ep < 0 || gWakeFd < 0) { perror("epoll/eventfd"); return 1; }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &lfd };
+    epoll_ctl(ep, EPOLL_CTL_ADD, lfd, &ev);
+    ev.data.ptr = &gWakeFd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, gWakeFd, &ev);
+
+    pthread_t *workers = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)nthreads);
+    if (!workers) { fprintf(stderr, "Memory allocation failed\n"); return 1; }
+    for (int i = 0; i < nthreads; ++i) pthread_create(&workers[i], NULL, worker_main, NULL);
+
+    if (upath) fprintf(stderr, "listening on unix:%s with %d workers\n", upath, nthreads);
+    else fprintf(stderr, "listening on %s:%d with %d workers\n", bind_addr, port, nthreads);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!gStop) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, -1);
+        if (n < 0) { if (errno == EINTR) continue; perror("epoll_wait"); break; }
+        for (int i = 0; i < n; ++i) {
+            void *tag = events[i].data.ptr;
+            if (tag == &lfd) { on_accept(ep, lfd); continue; }
+            if (tag == &gWakeFd) { on_completions(ep); continue; }
+            conn_t *c = (conn_t*)tag;
+            if (c->dead || c->closing) continue;
+            if (events[i].events & EPOLLOUT) {
+                if (!flush_out(ep, c)) { close_conn(ep, c); continue; }
+                dispatch(c);
+                if (finish_if_drained(ep, c)) continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) on_readable(ep, c);
+        }
+        while (gDead) {
+            conn_t *c = gDead;
+            gDead = c->qnext;
+            conn_free(c);
+        }
+    }
+
+    /* Shutdown: let workers drain, then release everything. Open
+       connections are simply dropped with the process. */
+    pthread_mutex_lock(&gQueueLock);
+    gStop = 1;
+    pthread_cond_broadcast(&gQueueCond);
+    pthread_mutex_unlock(&gQueueLock);
+    for (int i = 0; i < nthreads; ++i) pthread_join(workers[i], NULL);
+    free(workers);
+
+    close(lfd);
+    if (upath) unlink(upath);
+    close(ep);
+    close(gWakeFd);
+    kg_alt_free(gAlt);
+    kg_reach_free(gReach);
+    kg_topo_free(gTopo);
+    kg_path_cache_free(gPathCache);
+    kg_triples_free(gTriples);
+    kg_graph_free(gGraph);
+    return 0;
+}
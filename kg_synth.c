@@ -0,0 +1,173 @@
+/* =========================================================================
+   Knowledge Graph Engine — Synthetic Graph Generator (implementation)
+   ========================================================================= */
+
+#include "kg_synth.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* R-MAT quadrant probabilities (a, b, c; d is the rest), Graph500 values */
+#define RMAT_A  0.57
+#define RMAT_B  0.19
+#define RMAT_C  0.19
+
+void kg_synth_defaults(kg_synth_opts_t *o) {
+    o->model = KG_SYNTH_RMAT;
+    o->nodes = 1000;
+    o->edges = 8000;
+    o->labels = 16;
+    o->label_skew = 1.0;
+    o->seed = 42;
+    o->max_weight = 0.0;
+}
+
+/* [SECTION] Names */
+
+static const char *const SYLLABLES[32] = {
+    "ka", "lo", "mi", "ne", "ru", "sa", "te", "vo",
+    "da", "fi", "go", "hu", "ja", "ke", "li", "mo",
+    "na", "pe", "qui", "ra", "si", "to", "un", "ve",
+    "wa", "xe", "yo", "zu", "bra", "cle", "dri", "flo"
+};
+
+static const char *const REAL_LABELS[] = {
+    "Requires", "Includes", "Used for", "Has Library", "Subset of",
+    "Prerequisite for", "Needed for", "Popular for", "Required for"
+};
+#define N_REAL_LABELS (sizeof(REAL_LABELS) / sizeof(REAL_LABELS[0]))
+
+/* Base-32 digits of the id, one syllable each, a space every three:
+   a bijection, so names never collide. */
+void kg_synth_entity_name(unsigned long id, char *buf, size_t n) {
+    char tmp[KG_NAME_LEN];
+    size_t len = 0;
+    int syl = 0;
+    do {
+        const char *s = SYLLABLES[id & 31];
+        if (syl && syl % 3 == 0 && len + 1 < sizeof(tmp)) tmp[len++] = ' ';
+        for (; *s && len + 1 < sizeof(tmp); ++s) tmp[len++] = *s;
+        id >>= 5; syl++;
+    } while (id);
+    tmp[len] = '\0';
+    tmp[0] = (char)(tmp[0] - 'a' + 'A');
+    snprintf(buf, n, "%s", tmp);
+}
+
+void kg_synth_label_name(unsigned i, char *buf, size_t n) {
+    if (i < N_REAL_LABELS) snprintf(buf, n, "%s", REAL_LABELS[i]);
+    else snprintf(buf, n, "Relation %u", i);
+}
+
+/* [SECTION] Label Distribution (Zipf via cumulative table) */
+
+static double *zipf_cdf(unsigned k, double s) {
+    double *cdf = (double*)malloc(sizeof(double) * k);
+    if (!cdf) return NULL;
+    double sum = 0;
+    for (unsigned i = 0; i < k; ++i) { sum += 1.0 / pow((double)(i + 1), s); cdf[i] = sum; }
+    for (unsigned i = 0; i < k; ++i) cdf[i] /= sum;
+    return cdf;
+}
+
+static unsigned zipf_draw(const double *cdf, unsigned k, kg_rng_t *r) {
+    double u = kg_rng_unit(r);
+    unsigned lo = 0, hi = k - 1;
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* [SECTION] Edge Models */
+
+/* One R-MAT edge: descend `scale` levels picking a quadrant each time. */
+static void rmat_edge(kg_rng_t *r, unsigned scale, unsigned long *u, unsigned long *v) {
+    unsigned long row = 0, col = 0;
+    for (unsigned lvl = 0; lvl < scale; ++lvl) {
+        double p = kg_rng_unit(r);
+        row <<= 1; col <<= 1;
+        if (p < RMAT_A) { }
+        else if (p < RMAT_A + RMAT_B) col |= 1;
+        else if (p < RMAT_A + RMAT_B + RMAT_C) row |= 1;
+        else { row |= 1; col |= 1; }
+    }
+    *u = row; *v = col;
+}
+
+/* Weights come from their own stream (wr), so turning them on does not
+   change which edges a seed produces. */
+static int write_edge(FILE *fp, unsigned long u, unsigned long v, const char *label,
+                      double max_weight, kg_rng_t *wr) {
+    char a[KG_NAME_LEN], b[KG_NAME_LEN];
+    kg_synth_entity_name(u, a, sizeof(a));
+    kg_synth_entity_name(v, b, sizeof(b));
+    if (max_weight <= 0.0) return fprintf(fp, "%s|%s|%s\n", a, label, b) > 0;
+    double w = 1.0 + kg_rng_unit(wr) * (max_weight - 1.0);
+    return fprintf(fp, "%s|%s|%s|%.2f\n", a, label, b, w) > 0;
+}
+
+kg_status_t kg_synth_write(FILE *fp, const kg_synth_opts_t *o) {
+    if (o->nodes < 2 || o->edges == 0 || o->labels == 0) return KG_ERR_INVALID;
+    if (o->max_weight != 0.0 && !(o->max_weight >= 1.0)) return KG_ERR_INVALID;
+
+    double *cdf = zipf_cdf(o->labels, o->label_skew);
+    char (*labels)[KG_REL_LEN] = (char (*)[KG_REL_LEN])malloc((size_t)o->labels * KG_REL_LEN);
+    if (!cdf || !labels) { free(cdf); free(labels); return KG_ERR_NOMEM; }
+    for (unsigned i = 0; i < o->labels; ++i) kg_synth_label_name(i, labels[i], KG_REL_LEN);
+
+    kg_rng_t r, wr;
+    kg_rng_seed(&r, o->seed);
+    kg_rng_seed(&wr, o->seed ^ 0x9e3779b97f4a7c15ull);
+    kg_status_t st = KG_OK;
+
+    if (o->model == KG_SYNTH_RMAT) {
+        unsigned scale = 1;
+        while ((1ul << scale) < o->nodes) scale++;
+        /* Permute ids so hubs are not all clustered at small ids. */
+        unsigned long mult = 2654435761ul | 1ul;
+        for (unsigned long i = 0; i < o->edges; ) {
+            unsigned long u, v;
+            rmat_edge(&r, scale, &u, &v);
+            u = (u * mult) & ((1ul << scale) - 1);
+            v = (v * mult) & ((1ul << scale) - 1);
+            if (u >= o->nodes || v >= o->nodes || u == v) continue;
+            if (!write_edge(fp, u, v, labels[zipf_draw(cdf, o->labels, &r)], o->max_weight, &wr)) { st = KG_ERR_IO; break; }
+            ++i;
+        }
+    } else {
+        /* Barabasi-Albert: every endpoint ever used goes into `ends`, so a
+           uniform pick from it is a degree-proportional pick of a node. */
+        unsigned long m = o->edges / o->nodes;
+        if (m == 0) m = 1;
+        if (o->nodes < m + 2) { free(cdf); free(labels); return KG_ERR_INVALID; }
+        unsigned *ends = (unsigned*)malloc(sizeof(unsigned) * 2 * (o->edges + m));
+        if (!ends) { free(cdf); free(labels); return KG_ERR_NOMEM; }
+        size_t n_ends = 0;
+        unsigned long written = 0;
+
+        /* Seed: a small chain among the first m + 1 nodes */
+        for (unsigned long v = 1; v <= m && written < o->edges; ++v, ++written) {
+            if (!write_edge(fp, v, v - 1, labels[zipf_draw(cdf, o->labels, &r)], o->max_weight, &wr)) { st = KG_ERR_IO; break; }
+            ends[n_ends++] = (unsigned)v; ends[n_ends++] = (unsigned)(v - 1);
+        }
+        for (unsigned long v = m + 1; st == KG_OK && written < o->edges; ++v) {
+            if (v >= o->nodes) v = m + 1 + kg_rng_below(&r, o->nodes - m - 1);   /* out of fresh nodes: densify */
+            for (unsigned long j = 0; j < m && written < o->edges; ++j) {
+                unsigned long t = ends[kg_rng_below(&r, n_ends)];
+                if (t == v) continue;
+                if (!write_edge(fp, v, t, labels[zipf_draw(cdf, o->labels, &r)], o->max_weight, &wr)) { st = KG_ERR_IO; break; }
+                ends[n_ends++] = (unsigned)v; ends[n_ends++] = (unsigned)t;
+                written++;
+            }
+        }
+        free(ends);
+    }
+
+    free(cdf);
+    free(labels);
+    if (st == KG_OK && fflush(fp) != 0) st = KG_ERR_IO;
+    return st;
+}
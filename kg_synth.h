@@ -0,0 +1,76 @@
+/* =========================================================================
+   Knowledge Graph Engine — Synthetic Graph Generator
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Writes scale-free knowledge graphs in the Source|Relation|Target
+     format, so load, lookup and path queries can be measured far beyond
+     the sample relations.txt.
+       - R-MAT: recursive quadrant sampling, O(1) memory per edge
+       - Barabasi-Albert: preferential attachment, 8 bytes per edge
+     Relation labels are drawn from a Zipf distribution, so a handful of
+     labels dominate the way "Requires" / "Includes" do in real data.
+
+   ========================================================================= */
+#ifndef KG_SYNTH_H
+#define KG_SYNTH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "kg_graph.h"
+
+/* [SECTION] Random Numbers (xorshift64*, shared by the benchmark tools) */
+
+typedef struct kg_rng { uint64_t s; } kg_rng_t;
+
+static inline void kg_rng_seed(kg_rng_t *r, uint64_t seed) {
+    r->s = seed ? seed : 0x9e3779b97f4a7c15ull;
+}
+
+static inline uint64_t kg_rng_next(kg_rng_t *r) {
+    r->s ^= r->s >> 12; r->s ^= r->s << 25; r->s ^= r->s >> 27;
+    return r->s * 0x2545f4914f6cdd1dull;
+}
+
+/* Uniform in [0, n) */
+static inline uint64_t kg_rng_below(kg_rng_t *r, uint64_t n) {
+    return n ? kg_rng_next(r) % n : 0;
+}
+
+/* Uniform in [0, 1) */
+static inline double kg_rng_unit(kg_rng_t *r) {
+    return (double)(kg_rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* [SECTION] Generator */
+
+typedef enum kg_synth_model {
+    KG_SYNTH_RMAT = 0,
+    KG_SYNTH_BA
+} kg_synth_model_t;
+
+typedef struct kg_synth_opts {
+    kg_synth_model_t model;
+    unsigned long nodes;
+    unsigned long edges;
+    unsigned labels;             /* distinct relation labels */
+    double label_skew;           /* Zipf exponent; 0 = uniform */
+    uint64_t seed;
+    double max_weight;           /* >= 1: add a weight column, uniform in [1, max] */
+} kg_synth_opts_t;
+
+/* Defaults: R-MAT, 1000 nodes, 8000 edges, 16 labels, skew 1.0, no weights */
+void kg_synth_defaults(kg_synth_opts_t *o);
+
+/* Deterministic, unique, word-like name for node `id`. */
+void kg_synth_entity_name(unsigned long id, char *buf, size_t n);
+
+/* Label `i` (0 = most frequent). The first few are the real labels
+   from relations.txt, the rest are numbered. */
+void kg_synth_label_name(unsigned i, char *buf, size_t n);
+
+/* Writes o->edges lines to fp. KG_ERR_INVALID for nonsensical options,
+   KG_ERR_NOMEM / KG_ERR_IO otherwise. */
+kg_status_t kg_synth_write(FILE *fp, const kg_synth_opts_t *o);
+
+#endif /* KG_SYNTH_H */
@@ -0,0 +1,299 @@
+/* =========================================================================
+   Knowledge Graph Engine — Dependency Order (implementation)
+   ========================================================================= */
+
+#include "kg_topo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* [SECTION] Relation Sets */
+
+static void copy_field(char *dst, size_t len, const char *src, size_t n) {
+    if (n >= len) n = len - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+/* Defaults: only the names this graph has seen. */
+static kg_status_t default_filter(const kg_graph_t *g, kg_label_filter_t *f, const char *names) {
+    const char *list[8];
+    char buf[8][KG_REL_LEN];
+    size_t n = 0;
+    for (const char *p = names; *p && n < 8; ) {
+        size_t len = strcspn(p, ",");
+        copy_field(buf[n], sizeof(buf[n]), p, len);
+        kg_trim(buf[n]);
+        if (buf[n][0] && kg_find_label(g, buf[n]) != KG_NO_LABEL) { list[n] = buf[n]; n++; }
+        p += len + (p[len] == ',');
+    }
+    return kg_label_filter_init(g, f, 0, list, n, NULL);
+}
+
+static kg_status_t side_filter(const kg_graph_t *g, kg_label_filter_t *f, const char *spec,
+                               char *bad, size_t bad_len) {
+    if (!spec[strspn(spec, " \t")]) return kg_label_filter_init(g, f, 0, NULL, 0, NULL);
+    return kg_label_filter_parse(g, f, spec, bad, bad_len);
+}
+
+kg_status_t kg_topo_rels_parse(const kg_graph_t *g, const char *spec, kg_topo_rels_t *out,
+                               char *bad, size_t bad_len) {
+    memset(out, 0, sizeof(*out));
+    kg_status_t st;
+    if (!spec || !spec[strspn(spec, " \t")]) {
+        st = default_filter(g, &out->before, KG_TOPO_BEFORE_DEFAULT);
+        if (st == KG_OK) st = default_filter(g, &out->after, KG_TOPO_AFTER_DEFAULT);
+    } else {
+        char before[KG_LINE_BUF];
+        const char *slash = strchr(spec, '/');
+        copy_field(before, sizeof(before), spec, slash ? (size_t)(slash - spec) : strlen(spec));
+        st = side_filter(g, &out->before, before, bad, bad_len);
+        if (st == KG_OK) st = side_filter(g, &out->after, slash ? slash + 1 : "", bad, bad_len);
+    }
+    if (st != KG_OK) kg_topo_rels_free(out);
+    return st;
+}
+
+void kg_topo_rels_free(kg_topo_rels_t *r) {
+    kg_label_filter_free(&r->before);
+    kg_label_filter_free(&r->after);
+}
+
+void kg_topo_free(kg_topo_t *t) {
+    if (!t) return;
+    free(t->pre_row); free(t->pre);
+    free(t->order); free(t->rank);
+    free(t->cycle_row); free(t->cycle);
+    free(t);
+}
+
+size_t kg_topo_bytes(const kg_topo_t *t) {
+    return sizeof(*t) + (t->n + 1) * sizeof(size_t) + t->pre_row[t->n] * sizeof(unsigned)
+         + (t->n_ordered + t->n) * sizeof(unsigned)
+         + (t->n_cycles + 1) * sizeof(size_t) + t->cycle_row[t->n_cycles] * sizeof(unsigned);
+}
+
+/*
+   [SECTION] Build
+   - Two passes over the adjacency lists: count prerequisites, then fill.
+     "A before B" makes A a prerequisite of B, "A after B" B one of A.
+   - Kahn runs on the same arrays: each entity counts its unmet
+     prerequisites, and dependents are found through a second, transposed
+     copy (succ) built from pre.
+ */
+static kg_status_t fill_prerequisites(const kg_snapshot_t *s, const kg_topo_rels_t *r, kg_topo_t *t) {
+    size_t n = t->n;
+    t->pre_row = (size_t*)calloc(n + 1, sizeof(size_t));
+    if (!t->pre_row) return KG_ERR_NOMEM;
+    size_t *pos = NULL;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t u = 0; u < n; ++u) {
+            kg_entity_t *e = kg_entity_at(s->g, u);
+            if (!kg_visible(s, e)) continue;
+            for (const kg_relation_t *x = kg_snapshot_relations(s, e); x; x = x->next) {
+                unsigned v = x->target->id;
+                if (kg_label_allowed(&r->before, x->label)) {
+                    if (pass == 0) t->pre_row[v + 1]++;
+                    else t->pre[pos[v]++] = (unsigned)u;
+                }
+                if (kg_label_allowed(&r->after, x->label)) {
+                    if (pass == 0) t->pre_row[u + 1]++;
+                    else t->pre[pos[u]++] = v;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (size_t v = 0; v < n; ++v) t->pre_row[v + 1] += t->pre_row[v];
+            t->pre = (unsigned*)malloc((t->pre_row[n] ? t->pre_row[n] : 1) * sizeof(unsigned));
+            pos = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+            if (!t->pre || !pos) { free(pos); return KG_ERR_NOMEM; }
+            memcpy(pos, t->pre_row, n * sizeof(size_t));
+        }
+    }
+    free(pos);
+    return KG_OK;
+}
+
+static kg_status_t kahn(kg_topo_t *t) {
+    size_t n = t->n, m = t->pre_row[n];
+    size_t *succ_row = (size_t*)calloc(n + 1, sizeof(size_t));
+    unsigned *succ = (unsigned*)malloc((m ? m : 1) * sizeof(unsigned));
+    unsigned *need = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    t->order = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    t->rank = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));
+    if (!succ_row || !succ || !need || !t->order || !t->rank) {
+        free(succ_row); free(succ); free(need);
+        return KG_ERR_NOMEM;
+    }
+    for (size_t k = 0; k < m; ++k) succ_row[t->pre[k] + 1]++;
+    for (size_t v = 0; v < n; ++v) succ_row[v + 1] += succ_row[v];
+    for (size_t v = 0; v < n; ++v)
+        for (size_t k = t->pre_row[v]; k < t->pre_row[v + 1]; ++k)
+            succ[succ_row[t->pre[k]]++] = (unsigned)v;
+    for (size_t v = n; v > 0; --v) succ_row[v] = succ_row[v - 1];
+    succ_row[0] = 0;
+
+    /* order[] doubles as the FIFO queue */
+    size_t head = 0, tail = 0;
+    for (size_t v = 0; v < n; ++v) {
+        need[v] = (unsigned)(t->pre_row[v + 1] - t->pre_row[v]);
+        t->rank[v] = KG_NO_ENTITY;
+        if (need[v] || succ_row[v + 1] != succ_row[v]) t->n_involved++;
+        if (!need[v] && succ_row[v + 1] != succ_row[v]) t->order[tail++] = (unsigned)v;
+    }
+    while (head < tail) {
+        unsigned v = t->order[head];
+        t->rank[v] = (unsigned)head++;
+        for (size_t k = succ_row[v]; k < succ_row[v + 1]; ++k)
+            if (--need[succ[k]] == 0) t->order[tail++] = succ[k];
+    }
+    t->n_ordered = tail;
+    free(succ_row); free(succ); free(need);
+    return KG_OK;
+}
+
+/* Every entity Kahn left has a prerequisite it left too, so following
+   those from any of them must come back to an entity of the same walk
+   (a new cycle) or reach an earlier walk (nothing new). */
+static kg_status_t find_cycles(kg_topo_t *t) {
+    size_t n = t->n, left = t->n_involved - t->n_ordered;
+    t->cycle_row = (size_t*)calloc(left + 1, sizeof(size_t));
+    t->cycle = (unsigned*)malloc((left ? left : 1) * sizeof(unsigned));
+    unsigned *walk = (unsigned*)calloc(n ? n : 1, sizeof(unsigned));   /* walk number + 1 */
+    unsigned *at = (unsigned*)malloc((n ? n : 1) * sizeof(unsigned));   /* position in path */
+    unsigned *path = (unsigned*)malloc((left ? left : 1) * sizeof(unsigned));
+    if (!t->cycle_row || !t->cycle || !walk || !at || !path) {
+        free(walk); free(at); free(path);
+        return KG_ERR_NOMEM;
+    }
+    unsigned w = 0;
+    size_t k = 0;
+    for (size_t s = 0; s < n && left; ++s) {
+        if (t->rank[s] != KG_NO_ENTITY || t->pre_row[s] == t->pre_row[s + 1] || walk[s]) continue;
+        size_t len = 0;
+        unsigned v = (unsigned)s;
+        ++w;
+        while (!walk[v]) {
+            walk[v] = w;
+            at[v] = (unsigned)len;
+            path[len++] = v;
+            size_t e = t->pre_row[v];
+            while (t->rank[t->pre[e]] != KG_NO_ENTITY) e++;
+            v = t->pre[e];
+        }
+        if (walk[v] != w) continue;
+        /* path[at[v]..] is the cycle, each needing the next: store it the
+           other way round */
+        for (size_t i = len; i-- > at[v]; ) t->cycle[k++] = path[i];
+        t->cycle_row[++t->n_cycles] = k;
+    }
+    free(walk); free(at); free(path);
+    return KG_OK;
+}
+
+kg_status_t kg_topo_build(const kg_snapshot_t *s, const kg_topo_rels_t *r, kg_topo_t **out) {
+    *out = NULL;
+    kg_topo_t *t = (kg_topo_t*)calloc(1, sizeof(kg_topo_t));
+    if (!t) return KG_ERR_NOMEM;
+    t->g = s->g;
+    t->version = s->version;
+    t->n = s->n_entities;
+    kg_status_t st = fill_prerequisites(s, r, t);
+    if (st == KG_OK) st = kahn(t);
+    if (st == KG_OK) st = find_cycles(t);
+    if (st != KG_OK) { kg_topo_free(t); return st; }
+    *out = t;
+    return KG_OK;
+}
+
+/*
+   [SECTION] Prerequisite Closure
+   - Iterative post-order DFS over prerequisites: an entity is emitted
+     once all of its own have been. Visited entities go in a hash set
+     that grows with the answer, so nothing is sized by the graph.
+ */
+typedef struct id_set {
+    unsigned *slots;             /* id + 1, 0 = empty */
+    size_t mask, used;
+} id_set_t;
+
+static size_t id_slot(unsigned id, size_t mask) {
+    uint64_t h = (uint64_t)id * 0x9e3779b97f4a7c15ull;
+    return (size_t)(h >> 32) & mask;
+}
+
+/* 1 if added, 0 if present, -1 out of memory. */
+static int id_set_add(id_set_t *s, unsigned id) {
+    if ((s->used + 1) * 2 > s->mask + 1) {
+        size_t cap = (s->mask + 1) * 2;
+        unsigned *slots = (unsigned*)calloc(cap, sizeof(unsigned));
+        if (!slots) return -1;
+        for (size_t i = 0; i <= s->mask; ++i) {
+            if (!s->slots[i]) continue;
+            size_t j = id_slot(s->slots[i] - 1, cap - 1);
+            while (slots[j]) j = (j + 1) & (cap - 1);
+            slots[j] = s->slots[i];
+        }
+        free(s->slots);
+        s->slots = slots;
+        s->mask = cap - 1;
+    }
+    size_t j = id_slot(id, s->mask);
+    while (s->slots[j]) {
+        if (s->slots[j] == id + 1) return 0;
+        j = (j + 1) & s->mask;
+    }
+    s->slots[j] = id + 1;
+    s->used++;
+    return 1;
+}
+
+typedef struct frame {
+    unsigned v;
+    size_t next;                 /* index into pre of the next prerequisite */
+} frame_t;
+
+kg_status_t kg_topo_prerequisites(const kg_topo_t *t, const kg_entity_t *x, unsigned **ids, size_t *n) {
+    *ids = NULL; *n = 0;
+    if (x->id >= t->n) return KG_ERR_NOT_FOUND;
+
+    id_set_t seen = { (unsigned*)calloc(16, sizeof(unsigned)), 15, 0 };
+    size_t cap = 16, depth_cap = 16, len = 0, depth = 0;
+    unsigned *res = (unsigned*)malloc(cap * sizeof(unsigned));
+    frame_t *stack = (frame_t*)malloc(depth_cap * sizeof(frame_t));
+    kg_status_t st = KG_ERR_NOMEM;
+    if (!seen.slots || !res || !stack || id_set_add(&seen, x->id) < 0) goto fail;
+
+    stack[depth].v = x->id; stack[depth++].next = t->pre_row[x->id];
+    while (depth) {
+        frame_t *f = &stack[depth - 1];
+        if (f->next < t->pre_row[f->v + 1]) {
+            unsigned p = t->pre[f->next++];
+            int added = id_set_add(&seen, p);
+            if (added < 0) goto fail;
+            if (!added) continue;
+            if (depth == depth_cap) {
+                frame_t *grown = (frame_t*)realloc(stack, 2 * depth_cap * sizeof(frame_t));
+                if (!grown) goto fail;
+                stack = grown; depth_cap *= 2;
+            }
+            stack[depth].v = p; stack[depth++].next = t->pre_row[p];
+            continue;
+        }
+        depth--;
+        if (!depth) break;                       /* x itself */
+        if (len == cap) {
+            unsigned *grown = (unsigned*)realloc(res, 2 * cap * sizeof(unsigned));
+            if (!grown) goto fail;
+            res = grown; cap *= 2;
+        }
+        res[len++] = f->v;
+    }
+    free(seen.slots); free(stack);
+    if (!len) { free(res); return KG_OK; }
+    *ids = res; *n = len;
+    return KG_OK;
+fail:
+    free(seen.slots); free(res); free(stack);
+    return st;
+}
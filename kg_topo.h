@@ -0,0 +1,79 @@
+/* =========================================================================
+   Knowledge Graph Engine — Dependency Order
+   -------------------------------------------------------------------------
+ ->  Purpose:
+     Curricula as the data states them ("Data Structures|Prerequisite
+     for|Algorithms", "Machine Learning|Requires|Python"): which entity has
+     to come before which, along relations of two kinds:
+       - before: "A r B" puts A first ("Prerequisite for")
+       - after:  "A r B" puts B first ("Requires")
+     Built from one snapshot in O(n + m):
+       - every entity's prerequisites as a compact array
+       - a topological order of all entities those relations touch (Kahn,
+         prerequisites first, ties by id)
+       - what blocks the rest: one cycle per tangle, walked through the
+         prerequisites of the entities Kahn could not order.
+     "Everything X needs, in learning order" is then a depth-first walk of
+     X's prerequisites alone, post-order, so it costs time in proportion
+     to the answer, not to the graph.
+->   Build:
+     add kg_topo.c next to kg_graph.c
+
+   ========================================================================= */
+#ifndef KG_TOPO_H
+#define KG_TOPO_H
+
+#include "kg_graph.h"
+
+/* Used when no relations are named; those the graph lacks are skipped. */
+#define KG_TOPO_BEFORE_DEFAULT "Prerequisite for, Required for, Needed for"
+#define KG_TOPO_AFTER_DEFAULT  "Requires"
+
+typedef struct kg_topo_rels {
+    kg_label_filter_t before;    /* "A r B": A first */
+    kg_label_filter_t after;     /* "A r B": B first */
+} kg_topo_rels_t;
+
+/* spec is "before, ... / after, ..." (either side may be empty, e.g.
+   "/ Requires"); NULL or blank for the defaults. An unknown relation is
+   copied into bad[bad_len] (may be NULL): KG_ERR_NOT_FOUND. */
+kg_status_t kg_topo_rels_parse(const kg_graph_t *g, const char *spec, kg_topo_rels_t *out,
+                               char *bad, size_t bad_len);
+void kg_topo_rels_free(kg_topo_rels_t *r);
+
+typedef struct kg_topo {
+    const kg_graph_t *g;
+    unsigned long version;       /* snapshot the index was built from */
+    size_t n;                    /* entities covered (ids 0..n-1) */
+    size_t *pre_row;             /* n + 1 offsets into pre */
+    unsigned *pre;               /* direct prerequisites of each entity */
+    size_t n_involved;           /* entities with at least one such relation */
+    size_t n_ordered;            /* of those, the ones Kahn could order */
+    unsigned *order;             /* n_ordered entity ids, prerequisites first */
+    unsigned *rank;              /* entity id -> index in order, KG_NO_ENTITY if none */
+    size_t n_cycles;             /* disjoint; each entity a prerequisite of the next, */
+    size_t *cycle_row;           /* the last one of the first: cycle k is */
+    unsigned *cycle;             /* cycle[cycle_row[k] .. cycle_row[k + 1]) */
+} kg_topo_t;
+
+kg_status_t kg_topo_build(const kg_snapshot_t *s, const kg_topo_rels_t *r, kg_topo_t **out);
+void kg_topo_free(kg_topo_t *t);
+size_t kg_topo_bytes(const kg_topo_t *t);
+
+static inline int kg_topo_is_current(const kg_topo_t *t) {
+    return t->version == kg_graph_version(t->g);
+}
+
+/* Every entity on a cycle has no rank, and neither does anything that
+   (transitively) needs one of them. */
+static inline int kg_topo_blocked(const kg_topo_t *t, const kg_entity_t *e) {
+    return e->id < t->n && t->rank[e->id] == KG_NO_ENTITY && t->pre_row[e->id] != t->pre_row[e->id + 1];
+}
+
+/* All of x's transitive prerequisites (x itself excluded), each after
+   its own: *ids is heap allocated (free()), NULL when there are none.
+   Entities on a cycle come in the order the walk met them.
+   KG_ERR_NOT_FOUND if x is newer than the index. */
+kg_status_t kg_topo_prerequisites(const kg_topo_t *t, const kg_entity_t *x, unsigned **ids, size_t *n);
+
+#endif /* KG_TOPO_H */